@@ -1,20 +1,42 @@
-QT += core gui widgets network multimedia
+QT += core gui widgets network multimedia concurrent
 
 CONFIG += c++17
 
 TARGET = HackRfRadio
 
+# Data port frame decoder, control batches, TX audio packets and the spectrum
+# analyser (band scanner), shared with the server
+TCP_DIR = $$absolute_path($$PWD/../HackRfTcp)
+INCLUDEPATH += $$TCP_DIR
+
+# Latency histograms (header only) and thread placement, shared with
+# HackTvLib and the server
+LIB_DIR = $$absolute_path($$PWD/../HackTvLib)
+INCLUDEPATH += $$LIB_DIR
+DEFINES += THREADPLACEMENT_STATIC
+
 SOURCES += \
     main.cpp \
     radiowindow.cpp \
     tcpclient.cpp \
     audioplayback.cpp \
+    audioring.cpp \
     fmdemodulator.cpp \
     amdemodulator.cpp \
+    polyphaseresampler.cpp \
+    channelizer.cpp \
+    multivfo.cpp \
+    bandscanner.cpp \
     frequencywidget.cpp \
     meter.cpp \
     glplotter.cpp \
-    gainsettingsdialog.cpp
+    gainsettingsdialog.cpp \
+    $$TCP_DIR/iqcodec.cpp \
+    $$TCP_DIR/controlbatch.cpp \
+    $$TCP_DIR/iqshmbus.cpp \
+    $$TCP_DIR/txaudiointake.cpp \
+    $$TCP_DIR/spectrumanalyzer.cpp \
+    $$LIB_DIR/threadplacement.cpp
 
 ios {
     OBJECTIVE_SOURCES += audiocapture.mm
@@ -27,13 +49,25 @@ HEADERS += \
     tcpclient.h \
     audiocapture.h \
     audioplayback.h \
+    audioring.h \
     fmdemodulator.h \
     amdemodulator.h \
+    polyphaseresampler.h \
+    channelizer.h \
+    multivfo.h \
+    bandscanner.h \
     frequencywidget.h \
     meter.h \
     glplotter.h \
     constants.h \
-    gainsettingsdialog.h
+    gainsettingsdialog.h \
+    $$TCP_DIR/iqcodec.h \
+    $$TCP_DIR/controlbatch.h \
+    $$TCP_DIR/iqshmbus.h \
+    $$TCP_DIR/txaudiointake.h \
+    $$TCP_DIR/spectrumanalyzer.h \
+    $$LIB_DIR/latencyhistogram.h \
+    $$LIB_DIR/threadplacement.h
 
 win32 {
     DEFINES += _WIN32
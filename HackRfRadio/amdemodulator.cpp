@@ -1,5 +1,188 @@
 #include "amdemodulator.h"
 #include <QDebug>
+#include <cstring>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#include <xmmintrin.h>
+#define AMDEMOD_SSE 1
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define AMDEMOD_NEON 1
+#endif
+
+namespace {
+
+// Real FIR inner product, 4 taps per step
+inline float dotProduct(const float* x, const float* h, size_t n)
+{
+    size_t j = 0;
+    float sum = 0.0f;
+#if defined(AMDEMOD_SSE)
+    __m128 acc = _mm_setzero_ps();
+    for (; j + 4 <= n; j += 4) {
+        acc = _mm_add_ps(acc, _mm_mul_ps(_mm_loadu_ps(x + j), _mm_loadu_ps(h + j)));
+    }
+    alignas(16) float lanes[4];
+    _mm_store_ps(lanes, acc);
+    sum = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+#elif defined(AMDEMOD_NEON)
+    float32x4_t acc = vdupq_n_f32(0.0f);
+    for (; j + 4 <= n; j += 4) {
+        acc = vmlaq_f32(acc, vld1q_f32(x + j), vld1q_f32(h + j));
+    }
+    float lanes[4];
+    vst1q_f32(lanes, acc);
+    sum = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+#endif
+    for (; j < n; j++) sum += x[j] * h[j];
+    return sum;
+}
+
+// Complex samples against real taps given twice each (h0 h0 h1 h1 ...):
+// the interleaved I/Q line multiplies straight through, two samples per
+// step, and the even / odd lanes sum to I / Q
+inline std::complex<float> complexDot(const std::complex<float>* x, const float* h2, size_t taps)
+{
+    const float* xf = reinterpret_cast<const float*>(x);
+    const size_t n = taps * 2;
+    size_t j = 0;
+    float re = 0.0f, im = 0.0f;
+#if defined(AMDEMOD_SSE)
+    __m128 acc = _mm_setzero_ps();
+    for (; j + 4 <= n; j += 4) {
+        acc = _mm_add_ps(acc, _mm_mul_ps(_mm_loadu_ps(xf + j), _mm_loadu_ps(h2 + j)));
+    }
+    alignas(16) float lanes[4];
+    _mm_store_ps(lanes, acc);
+    re = lanes[0] + lanes[2];
+    im = lanes[1] + lanes[3];
+#elif defined(AMDEMOD_NEON)
+    float32x4_t acc = vdupq_n_f32(0.0f);
+    for (; j + 4 <= n; j += 4) {
+        acc = vmlaq_f32(acc, vld1q_f32(xf + j), vld1q_f32(h2 + j));
+    }
+    float lanes[4];
+    vst1q_f32(lanes, acc);
+    re = lanes[0] + lanes[2];
+    im = lanes[1] + lanes[3];
+#endif
+    for (; j < n; j += 2) {
+        re += xf[j] * h2[j];
+        im += xf[j + 1] * h2[j + 1];
+    }
+    return {re, im};
+}
+
+void magnitude(const std::complex<float>* in, float* out, size_t n)
+{
+    const float* f = reinterpret_cast<const float*>(in);
+    size_t i = 0;
+#if defined(AMDEMOD_SSE)
+    for (; i + 4 <= n; i += 4) {
+        const __m128 a = _mm_loadu_ps(f + i * 2);
+        const __m128 b = _mm_loadu_ps(f + i * 2 + 4);
+        const __m128 re = _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0));
+        const __m128 im = _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1));
+        _mm_storeu_ps(out + i, _mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(re, re), _mm_mul_ps(im, im))));
+    }
+#elif defined(AMDEMOD_NEON)
+    for (; i + 4 <= n; i += 4) {
+        const float32x4x2_t v = vld2q_f32(f + i * 2);
+        const float32x4_t p = vmlaq_f32(vmulq_f32(v.val[0], v.val[0]), v.val[1], v.val[1]);
+#if defined(__aarch64__)
+        vst1q_f32(out + i, vsqrtq_f32(p));
+#else
+        // p * rsqrt(p), estimate + two Newton steps; the floor keeps 0 from
+        // turning into 0 * inf
+        const float32x4_t q = vmaxq_f32(p, vdupq_n_f32(1e-30f));
+        float32x4_t r = vrsqrteq_f32(q);
+        r = vmulq_f32(r, vrsqrtsq_f32(vmulq_f32(q, r), r));
+        r = vmulq_f32(r, vrsqrtsq_f32(vmulq_f32(q, r), r));
+        vst1q_f32(out + i, vmulq_f32(q, r));
+#endif
+    }
+#endif
+    for (; i < n; i++) {
+        const float re = f[i * 2], im = f[i * 2 + 1];
+        out[i] = std::sqrt(re * re + im * im);
+    }
+}
+
+// out[i] = in[i] * phasor * step^i, in place allowed; phasor moves on by
+// step^n. The vector paths run four phasors a step apart and advance them
+// by step^4, so there is one complex multiply per sample and no sin / cos.
+void mixNco(const std::complex<float>* in, std::complex<float>* out, size_t n,
+            std::complex<float>& phasor, std::complex<float> step)
+{
+    const float* f = reinterpret_cast<const float*>(in);
+    float* o = reinterpret_cast<float*>(out);
+    float pr = phasor.real(), pi = phasor.imag();
+    const float sr = step.real(), si = step.imag();
+    size_t i = 0;
+#if defined(AMDEMOD_SSE) || defined(AMDEMOD_NEON)
+    if (n >= 4) {
+        alignas(16) float lr[4], li[4];
+        for (int k = 0; k < 4; k++) {
+            lr[k] = pr;
+            li[k] = pi;
+            const float t = pr * sr - pi * si;
+            pi = pr * si + pi * sr;
+            pr = t;
+        }
+        const std::complex<float> s2 = step * step;
+        const std::complex<float> s4 = s2 * s2;
+#if defined(AMDEMOD_SSE)
+        __m128 vr = _mm_load_ps(lr), vi = _mm_load_ps(li);
+        const __m128 wr = _mm_set1_ps(s4.real()), wi = _mm_set1_ps(s4.imag());
+        for (; i + 4 <= n; i += 4) {
+            const __m128 a = _mm_loadu_ps(f + i * 2);
+            const __m128 b = _mm_loadu_ps(f + i * 2 + 4);
+            const __m128 xr = _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0));
+            const __m128 xi = _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1));
+            const __m128 yr = _mm_sub_ps(_mm_mul_ps(xr, vr), _mm_mul_ps(xi, vi));
+            const __m128 yi = _mm_add_ps(_mm_mul_ps(xr, vi), _mm_mul_ps(xi, vr));
+            _mm_storeu_ps(o + i * 2, _mm_unpacklo_ps(yr, yi));
+            _mm_storeu_ps(o + i * 2 + 4, _mm_unpackhi_ps(yr, yi));
+            const __m128 nr = _mm_sub_ps(_mm_mul_ps(vr, wr), _mm_mul_ps(vi, wi));
+            vi = _mm_add_ps(_mm_mul_ps(vr, wi), _mm_mul_ps(vi, wr));
+            vr = nr;
+        }
+        _mm_store_ps(lr, vr);
+        _mm_store_ps(li, vi);
+#else
+        float32x4_t vr = vld1q_f32(lr), vi = vld1q_f32(li);
+        const float32x4_t wr = vdupq_n_f32(s4.real()), wi = vdupq_n_f32(s4.imag());
+        for (; i + 4 <= n; i += 4) {
+            const float32x4x2_t x = vld2q_f32(f + i * 2);
+            float32x4x2_t y;
+            y.val[0] = vmlsq_f32(vmulq_f32(x.val[0], vr), x.val[1], vi);
+            y.val[1] = vmlaq_f32(vmulq_f32(x.val[0], vi), x.val[1], vr);
+            vst2q_f32(o + i * 2, y);
+            const float32x4_t nr = vmlsq_f32(vmulq_f32(vr, wr), vi, wi);
+            vi = vmlaq_f32(vmulq_f32(vr, wi), vi, wr);
+            vr = nr;
+        }
+        vst1q_f32(lr, vr);
+        vst1q_f32(li, vi);
+#endif
+        pr = lr[0];
+        pi = li[0];
+    }
+#endif
+    for (; i < n; i++) {
+        const float xr = f[i * 2], xi = f[i * 2 + 1];
+        o[i * 2] = xr * pr - xi * pi;
+        o[i * 2 + 1] = xr * pi + xi * pr;
+        const float t = pr * sr - pi * si;
+        pi = pr * si + pi * sr;
+        pr = t;
+    }
+    // Keep the magnitude at 1 against rounding drift
+    const float norm = 1.0f / std::sqrt(pr * pr + pi * pi);
+    phasor = {pr * norm, pi * norm};
+}
+
+} // namespace
 
 AMDemodulator::AMDemodulator(double inputSampleRate, double bandwidth, QObject *parent)
     : QObject(parent)
@@ -9,50 +192,78 @@ AMDemodulator::AMDemodulator(double inputSampleRate, double bandwidth, QObject *
     rebuildChain();
 }
 
-std::vector<float> AMDemodulator::demodulate(const std::vector<std::complex<float>>& samples)
+const char* AMDemodulator::modeName(Mode mode)
 {
-    if (samples.empty()) return {};
+    switch (mode) {
+    case Synchronous: return "SAM";
+    case UpperSideband: return "USB";
+    case LowerSideband: return "LSB";
+    default: return "AM";
+    }
+}
 
-    auto iq = samples;
+std::vector<float> AMDemodulator::demodulate(const std::vector<std::complex<float>>& samples)
+{
+    std::vector<float> audio;
+    demodulate(samples.data(), samples.size(), audio);
+    return audio;
+}
 
-    // IQ decimation
+void AMDemodulator::demodulate(const std::complex<float>* samples, size_t count, std::vector<float>& audio)
+{
+    audio.clear();
+    if (!samples || count == 0) return;
+
+    // IQ decimation, ping-ponging between the two work buffers
+    const std::complex<float>* iq = samples;
+    size_t n = count;
+    std::vector<std::complex<float>>* next = &m_iqA;
+    std::vector<std::complex<float>>* spare = &m_iqB;
     for (auto& stage : m_iqStages) {
-        std::vector<std::complex<float>> tmp;
-        decimateComplex(iq, tmp, stage.taps, stage.factor, stage.iqHistory);
-        iq = std::move(tmp);
+        decimateComplex(iq, n, stage, *next);
+        iq = next->data();
+        n = next->size();
+        std::swap(next, spare);
     }
 
-    // IQ bandwidth filter
-    if (!m_iqBandwidthTaps.empty()) {
-        std::vector<std::complex<float>> tmp;
-        applyComplexFIR(iq, tmp, m_iqBandwidthTaps, m_iqBwHistory);
-        iq = std::move(tmp);
+    // IQ bandwidth filter (the Weaver low-pass is the channel filter for SSB)
+    if (!isSideband() && !m_iqBandwidthTaps.empty()) {
+        applyComplexFIR(iq, n, m_iqBandwidthTaps, m_iqBwLine, *next);
+        iq = next->data();
+        n = next->size();
     }
 
-    // AM demod: magnitude → AGC → DC block
-    auto audio = amDemod(iq);
+    switch (m_mode) {
+    case Synchronous:   synchronousDetect(iq, n, m_realA); break;
+    case UpperSideband:
+    case LowerSideband: sidebandDetect(iq, n, m_realA); break;
+    default:            envelopeDetect(iq, n, m_realA); break;
+    }
 
     // Real decimation to get closer to 48kHz
+    const float* real = m_realA.data();
+    n = m_realA.size();
+    std::vector<float>* realNext = &m_realB;
+    std::vector<float>* realSpare = &m_realA;
     for (auto& stage : m_realStages) {
-        std::vector<float> tmp;
-        decimateReal(audio, tmp, stage.taps, stage.factor, stage.realHistory);
-        audio = std::move(tmp);
+        decimateReal(real, n, stage, *realNext);
+        real = realNext->data();
+        n = realNext->size();
+        std::swap(realNext, realSpare);
     }
 
     // Resample to 48kHz
-    double lastRate = m_realStages.empty()
-                          ? (m_iqStages.empty() ? m_inputRate : m_iqStages.back().outputRate)
-                          : m_realStages.back().outputRate;
+    double lastRate = m_realStages.empty() ? m_iqRate : m_realStages.back().outputRate;
     if (std::abs(lastRate - 48000.0) > 1.0) {
-        audio = resample(audio, lastRate, 48000.0);
+        m_resampler.setRates(lastRate, 48000.0);
+        realNext->clear();
+        m_resampler.process(real, n, *realNext);
+        real = realNext->data();
+        n = realNext->size();
     }
 
     // Audio lowpass filter
-    {
-        std::vector<float> tmp;
-        applyFIR(audio, tmp, m_audioFilterTaps, m_audioFilterHistory);
-        audio = std::move(tmp);
-    }
+    applyFIR(real, n, m_audioFilterTaps, m_audioFilterLine, audio);
 
     // Output peak limiter
     for (size_t i = 0; i < audio.size(); i++) {
@@ -63,8 +274,6 @@ std::vector<float> AMDemodulator::demodulate(const std::vector<std::complex<floa
             audio[i] = (audio[i] > 0) ? threshold : -threshold;
         }
     }
-
-    return audio;
 }
 
 void AMDemodulator::setSampleRate(double newRate)
@@ -76,33 +285,42 @@ void AMDemodulator::setSampleRate(double newRate)
 void AMDemodulator::setBandwidth(double bandwidthHz)
 {
     m_bandwidth = std::clamp(bandwidthHz, 2000.0, 500000.0);
-    double postDecimRate = m_iqStages.empty() ? m_inputRate : m_iqStages.back().outputRate;
-    float cutoff = static_cast<float>(std::min(m_bandwidth * 0.5, postDecimRate * 0.45));
-    m_iqBandwidthTaps = designLPF(51, cutoff, static_cast<float>(postDecimRate));
-    m_iqBwHistory.clear();
+    designFilters();
+    m_ncoFreqLimit = 2.0 * M_PI * std::min(m_bandwidth * 0.5, 5000.0) / std::max(m_iqRate, 1.0);
+}
+
+void AMDemodulator::setMode(Mode mode)
+{
+    if (mode == m_mode) return;
+    m_mode = mode;
+    // SSB runs the IQ chain at a lower rate
+    rebuildChain();
 }
 
 void AMDemodulator::rebuildChain()
 {
     m_iqStages.clear();
     m_realStages.clear();
-    m_iqBwHistory.clear();
-    m_audioFilterHistory.clear();
+    m_iqBwLine.clear();
+    m_audioFilterLine.clear();
+    m_ssbLine.clear();
+    m_resampler.reset();
 
     // Reset demod state
     m_agcAmp = 0.0f;  // 0 = will auto-init from first chunk's actual level
-    m_dcOffset = 0.0f;
     m_dcBlockerX = 0.0f;
     m_dcBlockerY = 0.0f;
-    m_dcI = 0.0f;
-    m_dcQ = 0.0f;
     m_audioRms = 0.05f;
+    m_ssbLevel = 0.0f;
+    m_weaverDown = m_weaverUp = {1.0f, 0.0f};
 
-    qDebug() << "AM rebuildChain: inputRate=" << m_inputRate << "bandwidth=" << m_bandwidth;
+    qDebug() << "AM rebuildChain: inputRate=" << m_inputRate << "bandwidth=" << m_bandwidth
+             << "mode=" << modeName(m_mode);
 
     double rate = m_inputRate;
     double iqTarget = std::max(m_bandwidth * 6.0, 60000.0);
     iqTarget = std::min(iqTarget, 200000.0);
+    if (isSideband()) iqTarget = SSB_IQ_RATE;
     const int candidates[] = {10, 8, 5, 4, 3, 2};
 
     while (rate > iqTarget * 1.5) {
@@ -116,11 +334,13 @@ void AMDemodulator::rebuildChain()
         int taps = (best >= 8) ? 33 : (best >= 5) ? 21 : 17;
         DecimStage s;
         s.taps = designLPF(taps, cutoff, static_cast<float>(rate));
+        s.taps2 = interleaveTaps(s.taps);
         s.factor = best;
         s.outputRate = newRate;
         m_iqStages.push_back(std::move(s));
         rate = newRate;
     }
+    m_iqRate = rate;
 
     while (rate > 96000.0) {
         int best = 0;
@@ -139,45 +359,146 @@ void AMDemodulator::rebuildChain()
         rate = newRate;
     }
 
-    float audioCutoff = std::min(3500.0f, static_cast<float>(m_bandwidth / 2.0));
-    m_audioFilterTaps = designLPF(63, audioCutoff, 48000.0f);  // 63 taps for sharper cutoff
+    designFilters();
+    resetPll();
 
-    // SDR++ style: LPF cutoff = bandwidth/2
-    double postDecimRate = m_iqStages.empty() ? m_inputRate : m_iqStages.back().outputRate;
-    float defaultBW = static_cast<float>(std::min(m_bandwidth * 0.5, postDecimRate * 0.45));
-    if (defaultBW > 0) {
-        m_iqBandwidthTaps = designLPF(51, defaultBW, static_cast<float>(postDecimRate));
-    } else {
-        m_iqBandwidthTaps.clear();
-    }
+    // SSB AGC: 5 ms attack, 300 ms decay
+    m_ssbAttack = static_cast<float>(1.0 - std::exp(-1.0 / (0.005 * m_iqRate)));
+    m_ssbDecay = static_cast<float>(1.0 - std::exp(-1.0 / (0.3 * m_iqRate)));
 
     qDebug() << "AM chain built: iqStages=" << m_iqStages.size()
              << "realStages=" << m_realStages.size()
-             << "postDecimRate=" << postDecimRate
-             << "iqBwCutoff=" << defaultBW
-             << "audioCutoff=" << audioCutoff;
+             << "postDecimRate=" << m_iqRate;
+}
+
+// Channel filter (IQ bandwidth, or the Weaver low-pass and shifts) and
+// the audio low-pass, for the current bandwidth and mode
+void AMDemodulator::designFilters()
+{
+    float audioCutoff;
+    if (isSideband()) {
+        m_iqBandwidthTaps.clear();
+        const double high = std::min(std::max(m_bandwidth * 0.5, SSB_LOW_HZ + 700.0),
+                                     std::min(SSB_MAX_HIGH_HZ, m_iqRate * 0.45));
+        const double middle = (SSB_LOW_HZ + high) * 0.5;
+        const double half = (high - SSB_LOW_HZ) * 0.5;
+        m_ssbTaps = interleaveTaps(designLPF(SSB_TAPS, static_cast<float>(half), static_cast<float>(m_iqRate)));
+
+        // USB: the passband sits above the carrier, shift it down by its
+        // middle; LSB: below, shift it up
+        const float w = static_cast<float>(2.0 * M_PI * middle / m_iqRate);
+        const float down = (m_mode == UpperSideband) ? -w : w;
+        m_weaverDownStep = std::polar(1.0f, down);
+        m_weaverUpStep = std::polar(1.0f, -down);
+        audioCutoff = static_cast<float>(high);
+        qDebug() << "AM" << modeName(m_mode) << "passband" << SSB_LOW_HZ << "-" << high << "Hz";
+    } else {
+        m_ssbTaps.clear();
+        // SDR++ style: LPF cutoff = bandwidth/2
+        float cutoff = static_cast<float>(std::min(m_bandwidth * 0.5, m_iqRate * 0.45));
+        if (cutoff > 0) {
+            m_iqBandwidthTaps = interleaveTaps(designLPF(51, cutoff, static_cast<float>(m_iqRate)));
+        } else {
+            m_iqBandwidthTaps.clear();
+        }
+        audioCutoff = std::min(3500.0f, static_cast<float>(m_bandwidth / 2.0));
+    }
+    m_audioFilterTaps = designLPF(63, audioCutoff, 48000.0f);  // 63 taps for sharper cutoff
+}
+
+// Carrier PLL, second order, loop filter once per PLL_BLOCK samples on the
+// phase of the block's summed in-phase / quadrature output. Acquires at a
+// 100 Hz natural frequency and tracks at 20 Hz once locked.
+void AMDemodulator::resetPll()
+{
+    m_ncoPhasor = {1.0f, 0.0f};
+    m_ncoStep = {1.0f, 0.0f};
+    m_ncoFreq = 0.0;
+    m_lockMetric = 0.0f;
+    m_pllLocked = false;
+
+    const double rate = std::max(m_iqRate, 1.0);
+    const double blockSec = PLL_BLOCK / rate;
+    auto gains = [&](double naturalHz, float& kp, float& ki) {
+        const double wnT = std::min(2.0 * M_PI * naturalHz * blockSec, 0.5);
+        kp = static_cast<float>(2.0 * 0.707 * wnT);
+        ki = static_cast<float>(wnT * wnT / PLL_BLOCK);
+    };
+    gains(100.0, m_pllKpWide, m_pllKiWide);
+    gains(20.0, m_pllKpNarrow, m_pllKiNarrow);
+    m_ncoFreqLimit = 2.0 * M_PI * std::min(m_bandwidth * 0.5, 5000.0) / rate;
 }
 
 // AM Demodulation — v4
 // Simplified: magnitude → peak-hold AGC → DC block
 // The key problem was AGC instability on small chunks. Solution: use a very
 // slow per-sample peak tracker that converges over hundreds of chunks, not one.
-std::vector<float> AMDemodulator::amDemod(const std::vector<std::complex<float>>& signal)
+void AMDemodulator::envelopeDetect(const std::complex<float>* in, size_t n, std::vector<float>& out)
 {
-    if (signal.empty()) return {};
-    const size_t n = signal.size();
-    std::vector<float> out(n);
-
-    // Step 1: Magnitude (envelope detection) — NO IQ DC removal
+    // Magnitude (envelope detection) — NO IQ DC removal
     // IQ DC removal was destroying AM info in small chunks.
     // The BW filter already centers the signal; DC spike is outside passband.
-    for (size_t i = 0; i < n; i++) {
-        float I = signal[i].real();
-        float Q = signal[i].imag();
-        out[i] = std::sqrt(I * I + Q * Q);
+    out.resize(n);
+    magnitude(in, out.data(), n);
+    carrierAgc(out.data(), n);
+}
+
+void AMDemodulator::synchronousDetect(const std::complex<float>* in, size_t n, std::vector<float>& out)
+{
+    m_shifted.resize(n);
+    for (size_t k = 0; k < n; k += PLL_BLOCK) {
+        const size_t len = std::min(PLL_BLOCK, n - k);
+        std::complex<float>* y = m_shifted.data() + k;
+        mixNco(in + k, y, len, m_ncoPhasor, m_ncoStep);
+
+        float sumRe = 0.0f, sumIm = 0.0f;
+        for (size_t j = 0; j < len; j++) {
+            sumRe += y[j].real();
+            sumIm += y[j].imag();
+        }
+        const float mag = std::sqrt(sumRe * sumRe + sumIm * sumIm);
+        if (mag < 1e-20f) continue;
+
+        // Locked: the carrier sits on the real axis, cos(error) near 1
+        const float err = std::atan2(sumIm, sumRe);
+        m_lockMetric += 0.02f * (sumRe / mag - m_lockMetric);
+        if (!m_pllLocked && m_lockMetric > 0.8f) m_pllLocked = true;
+        else if (m_pllLocked && m_lockMetric < 0.5f) m_pllLocked = false;
+
+        const float kp = m_pllLocked ? m_pllKpNarrow : m_pllKpWide;
+        const float ki = m_pllLocked ? m_pllKiNarrow : m_pllKiWide;
+        m_ncoFreq = std::clamp(m_ncoFreq + static_cast<double>(ki) * err, -m_ncoFreqLimit, m_ncoFreqLimit);
+        m_ncoPhasor *= std::polar(1.0f, -kp * err);
+        m_ncoStep = std::polar(1.0f, static_cast<float>(-m_ncoFreq));
     }
 
-    // Step 2: Per-sample peak-hold AGC
+    // In-phase part, carrier included, for the same AGC and DC blocker as
+    // the envelope; the envelope itself while the loop is still searching
+    out.resize(n);
+    if (m_pllLocked) {
+        for (size_t i = 0; i < n; i++) out[i] = m_shifted[i].real();
+    } else {
+        magnitude(in, out.data(), n);
+    }
+    carrierAgc(out.data(), n);
+}
+
+void AMDemodulator::sidebandDetect(const std::complex<float>* in, size_t n, std::vector<float>& out)
+{
+    m_shifted.resize(n);
+    mixNco(in, m_shifted.data(), n, m_weaverDown, m_weaverDownStep);
+    applyComplexFIR(m_shifted.data(), n, m_ssbTaps, m_ssbLine, m_filtered);
+    mixNco(m_filtered.data(), m_filtered.data(), n, m_weaverUp, m_weaverUpStep);
+
+    out.resize(n);
+    for (size_t i = 0; i < n; i++) out[i] = m_filtered[i].real();
+    sidebandAgc(out.data(), n);
+}
+
+// Carrier AGC and DC blocker, shared by the envelope and SAM detectors
+void AMDemodulator::carrierAgc(float* audio, size_t n)
+{
+    // Per-sample peak-hold AGC
     // Track carrier level with very slow attack/decay (sample-rate based).
     // At 66kHz post-decim rate, alpha=0.0001 → time constant = 10000 samples = 150ms
     // This is slow enough to not follow audio modulation (lowest audio = 300Hz = 3.3ms)
@@ -188,34 +509,44 @@ std::vector<float> AMDemodulator::amDemod(const std::vector<std::complex<float>>
     if (m_agcAmp < 1e-6f && n > 0) {
         // Calculate initial level from first chunk
         float sum = 0.0f;
-        for (size_t i = 0; i < n; i++) sum += out[i];
+        for (size_t i = 0; i < n; i++) sum += audio[i];
         m_agcAmp = sum / static_cast<float>(n);
         if (m_agcAmp < 1e-6f) m_agcAmp = 0.01f;
     }
 
     for (size_t i = 0; i < n; i++) {
         // Slow exponential follower on magnitude
-        m_agcAmp += agcAlpha * (out[i] - m_agcAmp);
+        m_agcAmp += agcAlpha * (audio[i] - m_agcAmp);
 
         // Normalize so carrier sits at ~1.0
         float gain = (m_agcAmp > 1e-6f) ? (1.0f / m_agcAmp) : 1.0f;
-        if (gain > 50.0f) gain = 50.0f;
-        out[i] *= gain;
+        if (gain > AGC_MAX_GAIN) gain = AGC_MAX_GAIN;
+        audio[i] *= gain;
     }
 
-    // Step 3: DC blocker — remove the carrier (now ~1.0), leaving audio modulation
+    // DC blocker — remove the carrier (now ~1.0), leaving audio modulation
     // y[n] = x[n] - x[n-1] + R * y[n-1]
     // R = 0.999 at 66kHz → HPF cutoff ~10Hz — well below 300Hz voice band
     const float R = 0.999f;
     for (size_t i = 0; i < n; i++) {
-        float x = out[i];
+        float x = audio[i];
         float y = x - m_dcBlockerX + R * m_dcBlockerY;
         m_dcBlockerX = x;
         m_dcBlockerY = y;
-        out[i] = y;
+        audio[i] = y;
     }
+}
 
-    return out;
+// No carrier to follow: fast-attack, slow-decay peak AGC to about the
+// level the carrier AGC gives a well modulated AM signal
+void AMDemodulator::sidebandAgc(float* audio, size_t n)
+{
+    const float target = 0.5f;
+    for (size_t i = 0; i < n; i++) {
+        const float a = std::abs(audio[i]);
+        m_ssbLevel += ((a > m_ssbLevel) ? m_ssbAttack : m_ssbDecay) * (a - m_ssbLevel);
+        audio[i] *= std::min(target / std::max(m_ssbLevel, 1e-6f), AGC_MAX_GAIN);
+    }
 }
 
 std::vector<float> AMDemodulator::designLPF(int numTaps, float cutoff, float sampleRate)
@@ -234,147 +565,85 @@ std::vector<float> AMDemodulator::designLPF(int numTaps, float cutoff, float sam
     return h;
 }
 
+std::vector<float> AMDemodulator::interleaveTaps(const std::vector<float>& taps)
+{
+    std::vector<float> h2(taps.size() * 2);
+    for (size_t j = 0; j < taps.size(); j++) h2[j * 2] = h2[j * 2 + 1] = taps[j];
+    return h2;
+}
+
 // ========== Stateful FIR filters ==========
+// Each keeps a line of taps - 1 history samples followed by the block, so
+// the inner products read straight through; the history is moved to the
+// front afterwards and the line keeps its capacity.
 
-void AMDemodulator::decimateComplex(
-    const std::vector<std::complex<float>>& in,
-    std::vector<std::complex<float>>& out,
-    const std::vector<float>& taps, int factor,
-    std::vector<std::complex<float>>& history)
+void AMDemodulator::decimateComplex(const std::complex<float>* in, size_t n, DecimStage& stage,
+                                    std::vector<std::complex<float>>& out)
 {
-    const size_t T = taps.size();
-    const size_t N = in.size();
-    if (history.size() != T - 1) history.assign(T - 1, {0.0f, 0.0f});
-    std::vector<std::complex<float>> work;
-    work.reserve(history.size() + N);
-    work.insert(work.end(), history.begin(), history.end());
-    work.insert(work.end(), in.begin(), in.end());
+    const size_t T = stage.taps.size();
+    auto& line = stage.iqLine;
+    if (line.size() != T - 1) line.assign(T - 1, {0.0f, 0.0f});
+    line.resize(T - 1 + n);
+    std::copy(in, in + n, line.begin() + (T - 1));
+
     out.clear();
-    out.reserve(N / factor + 1);
-    for (size_t i = 0; i < N; i += factor) {
-        float sumR = 0.0f, sumI = 0.0f;
-        for (size_t j = 0; j < T; j++) {
-            const auto& s = work[i + j];
-            sumR += s.real() * taps[j];
-            sumI += s.imag() * taps[j];
-        }
-        out.emplace_back(sumR, sumI);
-    }
-    if (N >= T - 1) {
-        std::copy(in.end() - (T - 1), in.end(), history.begin());
-    } else {
-        size_t keep = (T - 1) - N;
-        std::copy(history.end() - keep, history.end(), history.begin());
-        std::copy(in.begin(), in.end(), history.begin() + keep);
+    size_t i = static_cast<size_t>(stage.phase);
+    for (; i < n; i += stage.factor) {
+        out.push_back(complexDot(line.data() + i, stage.taps2.data(), T));
     }
+    stage.phase = static_cast<int>(i - n);
+
+    std::copy(line.end() - (T - 1), line.end(), line.begin());
+    line.resize(T - 1);
 }
 
-void AMDemodulator::applyComplexFIR(
-    const std::vector<std::complex<float>>& in,
-    std::vector<std::complex<float>>& out,
-    const std::vector<float>& taps,
-    std::vector<std::complex<float>>& history)
+void AMDemodulator::applyComplexFIR(const std::complex<float>* in, size_t n, const std::vector<float>& taps2,
+                                    std::vector<std::complex<float>>& line, std::vector<std::complex<float>>& out)
 {
-    if (in.empty() || taps.empty()) { out = in; return; }
-    const size_t T = taps.size();
-    const size_t N = in.size();
-    if (history.size() != T - 1) history.assign(T - 1, {0.0f, 0.0f});
-    std::vector<std::complex<float>> work;
-    work.reserve(history.size() + N);
-    work.insert(work.end(), history.begin(), history.end());
-    work.insert(work.end(), in.begin(), in.end());
-    out.resize(N);
-    for (size_t i = 0; i < N; i++) {
-        float sumR = 0.0f, sumI = 0.0f;
-        for (size_t j = 0; j < T; j++) {
-            const auto& s = work[i + j];
-            sumR += s.real() * taps[j];
-            sumI += s.imag() * taps[j];
-        }
-        out[i] = {sumR, sumI};
-    }
-    if (N >= T - 1) {
-        std::copy(in.end() - (T - 1), in.end(), history.begin());
-    } else {
-        size_t keep = (T - 1) - N;
-        std::copy(history.end() - keep, history.end(), history.begin());
-        std::copy(in.begin(), in.end(), history.begin() + keep);
-    }
+    if (taps2.empty()) { out.assign(in, in + n); return; }
+    const size_t T = taps2.size() / 2;
+    if (line.size() != T - 1) line.assign(T - 1, {0.0f, 0.0f});
+    line.resize(T - 1 + n);
+    std::copy(in, in + n, line.begin() + (T - 1));
+
+    out.resize(n);
+    for (size_t i = 0; i < n; i++) out[i] = complexDot(line.data() + i, taps2.data(), T);
+
+    std::copy(line.end() - (T - 1), line.end(), line.begin());
+    line.resize(T - 1);
 }
 
-void AMDemodulator::decimateReal(
-    const std::vector<float>& in,
-    std::vector<float>& out,
-    const std::vector<float>& taps, int factor,
-    std::vector<float>& history)
+void AMDemodulator::decimateReal(const float* in, size_t n, DecimStage& stage, std::vector<float>& out)
 {
-    const size_t T = taps.size();
-    const size_t N = in.size();
-    if (history.size() != T - 1) history.assign(T - 1, 0.0f);
-    std::vector<float> work;
-    work.reserve(history.size() + N);
-    work.insert(work.end(), history.begin(), history.end());
-    work.insert(work.end(), in.begin(), in.end());
+    const size_t T = stage.taps.size();
+    auto& line = stage.realLine;
+    if (line.size() != T - 1) line.assign(T - 1, 0.0f);
+    line.resize(T - 1 + n);
+    std::copy(in, in + n, line.begin() + (T - 1));
+
     out.clear();
-    out.reserve(N / factor + 1);
-    for (size_t i = 0; i < N; i += factor) {
-        float sum = 0.0f;
-        for (size_t j = 0; j < T; j++) sum += work[i + j] * taps[j];
-        out.push_back(sum);
-    }
-    if (N >= T - 1) {
-        std::copy(in.end() - (T - 1), in.end(), history.begin());
-    } else {
-        size_t keep = (T - 1) - N;
-        std::copy(history.end() - keep, history.end(), history.begin());
-        std::copy(in.begin(), in.end(), history.begin() + keep);
+    size_t i = static_cast<size_t>(stage.phase);
+    for (; i < n; i += stage.factor) {
+        out.push_back(dotProduct(line.data() + i, stage.taps.data(), T));
     }
+    stage.phase = static_cast<int>(i - n);
+
+    std::copy(line.end() - (T - 1), line.end(), line.begin());
+    line.resize(T - 1);
 }
 
-void AMDemodulator::applyFIR(
-    const std::vector<float>& in,
-    std::vector<float>& out,
-    const std::vector<float>& taps,
-    std::vector<float>& history)
+void AMDemodulator::applyFIR(const float* in, size_t n, const std::vector<float>& taps,
+                             std::vector<float>& line, std::vector<float>& out)
 {
-    if (in.empty() || taps.empty()) { out = in; return; }
+    if (taps.empty()) { out.assign(in, in + n); return; }
     const size_t T = taps.size();
-    const size_t N = in.size();
-    if (history.size() != T - 1) history.assign(T - 1, 0.0f);
-    std::vector<float> work;
-    work.reserve(history.size() + N);
-    work.insert(work.end(), history.begin(), history.end());
-    work.insert(work.end(), in.begin(), in.end());
-    out.resize(N);
-    for (size_t i = 0; i < N; i++) {
-        float sum = 0.0f;
-        for (size_t j = 0; j < T; j++) sum += work[i + j] * taps[j];
-        out[i] = sum;
-    }
-    if (N >= T - 1) {
-        std::copy(in.end() - (T - 1), in.end(), history.begin());
-    } else {
-        size_t keep = (T - 1) - N;
-        std::copy(history.end() - keep, history.end(), history.begin());
-        std::copy(in.begin(), in.end(), history.begin() + keep);
-    }
-}
+    if (line.size() != T - 1) line.assign(T - 1, 0.0f);
+    line.resize(T - 1 + n);
+    std::copy(in, in + n, line.begin() + (T - 1));
 
-std::vector<float> AMDemodulator::resample(const std::vector<float>& in, double inRate, double outRate)
-{
-    if (in.empty()) return in;
-    double ratio = inRate / outRate;
-    size_t outN = static_cast<size_t>(in.size() / ratio);
-    std::vector<float> out;
-    out.reserve(outN);
-    for (size_t i = 0; i < outN; i++) {
-        double pos = i * ratio;
-        size_t idx = static_cast<size_t>(pos);
-        double frac = pos - idx;
-        if (idx + 1 < in.size())
-            out.push_back(static_cast<float>(in[idx] * (1.0 - frac) + in[idx + 1] * frac));
-        else if (idx < in.size())
-            out.push_back(in[idx]);
-    }
-    return out;
+    out.resize(n);
+    for (size_t i = 0; i < n; i++) out[i] = dotProduct(line.data() + i, taps.data(), T);
+
+    std::copy(line.end() - (T - 1), line.end(), line.begin());
+    line.resize(T - 1);
 }
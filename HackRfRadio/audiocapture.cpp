@@ -1,5 +1,6 @@
 #include "audiocapture.h"
 #include <QDebug>
+#include <QDateTime>
 
 #if defined(Q_OS_IOS)
 #include <AVFoundation/AVFoundation.h>
@@ -163,9 +164,14 @@ void AudioCapture::onReadyRead()
 
     if (!monoSamples.empty()) {
         std::lock_guard<std::mutex> lock(m_accMutex);
+        if (m_accumulator.empty()) {
+            // The newest sample was captured about now
+            m_accumulatorTimeUs = QDateTime::currentMSecsSinceEpoch() * 1000 -
+                                  static_cast<qint64>(monoSamples.size()) * 1000000 / m_format.sampleRate();
+        }
         m_accumulator.insert(m_accumulator.end(), monoSamples.begin(), monoSamples.end());
         if (m_accumulator.size() >= SEND_THRESHOLD) {
-            emit audioDataReady(m_accumulator);
+            emit audioDataReady(m_accumulator, m_accumulatorTimeUs);
             m_accumulator.clear();
         }
     }
@@ -176,7 +182,7 @@ void AudioCapture::onFlushTimer()
     if (!m_running.load()) return;
     std::lock_guard<std::mutex> lock(m_accMutex);
     if (!m_accumulator.empty()) {
-        emit audioDataReady(m_accumulator);
+        emit audioDataReady(m_accumulator, m_accumulatorTimeUs);
         m_accumulator.clear();
     }
 }
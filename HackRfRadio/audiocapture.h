@@ -23,9 +23,11 @@ public:
     bool start();
     void stop();
     bool isRunning() const { return m_running.load(); }
+    int sampleRate() const { return m_format.sampleRate(); }
 
 signals:
-    void audioDataReady(const std::vector<float>& samples);
+    // captureUs: UTC time of the first sample, microseconds
+    void audioDataReady(const std::vector<float>& samples, qint64 captureUs);
 
 private slots:
     void onReadyRead();
@@ -39,6 +41,7 @@ private:
     std::atomic<bool> m_running{false};
 
     std::vector<float> m_accumulator;
+    qint64 m_accumulatorTimeUs = 0;     // capture time of its first sample
     std::mutex m_accMutex;
 
     int m_inputChannels = 1;
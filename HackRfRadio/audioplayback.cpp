@@ -2,16 +2,13 @@
 #include <QDebug>
 #include <QMediaDevices>
 #include <QAudioDevice>
-#include <cstring>
-#include <cmath>
 #include <algorithm>
 
 AudioPlayback::AudioPlayback(QObject *parent)
     : QObject(parent)
+    , m_ring(2, RING_FRAMES)
+    , m_device(&m_ring, SAMPLE_RATE)
 {
-    m_ring.resize(RING_SIZE, 0.0f);
-    m_outputBuffer.resize(CHUNK_SIZE * 2 * sizeof(qint16));
-
     // Stereo Int16 at 48kHz - matches HackTvGui AudioOutput
     m_format.setSampleRate(SAMPLE_RATE);
     m_format.setChannelCount(2);
@@ -31,17 +28,22 @@ bool AudioPlayback::initAudioSink()
         return false;
     }
 
-
     m_audioSink = std::make_unique<QAudioSink>(outputDevice, m_format);
-    m_audioSink->setBufferSize(48000 * 2 * 2); // 500ms stereo buffer — low latency
-
-    m_ioDevice = m_audioSink->start();
-    if (!m_ioDevice || !m_ioDevice->isOpen()) {
-        qDebug() << "Failed to start audio sink";
+    // Small device buffer: the jitter margin lives in the ring
+    m_audioSink->setBufferSize(SAMPLE_RATE * AudioRingDevice::SINK_BUFFER_MS / 1000 * 2 * sizeof(qint16));
+
+    m_ring.reset();
+    m_device.open(QIODevice::ReadOnly);
+    m_audioSink->start(&m_device);
+    if (m_audioSink->error() != QAudio::NoError) {
+        qDebug() << "Failed to start audio sink" << m_audioSink->error();
         m_audioSink.reset();
+        m_device.close();
         return false;
     }
 
+    qDebug() << "Audio: pull mode, sink buffer" << m_audioSink->bufferSize() << "bytes, target"
+             << m_device.targetLatencyMs() << "ms";
     return true;
 }
 
@@ -55,14 +57,6 @@ bool AudioPlayback::start()
 
     // Apply stored volume to the sink
     m_audioSink->setVolume(static_cast<qreal>(m_volume.load()));
-
-    // Writer thread - uses QThread::create to avoid moveToThread issues
-    m_writerThread.setObjectName("AudioWriter");
-    QObject::connect(&m_writerThread, &QThread::started, [this]() {
-        writerLoop();
-    });
-    m_writerThread.start();
-
     return true;
 }
 
@@ -71,64 +65,31 @@ void AudioPlayback::stop()
     if (!m_running.load()) return;
 
     m_running.store(false);
-    m_queueNotEmpty.wakeAll();
-
-    if (m_writerThread.isRunning()) {
-        m_writerThread.quit();
-        m_writerThread.wait(2000);
-        if (m_writerThread.isRunning()) {
-            m_writerThread.terminate();
-            m_writerThread.wait();
-        }
-    }
-
-    if (m_ioDevice) {
-        m_ioDevice = nullptr;
-    }
 
     if (m_audioSink) {
         m_audioSink->stop();
         m_audioSink.reset();
     }
-
-    // Reset ring buffer
-    m_writePos = 0;
-    m_readPos = 0;
-    m_bufferSize = 0;
-
+    m_device.close();
+    m_ring.reset();
 }
 
-void AudioPlayback::enqueueAudio(const std::vector<float>& samples)
+void AudioPlayback::enqueueAudio(const float* samples, size_t count)
 {
-    if (!m_running.load() || samples.empty()) return;
-
-    QMutexLocker locker(&m_mutex);
-
-    size_t samplesToAdd = samples.size();
+    if (!m_running.load() || count < 2) return;
 
-    // Overflow: drop oldest data
-    if (m_bufferSize + samplesToAdd > MAX_QUEUE_SIZE) {
-        size_t overflow = (m_bufferSize + samplesToAdd) - MAX_QUEUE_SIZE;
-        m_readPos = (m_readPos + overflow) % RING_SIZE;
-        m_bufferSize -= overflow;
-    }
+    const size_t lost = m_ring.write(samples, count / 2);
+    if (lost > 0) m_device.countOverrun(lost);
+}
 
-    // Batch copy into ring (handle wrap)
-    size_t firstChunk = std::min(samplesToAdd, RING_SIZE - m_writePos);
-    std::copy(samples.begin(), samples.begin() + firstChunk,
-              m_ring.begin() + m_writePos);
-
-    if (samplesToAdd > firstChunk) {
-        size_t secondChunk = samplesToAdd - firstChunk;
-        std::copy(samples.begin() + firstChunk, samples.end(),
-                  m_ring.begin());
-        m_writePos = secondChunk;
-    } else {
-        m_writePos = (m_writePos + firstChunk) % RING_SIZE;
+double AudioPlayback::latencyMs() const
+{
+    double ms = m_device.bufferedMs();
+    if (m_audioSink) {
+        const qint64 queued = m_audioSink->bufferSize() - m_audioSink->bytesFree();
+        ms += std::max<qint64>(0, queued) * 1000.0 / (SAMPLE_RATE * 2 * sizeof(qint16));
     }
-
-    m_bufferSize += samplesToAdd;
-    m_queueNotEmpty.wakeOne();
+    return ms;
 }
 
 void AudioPlayback::setVolume(float vol)
@@ -140,99 +101,3 @@ void AudioPlayback::setVolume(float vol)
         m_audioSink->setVolume(static_cast<qreal>(vol));
     }
 }
-
-void AudioPlayback::writerLoop()
-{
-    bool bufferPrimed = false;
-    std::vector<float> chunk;
-    chunk.reserve(CHUNK_SIZE);
-
-    while (m_running.load()) {
-        chunk.clear();
-
-        {
-            QMutexLocker locker(&m_mutex);
-
-            // Buffer priming - wait for 100ms of data before starting
-            if (!bufferPrimed) {
-                if (m_bufferSize < MIN_BUFFER_SAMPLES) {
-                    m_queueNotEmpty.wait(&m_mutex, 100);
-                    continue;
-                }
-                bufferPrimed = true;
-            }
-
-            // Underrun - re-prime
-            if (m_bufferSize < CHUNK_SIZE) {
-                bufferPrimed = false;
-                m_queueNotEmpty.wait(&m_mutex, 50);
-                continue;
-            }
-
-            // Batch read from ring
-            size_t firstChunk = std::min<size_t>(CHUNK_SIZE, RING_SIZE - m_readPos);
-            chunk.insert(chunk.end(),
-                         m_ring.begin() + m_readPos,
-                         m_ring.begin() + m_readPos + firstChunk);
-
-            if (CHUNK_SIZE > firstChunk) {
-                size_t secondChunk = CHUNK_SIZE - firstChunk;
-                chunk.insert(chunk.end(),
-                             m_ring.begin(),
-                             m_ring.begin() + secondChunk);
-                m_readPos = secondChunk;
-            } else {
-                m_readPos = (m_readPos + firstChunk) % RING_SIZE;
-            }
-
-            m_bufferSize -= CHUNK_SIZE;
-        }
-
-        if (!chunk.empty()) {
-            writeChunk(chunk);
-        }
-    }
-}
-
-void AudioPlayback::writeChunk(const std::vector<float>& audioData)
-{
-    if (!m_ioDevice || !m_audioSink || audioData.empty()) return;
-
-    // audioData is already interleaved stereo [L,R,L,R,...] from demodulator
-    // Just convert float → int16
-    size_t requiredSize = audioData.size() * sizeof(qint16);
-    if (static_cast<size_t>(m_outputBuffer.size()) < requiredSize) {
-        m_outputBuffer.resize(requiredSize);
-    }
-
-    qint16* output = reinterpret_cast<qint16*>(m_outputBuffer.data());
-
-    for (size_t i = 0; i < audioData.size(); ++i) {
-        float sample = std::clamp(audioData[i], -1.0f, 1.0f);
-        output[i] = static_cast<qint16>(sample * 32767.0f);
-    }
-
-    qint64 bytesToWrite = static_cast<qint64>(requiredSize);
-    qint64 bytesWritten = 0;
-
-    // Blocking write - wait for audio sink space
-    while (bytesWritten < bytesToWrite && m_running.load()) {
-        qint64 remaining = bytesToWrite - bytesWritten;
-        if (m_audioSink->bytesFree() < remaining) {
-            QThread::msleep(5);
-            continue;
-        }
-
-        qint64 written = m_ioDevice->write(
-            m_outputBuffer.constData() + bytesWritten, remaining);
-
-        if (written > 0) {
-            bytesWritten += written;
-        } else if (written < 0) {
-            qCritical() << "Audio write error";
-            break;
-        } else {
-            QThread::msleep(1);
-        }
-    }
-}
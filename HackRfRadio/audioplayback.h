@@ -4,14 +4,14 @@
 #include <QObject>
 #include <QAudioSink>
 #include <QAudioFormat>
-#include <QIODevice>
-#include <QMutex>
-#include <QWaitCondition>
-#include <QThread>
 #include <vector>
 #include <atomic>
 #include <memory>
+#include "audioring.h"
 
+// RX audio out: interleaved stereo float at 48 kHz, played through a
+// QAudioSink in pull mode from a lock-free ring (see AudioRing). Feed it
+// from one thread at a time.
 class AudioPlayback : public QObject
 {
     Q_OBJECT
@@ -22,40 +22,32 @@ public:
 
     bool start();
     void stop();
-    void enqueueAudio(const std::vector<float>& samples);
+    void enqueueAudio(const std::vector<float>& samples) { enqueueAudio(samples.data(), samples.size()); }
+    void enqueueAudio(const float* samples, size_t count);
     bool isRunning() const { return m_running.load(); }
 
     void setVolume(float vol); // 0.0 - 1.0
 
+    // Audio held back for jitter, ring only; default 20 ms
+    void setTargetLatency(int ms) { m_device.setTargetLatency(ms); }
+    // Ring plus what the sink has queued
+    double latencyMs() const;
+    quint64 underruns() const { return m_device.underruns(); }
+    quint64 droppedFrames() const { return m_device.droppedFrames(); }
+
 private:
     bool initAudioSink();
-    void writerLoop();
-    void writeChunk(const std::vector<float>& chunk);
-
-    QAudioFormat m_format;
-    std::unique_ptr<QAudioSink> m_audioSink;
-    QIODevice* m_ioDevice = nullptr;
 
-    // Ring buffer - large for TCP jitter absorption
-    static constexpr size_t RING_SIZE = 480000;          // 10s at 48kHz
-    static constexpr size_t CHUNK_SIZE = 1024;           // samples per write
-    static constexpr size_t MIN_BUFFER_SAMPLES = 2400;   // 50ms priming
-    static constexpr size_t MAX_QUEUE_SIZE = 240000;     // 5s max
     static constexpr int SAMPLE_RATE = 48000;
+    static constexpr size_t RING_FRAMES = 16384;         // 340 ms, well over the target
 
-    std::vector<float> m_ring;
-    size_t m_writePos = 0;
-    size_t m_readPos = 0;
-    size_t m_bufferSize = 0;
-
-    mutable QMutex m_mutex;
-    QWaitCondition m_queueNotEmpty;
+    QAudioFormat m_format;
+    std::unique_ptr<QAudioSink> m_audioSink;
+    AudioRing m_ring;
+    AudioRingDevice m_device;
 
     std::atomic<bool> m_running{false};
     std::atomic<float> m_volume{0.5f};
-
-    QThread m_writerThread;
-    QByteArray m_outputBuffer;
 };
 
 #endif // AUDIOPLAYBACK_H
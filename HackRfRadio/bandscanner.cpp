@@ -0,0 +1,407 @@
+#include "bandscanner.h"
+#include <QFile>
+#include <QTextStream>
+#include <QDebug>
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+constexpr int MAX_CHANNELS = 100000;
+constexpr int DC_GUARD_BINS = 1;        // LO leakage of the zero-IF front end
+constexpr float ADJACENT_REJECT_DB = 20.0f;
+
+} // namespace
+
+BandScanner::BandScanner(QObject *parent)
+    : QObject(parent)
+{
+    m_config.bands = defaultBands();
+}
+
+BandScanner::~BandScanner() = default;
+
+QVector<BandScanner::Band> BandScanner::defaultBands()
+{
+    QVector<Band> bands;
+    bands.append({"PMR446", 446006250ULL, 446193750ULL, 12500, 12500});
+    bands.append({"2m", 144000000ULL, 146000000ULL, 12500, 12500});
+    bands.append({"70cm", 430000000ULL, 440000000ULL, 12500, 12500});
+    return bands;
+}
+
+QVector<BandScanner::Band> BandScanner::parseBands(const QStringList& list)
+{
+    QVector<Band> bands;
+    for (const QString& entry : list) {
+        const QStringList f = entry.split(':');
+        if (f.size() != 5) continue;
+        Band band;
+        band.label = f[0];
+        band.start = f[1].toULongLong();
+        band.stop = f[2].toULongLong();
+        band.step = f[3].toUInt();
+        band.bandwidth = f[4].toUInt();
+        if (band.start == 0 || band.stop < band.start || band.step == 0 || band.bandwidth == 0) continue;
+        bands.append(band);
+    }
+    return bands;
+}
+
+QStringList BandScanner::formatBands(const QVector<Band>& bands)
+{
+    QStringList list;
+    for (const Band& b : bands)
+        list << QString("%1:%2:%3:%4:%5").arg(b.label).arg(b.start).arg(b.stop).arg(b.step).arg(b.bandwidth);
+    return list;
+}
+
+QVector<BandScanner::Channel> BandScanner::parseChannels(const QStringList& list)
+{
+    QVector<Channel> channels;
+    for (const QString& entry : list) {
+        const QStringList f = entry.split(':');
+        if (f.size() < 2 || f.size() > 3) continue;
+        Channel channel;
+        channel.frequency = f[0].toULongLong();
+        channel.bandwidth = f[1].toUInt();
+        if (f.size() == 3) channel.label = f[2];
+        if (channel.frequency == 0 || channel.bandwidth == 0) continue;
+        channels.append(channel);
+    }
+    return channels;
+}
+
+QStringList BandScanner::formatChannels(const QVector<Channel>& channels)
+{
+    QStringList list;
+    for (const Channel& c : channels) {
+        QString entry = QString("%1:%2").arg(c.frequency).arg(c.bandwidth);
+        if (!c.label.isEmpty()) entry += ":" + c.label;
+        list << entry;
+    }
+    return list;
+}
+
+void BandScanner::setConfig(const Config& config)
+{
+    m_config = config;
+    m_config.dwellMs = std::clamp(m_config.dwellMs, MIN_DWELL_MS, MAX_DWELL_MS);
+    m_config.settleMs = std::max(0, m_config.settleMs);
+    m_config.priorityEvery = std::max(1, m_config.priorityEvery);
+    m_config.usableSpan = std::clamp(m_config.usableSpan, 0.1, 1.0);
+}
+
+void BandScanner::buildPlan(const QVector<Channel>& watch)
+{
+    m_channels.clear();
+    m_hops.clear();
+
+    for (const Band& band : m_config.bands) {
+        for (quint64 f = band.start; f <= band.stop && m_channels.size() < MAX_CHANNELS; f += band.step) {
+            ChannelState state;
+            state.channel.frequency = f;
+            state.channel.bandwidth = band.bandwidth;
+            state.channel.label = band.label;
+            m_channels.push_back(state);
+        }
+    }
+    auto byFrequency = [](const ChannelState& a, const ChannelState& b) {
+        return a.channel.frequency < b.channel.frequency;
+    };
+    auto sameFrequency = [](const ChannelState& a, const ChannelState& b) {
+        return a.channel.frequency == b.channel.frequency;
+    };
+    std::stable_sort(m_channels.begin(), m_channels.end(), byFrequency);
+    m_channels.erase(std::unique(m_channels.begin(), m_channels.end(), sameFrequency), m_channels.end());
+    const int regular = static_cast<int>(m_channels.size());
+    planHops(0, regular, false);
+    m_regularHops = static_cast<int>(m_hops.size());
+
+    auto addPriority = [this](const QVector<Channel>& list) {
+        for (const Channel& channel : list) {
+            ChannelState state;
+            state.channel = channel;
+            state.priority = true;
+            m_channels.push_back(state);
+        }
+    };
+    addPriority(m_config.priority);
+    addPriority(watch);
+    std::stable_sort(m_channels.begin() + regular, m_channels.end(), byFrequency);
+    planHops(regular, static_cast<int>(m_channels.size()) - regular, true);
+}
+
+void BandScanner::planHops(int first, int count, bool priority)
+{
+    // Greedy: a hop starts at the lower edge of the first channel not yet
+    // covered and takes every following channel that ends inside the span,
+    // less one channel width of room to keep the LO off a channel
+    const double span = m_sampleRate * m_config.usableSpan;
+    const int end = first + count;
+    int i = first;
+    while (i < end) {
+        const Channel& c = m_channels[i].channel;
+        const double lo = static_cast<double>(c.frequency) - c.bandwidth / 2.0;
+        double hi = static_cast<double>(c.frequency) + c.bandwidth / 2.0;
+        int j = i + 1;
+        while (j < end) {
+            const Channel& next = m_channels[j].channel;
+            const double top = static_cast<double>(next.frequency) + next.bandwidth / 2.0;
+            if (top - lo + next.bandwidth > span) break;
+            hi = std::max(hi, top);
+            j++;
+        }
+
+        // Middle of the group; a channel sitting on DC moves to its upper
+        // edge, so the LO spur lands between two channels
+        double center = (lo + hi) / 2.0;
+        for (int k = i; k < j; k++) {
+            const Channel& d = m_channels[k].channel;
+            if (std::fabs(static_cast<double>(d.frequency) - center) < d.bandwidth / 2.0) {
+                center = static_cast<double>(d.frequency) + d.bandwidth / 2.0;
+                break;
+            }
+        }
+
+        Hop hop;
+        hop.center = static_cast<quint64>(std::llround(center));
+        hop.first = i;
+        hop.count = j - i;
+        hop.coveredHz = hi - lo;
+        hop.priority = priority;
+        m_hops.push_back(hop);
+        i = j;
+    }
+}
+
+bool BandScanner::start(quint64 currentFrequency, const QVector<Channel>& watch)
+{
+    if (m_running) stop();
+    if (m_sampleRate <= 0.0) return false;
+
+    buildPlan(watch);
+    if (m_hops.empty()) {
+        qDebug() << "[BandScanner] nothing to scan";
+        return false;
+    }
+
+    // Bins of at most a quarter of the narrowest channel
+    quint32 narrowest = m_channels.front().channel.bandwidth;
+    for (const ChannelState& c : m_channels) narrowest = std::min(narrowest, c.channel.bandwidth);
+    SpectrumAnalyzer::Config ac;
+    ac.size = SpectrumAnalyzer::MIN_SIZE;
+    while (ac.size < SpectrumAnalyzer::MAX_SIZE && m_sampleRate / ac.size > narrowest / 4.0) ac.size <<= 1;
+    ac.fps = std::clamp(1000 / m_config.dwellMs, 1, SpectrumAnalyzer::MAX_FPS);
+    const double dwellSamples = m_sampleRate * m_config.dwellMs / 1000.0;
+    ac.averages = std::clamp(static_cast<int>(dwellSamples / ac.size), 1, MAX_AVERAGES);
+    if (!m_analyzer || !(m_analyzer->config() == ac)) m_analyzer = std::make_unique<SpectrumAnalyzer>(ac);
+
+    m_info = IqCodec::BlockInfo();
+    m_info.sampleRate = static_cast<uint32_t>(m_sampleRate);
+    m_frames.clear();
+
+    if (!m_logPath.isEmpty()) {
+        m_log = std::make_unique<QFile>(m_logPath);
+        if (!m_log->open(QIODevice::WriteOnly | QIODevice::Append | QIODevice::Text)) {
+            qDebug() << "[BandScanner] cannot log to" << m_logPath << m_log->errorString();
+            m_log.reset();
+        } else if (m_log->size() == 0) {
+            m_log->write("time,frequency_hz,bandwidth_hz,label,level_dbfs,snr_db,state,priority\n");
+        }
+    }
+
+    m_running = true;
+    m_tuned = currentFrequency;
+    m_nextRegular = 0;
+    m_nextPriority = 0;
+    m_sincePriority = 0;
+    m_sweepCoveredHz = 0.0;
+    m_retuneSumMs = 0.0;
+    m_retunes = 0;
+    m_sweepTimer.start();
+    m_hop = 0;
+    if (m_regularHops == 0) m_nextPriority = 1 % static_cast<int>(m_hops.size());
+    beginHop();
+
+    qDebug() << "[BandScanner]" << m_channels.size() << "channels in" << m_hops.size() << "hops,"
+             << ac.size << "point FFT," << ac.averages << "averages per" << m_config.dwellMs << "ms";
+    return true;
+}
+
+void BandScanner::stop()
+{
+    if (!m_running) return;
+    m_running = false;
+    m_state = Idle;
+    for (ChannelState& c : m_channels) c.open = false;
+    if (m_log) {
+        m_log->close();
+        m_log.reset();
+    }
+}
+
+void BandScanner::beginHop()
+{
+    const Hop& hop = m_hops[m_hop];
+    m_info.epoch++;
+    m_info.frequency = hop.center;
+    m_frames.clear();
+
+    // A single hop stays put: no retune, so nothing to wait for
+    if (hop.center == m_tuned) {
+        m_state = Dwelling;
+        return;
+    }
+    m_tuned = hop.center;
+    m_state = Retuning;
+    m_retuneTimer.start();
+    emit retuneRequested(hop.center);
+}
+
+void BandScanner::onRetuned()
+{
+    if (!m_running || m_state != Retuning || !m_confirmRetune) return;
+    m_retuneSumMs += m_retuneTimer.elapsed();
+    m_retunes++;
+    m_state = Dwelling;
+}
+
+void BandScanner::processIq(const QByteArray& data)
+{
+    if (!m_running || data.isEmpty()) return;
+
+    if (m_state == Retuning) {
+        const qint64 ms = m_retuneTimer.elapsed();
+        if (m_confirmRetune) {
+            if (ms < RETUNE_TIMEOUT_MS) return;
+            qDebug() << "[BandScanner] no retune confirmation for" << m_tuned << "Hz after" << ms << "ms";
+        } else if (ms < m_config.settleMs) {
+            return;
+        }
+        m_retuneSumMs += ms;
+        m_retunes++;
+        m_state = Dwelling;
+    }
+
+    m_analyzer->process(reinterpret_cast<const int8_t*>(data.constData()),
+                        static_cast<size_t>(data.size()), m_info, m_frames);
+    if (m_frames.empty()) return;
+    const SpectrumAnalyzer::Frame frame = std::move(m_frames.back());
+    m_frames.clear();
+    finishHop(frame);
+}
+
+void BandScanner::finishHop(const SpectrumAnalyzer::Frame& frame)
+{
+    const Hop hop = m_hops[m_hop];     // slots below may restart the plan
+    const int N = static_cast<int>(frame.db.size());
+    const double binHz = m_sampleRate / N;
+    const int dc = N / 2;
+
+    m_power.resize(N);
+    for (int k = 0; k < N; k++) m_power[k] = std::pow(10.0f, frame.db[k] * 0.1f);
+
+    // Noise floor: median bin of the usable span, robust to a few busy channels
+    const int half = std::min(dc, static_cast<int>(m_sampleRate * m_config.usableSpan / 2.0 / binHz));
+    m_floor.assign(m_power.begin() + (dc - half), m_power.begin() + std::min(N, dc + half + 1));
+    auto mid = m_floor.begin() + m_floor.size() / 2;
+    std::nth_element(m_floor.begin(), mid, m_floor.end());
+    const float floor = std::max(*mid, 1e-20f);
+
+    // Mean power of the channel's bins against the floor
+    m_levelDb.assign(hop.count, -200.0f);
+    m_snrDb.assign(hop.count, -200.0f);
+    for (int n = 0; n < hop.count; n++) {
+        const Channel& c = m_channels[hop.first + n].channel;
+        const double offset = static_cast<double>(c.frequency) - static_cast<double>(hop.center);
+        const double edge = c.bandwidth / 2.0;
+        int lo = dc + static_cast<int>(std::ceil((offset - edge) / binHz));
+        int hi = dc + static_cast<int>(std::floor((offset + edge) / binHz));
+        if (hi < lo) lo = hi = dc + static_cast<int>(std::lround(offset / binHz));
+        lo = std::max(lo, 0);
+        hi = std::min(hi, N - 1);
+
+        double sum = 0.0;
+        int bins = 0;
+        for (int k = lo; k <= hi; k++) {
+            if (std::abs(k - dc) <= DC_GUARD_BINS) continue;
+            sum += m_power[k];
+            bins++;
+        }
+        if (bins == 0) continue;
+        m_levelDb[n] = 10.0f * std::log10(std::max(static_cast<float>(sum), 1e-20f));
+        m_snrDb[n] = 10.0f * std::log10(std::max(static_cast<float>(sum / bins), 1e-20f) / floor);
+    }
+
+    const QDateTime now = QDateTime::currentDateTime();
+    for (int n = 0; n < hop.count; n++) {
+        ChannelState& state = m_channels[hop.first + n];
+        const float threshold = state.open ? m_config.thresholdDb - HYSTERESIS_DB : m_config.thresholdDb;
+        bool open = m_snrDb[n] >= threshold;
+
+        // Window skirts and splatter of a much stronger neighbour are not
+        // activity of their own
+        for (int m : {n - 1, n + 1}) {
+            if (!open || m < 0 || m >= hop.count) continue;
+            const Channel& a = state.channel;
+            const Channel& b = m_channels[hop.first + m].channel;
+            const double spacing = std::fabs(static_cast<double>(a.frequency) - static_cast<double>(b.frequency));
+            if (spacing <= (a.bandwidth + b.bandwidth) * 0.75 && m_levelDb[m] - m_levelDb[n] > ADJACENT_REJECT_DB)
+                open = false;
+        }
+        if (open == state.open) continue;
+        state.open = open;
+
+        Activity a;
+        a.time = now;
+        a.frequency = state.channel.frequency;
+        a.bandwidth = state.channel.bandwidth;
+        a.label = state.channel.label;
+        a.levelDb = m_levelDb[n];
+        a.snrDb = m_snrDb[n];
+        a.open = open;
+        a.priority = state.priority;
+        writeLog(a);
+        emit activity(a);
+    }
+
+    // A wrap of the regular hops is one sweep
+    if (!hop.priority) {
+        m_sweepCoveredHz += hop.coveredHz;
+        m_nextRegular = (m_hop + 1) % m_regularHops;
+        if (m_nextRegular == 0) {
+            const double ms = std::max<qint64>(1, m_sweepTimer.restart());
+            m_sweepRateMHz = m_sweepCoveredHz / 1e6 / (ms / 1000.0);
+            m_retuneMs = m_retunes > 0 ? m_retuneSumMs / m_retunes : 0.0;
+            emit sweepCompleted(m_sweepRateMHz, ms, m_retuneMs);
+            m_sweepCoveredHz = 0.0;
+            m_retuneSumMs = 0.0;
+            m_retunes = 0;
+        }
+    }
+    if (!m_running) return;
+
+    const int priorityHops = static_cast<int>(m_hops.size()) - m_regularHops;
+    const bool priorityTurn = m_regularHops == 0 ||
+                              (!hop.priority && ++m_sincePriority >= m_config.priorityEvery);
+    if (priorityHops > 0 && priorityTurn) {
+        m_sincePriority = 0;
+        m_hop = m_regularHops + m_nextPriority;
+        m_nextPriority = (m_nextPriority + 1) % priorityHops;
+    } else {
+        m_hop = m_nextRegular;
+    }
+    beginHop();
+}
+
+void BandScanner::writeLog(const Activity& a)
+{
+    if (!m_log) return;
+    QTextStream out(m_log.get());
+    out << a.time.toString(Qt::ISODateWithMs) << ','
+        << a.frequency << ',' << a.bandwidth << ',' << a.label << ','
+        << QString::number(a.levelDb, 'f', 1) << ',' << QString::number(a.snrDb, 'f', 1) << ','
+        << (a.open ? "open" : "closed") << ',' << (a.priority ? 1 : 0) << '\n';
+    out.flush();
+}
@@ -0,0 +1,182 @@
+#ifndef BANDSCANNER_H
+#define BANDSCANNER_H
+
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QByteArray>
+#include <memory>
+#include <vector>
+#include "spectrumanalyzer.h"
+
+class QFile;
+
+// Channel activity scanner over a list of band plans.
+//
+// The channels of all bands are packed into hops: each hop is one tuning
+// whose usable span (the middle of the capture, clear of the baseband
+// filter edges) holds as many channels as fit. Per hop the scanner asks
+// for a retune, drops what still comes from the old frequency, then takes
+// one averaged wideband FFT over the dwell (SpectrumAnalyzer, the same
+// scale as the spectrum display). Every channel of the hop is measured
+// from that one spectrum: the mean power of its bins against the median
+// bin of the span, so the threshold follows the noise floor and gain
+// changes. Channels crossing the threshold (with hysteresis) are reported
+// with a timestamp and appended to a CSV log.
+//
+// Stale samples: with binary control the TcpClient drops blocks of older
+// tuning epochs and signals retuned(); call onRetuned() from there. On a
+// local device HackTvGui drops blocks older than HackTvLib's tuneEpoch()
+// and calls onRetuned() with the first current one. On the text protocol
+// the only handle is time, so everything arriving within 'settleMs' of
+// the request is dropped.
+//
+// Priority channels get a hop of their own after every 'priorityEvery'
+// regular hops. Works on the raw int8 blocks, on the GUI thread.
+class BandScanner : public QObject
+{
+    Q_OBJECT
+
+public:
+    struct Band {
+        QString label;
+        quint64 start = 0;          // first channel centre, Hz
+        quint64 stop = 0;           // last channel centre, Hz
+        quint32 step = 12500;
+        quint32 bandwidth = 12500;
+    };
+
+    struct Channel {
+        quint64 frequency = 0;
+        quint32 bandwidth = 12500;
+        QString label;
+    };
+
+    struct Config {
+        QVector<Band> bands;
+        QVector<Channel> priority;
+        int dwellMs = 50;           // spectrum integration per hop
+        int settleMs = 60;          // text control: blocks dropped after a retune
+        int priorityEvery = 4;      // regular hops between priority hops
+        float thresholdDb = 10.0f;  // channel over the median bin
+        double usableSpan = 0.8;    // share of the sample rate used per hop
+    };
+
+    struct Activity {
+        QDateTime time;
+        quint64 frequency = 0;
+        quint32 bandwidth = 0;
+        QString label;
+        float levelDb = -200.0f;    // in-band power, dBFS
+        float snrDb = 0.0f;         // over the span's median bin
+        bool open = false;          // false: the channel went quiet
+        bool priority = false;
+    };
+
+    static constexpr int MIN_DWELL_MS = 20;
+    static constexpr int MAX_DWELL_MS = 1000;
+    static constexpr int MAX_AVERAGES = 16;
+    static constexpr int RETUNE_TIMEOUT_MS = 500;
+    static constexpr float HYSTERESIS_DB = 3.0f;
+
+    explicit BandScanner(QObject *parent = nullptr);
+    ~BandScanner();
+
+    // Used from the next start()
+    void setConfig(const Config& config);
+    const Config& config() const { return m_config; }
+    void setSampleRate(double rate) { m_sampleRate = rate; }
+    // true: wait for onRetuned() (binary control), else settleMs
+    void setRetuneConfirmation(bool on) { m_confirmRetune = on; }
+    // CSV of the activity, appended while scanning; empty = no log
+    void setLogFile(const QString& path) { m_logPath = path; }
+
+    // 'watch': priority channels for this run only, on top of the config's
+    bool start(quint64 currentFrequency, const QVector<Channel>& watch = {});
+    void stop();
+    bool isRunning() const { return m_running; }
+
+    // TcpClient::retuned: the next blocks are at the requested frequency
+    void onRetuned();
+    void processIq(const QByteArray& data);
+
+    int hopCount() const { return static_cast<int>(m_hops.size()); }
+    double sweepRateMHz() const { return m_sweepRateMHz; }
+    double retuneMs() const { return m_retuneMs; }
+
+    // "label:start:stop:step:bandwidth" and "frequency:bandwidth[:label]"
+    static QVector<Band> parseBands(const QStringList& list);
+    static QStringList formatBands(const QVector<Band>& bands);
+    static QVector<Channel> parseChannels(const QStringList& list);
+    static QStringList formatChannels(const QVector<Channel>& channels);
+    static QVector<Band> defaultBands();
+
+signals:
+    void retuneRequested(quint64 frequency);
+    void activity(const BandScanner::Activity& activity);
+    // One pass over the regular hops: scanned MHz per second and the mean
+    // time from retune request to the first fresh block
+    void sweepCompleted(double mhzPerSecond, double sweepMs, double retuneMs);
+
+private:
+    struct ChannelState {
+        Channel channel;
+        bool priority = false;
+        bool open = false;
+    };
+
+    struct Hop {
+        quint64 center = 0;
+        int first = 0;              // into m_channels
+        int count = 0;
+        double coveredHz = 0.0;
+        bool priority = false;
+    };
+
+    enum State { Idle, Retuning, Dwelling };
+
+    void buildPlan(const QVector<Channel>& watch);
+    void planHops(int first, int count, bool priority);
+    void beginHop();
+    void finishHop(const SpectrumAnalyzer::Frame& frame);
+    void writeLog(const Activity& a);
+
+    Config m_config;
+    double m_sampleRate = 0.0;
+    bool m_confirmRetune = false;
+    QString m_logPath;
+    std::unique_ptr<QFile> m_log;
+
+    std::vector<ChannelState> m_channels;
+    std::vector<Hop> m_hops;
+    int m_regularHops = 0;          // hops [0, m_regularHops) are regular
+
+    std::unique_ptr<SpectrumAnalyzer> m_analyzer;
+    std::vector<SpectrumAnalyzer::Frame> m_frames;
+    IqCodec::BlockInfo m_info;      // epoch bumped per hop restarts the analyzer
+    std::vector<float> m_power;     // linear bins of the last frame
+    std::vector<float> m_floor;     // scratch for the median
+    std::vector<float> m_levelDb;   // per channel of the hop
+    std::vector<float> m_snrDb;
+
+    bool m_running = false;
+    State m_state = Idle;
+    quint64 m_tuned = 0;
+    int m_hop = 0;                  // current hop
+    int m_nextRegular = 0;
+    int m_nextPriority = 0;
+    int m_sincePriority = 0;
+
+    QElapsedTimer m_retuneTimer;
+    QElapsedTimer m_sweepTimer;
+    double m_sweepCoveredHz = 0.0;
+    double m_retuneSumMs = 0.0;
+    int m_retunes = 0;
+    double m_sweepRateMHz = 0.0;
+    double m_retuneMs = 0.0;
+};
+
+#endif // BANDSCANNER_H
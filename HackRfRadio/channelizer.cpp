@@ -0,0 +1,312 @@
+#include "channelizer.h"
+#include <algorithm>
+#include <cmath>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#include <xmmintrin.h>
+#define CHANNELIZER_SSE 1
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define CHANNELIZER_NEON 1
+#endif
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+namespace {
+
+// Bins between the passband edge and Nc/2 for the Kaiser filter below
+constexpr double TRANSITION_BINS = 16.0;
+constexpr double KAISER_BETA = 6.0;     // ~60 dB stopband
+
+double besselI0(double x)
+{
+    double sum = 1.0, term = 1.0;
+    const double q = x * x / 4.0;
+    for (int k = 1; k < 32; k++) {
+        term *= q / (static_cast<double>(k) * k);
+        sum += term;
+        if (term < sum * 1e-12) break;
+    }
+    return sum;
+}
+
+} // namespace
+
+Channelizer::Channelizer()
+    : m_inputRate(0.0)
+    , m_size(0)
+    , m_hop(0)
+    , m_generation(0)
+    , m_fill(0)
+    , m_frames(0)
+{
+}
+
+std::vector<uint32_t> Channelizer::bitReverseTable(int n)
+{
+    int bits = 0;
+    while ((1 << bits) < n) bits++;
+    std::vector<uint32_t> table(n);
+    for (int i = 0; i < n; i++) {
+        uint32_t r = 0;
+        for (int b = 0; b < bits; b++) {
+            if (i & (1 << b)) r |= 1u << (bits - 1 - b);
+        }
+        table[i] = r;
+    }
+    return table;
+}
+
+void Channelizer::setInputRate(double rate)
+{
+    if (rate <= 0.0) return;
+
+    int n = MIN_FFT;
+    while (n < MAX_FFT && rate / n > TARGET_BIN_HZ) n <<= 1;
+
+    m_inputRate = rate;
+    m_size = n;
+    m_hop = n - n / 4;
+    m_generation++;
+
+    m_bitReverse = bitReverseTable(n);
+
+    // Twiddles per stage, laid out for transform(): stage 'len' starts at
+    // float len - 2 and holds [wr, wr] and [-wi, wi] for each of its len/2
+    // butterflies. They depend on len only, so the channels' small inverse
+    // transforms share them.
+    m_stageRe.assign(2 * n, 0.0f);
+    m_stageIm.assign(2 * n, 0.0f);
+    m_stageImInverse.assign(2 * n, 0.0f);
+    for (int len = 4; len <= n; len <<= 1) {
+        for (int k = 0; k < len / 2; k++) {
+            const double w = -2.0 * M_PI * k / len;
+            const float wr = static_cast<float>(std::cos(w));
+            const float wi = static_cast<float>(std::sin(w));
+            const int j = len - 2 + 2 * k;
+            m_stageRe[j] = wr;      m_stageRe[j + 1] = wr;
+            m_stageIm[j] = -wi;     m_stageIm[j + 1] = wi;
+            m_stageImInverse[j] = wi; m_stageImInverse[j + 1] = -wi;
+        }
+    }
+
+    m_spectra.clear();
+    reset();
+}
+
+void Channelizer::reset()
+{
+    m_frame.assign(m_size, {0.0f, 0.0f});
+    m_fill = m_size - m_hop;
+    m_frames = 0;
+}
+
+void Channelizer::configure(Channel& channel, double offsetHz, double bandwidthHz, double minRate) const
+{
+    channel.bandwidthHz = bandwidthHz;
+    channel.minRate = minRate;
+    channel.generation = m_generation;
+    channel.active = false;
+    if (m_size == 0) return;
+
+    const double bin = binHz();
+    const double passEdge = 0.5 * bandwidthHz + 0.5 * bin;
+    int nc = MIN_CHANNEL_FFT;
+    while (nc < m_size && (nc * bin < minRate || nc / 2.0 - passEdge / bin < TRANSITION_BINS)) nc <<= 1;
+
+    channel.size = nc;
+    channel.passBins = std::min(nc / 2 - 1, static_cast<int>(std::ceil(0.5 * bandwidthHz / bin)));
+    channel.rate = m_inputRate * nc / m_size;
+    channel.bitReverse = bitReverseTable(nc);
+    channel.work.assign(nc, {0.0f, 0.0f});
+
+    // Prototype at the input rate: N/4 + 1 taps fit the overlap of a frame.
+    // Cutoff halfway between the passband edge and Nc/2, where the bins stop.
+    const int taps = m_size / 4 + 1;
+    const double centre = (taps - 1) / 2.0;
+    const double fc = std::min(0.5 * (passEdge + 0.5 * channel.rate), 0.5 * channel.rate) / m_inputRate;
+    const double i0Beta = besselI0(KAISER_BETA);
+    std::vector<double> h(taps);
+    double sum = 0.0;
+    for (int n = 0; n < taps; n++) {
+        const double t = n - centre;
+        const double x = 2.0 * fc * t;
+        const double sinc = (std::abs(x) < 1e-12) ? 1.0 : std::sin(M_PI * x) / (M_PI * x);
+        const double r = t / centre;
+        const double win = besselI0(KAISER_BETA * std::sqrt(std::max(0.0, 1.0 - r * r))) / i0Beta;
+        h[n] = sinc * win;
+        sum += h[n];
+    }
+
+    // Its N-point spectrum at the Nc bins around DC, with the 1/N of the
+    // inverse transform folded in
+    channel.response.resize(nc);
+    const double scale = 1.0 / (sum * m_size);
+    for (int m = 0; m < nc; m++) {
+        const int k = (m < nc / 2) ? m : m - nc;
+        const double w = -2.0 * M_PI * k / m_size;
+        double re = 0.0, im = 0.0;
+        for (int n = 0; n < taps; n++) {
+            re += h[n] * std::cos(w * n);
+            im += h[n] * std::sin(w * n);
+        }
+        channel.response[m] = std::complex<float>(static_cast<float>(re * scale), static_cast<float>(im * scale));
+    }
+
+    setOffset(channel, offsetHz);
+}
+
+void Channelizer::setOffset(Channel& channel, double offsetHz) const
+{
+    channel.offsetHz = offsetHz;
+    if (m_size == 0 || channel.size == 0 || channel.generation != m_generation) {
+        channel.active = false;
+        return;
+    }
+
+    const double bin = binHz();
+    const int k = static_cast<int>(std::lround(offsetHz / bin));
+    channel.bin = k;
+    channel.active = std::abs(offsetHz) + 0.5 * channel.bandwidthHz < 0.5 * m_inputRate &&
+                     std::abs(k) + channel.size / 2 <= m_size / 2;
+
+    // The bins are taken relative to each frame's first sample; frames
+    // start 'hop' samples apart, so the mixer phase steps by k * hop / N
+    const double frameTurn = -2.0 * M_PI * std::fmod(static_cast<double>(k) * m_hop, m_size) / m_size;
+    channel.frameStep = std::polar(1.0f, static_cast<float>(frameTurn));
+    channel.framePhase = {1.0f, 0.0f};
+
+    const double residual = offsetHz - k * bin;
+    channel.fineStep = std::polar(1.0f, static_cast<float>(-2.0 * M_PI * residual / channel.rate));
+    channel.finePhase = {1.0f, 0.0f};
+}
+
+// Iterative radix-2 on bit-reversed input, n a power of two <= N.
+// Two butterflies per step from the per-stage tables (see setInputRate).
+void Channelizer::transform(std::complex<float>* x, int n, bool inverse) const
+{
+    for (int start = 0; start < n; start += 2) {
+        const std::complex<float> a = x[start];
+        const std::complex<float> b = x[start + 1];
+        x[start] = a + b;
+        x[start + 1] = a - b;
+    }
+
+    for (int len = 4; len <= n; len <<= 1) {
+        const int floats = len;     // half butterflies x 2 floats
+        const float* wr = &m_stageRe[len - 2];
+        const float* wi = inverse ? &m_stageImInverse[len - 2] : &m_stageIm[len - 2];
+        for (int start = 0; start < n; start += len) {
+            float* lo = reinterpret_cast<float*>(x + start);
+            float* hi = lo + floats;
+#if defined(CHANNELIZER_SSE)
+            for (int j = 0; j < floats; j += 4) {
+                const __m128 b = _mm_loadu_ps(hi + j);
+                const __m128 bs = _mm_shuffle_ps(b, b, _MM_SHUFFLE(2, 3, 0, 1));
+                const __m128 t = _mm_add_ps(_mm_mul_ps(b, _mm_loadu_ps(wr + j)),
+                                            _mm_mul_ps(bs, _mm_loadu_ps(wi + j)));
+                const __m128 a = _mm_loadu_ps(lo + j);
+                _mm_storeu_ps(lo + j, _mm_add_ps(a, t));
+                _mm_storeu_ps(hi + j, _mm_sub_ps(a, t));
+            }
+#elif defined(CHANNELIZER_NEON)
+            for (int j = 0; j < floats; j += 4) {
+                const float32x4_t b = vld1q_f32(hi + j);
+                const float32x4_t bs = vrev64q_f32(b);
+                const float32x4_t t = vmlaq_f32(vmulq_f32(b, vld1q_f32(wr + j)), bs, vld1q_f32(wi + j));
+                const float32x4_t a = vld1q_f32(lo + j);
+                vst1q_f32(lo + j, vaddq_f32(a, t));
+                vst1q_f32(hi + j, vsubq_f32(a, t));
+            }
+#else
+            for (int j = 0; j < floats; j += 2) {
+                const float br = hi[j], bi = hi[j + 1];
+                const float tr = br * wr[j] + bi * wi[j];
+                const float ti = bi * wr[j + 1] + br * wi[j + 1];
+                const float ar = lo[j], ai = lo[j + 1];
+                lo[j] = ar + tr;  lo[j + 1] = ai + ti;
+                hi[j] = ar - tr;  hi[j + 1] = ai - ti;
+            }
+#endif
+        }
+    }
+}
+
+void Channelizer::process(const std::complex<float>* in, size_t count)
+{
+    m_frames = 0;
+    if (m_size == 0) return;
+
+    while (count > 0) {
+        const size_t take = std::min(count, static_cast<size_t>(m_size - m_fill));
+        std::copy(in, in + take, m_frame.begin() + m_fill);
+        m_fill += static_cast<int>(take);
+        in += take;
+        count -= take;
+        if (m_fill < m_size) break;
+
+        if (m_frames == static_cast<int>(m_spectra.size())) m_spectra.emplace_back(m_size);
+        std::complex<float>* X = m_spectra[m_frames++].data();
+        for (int i = 0; i < m_size; i++) X[m_bitReverse[i]] = m_frame[i];
+        transform(X, m_size, false);
+
+        // Keep the last N/4 samples as the overlap of the next frame
+        std::copy(m_frame.begin() + m_hop, m_frame.end(), m_frame.begin());
+        m_fill = m_size - m_hop;
+    }
+}
+
+void Channelizer::extract(Channel& channel, std::vector<std::complex<float>>& out) const
+{
+    if (!channel.active || channel.generation != m_generation || m_frames == 0) return;
+
+    const int nc = channel.size;
+    const int mask = m_size - 1;
+    const int first = nc / 4;       // wrapped part of the circular convolution
+    std::complex<float>* y = channel.work.data();
+    const std::complex<float>* H = channel.response.data();
+    const size_t need = out.size() + static_cast<size_t>(m_frames) * (nc - first);
+    if (out.capacity() < need) out.reserve(std::max(need, out.capacity() * 2));
+
+    float power = 0.0f;
+    for (int f = 0; f < m_frames; f++) {
+        const std::complex<float>* X = m_spectra[f].data();
+        for (int k = -channel.passBins; k <= channel.passBins; k++) {
+            power += std::norm(X[(k + channel.bin) & mask]);
+        }
+        for (int m = 0; m < nc; m++) {
+            const int k = ((m < nc / 2) ? m : m - nc) + channel.bin;
+            const std::complex<float> a = X[k & mask];
+            const std::complex<float> w = H[m];
+            y[channel.bitReverse[m]] = std::complex<float>(a.real() * w.real() - a.imag() * w.imag(),
+                                                           a.real() * w.imag() + a.imag() * w.real());
+        }
+        transform(y, nc, true);
+
+        const std::complex<float> fp = channel.framePhase;
+        std::complex<float> p = channel.finePhase;
+        const std::complex<float> fs = channel.fineStep;
+        for (int m = first; m < nc; m++) {
+            const std::complex<float> r(fp.real() * p.real() - fp.imag() * p.imag(),
+                                        fp.real() * p.imag() + fp.imag() * p.real());
+            const std::complex<float> v = y[m];
+            out.emplace_back(v.real() * r.real() - v.imag() * r.imag(),
+                             v.real() * r.imag() + v.imag() * r.real());
+            p = std::complex<float>(p.real() * fs.real() - p.imag() * fs.imag(),
+                                    p.real() * fs.imag() + p.imag() * fs.real());
+        }
+
+        // Renormalise once per frame so the phasors do not drift in magnitude
+        const float gp = 1.5f - 0.5f * std::norm(p);
+        channel.finePhase = p * gp;
+        const std::complex<float> nf(fp.real() * channel.frameStep.real() - fp.imag() * channel.frameStep.imag(),
+                                     fp.real() * channel.frameStep.imag() + fp.imag() * channel.frameStep.real());
+        channel.framePhase = nf * (1.5f - 0.5f * std::norm(nf));
+    }
+
+    // Parseval: sum |X|^2 / N^2 is the mean power the bins carry
+    const float n2 = static_cast<float>(m_size) * static_cast<float>(m_size);
+    channel.powerDb = 10.0f * std::log10(std::max(power / (m_frames * n2), 1e-20f));
+}
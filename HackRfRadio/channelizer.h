@@ -0,0 +1,108 @@
+#ifndef CHANNELIZER_H
+#define CHANNELIZER_H
+
+#include <complex>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+// Shared fast-convolution channeliser for the multi-VFO receivers.
+//
+// The capture is cut into overlap-save frames of N samples (N a power of
+// two, ~2.5 kHz per bin) advancing by 3N/4, and each frame is transformed
+// once. A channel picks the Nc bins around its centre bin, weights them
+// with the response of a Kaiser windowed-sinc lowpass (N/4 + 1 taps, so
+// the overlap-save output is exact) and runs an Nc point inverse FFT:
+// that is the channel already mixed to baseband and decimated by N / Nc.
+// The first Nc/4 outputs of each frame are the wrapped part and are
+// dropped. What is left of the offset (less than half a bin) is removed
+// by a phasor at the channel rate, so any frequency can be tuned.
+//
+// process() is the only step that touches the full-rate samples; the cost
+// of a channel is about one small FFT per frame, so dozens of channels
+// stay cheap. The channeliser filter only guards against aliasing into
+// the channel; the demodulator after it does the channel selectivity.
+//
+// Threading: process() runs on one thread. extract() only reads the
+// frame spectra, so different Channels may be extracted concurrently
+// once process() has returned.
+class Channelizer
+{
+public:
+    static constexpr int MIN_FFT = 256;
+    static constexpr int MAX_FFT = 16384;
+    static constexpr double TARGET_BIN_HZ = 2500.0;
+    static constexpr int MIN_CHANNEL_FFT = 16;
+
+    struct Channel {
+        double offsetHz = 0.0;          // from the centre of the capture
+        double bandwidthHz = 0.0;
+        double minRate = 0.0;
+
+        int size = 0;                   // Nc, inverse FFT points
+        int bin = 0;                    // centre bin, -N/2 .. N/2-1
+        double rate = 0.0;              // output sample rate
+        int passBins = 0;               // bins within +-bandwidth/2
+        bool active = false;            // false: outside the capture
+        float powerDb = -200.0f;        // in-band power of the last extract(), dBFS
+
+        std::vector<std::complex<float>> response;  // Nc weights, FFT order
+        std::vector<uint32_t> bitReverse;
+        std::vector<std::complex<float>> work;
+
+        std::complex<float> frameStep{1.0f, 0.0f};  // phase of the bin across one hop
+        std::complex<float> framePhase{1.0f, 0.0f};
+        std::complex<float> fineStep{1.0f, 0.0f};   // residual offset per output sample
+        std::complex<float> finePhase{1.0f, 0.0f};
+        uint32_t generation = 0;        // Channelizer layout it was set up for
+    };
+
+    Channelizer();
+
+    // Picks the frame size for the rate and clears the history; Channels
+    // set up before must be configured again (see generation())
+    void setInputRate(double rate);
+    double inputRate() const { return m_inputRate; }
+    int fftSize() const { return m_size; }
+    double binHz() const { return m_size > 0 ? m_inputRate / m_size : 0.0; }
+    uint32_t generation() const { return m_generation; }
+
+    // Channel rate is the lowest power-of-two share of the input rate that
+    // is at least minRate and leaves room for the filter transition
+    void configure(Channel& channel, double offsetHz, double bandwidthHz, double minRate) const;
+    // Retune within the capture; keeps the filter when the size holds
+    void setOffset(Channel& channel, double offsetHz) const;
+
+    // Drop the frame history (retune, gap)
+    void reset();
+
+    // Transforms every frame completed by this block; the spectra stay
+    // valid until the next call
+    void process(const std::complex<float>* in, size_t count);
+    int frames() const { return m_frames; }
+
+    // Appends the channel's samples for the frames of the last process()
+    // and measures its in-band power (full-scale tone = 0 dBFS)
+    void extract(Channel& channel, std::vector<std::complex<float>>& out) const;
+
+private:
+    void transform(std::complex<float>* x, int n, bool inverse) const;
+    static std::vector<uint32_t> bitReverseTable(int n);
+
+    double m_inputRate;
+    int m_size;                                     // N
+    int m_hop;                                      // 3N/4
+    uint32_t m_generation;
+
+    std::vector<float> m_stageRe;                   // per-stage twiddles
+    std::vector<float> m_stageIm;
+    std::vector<float> m_stageImInverse;
+    std::vector<uint32_t> m_bitReverse;
+
+    std::vector<std::complex<float>> m_frame;       // overlap + new samples
+    int m_fill;
+    std::vector<std::vector<std::complex<float>>> m_spectra;
+    int m_frames;
+};
+
+#endif // CHANNELIZER_H
@@ -8,6 +8,7 @@
 #include <numeric>
 #include <algorithm>
 #include <atomic>
+#include "polyphaseresampler.h"
 
 #ifndef M_PI
 #define M_PI 3.14159265358979323846
@@ -53,11 +54,12 @@ private:
         // Persistent delay line for block-continuous filtering
         std::vector<std::complex<float>> iqHistory;   // for complex decimation
         std::vector<float> realHistory;                // for real decimation
+        int realPhase = 0;                             // first input to keep in the next block
     };
 
     double m_inputRate;
     double m_bandwidth;
-    float m_lastPhase;
+    std::complex<float> m_lastSample;  // discriminator: previous IQ sample
     float m_outputGain;
     float m_rxModIndex = 1.0f;
     float m_audioLpfCutoff = 5000.0f;
@@ -81,19 +83,31 @@ private:
     std::vector<float> m_audioFilterHistory;            // audio LPF state
     std::vector<float> m_monoFilterHistory;             // WBFM mono LPF state
     std::vector<float> m_diffFilterHistory;             // WBFM diff LPF state
+    std::vector<std::complex<float>> m_iqWork;         // FIR scratch: [history | input]
+    std::vector<float> m_realWork;
 
     // Stereo decode state
-    double m_pilotPhase = 0.0;       // PLL phase accumulator for 19 kHz pilot
+    // 19 kHz pilot PLL: recursive NCO (cos, sin), loop filter runs once per
+    // PILOT_BLOCK samples on the phase error integrated over the block
+    static constexpr int PILOT_BLOCK = 64;
+    float m_pilotCos = 1.0f;
+    float m_pilotSin = 0.0f;
     double m_pilotFreq = 19000.0;    // PLL frequency estimate
+    float m_pilotErrAcc = 0.0f;      // sum of mpx * cos (quadrature)
+    float m_pilotRefAcc = 0.0f;      // sum of mpx * sin (in phase)
+    int m_pilotCount = 0;            // samples in the accumulators
     float m_pilotLevel = 0.0f;       // pilot energy for detection
     std::atomic<bool> m_stereoDetected{false};
     bool m_forceMono = false;
     std::vector<float> m_monoFilterTaps;   // LPF for L+R (15 kHz)
     std::vector<float> m_diffFilterTaps;   // LPF for L-R (15 kHz)
+    int m_stereoDecim = 1;                 // both LPFs decimate by this (to >= 96 kHz)
+    int m_stereoPhase = 0;                 // shared, so L+R and L-R stay sample aligned
 
     float m_dcX1L = 0.0f, m_dcY1L = 0.0f;
     float m_dcX1R = 0.0f, m_dcY1R = 0.0f;
-    double m_resamplePhase = 0.0;  // fractional position carried between blocks
+    PolyphaseResampler m_resamplerL;  // -> 48 kHz, mono path uses L
+    PolyphaseResampler m_resamplerR;
 
     double m_mpxRate = 0.0;  // rate after IQ decimation (before stereo decode)
 
@@ -119,7 +133,7 @@ private:
         const std::vector<float>& in,
         std::vector<float>& out,
         const std::vector<float>& taps, int factor,
-        std::vector<float>& history);
+        std::vector<float>& history, int& phase);
     void applyFIR(
         const std::vector<float>& in,
         std::vector<float>& out,
@@ -127,8 +141,8 @@ private:
         std::vector<float>& history);
     std::vector<float> fmDemod(const std::vector<std::complex<float>>& signal, double rate);
     std::vector<float> decodeStereo(const std::vector<float>& mpx, double mpxRate);
-    std::vector<float> resample(const std::vector<float>& in, double inRate, double outRate);
     void removeDC(float& dcX1, float& dcY1, std::vector<float>& audio);
+    void resetPilot();
 };
 
 #endif // FMDEMODULATOR_H
@@ -3,12 +3,25 @@
 #include "fmdemodulator.h"
 #include "amdemodulator.h"
 #include <QVBoxLayout>
+#include <QHBoxLayout>
 #include <QGridLayout>
 #include <QGroupBox>
 #include <QPushButton>
 #include <QScrollArea>
 #include <QScroller>
 
+// Data port encodings, cycled by a button (no QComboBox, see RadioWindow)
+static const char* const IQ_ENCODINGS[] = { "raw", "bfp4", "deflate" };
+static const char* const IQ_ENCODING_LABELS[] = {
+    "Raw int8 (full quality)", "4-bit BFP (1.9x smaller, lossy)", "Deflate (lossless)"
+};
+static constexpr int IQ_ENCODING_COUNT = 3;
+
+// AM detectors, in AMDemodulator::Mode order
+static const char* const AM_DETECTOR_LABELS[] = {
+    "Envelope", "Synchronous (SAM)", "Upper sideband (USB)", "Lower sideband (LSB)"
+};
+
 GainSettingsDialog::GainSettingsDialog(TcpClient* tcpClient, FMDemodulator* fmDemod, AMDemodulator* amDemod, QWidget *parent)
     : QWidget(parent)
     , m_tcpClient(tcpClient)
@@ -105,6 +118,41 @@ void GainSettingsDialog::setupUi()
     connGrid->addWidget(new QLabel("Audio Port:"), 3, 0);
     connGrid->addWidget(m_audioPortSpin, 3, 1);
 
+    m_multicastCheck = new QCheckBox("Multicast IQ (server --multicast, LAN only)");
+    connect(m_multicastCheck, &QCheckBox::toggled, [this](bool) {
+        emit settingsChanged();
+    });
+    connGrid->addWidget(m_multicastCheck, 4, 0, 1, 2);
+
+    m_encodingBtn = new QPushButton(IQ_ENCODING_LABELS[0]);
+    m_encodingBtn->setMinimumHeight(44);
+    connect(m_encodingBtn, &QPushButton::clicked, [this]() {
+        setIqEncoding(IQ_ENCODINGS[(m_encodingIndex + 1) % IQ_ENCODING_COUNT]);
+        if (m_tcpClient) m_tcpClient->setEncoding(iqEncoding());
+        emit settingsChanged();
+    });
+    connGrid->addWidget(new QLabel("IQ Encoding:"), 5, 0);
+    connGrid->addWidget(m_encodingBtn, 5, 1);
+
+    m_binaryCheck = new QCheckBox("Binary control (batched, drops IQ from before a retune)");
+    connect(m_binaryCheck, &QCheckBox::toggled, [this](bool) {
+        emit settingsChanged();
+    });
+    connGrid->addWidget(m_binaryCheck, 6, 0, 1, 2);
+
+    // Per-stage latency, this app's and the server's, into the log
+    QPushButton* latencyBtn = new QPushButton("Report");
+    latencyBtn->setMinimumHeight(44);
+    connect(latencyBtn, &QPushButton::clicked, this, &GainSettingsDialog::latencyReportRequested);
+    QPushButton* latencyResetBtn = new QPushButton("Reset");
+    latencyResetBtn->setMinimumHeight(44);
+    connect(latencyResetBtn, &QPushButton::clicked, this, &GainSettingsDialog::latencyResetRequested);
+    QHBoxLayout* latencyRow = new QHBoxLayout();
+    latencyRow->addWidget(latencyBtn);
+    latencyRow->addWidget(latencyResetBtn);
+    connGrid->addWidget(new QLabel("Latency:"), 7, 0);
+    connGrid->addLayout(latencyRow, 7, 1);
+
     connGrid->setColumnMinimumWidth(0, 100);
     connGrid->setColumnStretch(1, 1);
     mainLayout->addWidget(connGroup);
@@ -164,6 +212,16 @@ void GainSettingsDialog::setupUi()
     });
     rxGrid->addWidget(new QLabel("IF BW:"), row, 0); rxGrid->addWidget(m_ifBwSlider, row, 1); rxGrid->addWidget(m_ifBwLabel, row, 2); row++;
 
+    // AM detector, cycled like the IQ encoding
+    m_amDetectorBtn = new QPushButton(AM_DETECTOR_LABELS[0]);
+    m_amDetectorBtn->setMinimumHeight(44);
+    connect(m_amDetectorBtn, &QPushButton::clicked, [this]() {
+        setAmDetector((m_amDetector + 1) % AMDemodulator::MODE_COUNT);
+        emit settingsChanged();
+    });
+    m_amDetectorRowLabel = new QLabel("AM Detector:");
+    rxGrid->addWidget(m_amDetectorRowLabel, row, 0); rxGrid->addWidget(m_amDetectorBtn, row, 1, 1, 2); row++;
+
     // RX Modulation Index slider: 0.01 - 5.0 (slider 1-500, /100)
     m_rxModIdxSlider = new QSlider(Qt::Horizontal); m_rxModIdxSlider->setRange(1, 500); m_rxModIdxSlider->setValue(100);
     m_rxModIdxLabel = new QLabel("1.00");
@@ -279,6 +337,19 @@ void GainSettingsDialog::setHost(const QString& h) { m_hostEdit->setText(h); }
 void GainSettingsDialog::setDataPort(int p) { m_dataPortSpin->setValue(p); }
 void GainSettingsDialog::setControlPort(int p) { m_controlPortSpin->setValue(p); }
 void GainSettingsDialog::setAudioPort(int p) { m_audioPortSpin->setValue(p); }
+bool GainSettingsDialog::multicastEnabled() const { return m_multicastCheck->isChecked(); }
+void GainSettingsDialog::setMulticastEnabled(bool en) { m_multicastCheck->setChecked(en); }
+bool GainSettingsDialog::binaryProtocolEnabled() const { return m_binaryCheck->isChecked(); }
+void GainSettingsDialog::setBinaryProtocolEnabled(bool en) { m_binaryCheck->setChecked(en); }
+QString GainSettingsDialog::iqEncoding() const { return IQ_ENCODINGS[m_encodingIndex]; }
+void GainSettingsDialog::setIqEncoding(const QString& encoding) {
+    for (int i = 0; i < IQ_ENCODING_COUNT; i++) {
+        if (encoding == IQ_ENCODINGS[i]) {
+            m_encodingIndex = i;
+            m_encodingBtn->setText(IQ_ENCODING_LABELS[i]);
+        }
+    }
+}
 
 // === Accessors ===
 
@@ -294,6 +365,7 @@ int GainSettingsDialog::rxModIndex() const { return m_rxModIdxSlider->value(); }
 int GainSettingsDialog::audioLpf() const { return m_audioLpfSlider->value(); }
 bool GainSettingsDialog::fmnrEnabled() const { return m_fmnrCheck->isChecked(); }
 bool GainSettingsDialog::ampEnabled() const { return m_ampEnableCheck->isChecked(); }
+int GainSettingsDialog::amDetector() const { return m_amDetector; }
 
 void GainSettingsDialog::setVgaGain(int v) { m_vgaGainSlider->setValue(v); }
 void GainSettingsDialog::setLnaGain(int v) { m_lnaGainSlider->setValue(v); }
@@ -312,6 +384,13 @@ void GainSettingsDialog::setAmpEnabled(bool en) {
     m_ampEnableCheck->blockSignals(false);
 }
 
+void GainSettingsDialog::setAmDetector(int mode) {
+    if (mode < 0 || mode >= AMDemodulator::MODE_COUNT) return;
+    m_amDetector = mode;
+    m_amDetectorBtn->setText(AM_DETECTOR_LABELS[mode]);
+    m_amDemod->setMode(static_cast<AMDemodulator::Mode>(mode));
+}
+
 void GainSettingsDialog::sendTxParams()
 {
     if (!m_tcpClient->isConnected()) return;
@@ -348,6 +427,11 @@ void GainSettingsDialog::setModulationVisibility(int modulation)
     // FM NR checkbox - only FM
     m_fmnrCheck->setVisible(isFM);
 
+    // AM detector - only AM
+    bool isAM = (modulation == 2);
+    if (m_amDetectorRowLabel) m_amDetectorRowLabel->setVisible(isAM);
+    m_amDetectorBtn->setVisible(isAM);
+
     // Audio LPF - all modes (useful for AM too)
     // Keep visible
 }
@@ -7,6 +7,7 @@
 #include <QCheckBox>
 #include <QLineEdit>
 #include <QSpinBox>
+#include <QPushButton>
 
 class TcpClient;
 class FMDemodulator;
@@ -28,6 +29,12 @@ public:
     void setDataPort(int p);
     void setControlPort(int p);
     void setAudioPort(int p);
+    bool multicastEnabled() const;
+    void setMulticastEnabled(bool en);
+    QString iqEncoding() const;              // raw, bfp4 or deflate
+    void setIqEncoding(const QString& encoding);
+    bool binaryProtocolEnabled() const;
+    void setBinaryProtocolEnabled(bool en);
 
     // Accessors for save/load
     int vgaGain() const;
@@ -42,6 +49,7 @@ public:
     int audioLpf() const;
     bool fmnrEnabled() const;
     bool ampEnabled() const;
+    int amDetector() const;                  // AMDemodulator::Mode
 
     void setVgaGain(int v);
     void setLnaGain(int v);
@@ -55,6 +63,7 @@ public:
     void setAudioLpf(int v);
     void setFmnrEnabled(bool en);
     void setAmpEnabled(bool en);
+    void setAmDetector(int mode);
 
     // Called on PTT press to push TX params to server
     void sendTxParams();
@@ -70,6 +79,8 @@ signals:
     void ampEnableChanged(bool enabled);
     void settingsChanged();
     void backClicked();
+    void latencyReportRequested();
+    void latencyResetRequested();
 
 private:
     void setupUi();
@@ -90,18 +101,25 @@ private:
     QSlider* m_audioLpfSlider;  QLabel* m_audioLpfLabel;
     QCheckBox* m_fmnrCheck;
     QCheckBox* m_ampEnableCheck;
+    QPushButton* m_amDetectorBtn;
+    int m_amDetector = 0;
 
     // Row labels for visibility control
     QLabel* m_rxModIdxRowLabel = nullptr;
     QLabel* m_deemphRowLabel = nullptr;
     QLabel* m_audioLpfRowLabel = nullptr;
     QLabel* m_rxGainRowLabel = nullptr;
+    QLabel* m_amDetectorRowLabel = nullptr;
 
     // Connection fields
     QLineEdit* m_hostEdit;
     QSpinBox* m_dataPortSpin;
     QSpinBox* m_controlPortSpin;
     QSpinBox* m_audioPortSpin;
+    QCheckBox* m_multicastCheck;
+    QPushButton* m_encodingBtn;
+    QCheckBox* m_binaryCheck;
+    int m_encodingIndex = 0;
 };
 
 #endif // GAINSETTINGSDIALOG_H
@@ -155,6 +155,10 @@ void CPlotter::paintEvent(QPaintEvent *event)
         }
     }
 
+    // Multi-VFO receivers
+    if (!m_VfoMarkers.isEmpty())
+        drawVfoMarkers(painter, w, specH);
+
     // Band allocation overlay at bottom of spectrum
     drawBandOverlay(painter, w, specH);
 
@@ -440,6 +444,33 @@ void CPlotter::drawFilterBox(QPainter &painter, int w, int h)
     painter.drawLine(hi, 0, hi, h);
 }
 
+void CPlotter::drawVfoMarkers(QPainter &painter, int w, int h)
+{
+    painter.setFont(m_Font);
+    for (int i = 0; i < m_VfoMarkers.size(); i++) {
+        const VfoMarker &m = m_VfoMarkers[i];
+        const int x = xFromFreq(m.freq);
+        if (x < 0 || x > w) continue;
+
+        int lo = xFromFreq(m.freq - m.bandwidth / 2);
+        int hi = xFromFreq(m.freq + m.bandwidth / 2);
+        if (hi - lo < 3) { lo = x - 1; hi = x + 2; }
+
+        // Green while its squelch is open, grey outside the capture
+        QColor col = !m.active ? QColor(120, 120, 120) : m.open ? QColor(0, 255, 102) : QColor(255, 170, 0);
+        QColor fill = col;
+        fill.setAlpha(m.open ? 60 : 30);
+        painter.fillRect(lo, 0, hi - lo, h, fill);
+
+        QPen pen(col);
+        pen.setWidthF(1.0);
+        pen.setStyle(Qt::DotLine);
+        painter.setPen(pen);
+        painter.drawLine(x, 0, x, h);
+        painter.drawText(x + 3, 12, QString::number(i + 1));
+    }
+}
+
 // ============================================================================
 // Band allocation overlay — known frequency bands shown at bottom of spectrum
 // ============================================================================
@@ -750,14 +781,19 @@ void CPlotter::mouseMoveEvent(QMouseEvent *event)
 
 void CPlotter::mousePressEvent(QMouseEvent *event)
 {
-    if (m_ClickResolution == 0) return; // non-interactive mode
-
 #if QT_VERSION < QT_VERSION_CHECK(6, 0, 0)
     QPoint pt = event->pos();
 #else
     QPoint pt = event->position().toPoint();
 #endif
 
+    if (m_VfoPlacement && event->button() == Qt::LeftButton) {
+        emit vfoClicked(freqFromX(pt.x()));
+        return;
+    }
+
+    if (m_ClickResolution == 0) return; // non-interactive mode
+
     if (event->button() == Qt::LeftButton) {
         m_DemodFreqX = xFromFreq(m_DemodCenterFreq);
         m_DemodLowCutFreqX = xFromFreq(m_DemodCenterFreq + m_DemodLowCutFreq);
@@ -7,6 +7,7 @@
 #include <QMap>
 #include <QList>
 #include <QPair>
+#include <QVector>
 #include <QRect>
 #include <QMouseEvent>
 #include <QWheelEvent>
@@ -113,6 +114,17 @@ public:
 
     void setWaterfallPalette(int pal);
 
+    // Multi-VFO receivers drawn over the spectrum. With placement on, a tap
+    // emits vfoClicked() instead of tuning, also in non-interactive mode.
+    struct VfoMarker {
+        qint64 freq;
+        int bandwidth;
+        bool active;    // inside the capture
+        bool open;      // squelch open
+    };
+    void setVfoMarkers(const QVector<VfoMarker>& markers) { m_VfoMarkers = markers; update(); }
+    void setVfoPlacementEnabled(bool enabled) { m_VfoPlacement = enabled; }
+
 signals:
     void newCenterFreq(qint64 f);
     void newDemodFreq(qint64 freq, qint64 delta);
@@ -122,6 +134,7 @@ signals:
     void pandapterRangeChanged(float min, float max);
     void newZoomLevel(float level);
     void wheelFreqChange(int direction); // +1 = up, -1 = down
+    void vfoClicked(qint64 freq);
 
 public slots:
     void resetHorizontalZoom(void);
@@ -161,6 +174,7 @@ private:
     void drawFilterBox(QPainter &painter, int w, int h);
     void drawFreqLabels(QPainter &painter, int w, int spectrumH);
     void drawBandOverlay(QPainter &painter, int w, int specH);
+    void drawVfoMarkers(QPainter &painter, int w, int specH);
 
     void makeFrequencyStrs();
     int  xFromFreq(qint64 freq);
@@ -270,6 +284,10 @@ private:
     QMap<int,int> m_Peaks;
     QList<QPair<QRect, qint64>> m_BookmarkTags;
 
+    // Multi-VFO
+    QVector<VfoMarker> m_VfoMarkers;
+    bool        m_VfoPlacement{false};
+
     // Waterfall timing
     quint64     tlast_wf_ms{0};
     quint64     msec_per_wfline{0};
@@ -1,5 +1,8 @@
 #include <QApplication>
+#include <QCommandLineParser>
+#include <QDebug>
 #include "radiowindow.h"
+#include "threadplacement.h"
 
 int main(int argc, char *argv[])
 {
@@ -8,8 +11,27 @@ int main(int argc, char *argv[])
     app.setApplicationVersion("1.0");
     app.setOrganizationName("MarenRobotics");
 
+    // Hot thread scheduling (threadplacement.h)
+    QCommandLineParser parser;
+    QCommandLineOption threadOption(QStringList() << "thread",
+                                    QString("Scheduling and CPUs of a group of hot threads, repeatable: %1")
+                                        .arg(ThreadPlacement::usage()), "role=settings");
+    QCommandLineOption mlockOption(QStringList() << "mlock", "Lock the process memory (mlockall)");
+    parser.addOption(threadOption);
+    parser.addOption(mlockOption);
+    parser.parse(app.arguments());
+    for (const QString& spec : parser.values(threadOption)) {
+        std::string error;
+        if (!ThreadPlacement::parse(spec.toStdString(), &error))
+            qDebug() << "Ignoring --thread:" << QString::fromStdString(error);
+    }
+    ThreadPlacement::setLockMemory(parser.isSet(mlockOption));
+
     RadioWindow w;
     w.show();
 
+    // After the window has allocated its rings and buffers
+    ThreadPlacement::lockMemory();
+
     return app.exec();
 }
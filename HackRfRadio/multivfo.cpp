@@ -0,0 +1,383 @@
+#include "multivfo.h"
+#include "fmdemodulator.h"
+#include "amdemodulator.h"
+#include "threadplacement.h"
+#include <QThreadPool>
+#include <QThread>
+#include <QtConcurrent/QtConcurrent>
+#include <QFile>
+#include <QDir>
+#include <QDateTime>
+#include <QDebug>
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+constexpr int AUDIO_RATE = 48000;
+constexpr size_t MAX_PENDING = AUDIO_RATE / 4 * 2;   // 250 ms of stereo
+
+// 16-bit mono PCM; sizes are patched when the file is closed
+void writeWavHeader(QFile& file, quint32 dataBytes)
+{
+    auto le16 = [](QByteArray& b, quint16 v) { b.append(char(v & 0xFF)); b.append(char(v >> 8)); };
+    auto le32 = [&](QByteArray& b, quint32 v) { le16(b, quint16(v & 0xFFFF)); le16(b, quint16(v >> 16)); };
+
+    QByteArray h;
+    h.append("RIFF");
+    le32(h, 36 + dataBytes);
+    h.append("WAVEfmt ");
+    le32(h, 16);
+    le16(h, 1);                 // PCM
+    le16(h, 1);                 // mono
+    le32(h, AUDIO_RATE);
+    le32(h, AUDIO_RATE * 2);
+    le16(h, 2);
+    le16(h, 16);
+    h.append("data");
+    le32(h, dataBytes);
+
+    file.seek(0);
+    file.write(h);
+}
+
+} // namespace
+
+struct MultiVfo::Vfo {
+    Info info;
+    Channelizer::Channel channel;
+    std::unique_ptr<FMDemodulator> fm;
+    std::unique_ptr<AMDemodulator> am;
+
+    std::vector<std::complex<float>> iq;
+    std::vector<float> pending;             // interleaved stereo, 48 kHz
+    std::vector<qint16> pcm;
+
+    std::unique_ptr<QFile> wav;
+    quint32 wavBytes = 0;
+
+    void stopRecording()
+    {
+        if (!wav) return;
+        writeWavHeader(*wav, wavBytes);
+        wav->close();
+        wav.reset();
+        wavBytes = 0;
+        info.recording = false;
+    }
+};
+
+MultiVfo::MultiVfo(QObject *parent)
+    : QObject(parent)
+    , m_pool(new QThreadPool(this))
+    , m_blockPool(new QThreadPool(this))
+{
+    m_pool->setMaxThreadCount(std::max(1, QThread::idealThreadCount()));
+    m_blockPool->setMaxThreadCount(1);
+}
+
+MultiVfo::~MultiVfo()
+{
+    m_blockPool->clear();
+    m_blockPool->waitForDone();
+    for (auto& vfo : m_vfos) vfo->stopRecording();
+}
+
+double MultiVfo::minChannelRate(Mode mode, double bandwidth)
+{
+    // What the demodulators decimate to anyway (see their rebuildChain)
+    if (mode == WFM) return std::max(bandwidth * 2.0, 300000.0);
+    return std::max(bandwidth * 4.0, 50000.0);
+}
+
+void MultiVfo::setSampleRate(double rate)
+{
+    if (rate <= 0.0 || rate == m_sampleRate) return;
+    m_sampleRate = rate;
+    {
+        std::lock_guard<std::mutex> lock(m_dspMutex);
+        m_channelizer.setInputRate(rate);
+        for (auto& vfo : m_vfos) setupVfo(*vfo);
+    }
+    emit vfosChanged();
+}
+
+void MultiVfo::setCenterFrequency(qint64 hz)
+{
+    if (hz == m_centerFrequency) return;
+    m_centerFrequency = hz;
+    {
+        std::lock_guard<std::mutex> lock(m_dspMutex);
+        for (auto& vfo : m_vfos) {
+            m_channelizer.setOffset(vfo->channel, static_cast<double>(vfo->info.frequency - hz));
+            vfo->info.active = vfo->channel.active;
+            vfo->pending.clear();
+        }
+    }
+    emit vfosChanged();
+}
+
+void MultiVfo::setupVfo(Vfo& vfo)
+{
+    Info& info = vfo.info;
+    m_channelizer.configure(vfo.channel, static_cast<double>(info.frequency - m_centerFrequency),
+                            info.bandwidth, minChannelRate(info.mode, info.bandwidth));
+    info.channelRate = vfo.channel.rate;
+    info.active = vfo.channel.active;
+    vfo.pending.clear();
+    if (vfo.channel.rate <= 0.0) return;
+
+    if (info.mode == AM) {
+        vfo.fm.reset();
+        if (!vfo.am) vfo.am = std::make_unique<AMDemodulator>(vfo.channel.rate, info.bandwidth);
+        else vfo.am->setSampleRate(vfo.channel.rate);
+        vfo.am->setBandwidth(info.bandwidth);
+        return;
+    }
+
+    vfo.am.reset();
+    if (!vfo.fm) vfo.fm = std::make_unique<FMDemodulator>(vfo.channel.rate, info.bandwidth);
+    else vfo.fm->setSampleRate(vfo.channel.rate);
+    vfo.fm->setBandwidth(info.bandwidth);
+
+    // Mode presets of the main receiver (RadioWindow::onModulationChanged)
+    const bool wide = (info.mode == WFM);
+    vfo.fm->setOutputGain(3.0f);
+    vfo.fm->setRxModIndex(wide ? 1.0f : 0.5f);
+    vfo.fm->setDeemphTau(50.0f);
+    vfo.fm->setAudioLPF(wide ? 8000.0f : 4000.0f);
+}
+
+int MultiVfo::addVfo(qint64 frequency, Mode mode, double bandwidth)
+{
+    if (count() >= MAX_VFOS) return -1;
+
+    auto vfo = std::make_unique<Vfo>();
+    vfo->info.id = m_nextId++;
+    vfo->info.frequency = frequency;
+    vfo->info.mode = mode;
+    vfo->info.bandwidth = bandwidth;
+
+    const int id = vfo->info.id;
+    {
+        std::lock_guard<std::mutex> lock(m_dspMutex);
+        setupVfo(*vfo);
+        if (m_recording) startRecording(*vfo);
+        m_vfos.push_back(std::move(vfo));
+    }
+    emit vfosChanged();
+    return id;
+}
+
+bool MultiVfo::removeVfo(int id)
+{
+    auto it = std::find_if(m_vfos.begin(), m_vfos.end(),
+                           [id](const std::unique_ptr<Vfo>& v) { return v->info.id == id; });
+    if (it == m_vfos.end()) return false;
+    {
+        std::lock_guard<std::mutex> lock(m_dspMutex);
+        (*it)->stopRecording();
+        m_vfos.erase(it);
+    }
+    emit vfosChanged();
+    return true;
+}
+
+void MultiVfo::clear()
+{
+    if (m_vfos.empty()) return;
+    {
+        std::lock_guard<std::mutex> lock(m_dspMutex);
+        for (auto& vfo : m_vfos) vfo->stopRecording();
+        m_vfos.clear();
+    }
+    emit vfosChanged();
+}
+
+QVector<MultiVfo::Info> MultiVfo::vfos() const
+{
+    QVector<Info> list;
+    list.reserve(count());
+    std::lock_guard<std::mutex> lock(m_stateMutex);
+    for (const auto& vfo : m_vfos) list.append(vfo->info);
+    return list;
+}
+
+int MultiVfo::vfoAt(qint64 frequency, qint64 slack) const
+{
+    for (const auto& vfo : m_vfos) {
+        const qint64 half = static_cast<qint64>(vfo->info.bandwidth / 2.0) + slack;
+        if (std::llabs(frequency - vfo->info.frequency) <= half) return vfo->info.id;
+    }
+    return -1;
+}
+
+void MultiVfo::setPan(int id, float pan)
+{
+    for (auto& vfo : m_vfos) {
+        if (vfo->info.id == id) vfo->info.pan = std::clamp(pan, -1.0f, 1.0f);
+    }
+}
+
+void MultiVfo::setRecording(bool on)
+{
+    m_recording = on;
+    {
+        std::lock_guard<std::mutex> lock(m_dspMutex);
+        for (auto& vfo : m_vfos) {
+            if (on) startRecording(*vfo);
+            else vfo->stopRecording();
+        }
+    }
+    emit vfosChanged();
+}
+
+void MultiVfo::startRecording(Vfo& vfo)
+{
+    if (vfo.wav || m_recordDir.isEmpty()) return;
+    QDir().mkpath(m_recordDir);
+    const QString name = QString("vfo%1_%2Hz_%3.wav")
+                             .arg(vfo.info.id)
+                             .arg(vfo.info.frequency)
+                             .arg(QDateTime::currentDateTime().toString("yyyyMMdd_HHmmss"));
+    auto file = std::make_unique<QFile>(QDir(m_recordDir).filePath(name));
+    if (!file->open(QIODevice::WriteOnly)) {
+        qDebug() << "[MultiVfo] cannot record to" << file->fileName() << file->errorString();
+        return;
+    }
+    writeWavHeader(*file, 0);
+    vfo.wav = std::move(file);
+    vfo.wavBytes = 0;
+    vfo.info.recording = true;
+}
+
+void MultiVfo::reset()
+{
+    std::lock_guard<std::mutex> lock(m_dspMutex);
+    m_channelizer.reset();
+    for (auto& vfo : m_vfos) vfo->pending.clear();
+}
+
+void MultiVfo::runVfo(Vfo& vfo)
+{
+    // The block thread, or a pool thread for one VFO of many
+    ThreadPlacement::apply(ThreadPlacement::Dsp);
+
+    vfo.iq.clear();
+    m_channelizer.extract(vfo.channel, vfo.iq);
+    Info& info = vfo.info;
+    {
+        std::lock_guard<std::mutex> lock(m_stateMutex);
+        info.active = vfo.channel.active;
+        if (vfo.iq.empty() || (!vfo.fm && !vfo.am)) return;
+        info.levelDb = vfo.channel.powerDb;
+    }
+
+    std::vector<float> audio;
+    if (vfo.fm) {
+        audio = vfo.fm->demodulate(vfo.iq);
+    } else {
+        auto mono = vfo.am->demodulate(vfo.iq);
+        const float amGain = m_amGain.load();
+        audio.resize(mono.size() * 2);
+        for (size_t i = 0; i < mono.size(); i++) {
+            float s = mono[i] * amGain;
+            // Same soft clipper as the main AM path
+            if (s > 0.6f) s = 0.6f + 0.4f * std::tanh((s - 0.6f) * 2.0f);
+            else if (s < -0.6f) s = -0.6f + 0.4f * std::tanh((s + 0.6f) * 2.0f);
+            audio[i * 2] = s;
+            audio[i * 2 + 1] = s;
+        }
+    }
+
+    const float squelchDb = m_squelchDb.load();
+    bool open = true;
+    if (squelchDb > SQUELCH_OFF) {
+        const float threshold = info.open ? squelchDb - SQUELCH_HYSTERESIS_DB : squelchDb;
+        open = info.levelDb >= threshold;
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_stateMutex);
+        info.open = open;
+        if (!open) {
+            vfo.pending.clear();
+            return;
+        }
+        vfo.pending.insert(vfo.pending.end(), audio.begin(), audio.end());
+        if (vfo.pending.size() > MAX_PENDING) {
+            vfo.pending.erase(vfo.pending.begin(), vfo.pending.end() - MAX_PENDING);
+        }
+    }
+
+    if (vfo.wav) {
+        const size_t frames = audio.size() / 2;
+        vfo.pcm.resize(frames);
+        for (size_t i = 0; i < frames; i++) {
+            const float s = std::clamp(0.5f * (audio[i * 2] + audio[i * 2 + 1]), -1.0f, 1.0f);
+            vfo.pcm[i] = static_cast<qint16>(std::lround(s * 32767.0f));
+        }
+        const qint64 bytes = static_cast<qint64>(frames * sizeof(qint16));
+        if (vfo.wav->write(reinterpret_cast<const char*>(vfo.pcm.data()), bytes) == bytes) {
+            vfo.wavBytes += static_cast<quint32>(bytes);
+        }
+    }
+}
+
+void MultiVfo::process(const std::vector<std::complex<float>>& samples)
+{
+    if (m_vfos.empty() || samples.empty() || m_sampleRate <= 0.0) return;
+
+    // Never wait for the VFOs here; a backlog drops blocks instead
+    if (m_queuedBlocks.load() >= MAX_QUEUED_BLOCKS) {
+        m_inputGap.store(true);
+        return;
+    }
+    m_queuedBlocks.fetch_add(1);
+    auto block = std::make_shared<std::vector<std::complex<float>>>(samples);
+    QtConcurrent::run(m_blockPool, [this, block]() {
+        processBlock(*block);
+        m_queuedBlocks.fetch_sub(1);
+    });
+}
+
+void MultiVfo::processBlock(const std::vector<std::complex<float>>& samples)
+{
+    std::lock_guard<std::mutex> lock(m_dspMutex);
+    if (m_inputGap.exchange(false)) {
+        m_channelizer.reset();
+    }
+    if (m_vfos.empty()) return;
+
+    m_channelizer.process(samples.data(), samples.size());
+    if (m_channelizer.frames() == 0) return;
+
+    if (m_vfos.size() == 1) {
+        runVfo(*m_vfos.front());
+        return;
+    }
+    QtConcurrent::blockingMap(m_pool, m_vfos, [this](std::unique_ptr<Vfo>& vfo) { runVfo(*vfo); });
+}
+
+void MultiVfo::mixInto(std::vector<float>& stereo)
+{
+    const size_t frames = stereo.size() / 2;
+    bool mixed = false;
+    std::lock_guard<std::mutex> lock(m_stateMutex);
+    for (auto& vfo : m_vfos) {
+        const size_t n = std::min(frames, vfo->pending.size() / 2);
+        if (n == 0) continue;
+        // Balance law: centre feeds both sides at full level
+        const float gl = std::min(1.0f, 1.0f - vfo->info.pan);
+        const float gr = std::min(1.0f, 1.0f + vfo->info.pan);
+        const float* p = vfo->pending.data();
+        for (size_t i = 0; i < n; i++) {
+            stereo[i * 2] += p[i * 2] * gl;
+            stereo[i * 2 + 1] += p[i * 2 + 1] * gr;
+        }
+        vfo->pending.erase(vfo->pending.begin(), vfo->pending.begin() + n * 2);
+        mixed = true;
+    }
+    if (mixed) {
+        for (auto& s : stereo) s = std::clamp(s, -1.0f, 1.0f);
+    }
+}
@@ -0,0 +1,127 @@
+#ifndef MULTIVFO_H
+#define MULTIVFO_H
+
+#include <QObject>
+#include <QString>
+#include <QVector>
+#include <atomic>
+#include <complex>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include "channelizer.h"
+
+class QThreadPool;
+
+// Extra receivers inside the current capture.
+//
+// Every VFO sits at an absolute frequency with its own mode and filter.
+// One Channelizer transform per block serves all of them; each VFO then
+// runs its own FMDemodulator or AMDemodulator on its narrow channel, on
+// a private thread pool (one task per VFO, so the block costs about the
+// slowest VFO). The 48 kHz stereo outputs are gated by an in-band power
+// squelch, panned and summed into the main audio by mixInto(), and can
+// each be recorded to a mono WAV file.
+//
+// VFOs outside the capture keep their settings and resume when a retune
+// brings them back. All calls from the GUI thread. process() only queues
+// the block for a worker thread, so VFO audio reaches mixInto() a block
+// or so later; calls that change VFOs wait for the block in progress.
+class MultiVfo : public QObject
+{
+    Q_OBJECT
+
+public:
+    // Same order as RadioWindow::Modulation
+    enum Mode { NFM, WFM, AM };
+
+    struct Info {
+        int id = 0;
+        qint64 frequency = 0;
+        Mode mode = NFM;
+        double bandwidth = 0.0;
+        double channelRate = 0.0;
+        float pan = 0.0f;           // -1 left .. +1 right
+        bool active = false;        // inside the capture
+        bool open = false;          // squelch open
+        bool recording = false;
+        float levelDb = -200.0f;
+    };
+
+    static constexpr int MAX_VFOS = 64;
+    static constexpr float SQUELCH_OFF = -200.0f;
+    static constexpr float SQUELCH_HYSTERESIS_DB = 3.0f;
+
+    explicit MultiVfo(QObject *parent = nullptr);
+    ~MultiVfo();
+
+    void setSampleRate(double rate);
+    void setCenterFrequency(qint64 hz);
+
+    // Returns the new id, or -1 when MAX_VFOS are in use
+    int addVfo(qint64 frequency, Mode mode, double bandwidth);
+    bool removeVfo(int id);
+    void clear();
+    int count() const { return static_cast<int>(m_vfos.size()); }
+    QVector<Info> vfos() const;
+    // Id of the VFO whose passband (plus 'slack') holds the frequency, or -1
+    int vfoAt(qint64 frequency, qint64 slack) const;
+
+    void setPan(int id, float pan);
+    void setAmGain(float gain) { m_amGain.store(gain); }
+    // In-band channel power to open at, dBFS; SQUELCH_OFF keeps all open
+    void setSquelch(float dbfs) { m_squelchDb.store(dbfs); }
+    float squelch() const { return m_squelchDb.load(); }
+
+    // Recording: one WAV per VFO in the directory, while its squelch is open
+    void setRecordDirectory(const QString& dir) { m_recordDir = dir; }
+    void setRecording(bool on);
+    bool isRecording() const { return m_recording; }
+
+    // Drop filter history (retune, sample gap)
+    void reset();
+
+    // Queues the block; returns at once
+    void process(const std::vector<std::complex<float>>& samples);
+    // Adds the VFO audio to interleaved 48 kHz stereo; what does not fit
+    // waits for the next block
+    void mixInto(std::vector<float>& stereo);
+
+signals:
+    void vfosChanged();
+
+private:
+    struct Vfo;
+
+    void setupVfo(Vfo& vfo);
+    void processBlock(const std::vector<std::complex<float>>& samples);
+    void runVfo(Vfo& vfo);
+    void startRecording(Vfo& vfo);
+    static double minChannelRate(Mode mode, double bandwidth);
+
+    static constexpr int MAX_QUEUED_BLOCKS = 4;
+
+    Channelizer m_channelizer;
+    std::vector<std::unique_ptr<Vfo>> m_vfos;
+    QThreadPool* m_pool;
+    QThreadPool* m_blockPool;           // one thread: blocks in order
+
+    // Held by the block thread for a whole block and by every GUI call
+    // that changes the VFOs or the channelizer; the vector itself only
+    // changes on the GUI thread, so GUI reads need no lock
+    std::mutex m_dspMutex;
+    // VFO audio and the status the block thread writes into Info
+    mutable std::mutex m_stateMutex;
+    std::atomic<int> m_queuedBlocks{0};
+    std::atomic<bool> m_inputGap{false};  // blocks dropped, restart the filters
+
+    double m_sampleRate = 0.0;
+    qint64 m_centerFrequency = 0;
+    int m_nextId = 1;
+    std::atomic<float> m_amGain{3.0f};
+    std::atomic<float> m_squelchDb{SQUELCH_OFF};
+    QString m_recordDir;
+    bool m_recording = false;
+};
+
+#endif // MULTIVFO_H
@@ -0,0 +1,62 @@
+#ifndef POLYPHASERESAMPLER_H
+#define POLYPHASERESAMPLER_H
+
+#include <vector>
+#include <cstddef>
+
+// Arbitrary-ratio resampler for the audio outputs (anything -> 48 kHz).
+//
+// The windowed-sinc prototype (Blackman-Harris, as the old per-sample
+// kernel) is sampled once into PHASES + 1 rows of 'taps' coefficients; an
+// output sample is the inner product of the input history with the two
+// rows around its fractional position, interpolated linearly. Each row is
+// normalised to unit DC gain, so the gain does not ripple with the phase.
+//
+// Cutoff is passband x half the lower of the two rates. When decimating,
+// the filter is stretched by the ratio (more taps per phase) so the
+// transition band stays the same width at the output; taps are capped at
+// MAX_TAPS. Position and history carry over between blocks, so block
+// boundaries are seamless; the delay is taps / 2 input samples.
+// Not thread safe: one instance per stream (per channel for stereo).
+class PolyphaseResampler
+{
+public:
+    static constexpr int PHASES = 256;
+    static constexpr int DEFAULT_TAPS = 32;     // per phase at ratio <= 1
+    static constexpr int MAX_TAPS = 512;
+    static constexpr double DEFAULT_PASSBAND = 0.85;
+
+    PolyphaseResampler();
+
+    // Rebuilds the bank (and clears the history) only when something changed
+    void setRates(double inRate, double outRate,
+                  double passband = DEFAULT_PASSBAND, int taps = DEFAULT_TAPS);
+    double inRate() const { return m_inRate; }
+    double outRate() const { return m_outRate; }
+    int taps() const { return m_taps; }
+    bool isValid() const { return m_taps > 0; }
+
+    // Drop the history (retune, mode change), keep the bank
+    void reset();
+
+    // Appends the output samples of this block to out
+    void process(const float* in, size_t count, std::vector<float>& out);
+    std::vector<float> process(const std::vector<float>& in);
+
+private:
+    void buildBank();
+
+    double m_inRate;
+    double m_outRate;
+    double m_passband;
+    int m_baseTaps;
+
+    int m_taps;                 // per phase, multiple of 4
+    double m_step;              // input samples per output sample
+    std::vector<float> m_bank;  // (PHASES + 1) x m_taps
+
+    std::vector<float> m_history;
+    double m_position;          // next output, in m_history samples
+};
+
+#endif // POLYPHASERESAMPLER_H
@@ -1,5 +1,6 @@
 #include "radiowindow.h"
 #include "constants.h"
+#include "threadplacement.h"
 #include <QVBoxLayout>
 #include <QHBoxLayout>
 #include <QGridLayout>
@@ -11,6 +12,8 @@
 #include <QScrollArea>
 #include <QScroller>
 #include <QFrame>
+#include <QStandardPaths>
+#include <QDir>
 #include <cmath>
 
 #ifdef Q_OS_ANDROID
@@ -26,7 +29,15 @@ RadioWindow::RadioWindow(QWidget *parent)
     , m_audioPlayback(new AudioPlayback(this))
     , m_fmDemod(new FMDemodulator(2000000.0, 12500.0, this))
     , m_amDemod(new AMDemodulator(2000000.0, 10000.0, this))
+    , m_multiVfo(new MultiVfo(this))
+    , m_scanner(new BandScanner(this))
     , m_gainDialog(nullptr)
+    , m_iqNetwork(m_latency.stage("iq.network"))
+    , m_iqAccumulate(m_latency.stage("iq.accumulate"))
+    , m_demodLatency(m_latency.stage("demod"))
+    , m_audioOut(m_latency.stage("audio.out"))
+    , m_rxTotal(m_latency.stage("rx.total"))
+    , m_micFlush(m_latency.stage("mic.flush"))
 {
     setWindowTitle("HackRF Radio");
     setMinimumSize(320, 600);
@@ -81,6 +92,8 @@ RadioWindow::RadioWindow(QWidget *parent)
 
     // Auto-save when any setting changes
     connect(m_gainDialog, &GainSettingsDialog::settingsChanged, this, &RadioWindow::saveSettings);
+    connect(m_gainDialog, &GainSettingsDialog::latencyReportRequested, this, &RadioWindow::logLatencyReport);
+    connect(m_gainDialog, &GainSettingsDialog::latencyResetRequested, this, &RadioWindow::resetLatency);
 
     loadSettings();
 
@@ -108,8 +121,60 @@ RadioWindow::RadioWindow(QWidget *parent)
     connect(m_tcpClient, &TcpClient::connectionError, this, &RadioWindow::onConnectionError);
     connect(m_tcpClient, &TcpClient::controlResponseReceived, this, &RadioWindow::onControlResponse);
     connect(m_tcpClient, &TcpClient::iqDataReceived, this, &RadioWindow::onIqDataReceived);
+    m_tcpClient->setLatencyStage(&m_iqNetwork);
+    connect(m_tcpClient, &TcpClient::multicastGap, this, [this](quint64 missing, quint64 total) {
+        m_gapSamplesSinceLog += missing;
+        if (m_gapLogTimer.isValid() && m_gapLogTimer.elapsed() < 1000) return;
+        m_gapLogTimer.start();
+        logMessage(QString("Multicast: %1 samples lost (zero-filled), %2 total")
+                       .arg(m_gapSamplesSinceLog).arg(total));
+        m_gapSamplesSinceLog = 0;
+    });
+    connect(m_tcpClient, &TcpClient::retuned, this, [this](quint32, qint64 ms) {
+        // Samples from the old frequency must not reach the demodulator
+        m_iqAccumulator.clear();
+        m_multiVfo->reset();
+        m_scanner->onRetuned();
+        if (ms >= 0 && (!m_retuneLogTimer.isValid() || m_retuneLogTimer.elapsed() >= 1000)) {
+            m_retuneLogTimer.start();
+            logMessage(QString("Retuned in %1 ms (IQ latency %2 ms, %3 stale blocks dropped)")
+                           .arg(ms).arg(m_tcpClient->iqLatencyMs(), 0, 'f', 1)
+                           .arg(m_tcpClient->staleBlocks()));
+        }
+    });
     connect(m_audioCapture, &AudioCapture::audioDataReady, this, &RadioWindow::onAudioCaptured);
 
+    // Multi-VFO recordings go next to the user's music
+    m_multiVfo->setRecordDirectory(
+        QStandardPaths::writableLocation(QStandardPaths::MusicLocation) + "/HackRfRadio");
+    connect(m_cPlotter, &CPlotter::vfoClicked, this, &RadioWindow::onVfoClicked);
+    connect(m_multiVfo, &MultiVfo::vfosChanged, this, &RadioWindow::updateVfoMarkers);
+    updateVfoMarkers();
+
+    // Band scanner: hops the radio itself, the tuned frequency stays put
+    connect(m_scanner, &BandScanner::retuneRequested, this, [this](quint64 freq) {
+        m_tcpClient->setFrequency(freq);
+        m_cPlotter->setCenterFreq(freq);
+    });
+    connect(m_scanner, &BandScanner::activity, this, [this](const BandScanner::Activity& a) {
+        logMessage(QString("Scan %1 %2 MHz %3 (%4 dBFS, %5 dB over floor) %6%7")
+                       .arg(a.time.toString("HH:mm:ss.zzz"))
+                       .arg(a.frequency / 1e6, 0, 'f', 5)
+                       .arg(a.open ? "active" : "quiet")
+                       .arg(a.levelDb, 0, 'f', 1)
+                       .arg(a.snrDb, 0, 'f', 1)
+                       .arg(a.label)
+                       .arg(a.priority ? " (priority)" : ""));
+    });
+    connect(m_scanner, &BandScanner::sweepCompleted, this, [this](double mhzPerSecond, double sweepMs, double retuneMs) {
+        m_scanBtn->setText(QString("SCAN %1 MHz/s").arg(mhzPerSecond, 0, 'f', 0));
+        if (m_scanLogTimer.isValid() && m_scanLogTimer.elapsed() < 10000) return;
+        m_scanLogTimer.start();
+        logMessage(QString("Scan: %1 hops in %2 ms, %3 MHz/s, %4 ms per retune")
+                       .arg(m_scanner->hopCount()).arg(sweepMs, 0, 'f', 0)
+                       .arg(mhzPerSecond, 0, 'f', 1).arg(retuneMs, 0, 'f', 1));
+    });
+
     // Stereo indicator
     connect(m_fmDemod, &FMDemodulator::stereoStatusChanged, this, [this](bool stereo) {
         if (m_forceMono) {
@@ -151,6 +216,9 @@ void RadioWindow::saveSettings()
     s.setValue("dataPort", m_gainDialog->dataPort());
     s.setValue("controlPort", m_gainDialog->controlPort());
     s.setValue("audioPort", m_gainDialog->audioPort());
+    s.setValue("multicast", m_gainDialog->multicastEnabled());
+    s.setValue("iqEncoding", m_gainDialog->iqEncoding());
+    s.setValue("binaryProtocol", m_gainDialog->binaryProtocolEnabled());
 
     // Frequency
     s.setValue("frequency", QVariant::fromValue(m_freqWidget->frequency()));
@@ -175,8 +243,23 @@ void RadioWindow::saveSettings()
     s.setValue("deemph", m_gainDialog->deemph());
     s.setValue("audioLpf", m_gainDialog->audioLpf());
     s.setValue("fmnr", m_gainDialog->fmnrEnabled());
+    s.setValue("amDetector", m_gainDialog->amDetector());
     s.setValue("ampEnable", m_gainDialog->ampEnabled());
 
+    // Multi-VFO: "frequency:mode:bandwidth" per receiver
+    QStringList vfoList;
+    for (const auto& v : m_multiVfo->vfos())
+        vfoList << QString("%1:%2:%3").arg(v.frequency).arg(static_cast<int>(v.mode)).arg(v.bandwidth, 0, 'f', 0);
+    s.setValue("vfos", vfoList);
+    s.setValue("vfoSquelch", m_vfoSquelchSlider->value());
+
+    // Scanner: "label:start:stop:step:bandwidth" per band, "frequency:bandwidth[:label]" per priority channel
+    const BandScanner::Config& scan = m_scanner->config();
+    s.setValue("scanBands", BandScanner::formatBands(scan.bands));
+    s.setValue("scanPriority", BandScanner::formatChannels(scan.priority));
+    s.setValue("scanDwellMs", scan.dwellMs);
+    s.setValue("scanThresholdDb", scan.thresholdDb);
+
     // Device type
     s.setValue("isHackRf", m_isHackRf);
 
@@ -197,12 +280,25 @@ void RadioWindow::loadSettings()
         return;
     }
 
+    // Read before onModulationChanged() saves the settings back
+    const QStringList savedVfos = s.value("vfos").toStringList();
+    const int savedVfoSquelch = s.value("vfoSquelch", 40).toInt();
+    BandScanner::Config scan = m_scanner->config();
+    if (s.contains("scanBands")) scan.bands = BandScanner::parseBands(s.value("scanBands").toStringList());
+    scan.priority = BandScanner::parseChannels(s.value("scanPriority").toStringList());
+    scan.dwellMs = s.value("scanDwellMs", scan.dwellMs).toInt();
+    scan.thresholdDb = s.value("scanThresholdDb", scan.thresholdDb).toFloat();
+    m_scanner->setConfig(scan);
+
     // Connection
     if (m_gainDialog) {
         m_gainDialog->setHost(s.value("host", "192.168.1.8").toString());
         m_gainDialog->setDataPort(s.value("dataPort", 5000).toInt());
         m_gainDialog->setControlPort(s.value("controlPort", 5001).toInt());
         m_gainDialog->setAudioPort(s.value("audioPort", 5002).toInt());
+        m_gainDialog->setMulticastEnabled(s.value("multicast", false).toBool());
+        m_gainDialog->setIqEncoding(s.value("iqEncoding", "raw").toString());
+        m_gainDialog->setBinaryProtocolEnabled(s.value("binaryProtocol", false).toBool());
     }
 
     // Frequency
@@ -238,6 +334,7 @@ void RadioWindow::loadSettings()
         m_gainDialog->setDeemph(s.value("deemph", 0).toInt());
         m_gainDialog->setAudioLpf(s.value("audioLpf", 50).toInt());
         m_gainDialog->setFmnrEnabled(s.value("fmnr", true).toBool());
+        m_gainDialog->setAmDetector(s.value("amDetector", 0).toInt());
         m_gainDialog->setAmpEnabled(s.value("ampEnable", false).toBool());
         m_gainDialog->blockSignals(false);
     }
@@ -260,6 +357,18 @@ void RadioWindow::loadSettings()
     m_cPlotter->setSpanFreq(static_cast<quint32>(m_sampleRate));
     m_cPlotter->setCenterFreq(static_cast<quint64>(freq));
 
+    // Multi-VFO
+    m_multiVfo->setSampleRate(m_sampleRate);
+    m_multiVfo->setCenterFrequency(static_cast<qint64>(freq));
+    m_multiVfo->clear();
+    for (const QString& entry : savedVfos) {
+        const QStringList f = entry.split(':');
+        if (f.size() != 3) continue;
+        const int mode = std::clamp(f[1].toInt(), 0, 2);
+        m_multiVfo->addVfo(f[0].toLongLong(), static_cast<MultiVfo::Mode>(mode), f[2].toDouble());
+    }
+    m_vfoSquelchSlider->setValue(savedVfoSquelch);
+
     // Apply volume and squelch
     m_audioPlayback->setVolume(m_volumeSlider->value() / 100.0f);
     m_volumeLabel->setText(QString("%1%").arg(m_volumeSlider->value()));
@@ -484,6 +593,58 @@ void RadioWindow::setupUi()
     m_cPlotter->setMaximumHeight(300);
     m_cPlotter->setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Expanding);
     mainLayout->addWidget(m_cPlotter, 1);
+    mainLayout->addSpacing(4);
+
+    // ──────────────────────────────────────────────
+    // MULTI-VFO row: VFO = tap spectrum to add/remove receivers
+    // ──────────────────────────────────────────────
+    QHBoxLayout* vfoRow = new QHBoxLayout();
+    vfoRow->setSpacing(8);
+
+    m_vfoBtn = new QPushButton("VFO");
+    m_vfoBtn->setObjectName("cycleBtn");
+    m_vfoBtn->setCheckable(true);
+    m_vfoBtn->setMinimumHeight(40);
+    connect(m_vfoBtn, &QPushButton::toggled, [this](bool checked) {
+        m_cPlotter->setVfoPlacementEnabled(checked);
+        m_vfoBtn->setText(checked ? "TAP SPECTRUM" : "VFO");
+    });
+    vfoRow->addWidget(m_vfoBtn, 1);
+
+    m_vfoLabel = new QLabel("");
+    m_vfoLabel->setAlignment(Qt::AlignCenter);
+    m_vfoLabel->setMinimumWidth(60);
+    m_vfoLabel->setStyleSheet("font-weight: bold; font-size: 14px; color: #00FF66;");
+    vfoRow->addWidget(m_vfoLabel);
+
+    m_vfoRecBtn = new QPushButton("REC");
+    m_vfoRecBtn->setObjectName("rfAmpBtn");
+    m_vfoRecBtn->setCheckable(true);
+    m_vfoRecBtn->setMinimumHeight(40);
+    connect(m_vfoRecBtn, &QPushButton::toggled, [this](bool checked) {
+        m_multiVfo->setRecording(checked);
+        if (checked) logMessage("Recording VFOs to " +
+            QStandardPaths::writableLocation(QStandardPaths::MusicLocation) + "/HackRfRadio");
+    });
+    vfoRow->addWidget(m_vfoRecBtn);
+
+    m_vfoClearBtn = new QPushButton("CLR");
+    m_vfoClearBtn->setObjectName("cycleBtn");
+    m_vfoClearBtn->setMinimumHeight(40);
+    connect(m_vfoClearBtn, &QPushButton::clicked, [this]() {
+        m_multiVfo->clear();
+        saveSettings();
+    });
+    vfoRow->addWidget(m_vfoClearBtn);
+
+    m_scanBtn = new QPushButton("SCAN");
+    m_scanBtn->setObjectName("cycleBtn");
+    m_scanBtn->setCheckable(true);
+    m_scanBtn->setMinimumHeight(40);
+    connect(m_scanBtn, &QPushButton::toggled, this, &RadioWindow::setScanning);
+    vfoRow->addWidget(m_scanBtn, 1);
+
+    mainLayout->addLayout(vfoRow);
     mainLayout->addSpacing(8);
 
     // ──────────────────────────────────────────────
@@ -549,6 +710,31 @@ void RadioWindow::setupUi()
     sliderGrid->addWidget(m_mainIfBwSlider, 1, 1);
     sliderGrid->addWidget(m_mainIfBwLabel, 1, 2);
 
+    // VFO squelch: in-band channel power, shown while VFOs exist
+    m_vfoSquelchIcon = new QLabel("SQL");
+    m_vfoSquelchIcon->setObjectName("sliderIcon");
+    m_vfoSquelchSlider = new QSlider(Qt::Horizontal);
+    m_vfoSquelchSlider->setRange(0, 100);
+    m_vfoSquelchSlider->setValue(40);
+    m_vfoSquelchSlider->setMinimumHeight(36);
+    m_vfoSquelchLabel = new QLabel("-80 dB");
+    m_vfoSquelchLabel->setMinimumWidth(60);
+    m_vfoSquelchLabel->setAlignment(Qt::AlignRight | Qt::AlignVCenter);
+    connect(m_vfoSquelchSlider, &QSlider::valueChanged, [this](int v) {
+        // 0 = off, else -120 .. -20 dBFS
+        const float db = (v == 0) ? MultiVfo::SQUELCH_OFF : -120.0f + v;
+        m_multiVfo->setSquelch(db);
+        m_vfoSquelchLabel->setText(v == 0 ? QString("OFF") : QString("%1 dB").arg(static_cast<int>(db)));
+    });
+    connect(m_vfoSquelchSlider, &QSlider::sliderReleased, this, &RadioWindow::saveSettings);
+    sliderGrid->addWidget(m_vfoSquelchIcon, 2, 0);
+    sliderGrid->addWidget(m_vfoSquelchSlider, 2, 1);
+    sliderGrid->addWidget(m_vfoSquelchLabel, 2, 2);
+    m_vfoSquelchIcon->setVisible(false);
+    m_vfoSquelchSlider->setVisible(false);
+    m_vfoSquelchLabel->setVisible(false);
+    m_multiVfo->setSquelch(-80.0f);
+
     sliderGrid->setColumnStretch(1, 1);
     mainLayout->addLayout(sliderGrid);
     mainLayout->addSpacing(6);
@@ -700,6 +886,9 @@ void RadioWindow::onConnectClicked()
     int dp = m_gainDialog ? m_gainDialog->dataPort() : 5000;
     int cp = m_gainDialog ? m_gainDialog->controlPort() : 5001;
     int ap = m_gainDialog ? m_gainDialog->audioPort() : 5002;
+    m_tcpClient->setMulticastMode(m_gainDialog && m_gainDialog->multicastEnabled());
+    m_tcpClient->setEncoding(m_gainDialog ? m_gainDialog->iqEncoding() : "raw");
+    m_tcpClient->setBinaryProtocol(m_gainDialog && m_gainDialog->binaryProtocolEnabled());
     logMessage(QString("Connecting to %1...").arg(host));
     m_tcpClient->connectToServer(host, dp, cp, ap);
 }
@@ -710,6 +899,9 @@ void RadioWindow::onConnected()
     m_connectionStatus->setStyleSheet("color: #44FF44; font-weight: bold; font-size: 13px;");
     m_connectBtn->setText("Disconnect");
     logMessage("Connected to server");
+    if (m_tcpClient->isSharedMemory()) {
+        logMessage("IQ via shared memory (server on this host)");
+    }
 
     // Start audio devices
     m_audioPlayback->start();
@@ -733,6 +925,11 @@ void RadioWindow::onConnected()
     // Query server for current device type to sync toggle
     m_tcpClient->requestDevice();
 
+    // Multicast IQ: ask the server where to listen (handled in onControlResponse)
+    if (m_tcpClient->isMulticastMode()) {
+        m_tcpClient->sendCommand("GET_MULTICAST");
+    }
+
     // Apply IF bandwidth from slider
     if (m_gainDialog) {
         int bwVal = m_gainDialog->ifBandwidth();
@@ -760,6 +957,7 @@ void RadioWindow::onDisconnected()
     m_audioCapture->stop();
     m_micStarted = false;
     m_isTx = false;
+    m_scanBtn->setChecked(false);
     logMessage("Disconnected");
 }
 
@@ -778,6 +976,23 @@ void RadioWindow::onControlResponse(const QString& response) {
             m_pttButton->setEnabled(isHackRf);
         }
     }
+    else if (response.startsWith("MULTICAST:")) {
+        QString target = response.mid(10).trimmed();
+        int colon = target.lastIndexOf(':');
+        QHostAddress group(target.left(colon));
+        quint16 port = target.mid(colon + 1).toUShort();
+        if (colon > 0 && port && m_tcpClient->joinMulticast(group, port)) {
+            logMessage(QString("Receiving IQ from multicast %1:%2").arg(group.toString()).arg(port));
+        } else {
+            logMessage("Multicast join failed, using the TCP data port");
+            m_tcpClient->connectDataSocket();
+        }
+        return;
+    }
+    else if (response.startsWith("ERROR: Multicast")) {
+        // Server runs without --multicast
+        m_tcpClient->connectDataSocket();
+    }
     // Only log non-OK responses (errors/info, not routine confirmations)
     if (!response.startsWith("OK:"))
         logMessage("Server: " + response);
@@ -790,6 +1005,11 @@ void RadioWindow::onControlResponse(const QString& response) {
 void RadioWindow::onIqDataReceived(const QByteArray& data)
 {
     if (m_isTx) return;
+    if (m_scanner->isRunning()) {
+        m_scanner->processIq(data);
+        return;
+    }
+    if (m_iqAccumulator.isEmpty()) m_iqAccumulatorUs = LatencyHistogram::steadyUs();
     m_iqAccumulator.append(data);
     while (m_iqAccumulator.size() >= IQ_PROCESS_THRESHOLD) processIqBuffer();
 }
@@ -798,8 +1018,11 @@ void RadioWindow::processIqBuffer()
 {
     if (m_iqAccumulator.size() < IQ_PROCESS_THRESHOLD) return;
 
+    const qint64 startUs = LatencyHistogram::steadyUs();
+    m_iqAccumulate.record(startUs - m_iqAccumulatorUs);
     QByteArray chunk = m_iqAccumulator.left(IQ_PROCESS_THRESHOLD);
     m_iqAccumulator.remove(0, IQ_PROCESS_THRESHOLD);
+    m_iqAccumulatorUs = startUs;        // the rest came in with the last read
 
     const int8_t* iq = reinterpret_cast<const int8_t*>(chunk.constData());
     size_t n = chunk.size() / 2;
@@ -832,6 +1055,12 @@ void RadioWindow::processIqBuffer()
         m_lastSignalLevel = std::clamp(level, 0.0f, 1.0f);
     }
 
+    const bool multiVfo = m_multiVfo->count() > 0;
+    if (multiVfo) {
+        m_multiVfo->setAmGain(m_gainDialog ? (m_gainDialog->rxGain() / 100.0f) : 5.0f);
+        m_multiVfo->process(samples);
+    }
+
     std::vector<float> audio;
     switch (m_currentModulation) {
     case FM_NB: case FM_WB:
@@ -856,10 +1085,26 @@ void RadioWindow::processIqBuffer()
     }
 
     if (!audio.empty()) {
-        if (m_squelchLevel <= 0.001f || m_lastSignalLevel >= m_squelchLevel) {
+        const bool mainOpen = m_squelchLevel <= 0.001f || m_lastSignalLevel >= m_squelchLevel;
+        if (multiVfo) {
+            // The VFOs ride on the main audio timing; a closed main squelch
+            // only silences the main receiver
+            if (!mainOpen) std::fill(audio.begin(), audio.end(), 0.0f);
+            m_multiVfo->mixInto(audio);
+            m_audioPlayback->enqueueAudio(audio);
+        } else if (mainOpen) {
             m_audioPlayback->enqueueAudio(audio);
         }
     }
+
+    m_demodLatency.record(LatencyHistogram::steadyUs() - startUs);
+    const double audioMs = m_audioPlayback->latencyMs();
+    m_audioOut.recordMs(audioMs);
+    // Age of the newest block's first sample plus what is queued ahead of it
+    if (m_tcpClient->lastCaptureUs()) {
+        m_rxTotal.record(LatencyHistogram::utcUs() - m_tcpClient->lastCaptureUs() +
+                         static_cast<int64_t>(audioMs * 1000.0));
+    }
 }
 
 // ============================================================
@@ -870,6 +1115,7 @@ void RadioWindow::onPttPressed()
 {
     if (!m_tcpClient->isConnected() || m_isTx || !m_isHackRf) return;
 
+    m_scanBtn->setChecked(false);
     m_isTx = true;
     m_iqAccumulator.clear();
 
@@ -916,12 +1162,13 @@ void RadioWindow::onPttReleased()
     logMessage("PTT OFF");
 }
 
-void RadioWindow::onAudioCaptured(const std::vector<float>& samples)
+void RadioWindow::onAudioCaptured(const std::vector<float>& samples, qint64 captureUs)
 {
     if (!m_isTx || !m_tcpClient->isConnected()) return;
 
     // Always send audio immediately - never block TX
-    m_tcpClient->sendAudioData(samples.data(), samples.size());
+    m_tcpClient->sendAudioData(samples.data(), samples.size(), m_audioCapture->sampleRate(), captureUs);
+    m_micFlush.record(LatencyHistogram::utcUs() - captureUs);
 
     // Accumulate mic samples for FFT display
     static std::vector<float> micFftBuf;
@@ -987,8 +1234,16 @@ void RadioWindow::keyReleaseEvent(QKeyEvent *event)
 
 void RadioWindow::onFrequencyChanged(uint64_t freq)
 {
+    // Tuning by hand ends the scan
+    if (m_scanner->isRunning()) {
+        m_scanBtn->blockSignals(true);
+        m_scanBtn->setChecked(false);
+        m_scanBtn->blockSignals(false);
+        setScanning(false);
+    }
     if (m_tcpClient->isConnected()) m_tcpClient->setFrequency(freq);
     m_cPlotter->setCenterFreq(static_cast<quint64>(freq));
+    m_multiVfo->setCenterFrequency(static_cast<qint64>(freq));
 }
 
 // ============================================================
@@ -1091,6 +1346,7 @@ void RadioWindow::onModulationChanged(int index)
     }
     m_fmDemod->setSampleRate(m_sampleRate);
     m_amDemod->setSampleRate(m_sampleRate);
+    m_multiVfo->setSampleRate(m_sampleRate);
     m_cPlotter->setSampleRate(m_sampleRate);
     m_cPlotter->setSpanFreq(static_cast<quint32>(m_sampleRate));
 
@@ -1140,8 +1396,11 @@ void RadioWindow::onBwChanged(int index)
 
     m_fmDemod->setSampleRate(m_sampleRate);
     m_amDemod->setSampleRate(m_sampleRate);
+    m_multiVfo->setSampleRate(m_sampleRate);
     m_cPlotter->setSampleRate(m_sampleRate);
     m_cPlotter->setSpanFreq(static_cast<quint32>(m_sampleRate));
+    // New rate, new hop plan
+    if (m_scanner->isRunning()) setScanning(true);
 
     if (m_gainDialog) {
         float rxGain = m_gainDialog->rxGain() / 100.0f;
@@ -1163,11 +1422,129 @@ void RadioWindow::logMessage(const QString& msg)
     qDebug() << "[Radio]" << msg;
 }
 
+void RadioWindow::logLatencyReport()
+{
+    const auto stages = m_latency.summaries();
+    logMessage(QString("Latency (ms), %1 stages here:").arg(stages.size()));
+    for (const auto& stage : stages) {
+        logMessage(QString::fromStdString(LatencyRecorder::formatLine(stage.first, stage.second)).trimmed());
+    }
+    for (const std::string& line : ThreadPlacement::report()) {
+        logMessage("Threads: " + QString::fromStdString(line));
+    }
+    // The server's stages come back as "Server: " lines
+    if (m_tcpClient->isConnected()) m_tcpClient->sendCommand("GET_LATENCY");
+}
+
+void RadioWindow::resetLatency()
+{
+    m_latency.reset();
+    if (m_tcpClient->isConnected()) m_tcpClient->sendCommand("RESET_LATENCY");
+    logMessage("Latency histograms cleared");
+}
+
 void RadioWindow::updatePlotter(float* fft_data, int size)
 {
     m_fftUpdatePending.storeRelease(0);
     m_cPlotter->setNewFttData(fft_data, size);
     delete[] fft_data;
+    // Squelch state changes every block; refresh along with the spectrum
+    if (m_multiVfo->count() > 0) updateVfoMarkers();
+}
+
+// ============================================================
+// Multi-VFO
+// ============================================================
+
+void RadioWindow::onVfoClicked(qint64 freq)
+{
+    // Snap to the channel raster: 6.25 kHz covers the 12.5 kHz and PMR plans
+    const qint64 raster = (m_currentModulation == FM_WB) ? 100000 : 6250;
+    const qint64 snapped = (freq + raster / 2) / raster * raster;
+
+    m_multiVfo->setCenterFrequency(static_cast<qint64>(m_freqWidget->frequency()));
+    const int hit = m_multiVfo->vfoAt(freq, raster / 2);
+    if (hit >= 0) {
+        m_multiVfo->removeVfo(hit);
+    } else {
+        const double bw = (m_currentModulation == AM) ? m_amDemod->bandwidth() : m_fmDemod->bandwidth();
+        const int id = m_multiVfo->addVfo(snapped, static_cast<MultiVfo::Mode>(m_currentModulation), bw);
+        if (id < 0) {
+            logMessage(QString("At most %1 VFOs").arg(MultiVfo::MAX_VFOS));
+            return;
+        }
+        logMessage(QString("VFO %1 at %2 MHz (%3 channel at %4 kS/s)")
+                       .arg(m_multiVfo->count())
+                       .arg(snapped / 1e6, 0, 'f', 5)
+                       .arg(m_modEntries[m_modulationIndex].shortLabel)
+                       .arg(m_multiVfo->vfos().back().channelRate / 1000.0, 0, 'f', 1));
+    }
+    saveSettings();
+}
+
+void RadioWindow::updateVfoMarkers()
+{
+    const auto vfos = m_multiVfo->vfos();
+    QVector<CPlotter::VfoMarker> markers;
+    markers.reserve(vfos.size());
+    int open = 0;
+    for (const auto& v : vfos) {
+        markers.append({v.frequency, static_cast<int>(v.bandwidth), v.active, v.open});
+        if (v.open) open++;
+    }
+    m_cPlotter->setVfoMarkers(markers);
+
+    const bool any = !vfos.isEmpty();
+    m_vfoLabel->setText(any ? QString("%1/%2").arg(open).arg(vfos.size()) : QString());
+    m_vfoSquelchIcon->setVisible(any);
+    m_vfoSquelchSlider->setVisible(any);
+    m_vfoSquelchLabel->setVisible(any);
+}
+
+// ============================================================
+// Band scanner
+// ============================================================
+
+// Turning on while running restarts with the current rate and VFOs
+void RadioWindow::setScanning(bool on)
+{
+    if (on) {
+        if (!m_tcpClient->isConnected() || m_isTx) {
+            m_scanBtn->setChecked(false);
+            return;
+        }
+        // The multi-VFO receivers are watched as priority channels
+        QVector<BandScanner::Channel> watch;
+        for (const auto& v : m_multiVfo->vfos())
+            watch.append({static_cast<quint64>(v.frequency), static_cast<quint32>(v.bandwidth), QString("VFO %1").arg(v.id)});
+
+        const QString dir = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
+        QDir().mkpath(dir);
+        m_scanner->setLogFile(dir + "/scan.csv");
+        m_scanner->setSampleRate(m_sampleRate);
+        m_scanner->setRetuneConfirmation(m_tcpClient->isBinaryProtocol());
+        // A restart does not know where the radio is: always retune first
+        const quint64 tuned = m_scanner->isRunning() ? 0 : m_freqWidget->frequency();
+        const bool started = m_scanner->start(tuned, watch);
+        if (!started) {
+            m_scanBtn->setChecked(false);
+            logMessage("Scan: no channels in the band list");
+            return;
+        }
+        m_scanLogTimer.invalidate();
+        logMessage(QString("Scanning %1 hops, activity logged to %2/scan.csv").arg(m_scanner->hopCount()).arg(dir));
+        return;
+    }
+
+    if (!m_scanner->isRunning()) return;
+    m_scanner->stop();
+    m_scanBtn->setText("SCAN");
+    // Back to the frequency on the dial
+    const uint64_t freq = m_freqWidget->frequency();
+    m_iqAccumulator.clear();
+    m_multiVfo->reset();
+    if (m_tcpClient->isConnected()) m_tcpClient->setFrequency(freq);
+    m_cPlotter->setCenterFreq(static_cast<quint64>(freq));
 }
 
 bool RadioWindow::eventFilter(QObject *obj, QEvent *event)
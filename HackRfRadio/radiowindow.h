@@ -7,6 +7,7 @@
 #include <QLabel>
 #include <QCheckBox>
 #include <QStackedWidget>
+#include <QElapsedTimer>
 #include <complex>
 #include <vector>
 #include <atomic>
@@ -16,10 +17,13 @@
 #include "audioplayback.h"
 #include "fmdemodulator.h"
 #include "amdemodulator.h"
+#include "multivfo.h"
+#include "bandscanner.h"
 #include "frequencywidget.h"
 #include "meter.h"
 #include "glplotter.h"
 #include "gainsettingsdialog.h"
+#include "latencyhistogram.h"
 
 class RadioWindow : public QMainWindow
 {
@@ -43,7 +47,7 @@ private slots:
     void onIqDataReceived(const QByteArray& data);
     void onPttPressed();
     void onPttReleased();
-    void onAudioCaptured(const std::vector<float>& samples);
+    void onAudioCaptured(const std::vector<float>& samples, qint64 captureUs);
     void onFrequencyChanged(uint64_t freq);
     void onModulationChanged(int index);
     void onVolumeChanged(int value);
@@ -51,6 +55,7 @@ private slots:
     void onSettingsClicked();
     void onSettingsBack();
     void onBwChanged(int index);
+    void onVfoClicked(qint64 freq);
 
 private:
     void setupUi();
@@ -59,12 +64,18 @@ private:
     void logMessage(const QString& msg);
     void saveSettings();
     void loadSettings();
+    void updateVfoMarkers();
+    void setScanning(bool on);
+    void logLatencyReport();
+    void resetLatency();
 
     TcpClient* m_tcpClient;
     AudioCapture* m_audioCapture;
     AudioPlayback* m_audioPlayback;
     FMDemodulator* m_fmDemod;
     AMDemodulator* m_amDemod;
+    MultiVfo* m_multiVfo;
+    BandScanner* m_scanner;
 
     // Page switching
     QStackedWidget* m_stackedWidget;
@@ -106,6 +117,16 @@ private:
     CMeter* m_cMeter;
     CPlotter* m_cPlotter;
 
+    // Multi-VFO: tap the spectrum to add/remove receivers
+    QPushButton* m_vfoBtn;
+    QPushButton* m_vfoRecBtn;
+    QPushButton* m_vfoClearBtn;
+    QPushButton* m_scanBtn;
+    QLabel* m_vfoLabel;
+    QLabel* m_vfoSquelchIcon;
+    QSlider* m_vfoSquelchSlider;
+    QLabel* m_vfoSquelchLabel;
+
     // Settings page
     GainSettingsDialog* m_gainDialog;
     QPushButton* m_settingsBtn;
@@ -140,6 +161,31 @@ protected:
     float m_lastSignalLevel = 0.0f;
 
     QByteArray m_iqAccumulator;
+    qint64 m_iqAccumulatorUs = 0;       // steady time its oldest byte came in
+
+    // Per-stage latency (GET_LATENCY on the server covers its side):
+    // iq.network   server capture -> here (UTC, needs synced clocks)
+    // iq.accumulate  waiting for a full IQ_PROCESS_THRESHOLD block
+    // demod        processIqBuffer
+    // audio.out    queued in the playback ring and sink
+    // rx.total     server capture -> speaker (framed data port only)
+    // mic.flush    mic capture -> sent to the audio port
+    LatencyRecorder m_latency;
+    LatencyHistogram& m_iqNetwork;
+    LatencyHistogram& m_iqAccumulate;
+    LatencyHistogram& m_demodLatency;
+    LatencyHistogram& m_audioOut;
+    LatencyHistogram& m_rxTotal;
+    LatencyHistogram& m_micFlush;
+
+    // Multicast gap logging, at most once a second
+    QElapsedTimer m_gapLogTimer;
+    quint64 m_gapSamplesSinceLog = 0;
+
+    // Retune timing logs (binary control), at most once a second
+    QElapsedTimer m_retuneLogTimer;
+    // Scanner sweep rate logs, at most every ten seconds
+    QElapsedTimer m_scanLogTimer;
     static constexpr int IQ_PROCESS_THRESHOLD = 32768;
     QAtomicInt m_fftUpdatePending{0};
 
@@ -1,11 +1,24 @@
 #include "tcpclient.h"
+#include "latencyhistogram.h"
 #include <QDebug>
+#include <QtEndian>
+#include <QDateTime>
+#include <QNetworkInterface>
+#include <cstring>
+#include <algorithm>
+
+// Multicast datagram header, see HackRfTcp/iqmulticaster.h
+static constexpr int MC_HEADER_SIZE = 40;
+static constexpr quint8 MC_VERSION = 1;
+static constexpr quint8 MC_FORMAT_CI8 = 1;
+static constexpr quint8 MC_FORMAT_CU8 = 2;
 
 TcpClient::TcpClient(QObject *parent)
     : QObject(parent)
     , m_dataSocket(new QTcpSocket(this))
     , m_controlSocket(new QTcpSocket(this))
     , m_audioSocket(new QTcpSocket(this))
+    , m_multicastSocket(new QUdpSocket(this))
     , m_dataPort(5000)
     , m_controlPort(5001)
     , m_audioPort(5002)
@@ -26,6 +39,11 @@ TcpClient::TcpClient(QObject *parent)
     connect(m_audioSocket, &QTcpSocket::connected, this, &TcpClient::onAudioConnected);
     connect(m_audioSocket, &QTcpSocket::disconnected, this, &TcpClient::onAudioDisconnected);
     connect(m_audioSocket, &QTcpSocket::errorOccurred, this, &TcpClient::onAudioError);
+
+    // Multicast IQ
+    connect(m_multicastSocket, &QUdpSocket::readyRead, this, &TcpClient::onMulticastReadyRead);
+
+    m_clock.start();
 }
 
 TcpClient::~TcpClient()
@@ -42,7 +60,9 @@ bool TcpClient::connectToServer(const QString& host, quint16 dataPort, quint16 c
 
 
     m_controlSocket->connectToHost(host, controlPort);
-    m_dataSocket->connectToHost(host, dataPort);
+    if (!m_multicastMode && !openSharedMemory()) {
+        m_dataSocket->connectToHost(host, dataPort);
+    }
     m_audioSocket->connectToHost(host, audioPort);
 
     return true;
@@ -51,6 +71,8 @@ bool TcpClient::connectToServer(const QString& host, quint16 dataPort, quint16 c
 void TcpClient::disconnectFromServer()
 {
     m_connected.store(false);
+    leaveMulticast();
+    closeSharedMemory();
 
     if (m_dataSocket->state() != QAbstractSocket::UnconnectedState) {
         m_dataSocket->disconnectFromHost();
@@ -68,16 +90,431 @@ bool TcpClient::isConnected() const
     return m_connected.load();
 }
 
+void TcpClient::connectDataSocket()
+{
+    if (m_dataSocket->state() == QAbstractSocket::UnconnectedState && !m_host.isEmpty()) {
+        m_dataSocket->connectToHost(m_host, m_dataPort);
+    }
+}
+
+// ============================================================
+// Data port encoding
+// ============================================================
+
+void TcpClient::setEncoding(const QString& encoding)
+{
+    m_encoding = encoding.trimmed().toLower();
+    requestEncoding();
+}
+
+void TcpClient::requestEncoding()
+{
+    // Nothing to ask for while the port still sends bare IQ (binary control
+    // wants frames even for raw, for the epochs)
+    if (m_encoding == "raw" && !m_encodingRequested && !m_binaryProtocol) return;
+    if (m_dataSocket->state() != QAbstractSocket::ConnectedState ||
+        m_controlSocket->state() != QAbstractSocket::ConnectedState) return;
+
+    m_encodingRequested = true;
+    sendCommand(QString("SET_ENCODING:%1:%2").arg(m_encoding).arg(m_dataSocket->localPort()));
+}
+
+// Bare IQ (or garbage after a bad header) up to the first frame header
+bool TcpClient::findFrameStart(QByteArray& out)
+{
+    IqCodec::FrameHeader header;
+    int pos = 0;
+    while ((pos = m_rxBuffer.indexOf("HRQF", pos)) >= 0) {
+        if (m_rxBuffer.size() - pos < IqCodec::FRAME_HEADER) break;
+        if (IqCodec::parseHeader(m_rxBuffer.constData() + pos, &header)) {
+            if (!m_frameLost) out.append(m_rxBuffer.constData(), pos);
+            m_rxBuffer.remove(0, pos);
+            m_framed = true;
+            m_frameLost = false;
+            return true;
+        }
+        pos++;
+    }
+
+    // Keep a possible partial header, pass the rest on
+    int keep = (pos >= 0) ? m_rxBuffer.size() - pos
+                          : std::min<int>(m_rxBuffer.size(), IqCodec::FRAME_HEADER - 1);
+    if (!m_frameLost) out.append(m_rxBuffer.constData(), m_rxBuffer.size() - keep);
+    m_rxBuffer.remove(0, m_rxBuffer.size() - keep);
+    return false;
+}
+
+qint64 TcpClient::dataAvailable() const
+{
+    return m_rxBuffer.size() + m_dataSocket->bytesAvailable();
+}
+
+void TcpClient::readData(char* dst, qint64 len)
+{
+    qint64 n = std::min<qint64>(len, m_rxBuffer.size());
+    if (n > 0) {
+        std::memcpy(dst, m_rxBuffer.constData(), static_cast<size_t>(n));
+        m_rxBuffer.remove(0, static_cast<int>(n));
+    }
+    if (n < len) m_dataSocket->read(dst + n, len - n);
+}
+
+void TcpClient::skipData(qint64 len)
+{
+    qint64 n = std::min<qint64>(len, m_rxBuffer.size());
+    if (n > 0) m_rxBuffer.remove(0, static_cast<int>(n));
+    if (n < len) m_dataSocket->skip(len - n);
+}
+
+// Sequence, epoch and latency bookkeeping shared by the data port and the
+// shared-memory ring; false when the frame predates our last retune
+bool TcpClient::acceptFrame(const IqCodec::FrameHeader& header, QByteArray& out)
+{
+    const IqCodec::BlockInfo& info = header.info;
+
+    if (m_haveSequence && info.sequence != m_nextSequence) {
+        m_lostBlocks += static_cast<quint32>(info.sequence - m_nextSequence);
+    }
+    m_haveSequence = true;
+    m_nextSequence = info.sequence + 1;
+    const bool tuningChanged = m_haveEpoch &&
+        (info.frequency != m_lastFrequency || info.sampleRate != m_lastSampleRate);
+    m_haveEpoch = true;
+    m_lastEpoch = info.epoch;
+    m_lastFrequency = info.frequency;
+    m_lastSampleRate = info.sampleRate;
+
+    // Captured before our last retune: useless to the demodulator
+    if (static_cast<qint32>(info.epoch - m_minEpoch) < 0) {
+        m_staleBlocks++;
+        return false;
+    }
+    if (m_retunePending || tuningChanged) {
+        if (!out.isEmpty()) {
+            emit iqDataReceived(out);
+            out.clear();
+        }
+        emit retuned(info.epoch, m_retunePending ? m_clock.elapsed() - m_retuneSentMs : -1);
+        m_retunePending = false;
+    }
+
+    // Age of the last sample in the block
+    if (info.timeUs && info.sampleRate) {
+        const int sampleBytes = (info.format == IqCodec::FormatCi16) ? 4 : 2;
+        qint64 blockUs = static_cast<qint64>(header.decodedBytes / sampleBytes) * 1000000 / info.sampleRate;
+        qint64 ageUs = QDateTime::currentMSecsSinceEpoch() * 1000 - static_cast<qint64>(info.timeUs) - blockUs;
+        double ms = ageUs / 1000.0;
+        m_latencyMs = (m_latencyMs == 0.0) ? ms : 0.9 * m_latencyMs + 0.1 * ms;
+        if (m_networkLatency) m_networkLatency->record(ageUs);
+    }
+    m_lastCaptureUs = static_cast<qint64>(info.timeUs);
+    return true;
+}
+
+// Whole frames only: header first, then the payload once all of it is in
+// the socket buffer, read straight into the output for raw frames
+void TcpClient::readFrames(QByteArray& out)
+{
+    while (m_framed) {
+        if (!m_haveHeader) {
+            if (dataAvailable() < IqCodec::FRAME_HEADER) return;
+            char raw[IqCodec::FRAME_HEADER];
+            readData(raw, IqCodec::FRAME_HEADER);
+            if (!IqCodec::parseHeader(raw, &m_header)) {
+                // Should not happen on TCP; drop bytes until the next frame
+                qDebug() << "Data port: bad frame header, resyncing";
+                m_decodeErrors++;
+                m_rxBuffer.prepend(QByteArray(raw + 1, IqCodec::FRAME_HEADER - 1));
+                m_rxBuffer.append(m_dataSocket->readAll());
+                m_framed = false;
+                m_frameLost = true;
+                if (!findFrameStart(out)) return;
+                continue;
+            }
+            m_haveHeader = true;
+        }
+
+        const qint64 extra = m_header.headerBytes - IqCodec::FRAME_HEADER;
+        if (dataAvailable() < extra + m_header.payloadBytes) return;
+        skipData(extra);
+        m_haveHeader = false;
+
+        if (!acceptFrame(m_header, out)) {
+            skipData(m_header.payloadBytes);
+            continue;
+        }
+
+        if (m_header.encoding == IqCodec::Raw) {
+            int start = out.size();
+            out.resize(start + static_cast<int>(m_header.payloadBytes));
+            readData(out.data() + start, m_header.payloadBytes);
+        } else {
+            m_payload.resize(static_cast<int>(m_header.payloadBytes));
+            readData(m_payload.data(), m_header.payloadBytes);
+            if (!IqCodec::decodeFrame(m_header, m_payload.constData(), out)) {
+                m_decodeErrors++;
+            }
+        }
+    }
+}
+
+void TcpClient::resetFrameState()
+{
+    m_haveSequence = false;
+    m_haveEpoch = false;
+    m_minEpoch = 0;
+    m_retunePending = false;
+}
+
+// ============================================================
+// Shared-memory IQ (server on this host)
+// ============================================================
+
+bool TcpClient::isLocalHost(const QString& host)
+{
+    if (host.compare("localhost", Qt::CaseInsensitive) == 0) return true;
+    QHostAddress address(host);
+    if (address.isNull()) return false;
+    return address.isLoopback() || QNetworkInterface::allAddresses().contains(address);
+}
+
+bool TcpClient::openSharedMemory()
+{
+    if (!m_localTransport || !isLocalHost(m_host)) return false;
+
+    QString error;
+    if (!m_shmReader.open(m_dataPort, &error)) {
+        qDebug() << "Shared memory IQ not available:" << error << "- using the data port";
+        return false;
+    }
+
+    // Ring records are always framed, like a data port after SET_ENCODING
+    resetFrameState();
+    m_shmNotifier = new QSocketNotifier(m_shmReader.notifyFd(), QSocketNotifier::Read, this);
+    connect(m_shmNotifier, &QSocketNotifier::activated, this, &TcpClient::onShmReadable);
+
+    // The server never writes to this socket again, readable means it closed
+    m_shmHangup = new QSocketNotifier(m_shmReader.socketFd(), QSocketNotifier::Read, this);
+    connect(m_shmHangup, &QSocketNotifier::activated, this, [this]() {
+        qDebug() << "Shared memory IQ: server went away";
+        closeSharedMemory();
+        if (m_connected.load()) connectDataSocket();
+    });
+
+    qDebug() << "Receiving IQ through shared memory" << IqShmBus::socketName(m_dataPort);
+    return true;
+}
+
+void TcpClient::closeSharedMemory()
+{
+    // May run from one of the notifiers' own signals
+    for (QSocketNotifier* notifier : {m_shmNotifier, m_shmHangup}) {
+        if (!notifier) continue;
+        notifier->setEnabled(false);
+        notifier->deleteLater();
+    }
+    m_shmNotifier = nullptr;
+    m_shmHangup = nullptr;
+    m_shmReader.close();
+}
+
+void TcpClient::onShmReadable()
+{
+    m_shmReader.clearNotify();
+
+    // Everything published since the last wakeup; an overrun shows up as
+    // a sequence gap (lostBlocks) after the reader skipped ahead
+    QByteArray out;
+    IqCodec::FrameHeader header;
+    while (m_shmReader.peek(&header)) {
+        if (!acceptFrame(header, out)) {
+            m_shmReader.skip();
+            continue;
+        }
+        m_shmReader.take(out);
+    }
+
+    if (!out.isEmpty()) {
+        emit iqDataReceived(out);
+    }
+}
+
+// ============================================================
+// Multicast IQ
+// ============================================================
+
+bool TcpClient::joinMulticast(const QHostAddress& group, quint16 port)
+{
+    leaveMulticast();
+
+    QHostAddress any = (group.protocol() == QAbstractSocket::IPv6Protocol) ? QHostAddress::AnyIPv6
+                                                                           : QHostAddress::AnyIPv4;
+    if (!m_multicastSocket->bind(any, port, QUdpSocket::ShareAddress | QUdpSocket::ReuseAddressHint)) {
+        emit connectionError("Multicast: " + m_multicastSocket->errorString());
+        return false;
+    }
+    // A few blocks of slack before the kernel drops datagrams
+    m_multicastSocket->setSocketOption(QAbstractSocket::ReceiveBufferSizeSocketOption, 4 * 1024 * 1024);
+    if (!m_multicastSocket->joinMulticastGroup(group)) {
+        emit connectionError("Multicast: " + m_multicastSocket->errorString());
+        m_multicastSocket->close();
+        return false;
+    }
+
+    m_multicastGroup = group;
+    m_mcSynced = false;
+    m_mcLostSamples = 0;
+    m_mcLatePackets = 0;
+    qDebug() << "Joined multicast" << group.toString() << "port" << port;
+    return true;
+}
+
+void TcpClient::leaveMulticast()
+{
+    if (m_multicastSocket->state() == QAbstractSocket::UnconnectedState) return;
+    if (!m_multicastGroup.isNull()) {
+        m_multicastSocket->leaveMulticastGroup(m_multicastGroup);
+    }
+    m_multicastSocket->close();
+    m_multicastGroup.clear();
+}
+
+void TcpClient::onMulticastReadyRead()
+{
+    // Everything queued right now becomes one contiguous IQ chunk
+    QByteArray out;
+
+    while (m_multicastSocket->hasPendingDatagrams()) {
+        qint64 size = m_multicastSocket->pendingDatagramSize();
+        if (size < 0) break;
+        m_datagram.resize(static_cast<int>(std::max<qint64>(size, 1)));
+        qint64 n = m_multicastSocket->readDatagram(m_datagram.data(), m_datagram.size());
+        if (n < MC_HEADER_SIZE) continue;
+
+        const char* h = m_datagram.constData();
+        quint8 version = static_cast<quint8>(h[4]);
+        quint8 format = static_cast<quint8>(h[5]);
+        int headerSize = qFromLittleEndian<quint16>(h + 6);
+        if (std::memcmp(h, "HRIQ", 4) != 0 || version != MC_VERSION ||
+            headerSize < MC_HEADER_SIZE || headerSize > n ||
+            (format != MC_FORMAT_CI8 && format != MC_FORMAT_CU8)) {
+            continue;
+        }
+
+        quint32 sampleRate = qFromLittleEndian<quint32>(h + 12);
+        quint64 index = qFromLittleEndian<quint64>(h + 24);
+        const char* payload = h + headerSize;
+        int payloadLen = static_cast<int>(n - headerSize) & ~1;
+
+        // Up to one second of missing samples is zero-filled to keep the
+        // demodulator timing; anything further is a server restart or retune
+        const qint64 window = std::max<qint64>(sampleRate, 1000000);
+        if (!m_mcSynced) {
+            m_mcNextIndex = index;
+            m_mcSynced = true;
+        }
+        qint64 diff = static_cast<qint64>(index - m_mcNextIndex);
+        if (diff < 0 && diff > -window) {
+            m_mcLatePackets++;
+            continue;
+        }
+        if (diff > 0 && diff <= window) {
+            out.append(QByteArray(static_cast<int>(diff * 2), 0));
+            m_mcLostSamples += static_cast<quint64>(diff);
+            emit multicastGap(static_cast<quint64>(diff), m_mcLostSamples);
+        } else if (diff != 0) {
+            qDebug() << "Multicast stream jumped by" << diff << "samples, resyncing";
+        }
+
+        int start = out.size();
+        out.append(payload, payloadLen);
+        if (format == MC_FORMAT_CU8) {
+            // RTL-SDR offset binary -> signed
+            char* p = out.data() + start;
+            for (int i = 0; i < payloadLen; i++) p[i] = static_cast<char>(p[i] ^ 0x80);
+        }
+        m_mcNextIndex = index + static_cast<quint64>(payloadLen / 2);
+    }
+
+    if (!out.isEmpty()) {
+        emit iqDataReceived(out);
+    }
+}
+
 // ============================================================
 // Control commands
 // ============================================================
 
 void TcpClient::sendCommand(const QString& command)
 {
-    if (m_controlSocket->state() == QAbstractSocket::ConnectedState) {
-        m_controlSocket->write((command + "\n").toUtf8());
-        m_controlSocket->flush();
+    if (m_controlSocket->state() != QAbstractSocket::ConnectedState) return;
+
+    if (m_binaryProtocol) {
+        // Everything issued in this event loop pass goes out as one frame
+        m_batch.addCommand(command);
+        if (!m_batchScheduled) {
+            m_batchScheduled = true;
+            QTimer::singleShot(0, this, &TcpClient::flushBatch);
+        }
+        return;
+    }
+
+    m_controlSocket->write((command + "\n").toUtf8());
+    m_controlSocket->flush();
+}
+
+void TcpClient::flushBatch()
+{
+    m_batchScheduled = false;
+    if (m_batch.isEmpty()) return;
+    if (m_controlSocket->state() != QAbstractSocket::ConnectedState) {
+        m_batch.clear();
+        return;
+    }
+
+    bool retune = false;
+    for (const ControlBatch::Message& message : m_batch.messages()) {
+        if (ControlBatch::isRetune(message.opcode)) retune = true;
+    }
+    if (retune) {
+        // Whatever the data port carries right now predates this batch
+        if (m_haveEpoch) m_minEpoch = m_lastEpoch + 1;
+        m_retunePending = true;
+        m_retuneSentMs = m_clock.elapsed();
+    }
+    m_sentBatches.push_back(retune);
+
+    m_controlSocket->write(m_batch.encode());
+    m_controlSocket->flush();
+    m_batch.clear();
+}
+
+void TcpClient::handleReplyFrame(const QByteArray& frame)
+{
+    ControlBatch replies;
+    quint32 epoch = 0;
+    if (!ControlBatch::decode(frame, &replies, &epoch)) {
+        qDebug() << "Control: bad reply frame";
+        return;
     }
+
+    for (const ControlBatch::Message& message : replies.messages()) {
+        if (message.opcode != ControlBatch::Reply) continue;
+        const QStringList lines = QString::fromUtf8(message.payload).split('\n');
+        for (const QString& line : lines) {
+            QString text = line.trimmed();
+            if (!text.isEmpty()) emit controlResponseReceived(text);
+        }
+    }
+
+    if (m_sentBatches.empty()) return;
+    const bool retune = m_sentBatches.front();
+    m_sentBatches.pop_front();
+
+    // The server's epoch after the batch ran: exact, also when a command
+    // failed and nothing moved. A later retune still in flight keeps its guess.
+    bool laterRetune = std::find(m_sentBatches.begin(), m_sentBatches.end(), true) != m_sentBatches.end();
+    if (retune && !laterRetune) m_minEpoch = epoch;
 }
 
 void TcpClient::setFrequency(uint64_t freq_hz)
@@ -156,11 +593,20 @@ void TcpClient::requestStatus()
     sendCommand("GET_STATUS");
 }
 
-void TcpClient::sendAudioData(const float* data, size_t count)
+void TcpClient::sendAudioData(const float* data, size_t count, int sampleRate, qint64 captureUs)
 {
-    if (m_audioSocket->state() == QAbstractSocket::ConnectedState && data && count > 0) {
-        QByteArray audioBytes(reinterpret_cast<const char*>(data), count * sizeof(float));
-        m_audioSocket->write(audioBytes);
+    if (m_audioSocket->state() == QAbstractSocket::ConnectedState && data && count > 0 && sampleRate > 0) {
+        // The server jitter-buffers and resamples; the header carries the rate and a sequence
+        while (count > 0) {
+            const size_t n = std::min<size_t>(count, TxAudioIntake::MAX_PACKET_SAMPLES);
+            m_audioSocket->write(TxAudioIntake::encodePacket(m_audioSequence++, data, n,
+                                                             static_cast<uint32_t>(sampleRate),
+                                                             TxAudioIntake::FormatF32,
+                                                             static_cast<uint64_t>(captureUs)));
+            data += n;
+            count -= n;
+            if (captureUs) captureUs += static_cast<qint64>(n) * 1000000 / sampleRate;
+        }
         m_audioSocket->flush(); // Force immediate send - critical for real-time audio
     }
 }
@@ -173,6 +619,15 @@ void TcpClient::onDataConnected()
 {
     m_dataSocket->setSocketOption(QAbstractSocket::LowDelayOption, 1);
     m_dataSocket->setSocketOption(QAbstractSocket::ReceiveBufferSizeSocketOption, 1024 * 1024);
+
+    // New connection starts as bare IQ
+    m_encodingRequested = false;
+    m_framed = false;
+    m_frameLost = false;
+    m_rxBuffer.clear();
+    m_haveHeader = false;
+    resetFrameState();
+    requestEncoding();
 }
 
 void TcpClient::onDataDisconnected()
@@ -181,9 +636,26 @@ void TcpClient::onDataDisconnected()
 
 void TcpClient::onDataReadyRead()
 {
-    QByteArray data = m_dataSocket->readAll();
-    if (!data.isEmpty()) {
-        emit iqDataReceived(data);
+    if (!m_encodingRequested) {
+        QByteArray data = m_dataSocket->readAll();
+        if (!data.isEmpty()) emit iqDataReceived(data);
+        return;
+    }
+
+    QByteArray out;
+    if (!m_framed) {
+        m_rxBuffer.append(m_dataSocket->readAll());
+        if (!findFrameStart(out)) {
+            if (!out.isEmpty()) emit iqDataReceived(out);
+            return;
+        }
+    }
+
+    // Frames stay in the socket buffer until complete
+    readFrames(out);
+
+    if (!out.isEmpty()) {
+        emit iqDataReceived(out);
     }
 }
 
@@ -200,23 +672,44 @@ void TcpClient::onDataError(QAbstractSocket::SocketError error)
 void TcpClient::onControlConnected()
 {
     m_connected.store(true);
+    requestEncoding();
     emit connected();
 }
 
 void TcpClient::onControlDisconnected()
 {
     m_connected.store(false);
+    m_batch.clear();
+    m_sentBatches.clear();
     emit disconnected();
 }
 
 void TcpClient::onControlReadyRead()
 {
-    while (m_controlSocket->canReadLine()) {
+    for (;;) {
+        // Batch replies and text lines (welcome, DUMP_DONE...) in any mix
+        if (m_controlSocket->peek(4) == "HRCM") {
+            QByteArray header = m_controlSocket->peek(ControlBatch::HEADER);
+            int size = ControlBatch::frameSize(header.constData(), header.size());
+            if (size < 0) {
+                qDebug() << "Control: bad frame, disconnecting";
+                m_controlSocket->abort();
+                return;
+            }
+            if (size == 0 || m_controlSocket->bytesAvailable() < size) return;
+            handleReplyFrame(m_controlSocket->read(size));
+            continue;
+        }
+
+        if (!m_controlSocket->canReadLine()) break;
         QString line = QString::fromUtf8(m_controlSocket->readLine()).trimmed();
         if (!line.isEmpty()) {
             emit controlResponseReceived(line);
         }
     }
+    // A partial frame has to wait for the rest
+    if (m_binaryProtocol) return;
+
     // Also read any remaining data that doesn't end with newline
     QByteArray remaining = m_controlSocket->readAll();
     if (!remaining.isEmpty()) {
@@ -236,6 +729,7 @@ void TcpClient::onControlError(QAbstractSocket::SocketError error)
 
 void TcpClient::onAudioConnected()
 {
+    m_audioSequence = 0;
     m_audioSocket->setSocketOption(QAbstractSocket::LowDelayOption, 1);
     // Smaller send buffer for lower latency audio
     m_audioSocket->setSocketOption(QAbstractSocket::SendBufferSizeSocketOption, 32768);
@@ -3,8 +3,19 @@
 
 #include <QObject>
 #include <QTcpSocket>
+#include <QUdpSocket>
+#include <QHostAddress>
 #include <QTimer>
+#include <QElapsedTimer>
+#include <QSocketNotifier>
 #include <atomic>
+#include <deque>
+#include "iqcodec.h"
+#include "controlbatch.h"
+#include "iqshmbus.h"
+#include "txaudiointake.h"
+
+class LatencyHistogram;
 
 class TcpClient : public QObject
 {
@@ -19,6 +30,41 @@ public:
     void disconnectFromServer();
     bool isConnected() const;
 
+    // Multicast IQ: skip the data port and take IQ from the server's
+    // multicast group instead (GET_MULTICAST tells where). Set before connecting.
+    void setMulticastMode(bool enable) { m_multicastMode = enable; }
+    bool isMulticastMode() const { return m_multicastMode; }
+    bool joinMulticast(const QHostAddress& group, quint16 port);
+    void leaveMulticast();
+    void connectDataSocket();               // fall back to the TCP data port
+
+    // Same host: read IQ from the server's shared-memory ring (Linux) instead
+    // of the data port. On by default, falls back to TCP if the ring is not
+    // there. Set before connecting.
+    void setLocalTransport(bool enable) { m_localTransport = enable; }
+    bool isSharedMemory() const { return m_shmReader.isOpen(); }
+    quint64 shmOverruns() const { return m_shmReader.overruns(); }
+
+    // Data port encoding (raw, bfp4, deflate); sent once both sockets are up,
+    // frames are decoded back to int8 IQ before iqDataReceived
+    void setEncoding(const QString& encoding);
+    quint64 decodeErrors() const { return m_decodeErrors; }
+
+    // Binary control (ControlBatch): commands issued in one event loop pass
+    // go out as one frame, and the data port is framed (raw at least) so IQ
+    // captured before a retune can be dropped. Set before connecting.
+    void setBinaryProtocol(bool enable) { m_binaryProtocol = enable; }
+    bool isBinaryProtocol() const { return m_binaryProtocol; }
+
+    // Framed data port statistics
+    quint64 lostBlocks() const { return m_lostBlocks; }        // sequence gaps
+    quint64 staleBlocks() const { return m_staleBlocks; }      // dropped after a retune
+    double iqLatencyMs() const { return m_latencyMs; }         // capture -> here, needs synced clocks
+    // UTC capture time of the first sample of the last framed block (0: unknown)
+    qint64 lastCaptureUs() const { return m_lastCaptureUs; }
+    // Records capture -> arrival of every framed block
+    void setLatencyStage(LatencyHistogram* network) { m_networkLatency = network; }
+
     // Control commands
     void sendCommand(const QString& command);
     void setFrequency(uint64_t freq_hz);
@@ -37,13 +83,18 @@ public:
     void switchToTx();
     void requestStatus();
 
-    // TX audio data
-    void sendAudioData(const float* data, size_t count);
+    // TX audio data, mono at the capture rate, sent as HRAU packets;
+    // captureUs (UTC time of the first sample) lets the server time the hop
+    void sendAudioData(const float* data, size_t count, int sampleRate, qint64 captureUs = 0);
 
 signals:
     void connected();
     void disconnected();
     void iqDataReceived(const QByteArray& data);
+    void multicastGap(quint64 missingSamples, quint64 totalLost);
+    // First framed IQ at a new frequency or rate; ms since our command went
+    // out, or -1 when somebody else retuned the server
+    void retuned(quint32 epoch, qint64 ms);
     void controlResponseReceived(const QString& response);
     void connectionError(const QString& error);
 
@@ -62,10 +113,31 @@ private slots:
     void onAudioDisconnected();
     void onAudioError(QAbstractSocket::SocketError error);
 
+    void onMulticastReadyRead();
+    void onShmReadable();
+
 private:
+    void requestEncoding();
+    bool findFrameStart(QByteArray& out);
+    void readFrames(QByteArray& out);
+    bool acceptFrame(const IqCodec::FrameHeader& header, QByteArray& out);
+    void resetFrameState();
+    qint64 dataAvailable() const;
+    void readData(char* dst, qint64 len);
+    void skipData(qint64 len);
+
+    static bool isLocalHost(const QString& host);
+    bool openSharedMemory();
+    void closeSharedMemory();
+
+    void flushBatch();
+    void handleReplyFrame(const QByteArray& frame);
+
     QTcpSocket* m_dataSocket;
     QTcpSocket* m_controlSocket;
     QTcpSocket* m_audioSocket;
+    QUdpSocket* m_multicastSocket;
+    quint32 m_audioSequence = 0;
 
     QString m_host;
     quint16 m_dataPort;
@@ -73,6 +145,55 @@ private:
     quint16 m_audioPort;
 
     std::atomic<bool> m_connected{false};
+
+    // Framed data port (IqCodec)
+    QString m_encoding = "raw";
+    bool m_encodingRequested = false;   // the port may switch to frames at any point
+    bool m_framed = false;              // in step with the frames
+    bool m_frameLost = false;           // bad header: skip to the next frame
+    QByteArray m_rxBuffer;              // resync scan leftovers, read before the socket
+    quint64 m_decodeErrors = 0;
+    bool m_haveHeader = false;          // m_header read, waiting for its payload
+    IqCodec::FrameHeader m_header;
+    QByteArray m_payload;               // encoded payloads, reused
+    bool m_haveSequence = false;
+    quint32 m_nextSequence = 0;
+    quint64 m_lostBlocks = 0;
+    quint64 m_staleBlocks = 0;
+    double m_latencyMs = 0.0;
+    qint64 m_lastCaptureUs = 0;
+    LatencyHistogram* m_networkLatency = nullptr;
+
+    // Tuning epochs (see HackRfTcp/iqcodec.h)
+    bool m_haveEpoch = false;
+    quint32 m_lastEpoch = 0;
+    quint32 m_minEpoch = 0;             // frames before this one are stale
+    quint64 m_lastFrequency = 0;
+    quint32 m_lastSampleRate = 0;
+    bool m_retunePending = false;
+    qint64 m_retuneSentMs = 0;
+
+    // Binary control
+    bool m_binaryProtocol = false;
+    ControlBatch m_batch;
+    bool m_batchScheduled = false;
+    std::deque<bool> m_sentBatches;     // retune or not, answered in order
+    QElapsedTimer m_clock;
+
+    // Shared-memory IQ
+    bool m_localTransport = true;
+    IqShmReader m_shmReader;
+    QSocketNotifier* m_shmNotifier = nullptr;   // blocks published
+    QSocketNotifier* m_shmHangup = nullptr;     // server closed the socket
+
+    // Multicast receive state
+    bool m_multicastMode = false;
+    QHostAddress m_multicastGroup;
+    QByteArray m_datagram;
+    bool m_mcSynced = false;
+    quint64 m_mcNextIndex = 0;          // sample index expected next
+    quint64 m_mcLostSamples = 0;        // zero-filled
+    quint64 m_mcLatePackets = 0;        // reordered or duplicate, dropped
 };
 
 #endif // TCPCLIENT_H
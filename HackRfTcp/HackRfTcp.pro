@@ -3,10 +3,30 @@ CONFIG += c++17 cmdline
 PARENT_DIR = $$absolute_path($$PWD/../)
 INCLUDEPATH += $$PARENT_DIR/include
 SOURCES += \
+        controlbatch.cpp \
+        ddcchannel.cpp \
+        iqcodec.cpp \
+        iqmulticaster.cpp \
+        iqshmbus.cpp \
+        iqstreamer.cpp \
+        iqtimemachine.cpp \
         main.cpp \
-        sdrdevice.cpp
+        sdrdevice.cpp \
+        spectrumanalyzer.cpp \
+        txaudiointake.cpp \
+        $$PARENT_DIR/HackTvLib/ddcchain.cpp
 HEADERS += \
-    sdrdevice.h
+    controlbatch.h \
+    ddcchannel.h \
+    iqcodec.h \
+    iqmulticaster.h \
+    iqshmbus.h \
+    iqstreamer.h \
+    iqtimemachine.h \
+    sdrdevice.h \
+    spectrumanalyzer.h \
+    txaudiointake.h \
+    $$PARENT_DIR/HackTvLib/ddcchain.h
 win32 {
     WIN_LIB_DIR = $$absolute_path($$PARENT_DIR/lib/windows)
     INCLUDEPATH += $$PARENT_DIR/HackTvLib
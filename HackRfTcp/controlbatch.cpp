@@ -0,0 +1,171 @@
+#include "controlbatch.h"
+#include <QStringList>
+#include <QtEndian>
+#include <cstring>
+
+void ControlBatch::add(Opcode opcode, const QByteArray& payload)
+{
+    m_messages.push_back({opcode, payload});
+}
+
+static QByteArray u32Payload(uint32_t value)
+{
+    QByteArray payload(4, Qt::Uninitialized);
+    qToLittleEndian<quint32>(value, payload.data());
+    return payload;
+}
+
+void ControlBatch::addCommand(const QString& command)
+{
+    static const struct {
+        const char* name;
+        Opcode opcode;
+    } numeric[] = {
+        {"SET_SAMPLE_RATE", SetSampleRate},
+        {"SET_VGA_GAIN", SetVgaGain},
+        {"SET_LNA_GAIN", SetLnaGain},
+        {"SET_RX_AMP_GAIN", SetRxAmpGain},
+        {"SET_TX_AMP_GAIN", SetTxAmpGain},
+        {"SET_AMP_ENABLE", SetAmpEnable},
+    };
+
+    QStringList parts = command.trimmed().split(':');
+    QString cmd = parts[0].toUpper();
+    bool ok = false;
+
+    if (parts.size() == 1 && cmd == "SWITCH_RX") {
+        add(SwitchRx);
+        return;
+    }
+    if (parts.size() == 1 && cmd == "SWITCH_TX") {
+        add(SwitchTx);
+        return;
+    }
+    if (parts.size() == 2 && cmd == "SET_FREQ") {
+        quint64 freq = parts[1].toULongLong(&ok);
+        if (ok) {
+            QByteArray payload(8, Qt::Uninitialized);
+            qToLittleEndian<quint64>(freq, payload.data());
+            add(SetFrequency, payload);
+            return;
+        }
+    }
+    if (parts.size() == 2) {
+        for (const auto& entry : numeric) {
+            if (cmd != entry.name) continue;
+            uint32_t value = parts[1].toUInt(&ok);
+            if (ok) {
+                add(entry.opcode, u32Payload(value));
+                return;
+            }
+        }
+    }
+
+    // Everything else (and anything malformed, so the server reports it)
+    add(Text, command.trimmed().toUtf8());
+}
+
+void ControlBatch::addReply(const QString& reply)
+{
+    add(Reply, reply.toUtf8());
+}
+
+QByteArray ControlBatch::encode(uint32_t epoch) const
+{
+    int body = 0;
+    for (const Message& m : m_messages) body += 4 + m.payload.size();
+
+    QByteArray frame(HEADER + body, Qt::Uninitialized);
+    char* p = frame.data();
+    std::memcpy(p, "HRCM", 4);
+    p[4] = static_cast<char>(VERSION);
+    p[5] = 0;
+    qToLittleEndian<quint16>(static_cast<quint16>(m_messages.size()), p + 6);
+    qToLittleEndian<quint32>(static_cast<quint32>(body), p + 8);
+    qToLittleEndian<quint32>(epoch, p + 12);
+
+    p += HEADER;
+    for (const Message& m : m_messages) {
+        qToLittleEndian<quint16>(m.opcode, p);
+        qToLittleEndian<quint16>(static_cast<quint16>(m.payload.size()), p + 2);
+        std::memcpy(p + 4, m.payload.constData(), m.payload.size());
+        p += 4 + m.payload.size();
+    }
+    return frame;
+}
+
+int ControlBatch::frameSize(const char* data, int len)
+{
+    if (len < HEADER) return 0;
+    if (std::memcmp(data, "HRCM", 4) != 0 || static_cast<uint8_t>(data[4]) != VERSION) return -1;
+
+    quint32 body = qFromLittleEndian<quint32>(data + 8);
+    if (body > MAX_BODY) return -1;
+    return HEADER + static_cast<int>(body);
+}
+
+bool ControlBatch::decode(const QByteArray& frame, ControlBatch* batch, uint32_t* epoch)
+{
+    if (frameSize(frame.constData(), frame.size()) != frame.size()) return false;
+
+    const char* p = frame.constData();
+    const int count = qFromLittleEndian<quint16>(p + 6);
+    if (epoch) *epoch = qFromLittleEndian<quint32>(p + 12);
+
+    batch->clear();
+    int pos = HEADER;
+    for (int i = 0; i < count; i++) {
+        if (frame.size() - pos < 4) return false;
+        quint16 opcode = qFromLittleEndian<quint16>(p + pos);
+        int len = qFromLittleEndian<quint16>(p + pos + 2);
+        if (frame.size() - pos - 4 < len) return false;
+        batch->add(static_cast<Opcode>(opcode), frame.mid(pos + 4, len));
+        pos += 4 + len;
+    }
+    return pos == frame.size();
+}
+
+QString ControlBatch::toCommand(const Message& message)
+{
+    const QByteArray& payload = message.payload;
+    auto u32 = [&payload]() { return qFromLittleEndian<quint32>(payload.constData()); };
+
+    switch (message.opcode) {
+    case Text:
+        return QString::fromUtf8(payload).trimmed();
+    case SetFrequency:
+        if (payload.size() != 8) break;
+        return QString("SET_FREQ:%1").arg(qFromLittleEndian<quint64>(payload.constData()));
+    case SetSampleRate:
+        if (payload.size() != 4) break;
+        return QString("SET_SAMPLE_RATE:%1").arg(u32());
+    case SetVgaGain:
+        if (payload.size() != 4) break;
+        return QString("SET_VGA_GAIN:%1").arg(u32());
+    case SetLnaGain:
+        if (payload.size() != 4) break;
+        return QString("SET_LNA_GAIN:%1").arg(u32());
+    case SetRxAmpGain:
+        if (payload.size() != 4) break;
+        return QString("SET_RX_AMP_GAIN:%1").arg(u32());
+    case SetTxAmpGain:
+        if (payload.size() != 4) break;
+        return QString("SET_TX_AMP_GAIN:%1").arg(u32());
+    case SetAmpEnable:
+        if (payload.size() != 4) break;
+        return QString("SET_AMP_ENABLE:%1").arg(u32());
+    case SwitchRx:
+        return "SWITCH_RX";
+    case SwitchTx:
+        return "SWITCH_TX";
+    case Reply:
+        break;
+    }
+    return QString();
+}
+
+bool ControlBatch::isRetune(Opcode opcode)
+{
+    return opcode == SetFrequency || opcode == SetSampleRate ||
+           opcode == SwitchRx || opcode == SwitchTx;
+}
@@ -0,0 +1,81 @@
+#ifndef CONTROLBATCH_H
+#define CONTROLBATCH_H
+
+#include <QByteArray>
+#include <QString>
+#include <vector>
+#include <cstdint>
+
+// Binary control frames for the control port, next to the text protocol.
+//
+// A client may send, instead of a text line, a frame holding any number of
+// commands; the server runs them in order and answers with one frame that
+// holds one Reply per command plus the tuning epoch after the last one
+// (see IqCodec: data frames carry the same epoch). A retune plus its gains
+// is then one write and one reply, and the client knows exactly which data
+// frames were captured before it. Unsolicited messages (DUMP_DONE...) stay
+// text lines and only ever appear between frames.
+//
+// Frame, little endian:
+//    0  char[4]  "HRCM"
+//    4  uint8    version (1)
+//    5  uint8    reserved (0)
+//    6  uint16   message count
+//    8  uint32   body bytes that follow
+//   12  uint32   tuning epoch (replies; 0 from clients)
+// Message:
+//    0  uint16   opcode
+//    2  uint16   payload bytes
+//    4  payload
+class ControlBatch
+{
+public:
+    enum Opcode : uint16_t {
+        Text = 1,               // UTF-8 text command, as on the text protocol
+        SetFrequency = 2,       // uint64 Hz
+        SetSampleRate = 3,      // uint32 Hz
+        SetVgaGain = 4,         // uint32
+        SetLnaGain = 5,         // uint32
+        SetRxAmpGain = 6,       // uint32
+        SetTxAmpGain = 7,       // uint32
+        SetAmpEnable = 8,       // uint32 0/1
+        SwitchRx = 9,           // no payload
+        SwitchTx = 10,          // no payload
+        Reply = 0x8000          // server -> client: UTF-8 reply text
+    };
+
+    struct Message {
+        Opcode opcode;
+        QByteArray payload;
+    };
+
+    static constexpr int HEADER = 16;
+    static constexpr uint8_t VERSION = 1;
+    static constexpr uint32_t MAX_BODY = 256 * 1024;
+
+    void add(Opcode opcode, const QByteArray& payload = QByteArray());
+    void addCommand(const QString& command);        // compact opcode where there is one
+    void addReply(const QString& reply);
+
+    bool isEmpty() const { return m_messages.empty(); }
+    int count() const { return static_cast<int>(m_messages.size()); }
+    const std::vector<Message>& messages() const { return m_messages; }
+    void clear() { m_messages.clear(); }
+
+    QByteArray encode(uint32_t epoch = 0) const;
+
+    // 0: need more bytes, -1: not a frame, otherwise the whole frame size
+    static int frameSize(const char* data, int len);
+    static bool decode(const QByteArray& frame, ControlBatch* batch, uint32_t* epoch);
+
+    // Back to the text form the command parser understands; empty if unknown
+    static QString toCommand(const Message& message);
+
+    // Commands that change what the data port carries
+    static bool isRetune(Opcode opcode);
+
+private:
+    std::vector<Message> m_messages;
+};
+
+#endif // CONTROLBATCH_H
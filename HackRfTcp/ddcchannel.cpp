@@ -0,0 +1,26 @@
+#include "ddcchannel.h"
+#include <cmath>
+#include <algorithm>
+
+DdcChannel::DdcChannel(uint32_t inputRate, double offsetHz, double bandwidthHz)
+    : m_offset(offsetHz)
+    , m_bandwidth(bandwidthHz)
+{
+    // Output rate >= 1.5x bandwidth leaves a third of it for the transition band
+    const int maxDecimation = std::max(1, static_cast<int>(std::floor(inputRate / (1.5 * bandwidthHz))));
+    m_chain.configure(inputRate, DdcChain::smoothDecimation(maxDecimation), offsetHz,
+                      bandwidthHz / 2.0, STOPBAND_DB);
+}
+
+void DdcChannel::process(const int8_t* in, size_t len, QByteArray& out)
+{
+    const std::vector<std::complex<float>>& iq = m_chain.process(in, len);
+
+    out.resize(static_cast<int>(iq.size() * 2 * sizeof(int16_t)));
+    int16_t* dst = reinterpret_cast<int16_t*>(out.data());
+    for (size_t i = 0; i < iq.size(); i++) {
+        // Full scale 1.0 (int8 full scale) -> x256 of int8 in int16
+        dst[i * 2]     = static_cast<int16_t>(std::clamp(iq[i].real() * 32768.0f, -32767.0f, 32767.0f));
+        dst[i * 2 + 1] = static_cast<int16_t>(std::clamp(iq[i].imag() * 32768.0f, -32767.0f, 32767.0f));
+    }
+}
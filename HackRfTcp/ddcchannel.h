@@ -0,0 +1,42 @@
+#ifndef DDCCHANNEL_H
+#define DDCCHANNEL_H
+
+#include <QByteArray>
+#include <complex>
+#include <vector>
+#include <cstdint>
+#include "ddcchain.h"
+
+// Per-client digital down converter for HackRfTcp.
+//
+// int8 IQ at the radio rate -> DdcChain (HackTvLib's DDC signal path: NCO
+// shift by -offset, then Kaiser windowed FIR decimators of 10 or less, the
+// channel filter last at the lowest rate) -> int16 IQ.
+// The output rate is the radio rate / D, at least 1.5x the requested
+// bandwidth, with D picked from the numbers whose prime factors are 7 or
+// less so the cascade has no large prime stage. Everything that would
+// alias into the band is down by STOPBAND_DB.
+// Output is ci16_le scaled x256, leaving headroom for the processing gain
+// that int8 would throw away after narrow decimation.
+class DdcChannel
+{
+public:
+    DdcChannel(uint32_t inputRate, double offsetHz, double bandwidthHz);
+
+    void process(const int8_t* in, size_t len, QByteArray& out);
+
+    double offset() const { return m_offset; }
+    double bandwidth() const { return m_bandwidth; }
+    int decimation() const { return m_chain.decimation(); }
+    double outputRate() const { return m_chain.outputRate(); }
+    size_t taps() const { return m_chain.taps(); }
+
+    static constexpr double STOPBAND_DB = 60.0;
+
+private:
+    double m_offset;
+    double m_bandwidth;
+    DdcChain m_chain;
+};
+
+#endif // DDCCHANNEL_H
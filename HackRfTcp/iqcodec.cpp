@@ -0,0 +1,316 @@
+#include "iqcodec.h"
+#include <QtEndian>
+#include <cstring>
+#include <cstdlib>
+#include <algorithm>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+bool IqCodec::parseEncoding(const QString& name, Encoding* encoding)
+{
+    QString n = name.trimmed().toLower();
+    if (n == "raw")          *encoding = Raw;
+    else if (n == "bfp4")    *encoding = Bfp4;
+    else if (n == "deflate") *encoding = Deflate;
+    else return false;
+    return true;
+}
+
+QString IqCodec::encodingName(Encoding encoding)
+{
+    switch (encoding) {
+    case Raw:     return "raw";
+    case Bfp4:    return "bfp4";
+    case Deflate: return "deflate";
+    }
+    return "unknown";
+}
+
+// ============================================================
+// Frames
+// ============================================================
+
+void IqCodec::writeHeader(char* h, Encoding encoding, uint8_t flags, const BlockInfo& info,
+                          uint32_t payloadBytes, uint32_t decodedBytes)
+{
+    std::memcpy(h, "HRQF", 4);
+    h[4] = static_cast<char>(FRAME_VERSION);
+    h[5] = static_cast<char>(encoding);
+    h[6] = static_cast<char>(flags | info.flags);
+    h[7] = static_cast<char>(info.format);
+    qToLittleEndian<quint16>(FRAME_HEADER, h + 8);
+    qToLittleEndian<quint16>(0, h + 10);
+    qToLittleEndian<quint32>(info.sequence, h + 12);
+    qToLittleEndian<quint32>(payloadBytes, h + 16);
+    qToLittleEndian<quint32>(decodedBytes, h + 20);
+    qToLittleEndian<quint64>(info.sampleIndex, h + 24);
+    qToLittleEndian<quint64>(info.timeUs, h + 32);
+    qToLittleEndian<quint64>(info.frequency, h + 40);
+    qToLittleEndian<quint32>(info.sampleRate, h + 48);
+    qToLittleEndian<quint32>(info.epoch, h + 52);
+}
+
+QByteArray IqCodec::encodeFrame(Encoding encoding, const QByteArray& block, const BlockInfo& info)
+{
+    const size_t len = static_cast<size_t>(block.size());
+    const int8_t* in = reinterpret_cast<const int8_t*>(block.constData());
+    QByteArray frame;
+    uint8_t flags = 0;
+
+    switch (encoding) {
+    case Raw:
+        frame.resize(FRAME_HEADER + block.size());
+        std::memcpy(frame.data() + FRAME_HEADER, block.constData(), len);
+        break;
+
+    case Bfp4: {
+        size_t encoded = bfp4EncodedSize(len);
+        frame.resize(FRAME_HEADER + static_cast<int>(encoded));
+        encodeBfp4(in, len, reinterpret_cast<uint8_t*>(frame.data() + FRAME_HEADER));
+        break;
+    }
+
+    case Deflate: {
+        // Level 1: the gain over 9 is a few percent on noise-like IQ, the cost 5-10x
+        QByteArray packed;
+        if (deltaHelps(in, len)) {
+            QByteArray delta(block.size(), Qt::Uninitialized);
+            deltaEncode(in, len, reinterpret_cast<int8_t*>(delta.data()));
+            packed = qCompress(delta, 1);
+            flags |= FLAG_DELTA;
+        } else {
+            packed = qCompress(block, 1);
+        }
+        frame.resize(FRAME_HEADER + packed.size());
+        std::memcpy(frame.data() + FRAME_HEADER, packed.constData(), packed.size());
+        break;
+    }
+    }
+
+    writeHeader(frame.data(), encoding, flags, info, static_cast<uint32_t>(frame.size() - FRAME_HEADER),
+                static_cast<uint32_t>(len));
+    return frame;
+}
+
+bool IqCodec::parseHeader(const char* data, FrameHeader* header)
+{
+    if (std::memcmp(data, "HRQF", 4) != 0) return false;
+    if (static_cast<uint8_t>(data[4]) != FRAME_VERSION) return false;
+
+    uint8_t encoding = static_cast<uint8_t>(data[5]);
+    uint8_t format = static_cast<uint8_t>(data[7]);
+    if (encoding > Deflate || (format != FormatCi8 && format != FormatCi16)) return false;
+
+    header->encoding = static_cast<Encoding>(encoding);
+    header->flags = static_cast<uint8_t>(data[6]);
+    if (header->flags & ~(FLAG_DELTA | FLAG_RETUNED)) return false;
+    header->headerBytes = qFromLittleEndian<quint16>(data + 8);
+    if (header->headerBytes < FRAME_HEADER || header->headerBytes > 1024) return false;
+    header->payloadBytes = qFromLittleEndian<quint32>(data + 16);
+    header->decodedBytes = qFromLittleEndian<quint32>(data + 20);
+    if (header->payloadBytes > MAX_FRAME_BYTES || header->decodedBytes > MAX_FRAME_BYTES) return false;
+
+    BlockInfo& info = header->info;
+    info.format = static_cast<SampleFormat>(format);
+    info.flags = header->flags & FLAG_RETUNED;
+    info.sequence = qFromLittleEndian<quint32>(data + 12);
+    info.sampleIndex = qFromLittleEndian<quint64>(data + 24);
+    info.timeUs = qFromLittleEndian<quint64>(data + 32);
+    info.frequency = qFromLittleEndian<quint64>(data + 40);
+    info.sampleRate = qFromLittleEndian<quint32>(data + 48);
+    info.epoch = qFromLittleEndian<quint32>(data + 52);
+
+    switch (header->encoding) {
+    case Raw:     return header->payloadBytes == header->decodedBytes;
+    case Bfp4:    return header->payloadBytes == bfp4EncodedSize(header->decodedBytes);
+    case Deflate: return header->payloadBytes >= 4;
+    }
+    return false;
+}
+
+bool IqCodec::decodeFrame(const FrameHeader& header, const char* payload, QByteArray& out)
+{
+    const int start = out.size();
+
+    switch (header.encoding) {
+    case Raw:
+        out.append(payload, static_cast<int>(header.payloadBytes));
+        return true;
+
+    case Bfp4:
+        out.resize(start + static_cast<int>(header.decodedBytes));
+        decodeBfp4(reinterpret_cast<const uint8_t*>(payload), header.decodedBytes,
+                   reinterpret_cast<int8_t*>(out.data() + start));
+        return true;
+
+    case Deflate: {
+        QByteArray delta = qUncompress(reinterpret_cast<const uchar*>(payload),
+                                       static_cast<qsizetype>(header.payloadBytes));
+        if (static_cast<uint32_t>(delta.size()) != header.decodedBytes) return false;
+        if (header.flags & FLAG_DELTA) {
+            deltaDecode(reinterpret_cast<int8_t*>(delta.data()), static_cast<size_t>(delta.size()));
+        }
+        out.append(delta);
+        return true;
+    }
+    }
+    return false;
+}
+
+// ============================================================
+// 4-bit block floating point
+// ============================================================
+
+size_t IqCodec::bfp4EncodedSize(size_t values)
+{
+    return (values + BFP_GROUP - 1) / BFP_GROUP * BFP_GROUP_BYTES;
+}
+
+void IqCodec::encodeBfp4(const int8_t* in, size_t values, uint8_t* out)
+{
+    int8_t group[BFP_GROUP];
+
+    for (size_t pos = 0; pos < values; pos += BFP_GROUP) {
+        const size_t n = std::min<size_t>(BFP_GROUP, values - pos);
+        std::memcpy(group, in + pos, n);
+        std::memset(group + n, 0, BFP_GROUP - n);
+
+        int peak = 0;
+        for (int i = 0; i < BFP_GROUP; i++) {
+            peak = std::max(peak, std::abs(static_cast<int>(group[i])));
+        }
+
+        // Smallest shift that keeps the peak within +/-7 steps (-128 still fits as -8 << 4)
+        int shift = 0;
+        while (shift < 4 && peak > (7 << shift)) shift++;
+
+        *out++ = static_cast<uint8_t>(shift);
+        const int round = shift ? 1 << (shift - 1) : 0;
+        for (int i = 0; i < BFP_GROUP; i += 2) {
+            int lo = std::clamp((group[i] + round) >> shift, -8, 7);
+            int hi = std::clamp((group[i + 1] + round) >> shift, -8, 7);
+            *out++ = static_cast<uint8_t>((lo & 0x0f) | ((hi & 0x0f) << 4));
+        }
+    }
+}
+
+void IqCodec::decodeBfp4(const uint8_t* in, size_t values, int8_t* out)
+{
+    int8_t tail[BFP_GROUP];
+
+    for (size_t pos = 0; pos < values; pos += BFP_GROUP, in += BFP_GROUP_BYTES) {
+        // Short last group: decode into scratch, copy what is real
+        const bool partial = values - pos < static_cast<size_t>(BFP_GROUP);
+        int8_t* dst = partial ? tail : out + pos;
+        const int shift = std::min<int>(in[0], 4);
+        const uint8_t* nibbles = in + 1;
+
+#if defined(__SSE2__)
+        const __m128i mask = _mm_set1_epi8(0x0f);
+        const __m128i sign = _mm_set1_epi8(0x08);
+        for (int i = 0; i < BFP_GROUP / 2; i += 16) {
+            __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(nibbles + i));
+            __m128i lo = _mm_and_si128(b, mask);
+            __m128i hi = _mm_and_si128(_mm_srli_epi16(b, 4), mask);
+            // 4-bit two's complement -> int8, then scale by 2^shift
+            lo = _mm_sub_epi8(_mm_xor_si128(lo, sign), sign);
+            hi = _mm_sub_epi8(_mm_xor_si128(hi, sign), sign);
+            for (int s = 0; s < shift; s++) {
+                lo = _mm_add_epi8(lo, lo);
+                hi = _mm_add_epi8(hi, hi);
+            }
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + 2 * i), _mm_unpacklo_epi8(lo, hi));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + 2 * i + 16), _mm_unpackhi_epi8(lo, hi));
+        }
+#elif defined(__ARM_NEON)
+        const uint8x16_t mask = vdupq_n_u8(0x0f);
+        const int8x16_t sign = vdupq_n_s8(0x08);
+        const int8x16_t scale = vdupq_n_s8(static_cast<int8_t>(shift));
+        for (int i = 0; i < BFP_GROUP / 2; i += 16) {
+            uint8x16_t b = vld1q_u8(nibbles + i);
+            int8x16_t lo = vreinterpretq_s8_u8(vandq_u8(b, mask));
+            int8x16_t hi = vreinterpretq_s8_u8(vshrq_n_u8(b, 4));
+            lo = vshlq_s8(vsubq_s8(veorq_s8(lo, sign), sign), scale);
+            hi = vshlq_s8(vsubq_s8(veorq_s8(hi, sign), sign), scale);
+            int8x16x2_t pair = {{lo, hi}};
+            vst2q_s8(dst + 2 * i, pair);
+        }
+#else
+        for (int i = 0; i < BFP_GROUP / 2; i++) {
+            int lo = ((nibbles[i] & 0x0f) ^ 0x08) - 0x08;
+            int hi = ((nibbles[i] >> 4) ^ 0x08) - 0x08;
+            dst[2 * i] = static_cast<int8_t>(lo * (1 << shift));
+            dst[2 * i + 1] = static_cast<int8_t>(hi * (1 << shift));
+        }
+#endif
+
+        if (partial) {
+            std::memcpy(out + pos, tail, values - pos);
+        }
+    }
+}
+
+// ============================================================
+// Delta coding (I and Q separately, wrapping int8)
+// ============================================================
+
+// Sum of magnitudes as a cheap stand-in for entropy, on every 8th pair
+bool IqCodec::deltaHelps(const int8_t* in, size_t len)
+{
+    long plain = 0, delta = 0;
+    for (size_t i = 16; i + 1 < len; i += 16) {
+        plain += std::abs(in[i]) + std::abs(in[i + 1]);
+        delta += std::abs(in[i] - in[i - 2]) + std::abs(in[i + 1] - in[i - 1]);
+    }
+    return delta < plain;
+}
+
+void IqCodec::deltaEncode(const int8_t* in, size_t len, int8_t* out)
+{
+    const uint8_t* u = reinterpret_cast<const uint8_t*>(in);
+    uint8_t* o = reinterpret_cast<uint8_t*>(out);
+    for (size_t i = 0; i < std::min<size_t>(len, 2); i++) o[i] = u[i];
+    for (size_t i = 2; i < len; i++) {
+        o[i] = static_cast<uint8_t>(u[i] - u[i - 2]);
+    }
+}
+
+void IqCodec::deltaDecode(int8_t* data, size_t len)
+{
+    uint8_t* u = reinterpret_cast<uint8_t*>(data);
+    size_t i = 0;
+
+#if defined(__SSE2__)
+    // Stride-2 prefix sum inside 16 bytes, plus the last I/Q pair of the previous vector
+    __m128i carry = _mm_setzero_si128();
+    for (; i + 16 <= len; i += 16) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(u + i));
+        v = _mm_add_epi8(v, _mm_slli_si128(v, 2));
+        v = _mm_add_epi8(v, _mm_slli_si128(v, 4));
+        v = _mm_add_epi8(v, _mm_slli_si128(v, 8));
+        v = _mm_add_epi8(v, carry);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(u + i), v);
+        carry = _mm_set1_epi16(static_cast<short>(_mm_extract_epi16(v, 7)));
+    }
+#elif defined(__ARM_NEON)
+    const uint8x16_t zero = vdupq_n_u8(0);
+    uint8x16_t carry = zero;
+    for (; i + 16 <= len; i += 16) {
+        uint8x16_t v = vld1q_u8(u + i);
+        v = vaddq_u8(v, vextq_u8(zero, v, 14));
+        v = vaddq_u8(v, vextq_u8(zero, v, 12));
+        v = vaddq_u8(v, vextq_u8(zero, v, 8));
+        v = vaddq_u8(v, carry);
+        vst1q_u8(u + i, v);
+        carry = vreinterpretq_u8_u16(vdupq_n_u16(vgetq_lane_u16(vreinterpretq_u16_u8(v), 7)));
+    }
+#endif
+
+    for (; i < len; i++) {
+        if (i >= 2) u[i] = static_cast<uint8_t>(u[i] + u[i - 2]);
+    }
+}
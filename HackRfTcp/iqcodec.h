@@ -0,0 +1,110 @@
+#ifndef IQCODEC_H
+#define IQCODEC_H
+
+#include <QByteArray>
+#include <QString>
+#include <cstdint>
+#include <cstddef>
+
+// Data port encodings for links slower than the raw ~40 MB/s int8 stream.
+//
+// A client that asked for an encoding gets every block as a frame:
+//    0  char[4]  "HRQF"
+//    4  uint8    version (2)
+//    5  uint8    encoding
+//    6  uint8    flags (FLAG_DELTA, FLAG_RETUNED)
+//    7  uint8    sample format (1 = ci8, 2 = ci16 from a DDC)
+//    8  uint16   header bytes (56; newer versions may append fields)
+//   10  uint16   reserved (0)
+//   12  uint32   block sequence on this data port (a gap = dropped blocks)
+//   16  uint32   payload bytes that follow the header
+//   20  uint32   bytes after decoding
+//   24  uint64   index of the first sample since the stream started
+//   32  uint64   capture time of the first sample, UTC microseconds
+//   40  uint64   centre frequency in Hz
+//   48  uint32   sample rate
+//   52  uint32   tuning epoch: +1 on every frequency, rate, gain or mode
+//                change, so clients can drop samples from before a retune
+// little endian. Until the first SET_ENCODING the port sends bare int8 IQ
+// as before; after it every block is framed, Raw included, so the client
+// can follow later switches without guessing where a block starts.
+//
+//   Raw      payload is the block itself (int8, or ci16 from a DDC)
+//   Bfp4     4-bit block floating point: per 64 values one shift byte
+//            (0-4) and 32 bytes of two's complement nibbles, low nibble
+//            first; ~1.9x smaller, about 20 dB SNR
+//   Deflate  lossless: zlib (qCompress, level 1), with I and Q delta coded
+//            first when that looks smaller (oversampled signals; on white
+//            noise deltas only add entropy)
+//
+// HackRfRadio's TcpClient builds this file for the decoder side.
+class IqCodec
+{
+public:
+    enum Encoding : uint8_t {
+        Raw = 0,
+        Bfp4 = 1,
+        Deflate = 2
+    };
+
+    enum SampleFormat : uint8_t {
+        FormatCi8 = 1,
+        FormatCi16 = 2
+    };
+
+    static constexpr int FRAME_HEADER = 56;
+    static constexpr uint8_t FRAME_VERSION = 2;
+    static constexpr uint8_t FLAG_DELTA = 0x01;        // deflate payload is delta coded
+    static constexpr uint8_t FLAG_RETUNED = 0x02;      // first block of a new tuning epoch
+    static constexpr int BFP_GROUP = 64;                        // values per shift byte
+    static constexpr int BFP_GROUP_BYTES = 1 + BFP_GROUP / 2;
+    static constexpr uint32_t MAX_FRAME_BYTES = 16 * 1024 * 1024;
+
+    // What the radio was doing when the block was captured
+    struct BlockInfo {
+        SampleFormat format = FormatCi8;
+        uint8_t flags = 0;                  // FLAG_RETUNED
+        uint32_t sequence = 0;
+        uint64_t sampleIndex = 0;
+        uint64_t timeUs = 0;
+        uint64_t frequency = 0;
+        uint32_t sampleRate = 0;
+        uint32_t epoch = 0;
+    };
+
+    struct FrameHeader {
+        Encoding encoding = Raw;
+        uint8_t flags = 0;
+        int headerBytes = FRAME_HEADER;
+        uint32_t payloadBytes = 0;
+        uint32_t decodedBytes = 0;
+        BlockInfo info;
+    };
+
+    static bool parseEncoding(const QString& name, Encoding* encoding);
+    static QString encodingName(Encoding encoding);
+
+    // Whole frame (header + payload) for one block
+    static QByteArray encodeFrame(Encoding encoding, const QByteArray& block, const BlockInfo& info);
+
+    // FRAME_HEADER bytes at out, for frames built elsewhere (shared memory ring)
+    static void writeHeader(char* out, Encoding encoding, uint8_t flags, const BlockInfo& info,
+                            uint32_t payloadBytes, uint32_t decodedBytes);
+
+    // Header check on FRAME_HEADER bytes; false on anything that is not a
+    // plausible frame. header->headerBytes may be larger (skip the rest).
+    static bool parseHeader(const char* data, FrameHeader* header);
+
+    // Appends the decoded payload to out
+    static bool decodeFrame(const FrameHeader& header, const char* payload, QByteArray& out);
+
+    // Codec kernels
+    static size_t bfp4EncodedSize(size_t values);
+    static void encodeBfp4(const int8_t* in, size_t values, uint8_t* out);
+    static void decodeBfp4(const uint8_t* in, size_t values, int8_t* out);
+    static void deltaEncode(const int8_t* in, size_t len, int8_t* out);
+    static void deltaDecode(int8_t* data, size_t len);      // in place
+    static bool deltaHelps(const int8_t* in, size_t len);
+};
+
+#endif // IQCODEC_H
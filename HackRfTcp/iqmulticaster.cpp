@@ -0,0 +1,280 @@
+#include "iqmulticaster.h"
+#include <QUdpSocket>
+#include <QtEndian>
+#include <QDebug>
+#include <chrono>
+#include <future>
+#include <vector>
+#include <cstring>
+#include <algorithm>
+
+#ifdef Q_OS_LINUX
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <cerrno>
+#endif
+
+// Datagrams per sendmmsg() call
+static constexpr int SEND_BATCH = 64;
+
+IqMulticaster::IqMulticaster()
+    : m_port(0)
+    , m_ttl(1)
+    , m_payloadSize(1400)
+    , m_stop(false)
+    , m_running(false)
+    , m_frequency(0)
+    , m_sampleRate(0)
+    , m_format(FORMAT_CI8)
+    , m_sequence(0)
+    , m_sampleIndex(0)
+    , m_packets(0)
+    , m_bytes(0)
+    , m_syscalls(0)
+    , m_overruns(0)
+    , m_sendErrors(0)
+{
+}
+
+IqMulticaster::~IqMulticaster()
+{
+    stop();
+}
+
+bool IqMulticaster::start(const QHostAddress& group, quint16 port, int ttl, int mtu, QString* error)
+{
+    if (m_running.load()) return true;
+
+    if (!group.isMulticast()) {
+        if (error) *error = QString("%1 is not a multicast address").arg(group.toString());
+        return false;
+    }
+
+    m_group = group;
+    m_port = port;
+    m_ttl = std::max(1, ttl);
+
+    // IPv4 + UDP headers; whole IQ pairs
+    int ipHeader = (group.protocol() == QAbstractSocket::IPv6Protocol) ? 40 : 20;
+    m_payloadSize = (std::max(576, mtu) - ipHeader - 8 - HEADER_SIZE) & ~1;
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = false;
+        m_pending.clear();
+    }
+    m_sequence = 0;
+    m_sampleIndex = 0;
+
+    // The socket is created on the worker; wait for it to report back
+    std::promise<QString> ready;
+    std::future<QString> result = ready.get_future();
+    m_thread = std::thread(&IqMulticaster::run, this, &ready);
+    QString setupError = result.get();
+
+    if (!setupError.isEmpty()) {
+        m_thread.join();
+        if (error) *error = setupError;
+        return false;
+    }
+
+    m_running.store(true);
+    qDebug() << "Multicast:" << group.toString() << "port" << port << "TTL" << m_ttl
+             << "payload" << m_payloadSize << "bytes";
+    return true;
+}
+
+void IqMulticaster::stop()
+{
+    if (!m_thread.joinable()) return;
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_cond.notify_one();
+    m_thread.join();
+    m_running.store(false);
+}
+
+void IqMulticaster::setTuning(uint64_t frequency, uint32_t sampleRate)
+{
+    m_frequency.store(frequency);
+    m_sampleRate.store(sampleRate);
+}
+
+// ============================================================
+// Producer
+// ============================================================
+
+void IqMulticaster::pushBlock(const int8_t* data, size_t len)
+{
+    if (!m_running.load(std::memory_order_relaxed)) return;
+
+    quint64 nowUs = std::chrono::duration_cast<std::chrono::microseconds>(
+                        std::chrono::system_clock::now().time_since_epoch()).count();
+    QByteArray block(reinterpret_cast<const char*>(data), static_cast<int>(len));
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_pending.size() >= MAX_PENDING) {
+            // Network slower than the radio: receivers see it as a gap
+            m_pending.pop_front();
+            m_overruns.fetch_add(1, std::memory_order_relaxed);
+        }
+        m_pending.push_back({std::move(block), nowUs});
+    }
+    m_cond.notify_one();
+}
+
+// ============================================================
+// Worker
+// ============================================================
+
+void IqMulticaster::run(std::promise<QString>* ready)
+{
+    QUdpSocket socket;
+    if (!socket.bind(m_group.protocol() == QAbstractSocket::IPv6Protocol ? QHostAddress::AnyIPv6
+                                                                         : QHostAddress::AnyIPv4, 0)) {
+        ready->set_value(QString("cannot bind multicast socket: %1").arg(socket.errorString()));
+        return;
+    }
+    socket.setSocketOption(QAbstractSocket::MulticastTtlOption, m_ttl);
+    socket.setSocketOption(QAbstractSocket::MulticastLoopbackOption, 1);
+    socket.setSocketOption(QAbstractSocket::SendBufferSizeSocketOption, 4 * 1024 * 1024);
+    ready->set_value(QString());
+
+    for (;;) {
+        Block block;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_cond.wait(lock, [this]() { return m_stop || !m_pending.empty(); });
+            if (m_stop) return;
+            block = std::move(m_pending.front());
+            m_pending.pop_front();
+        }
+        sendBlock(socket, block);
+    }
+}
+
+void IqMulticaster::sendBlock(QUdpSocket& socket, const Block& block)
+{
+    const uint32_t sampleRate = m_sampleRate.load();
+    const uint64_t frequency = m_frequency.load();
+    const uint8_t format = m_format.load();
+    const int len = block.data.size() & ~1;
+    const int packets = (len + m_payloadSize - 1) / m_payloadSize;
+
+    // Headers for the whole block; payloads point into the block itself
+    std::vector<char> headers(static_cast<size_t>(packets) * HEADER_SIZE);
+    for (int i = 0; i < packets; i++) {
+        char* h = headers.data() + static_cast<size_t>(i) * HEADER_SIZE;
+        uint64_t index = m_sampleIndex + static_cast<uint64_t>(i) * (m_payloadSize / 2);
+        uint64_t offsetUs = sampleRate ? (static_cast<uint64_t>(i) * (m_payloadSize / 2)) * 1000000ULL / sampleRate : 0;
+        // Block time is its arrival, i.e. its last sample
+        uint64_t blockUs = sampleRate ? static_cast<uint64_t>(len / 2) * 1000000ULL / sampleRate : 0;
+
+        std::memcpy(h, "HRIQ", 4);
+        h[4] = static_cast<char>(VERSION);
+        h[5] = static_cast<char>(format);
+        qToLittleEndian<quint16>(HEADER_SIZE, h + 6);
+        qToLittleEndian<quint32>(m_sequence + static_cast<uint32_t>(i), h + 8);
+        qToLittleEndian<quint32>(sampleRate, h + 12);
+        qToLittleEndian<quint64>(frequency, h + 16);
+        qToLittleEndian<quint64>(index, h + 24);
+        qToLittleEndian<quint64>(block.timeUs - blockUs + offsetUs, h + 32);
+    }
+
+#ifdef Q_OS_LINUX
+    sockaddr_storage dest;
+    socklen_t destLen;
+    std::memset(&dest, 0, sizeof(dest));
+    if (m_group.protocol() == QAbstractSocket::IPv6Protocol) {
+        sockaddr_in6* d = reinterpret_cast<sockaddr_in6*>(&dest);
+        d->sin6_family = AF_INET6;
+        d->sin6_port = htons(m_port);
+        Q_IPV6ADDR addr = m_group.toIPv6Address();
+        std::memcpy(&d->sin6_addr, &addr, 16);
+        destLen = sizeof(sockaddr_in6);
+    } else {
+        sockaddr_in* d = reinterpret_cast<sockaddr_in*>(&dest);
+        d->sin_family = AF_INET;
+        d->sin_port = htons(m_port);
+        d->sin_addr.s_addr = htonl(m_group.toIPv4Address());
+        destLen = sizeof(sockaddr_in);
+    }
+
+    // Header + payload as two iovecs, up to SEND_BATCH datagrams per syscall
+    const int fd = static_cast<int>(socket.socketDescriptor());
+    iovec iov[SEND_BATCH][2];
+    mmsghdr msgs[SEND_BATCH];
+    int next = 0;
+    while (next < packets) {
+        int batch = std::min(SEND_BATCH, packets - next);
+        for (int i = 0; i < batch; i++) {
+            int p = next + i;
+            int offset = p * m_payloadSize;
+            iov[i][0].iov_base = headers.data() + static_cast<size_t>(p) * HEADER_SIZE;
+            iov[i][0].iov_len = HEADER_SIZE;
+            iov[i][1].iov_base = const_cast<char*>(block.data.constData()) + offset;
+            iov[i][1].iov_len = static_cast<size_t>(std::min(m_payloadSize, len - offset));
+
+            std::memset(&msgs[i], 0, sizeof(mmsghdr));
+            msgs[i].msg_hdr.msg_name = &dest;
+            msgs[i].msg_hdr.msg_namelen = destLen;
+            msgs[i].msg_hdr.msg_iov = iov[i];
+            msgs[i].msg_hdr.msg_iovlen = 2;
+        }
+
+        int sent = sendmmsg(fd, msgs, batch, 0);
+        m_syscalls.fetch_add(1, std::memory_order_relaxed);
+        if (sent < 0) {
+            if (errno == EINTR) continue;
+            // ENOBUFS and friends: the rest of this block is lost on the wire
+            m_sendErrors.fetch_add(packets - next, std::memory_order_relaxed);
+            break;
+        }
+        for (int i = 0; i < sent; i++) {
+            m_bytes.fetch_add(msgs[i].msg_len, std::memory_order_relaxed);
+        }
+        m_packets.fetch_add(sent, std::memory_order_relaxed);
+        next += sent;
+    }
+#else
+    QByteArray datagram;
+    for (int p = 0; p < packets; p++) {
+        int offset = p * m_payloadSize;
+        int size = std::min(m_payloadSize, len - offset);
+        datagram.resize(HEADER_SIZE + size);
+        std::memcpy(datagram.data(), headers.data() + static_cast<size_t>(p) * HEADER_SIZE, HEADER_SIZE);
+        std::memcpy(datagram.data() + HEADER_SIZE, block.data.constData() + offset, size);
+
+        qint64 written = socket.writeDatagram(datagram, m_group, m_port);
+        m_syscalls.fetch_add(1, std::memory_order_relaxed);
+        if (written < 0) {
+            m_sendErrors.fetch_add(1, std::memory_order_relaxed);
+        } else {
+            m_bytes.fetch_add(written, std::memory_order_relaxed);
+            m_packets.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+#endif
+
+    // Lost datagrams still advance the counters, so receivers see the gap
+    m_sequence += static_cast<uint32_t>(packets);
+    m_sampleIndex += static_cast<uint64_t>(len / 2);
+}
+
+QString IqMulticaster::statusText() const
+{
+    if (!m_running.load()) return "OFF";
+
+    quint64 packets = m_packets.load();
+    return QString("%1:%2, %3 packets, %4 MB, %5 packets/call, %6 send errors, %7 block overruns")
+        .arg(m_group.toString()).arg(m_port)
+        .arg(packets)
+        .arg(m_bytes.load() / (1024.0 * 1024.0), 0, 'f', 1)
+        .arg(m_syscalls.load() ? static_cast<double>(packets) / m_syscalls.load() : 0.0, 0, 'f', 1)
+        .arg(m_sendErrors.load())
+        .arg(m_overruns.load());
+}
@@ -0,0 +1,100 @@
+#ifndef IQMULTICASTER_H
+#define IQMULTICASTER_H
+
+#include <QString>
+#include <QByteArray>
+#include <QHostAddress>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <future>
+#include <deque>
+#include <cstdint>
+
+class QUdpSocket;
+
+// UDP multicast distribution of the RX IQ stream.
+//
+// Every block is cut into MTU-sized datagrams and sent once to a multicast
+// group, so the server cost does not depend on how many receivers joined.
+// pushBlock() is called from the RX callback and only queues the block;
+// a worker thread packetises it and sends with sendmmsg() on Linux
+// (QUdpSocket::writeDatagram() elsewhere).
+//
+// Datagram layout, little endian (HackRfRadio's TcpClient parses the same):
+//    0  char[4]  "HRIQ"
+//    4  uint8    version (1)
+//    5  uint8    sample format (1 = ci8, 2 = cu8 from RTL-SDR)
+//    6  uint16   header size (40)
+//    8  uint32   sequence number, +1 per datagram
+//   12  uint32   sample rate
+//   16  uint64   center frequency in Hz
+//   24  uint64   index of the first IQ pair in the payload since start()
+//   32  uint64   UTC time of that sample in microseconds (from block arrival)
+//   40  payload  IQ pairs
+class IqMulticaster
+{
+public:
+    static constexpr int HEADER_SIZE = 40;
+    static constexpr uint8_t VERSION = 1;
+    static constexpr uint8_t FORMAT_CI8 = 1;
+    static constexpr uint8_t FORMAT_CU8 = 2;
+
+    IqMulticaster();
+    ~IqMulticaster();
+
+    bool start(const QHostAddress& group, quint16 port, int ttl, int mtu, QString* error = nullptr);
+    void stop();
+    bool isRunning() const { return m_running.load(); }
+
+    QHostAddress group() const { return m_group; }
+    quint16 port() const { return m_port; }
+
+    // Header fields for the following blocks (any thread)
+    void setTuning(uint64_t frequency, uint32_t sampleRate);
+    void setFormat(uint8_t format) { m_format.store(format); }
+
+    // Producer side: RX callback thread, copies the block once
+    void pushBlock(const int8_t* data, size_t len);
+
+    QString statusText() const;
+
+private:
+    struct Block {
+        QByteArray data;
+        quint64 timeUs;
+    };
+
+    void run(std::promise<QString>* ready);
+    void sendBlock(QUdpSocket& socket, const Block& block);
+
+    QHostAddress m_group;
+    quint16 m_port;
+    int m_ttl;
+    int m_payloadSize;
+
+    std::thread m_thread;
+    std::mutex m_mutex;                    // guards m_pending / m_stop
+    std::condition_variable m_cond;
+    std::deque<Block> m_pending;
+    bool m_stop;
+    static constexpr size_t MAX_PENDING = 32;
+
+    std::atomic<bool> m_running;
+    std::atomic<uint64_t> m_frequency;
+    std::atomic<uint32_t> m_sampleRate;
+    std::atomic<uint8_t> m_format;
+
+    // Worker thread only
+    uint32_t m_sequence;
+    uint64_t m_sampleIndex;
+
+    std::atomic<quint64> m_packets;
+    std::atomic<quint64> m_bytes;
+    std::atomic<quint64> m_syscalls;
+    std::atomic<quint64> m_overruns;
+    std::atomic<quint64> m_sendErrors;
+};
+
+#endif // IQMULTICASTER_H
@@ -0,0 +1,527 @@
+#include "iqshmbus.h"
+#include <QDebug>
+#include <cstring>
+#include <algorithm>
+#include <new>
+
+#ifdef Q_OS_LINUX
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/eventfd.h>
+#include <sys/syscall.h>
+#include <poll.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cstddef>
+#include <cerrno>
+#endif
+
+// First message on the unix socket, with the two descriptors attached
+struct ShmHello {
+    char magic[4];
+    uint32_t version;
+    uint64_t ringBytes;
+};
+
+QString IqShmBus::socketName(quint16 dataPort)
+{
+    return QString("hackrftcp-iq-%1").arg(dataPort);
+}
+
+#ifdef Q_OS_LINUX
+
+static void closeFd(int& fd)
+{
+    if (fd >= 0) ::close(fd);
+    fd = -1;
+}
+
+// The ring twice, back to back, so no record ever has to be split
+static char* mapRing(int fd, size_t ringBytes, int prot)
+{
+    void* base = mmap(nullptr, 2 * ringBytes, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (base == MAP_FAILED) return nullptr;
+
+    char* p = static_cast<char*>(base);
+    for (int i = 0; i < 2; i++) {
+        void* half = mmap(p + i * ringBytes, ringBytes, prot, MAP_SHARED | MAP_FIXED, fd,
+                          static_cast<off_t>(IqShmBus::CONTROL_BYTES));
+        if (half == MAP_FAILED) {
+            munmap(base, 2 * ringBytes);
+            return nullptr;
+        }
+    }
+    return p;
+}
+
+static socklen_t abstractAddress(const QString& name, sockaddr_un* addr)
+{
+    QByteArray bytes = name.toUtf8();
+    std::memset(addr, 0, sizeof(sockaddr_un));
+    addr->sun_family = AF_UNIX;
+    size_t len = std::min(static_cast<size_t>(bytes.size()), sizeof(addr->sun_path) - 1);
+    std::memcpy(addr->sun_path + 1, bytes.constData(), len);     // leading NUL: abstract namespace
+    return static_cast<socklen_t>(offsetof(sockaddr_un, sun_path) + 1 + len);
+}
+
+// ============================================================
+// Server
+// ============================================================
+
+IqShmBus::IqShmBus()
+    : m_memFd(-1)
+    , m_readOnlyFd(-1)
+    , m_listenFd(-1)
+    , m_stopFd(-1)
+    , m_control(nullptr)
+    , m_ring(nullptr)
+    , m_ringBytes(0)
+    , m_readerCount(0)
+    , m_running(false)
+    , m_writePos(0)
+    , m_blocks(0)
+    , m_bytes(0)
+{
+}
+
+IqShmBus::~IqShmBus()
+{
+    stop();
+}
+
+bool IqShmBus::start(quint16 dataPort, size_t ringBytes, QString* error)
+{
+    if (m_running.load()) return true;
+
+    auto fail = [this, error](const QString& message) {
+        if (error) *error = QString("%1: %2").arg(message, QString::fromLocal8Bit(strerror(errno)));
+        stop();
+        return false;
+    };
+
+    const size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    m_ringBytes = (std::max<size_t>(ringBytes, 4 * 1024 * 1024) + page - 1) / page * page;
+    m_name = socketName(dataPort);
+
+    // memfd_create through syscall(): older libc headers lack the wrapper
+    m_memFd = static_cast<int>(syscall(SYS_memfd_create, "hackrftcp-iq", MFD_CLOEXEC));
+    if (m_memFd < 0) return fail("memfd_create");
+    if (ftruncate(m_memFd, static_cast<off_t>(CONTROL_BYTES + m_ringBytes)) != 0) return fail("ftruncate");
+
+    // What readers get: the same file, opened read-only
+    QByteArray self = QString("/proc/self/fd/%1").arg(m_memFd).toLatin1();
+    m_readOnlyFd = ::open(self.constData(), O_RDONLY | O_CLOEXEC);
+    if (m_readOnlyFd < 0) return fail("read-only reopen");
+
+    void* control = mmap(nullptr, CONTROL_BYTES, PROT_READ | PROT_WRITE, MAP_SHARED, m_memFd, 0);
+    if (control == MAP_FAILED) return fail("mmap");
+    m_control = new (control) Control;
+    std::memcpy(m_control->magic, "HRSM", 4);
+    m_control->version = VERSION;
+    m_control->ringBytes = m_ringBytes;
+    m_control->writePos.store(0);
+    m_control->writeEnd.store(0);
+    m_control->newest.store(0);
+    m_writePos = 0;
+
+    m_ring = mapRing(m_memFd, m_ringBytes, PROT_READ | PROT_WRITE);
+    if (!m_ring) return fail("ring mmap");
+    // Fault the ring in now, not in the USB callback
+    std::memset(m_ring, 0, m_ringBytes);
+
+    m_listenFd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (m_listenFd < 0) return fail("socket");
+    sockaddr_un addr;
+    socklen_t addrLen = abstractAddress(m_name, &addr);
+    if (bind(m_listenFd, reinterpret_cast<sockaddr*>(&addr), addrLen) != 0) return fail("bind @" + m_name);
+    if (listen(m_listenFd, 8) != 0) return fail("listen");
+
+    m_stopFd = eventfd(0, EFD_CLOEXEC);
+    if (m_stopFd < 0) return fail("eventfd");
+
+    m_thread = std::thread(&IqShmBus::run, this);
+    m_running.store(true);
+    qDebug() << "Shared memory IQ: @" + m_name << m_ringBytes / (1024 * 1024) << "MB ring";
+    return true;
+}
+
+void IqShmBus::stop()
+{
+    if (m_thread.joinable()) {
+        uint64_t one = 1;
+        if (write(m_stopFd, &one, sizeof(one)) < 0) {
+            qDebug() << "Shared memory IQ: cannot wake the listener";
+        }
+        m_thread.join();
+    }
+    m_running.store(false);
+
+    {
+        std::lock_guard<std::mutex> lock(m_readersMutex);
+        for (Reader& r : m_readers) {
+            closeFd(r.socket);
+            closeFd(r.eventFd);
+        }
+        m_readers.clear();
+        m_readerCount.store(0);
+    }
+
+    if (m_ring) munmap(m_ring, 2 * m_ringBytes);
+    if (m_control) munmap(m_control, CONTROL_BYTES);
+    m_ring = nullptr;
+    m_control = nullptr;
+    closeFd(m_listenFd);
+    closeFd(m_stopFd);
+    closeFd(m_readOnlyFd);
+    closeFd(m_memFd);
+}
+
+void IqShmBus::pushBlock(const int8_t* data, size_t len, const IqCodec::BlockInfo& info)
+{
+    // Nobody mapped the ring: skip the copy
+    if (m_readerCount.load(std::memory_order_relaxed) == 0) return;
+
+    const size_t record = IqCodec::FRAME_HEADER + len;
+    if (record > m_ringBytes / 2) return;
+
+    // Announce the range first: readers check it after copying
+    const uint64_t pos = m_writePos;
+    m_control->writeEnd.store(pos + record, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    char* dst = m_ring + pos % m_ringBytes;
+    IqCodec::writeHeader(dst, IqCodec::Raw, 0, info, static_cast<uint32_t>(len), static_cast<uint32_t>(len));
+    std::memcpy(dst + IqCodec::FRAME_HEADER, data, len);
+
+    m_control->newest.store(pos, std::memory_order_relaxed);
+    m_control->writePos.store(pos + record, std::memory_order_release);
+    m_writePos = pos + record;
+    m_blocks.fetch_add(1, std::memory_order_relaxed);
+    m_bytes.fetch_add(len, std::memory_order_relaxed);
+
+    // One eventfd write per reader; they drain every record since their cursor
+    std::lock_guard<std::mutex> lock(m_readersMutex);
+    const uint64_t one = 1;
+    for (const Reader& r : m_readers) {
+        if (write(r.eventFd, &one, sizeof(one)) < 0 && errno != EAGAIN) {
+            qDebug() << "Shared memory IQ: eventfd write failed";
+        }
+    }
+}
+
+// Listener thread: accepts readers and notices when they go away
+void IqShmBus::run()
+{
+    for (;;) {
+        std::vector<pollfd> fds;
+        fds.push_back({m_stopFd, POLLIN, 0});
+        fds.push_back({m_listenFd, POLLIN, 0});
+        {
+            std::lock_guard<std::mutex> lock(m_readersMutex);
+            for (const Reader& r : m_readers) fds.push_back({r.socket, POLLIN, 0});
+        }
+
+        if (poll(fds.data(), fds.size(), -1) < 0) {
+            if (errno == EINTR) continue;
+            qDebug() << "Shared memory IQ: poll failed:" << strerror(errno);
+            return;
+        }
+        if (fds[0].revents) return;
+
+        if (fds[1].revents & POLLIN) {
+            int socket = accept4(m_listenFd, nullptr, nullptr, SOCK_CLOEXEC);
+            if (socket >= 0) addReader(socket);
+        }
+
+        // Readers never send anything: readable means closed
+        for (size_t i = 2; i < fds.size(); i++) {
+            if (!fds[i].revents) continue;
+            char byte;
+            if (recv(fds[i].fd, &byte, 1, MSG_DONTWAIT) > 0) continue;
+
+            std::lock_guard<std::mutex> lock(m_readersMutex);
+            auto it = std::find_if(m_readers.begin(), m_readers.end(),
+                                   [&](const Reader& r) { return r.socket == fds[i].fd; });
+            if (it != m_readers.end()) {
+                closeFd(it->socket);
+                closeFd(it->eventFd);
+                m_readers.erase(it);
+                m_readerCount.store(static_cast<int>(m_readers.size()));
+                qDebug() << "Shared memory IQ: reader left," << m_readers.size() << "remaining";
+            }
+        }
+    }
+}
+
+void IqShmBus::addReader(int socket)
+{
+    int eventFd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (eventFd < 0) {
+        ::close(socket);
+        return;
+    }
+
+    ShmHello hello;
+    std::memcpy(hello.magic, "HRSM", 4);
+    hello.version = VERSION;
+    hello.ringBytes = m_ringBytes;
+
+    iovec iov = {&hello, sizeof(hello)};
+    alignas(cmsghdr) char control[CMSG_SPACE(2 * sizeof(int))];
+    std::memset(control, 0, sizeof(control));
+    msghdr msg;
+    std::memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+    cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_RIGHTS;
+    cmsg->cmsg_len = CMSG_LEN(2 * sizeof(int));
+    int fds[2] = {m_readOnlyFd, eventFd};
+    std::memcpy(CMSG_DATA(cmsg), fds, sizeof(fds));
+
+    if (sendmsg(socket, &msg, MSG_NOSIGNAL) != static_cast<ssize_t>(sizeof(hello))) {
+        ::close(eventFd);
+        ::close(socket);
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(m_readersMutex);
+    m_readers.push_back({socket, eventFd});
+    m_readerCount.store(static_cast<int>(m_readers.size()));
+    qDebug() << "Shared memory IQ: reader joined," << m_readers.size() << "total";
+}
+
+QString IqShmBus::statusText() const
+{
+    if (!m_running.load()) return "OFF";
+    return QString("@%1, %2 MB ring, %3 reader(s), %4 blocks, %5 MB")
+        .arg(m_name).arg(m_ringBytes / (1024 * 1024)).arg(m_readerCount.load())
+        .arg(m_blocks.load()).arg(m_bytes.load() / (1024.0 * 1024.0), 0, 'f', 1);
+}
+
+// ============================================================
+// Reader
+// ============================================================
+
+IqShmReader::IqShmReader()
+    : m_socket(-1)
+    , m_eventFd(-1)
+    , m_memFd(-1)
+    , m_control(nullptr)
+    , m_ring(nullptr)
+    , m_ringBytes(0)
+    , m_cursor(0)
+    , m_peeked(false)
+    , m_overruns(0)
+{
+}
+
+IqShmReader::~IqShmReader()
+{
+    close();
+}
+
+bool IqShmReader::open(quint16 dataPort, QString* error)
+{
+    close();
+
+    auto fail = [this, error](const QString& message) {
+        if (error) *error = message;
+        close();
+        return false;
+    };
+
+    m_socket = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (m_socket < 0) return fail("socket failed");
+    sockaddr_un addr;
+    socklen_t addrLen = abstractAddress(IqShmBus::socketName(dataPort), &addr);
+    if (::connect(m_socket, reinterpret_cast<sockaddr*>(&addr), addrLen) != 0) {
+        return fail("no shared memory IQ on this host");
+    }
+
+    // The hello is sent right after accept; do not hang on a stuck server
+    timeval timeout = {1, 0};
+    setsockopt(m_socket, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+    ShmHello hello;
+    iovec iov = {&hello, sizeof(hello)};
+    alignas(cmsghdr) char control[CMSG_SPACE(2 * sizeof(int))];
+    msghdr msg;
+    std::memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+    if (recvmsg(m_socket, &msg, MSG_CMSG_CLOEXEC) != static_cast<ssize_t>(sizeof(hello))) {
+        return fail("no hello from the server");
+    }
+    cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+    if (!cmsg || cmsg->cmsg_type != SCM_RIGHTS || cmsg->cmsg_len != CMSG_LEN(2 * sizeof(int))) {
+        return fail("no descriptors from the server");
+    }
+    int fds[2];
+    std::memcpy(fds, CMSG_DATA(cmsg), sizeof(fds));
+    m_memFd = fds[0];
+    m_eventFd = fds[1];
+    fcntl(m_eventFd, F_SETFL, fcntl(m_eventFd, F_GETFL) | O_NONBLOCK);
+
+    if (std::memcmp(hello.magic, "HRSM", 4) != 0 || hello.version != IqShmBus::VERSION) {
+        return fail("unsupported shared memory version");
+    }
+
+    void* controlPage = mmap(nullptr, IqShmBus::CONTROL_BYTES, PROT_READ, MAP_SHARED, m_memFd, 0);
+    if (controlPage == MAP_FAILED) return fail("mmap failed");
+    m_control = static_cast<const IqShmBus::Control*>(controlPage);
+    m_ringBytes = hello.ringBytes;
+    m_ring = mapRing(m_memFd, m_ringBytes, PROT_READ);
+    if (!m_ring) return fail("ring mmap failed");
+
+    // Start with the next block
+    m_cursor = m_control->writePos.load(std::memory_order_acquire);
+    m_peeked = false;
+    m_overruns = 0;
+    return true;
+}
+
+void IqShmReader::close()
+{
+    if (m_ring) munmap(const_cast<char*>(m_ring), 2 * m_ringBytes);
+    if (m_control) munmap(const_cast<IqShmBus::Control*>(m_control), IqShmBus::CONTROL_BYTES);
+    m_ring = nullptr;
+    m_control = nullptr;
+    closeFd(m_memFd);
+    closeFd(m_eventFd);
+    closeFd(m_socket);
+}
+
+void IqShmReader::clearNotify()
+{
+    uint64_t count;
+    if (read(m_eventFd, &count, sizeof(count)) < 0 && errno != EAGAIN) {
+        qDebug() << "Shared memory IQ: eventfd read failed";
+    }
+}
+
+// Nothing from position on was overwritten (after the data was copied)
+bool IqShmReader::stillValid(uint64_t position) const
+{
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return m_control->writeEnd.load(std::memory_order_relaxed) - position <= m_ringBytes;
+}
+
+void IqShmReader::resync()
+{
+    m_overruns++;
+    m_cursor = m_control->newest.load(std::memory_order_acquire);
+    m_peeked = false;
+}
+
+bool IqShmReader::peek(IqCodec::FrameHeader* header)
+{
+    if (!m_control) return false;
+
+    while (!m_peeked) {
+        uint64_t writePos = m_control->writePos.load(std::memory_order_acquire);
+        if (m_cursor == writePos) return false;
+        if (writePos - m_cursor > m_ringBytes) {
+            resync();
+            continue;
+        }
+
+        char raw[IqCodec::FRAME_HEADER];
+        std::memcpy(raw, m_ring + m_cursor % m_ringBytes, sizeof(raw));
+        if (!stillValid(m_cursor)) {
+            resync();
+            continue;
+        }
+        if (!IqCodec::parseHeader(raw, &m_header) || m_header.encoding != IqCodec::Raw ||
+            m_header.headerBytes + m_header.payloadBytes > writePos - m_cursor) {
+            // Cannot happen with a sane writer; start over at its newest block
+            qDebug() << "Shared memory IQ: bad record, resyncing";
+            resync();
+            if (m_cursor == writePos) return false;
+            continue;
+        }
+        m_peeked = true;
+    }
+
+    *header = m_header;
+    return true;
+}
+
+bool IqShmReader::take(QByteArray& out)
+{
+    if (!m_peeked) return false;
+
+    const int start = out.size();
+    out.resize(start + static_cast<int>(m_header.payloadBytes));
+    std::memcpy(out.data() + start, m_ring + (m_cursor + m_header.headerBytes) % m_ringBytes,
+                m_header.payloadBytes);
+    if (!stillValid(m_cursor)) {
+        out.resize(start);
+        resync();
+        return false;
+    }
+    skip();
+    return true;
+}
+
+void IqShmReader::skip()
+{
+    if (!m_peeked) return;
+    m_cursor += m_header.headerBytes + m_header.payloadBytes;
+    m_peeked = false;
+}
+
+#else
+
+// Other systems: no shared memory IQ, clients stay on TCP
+
+IqShmBus::IqShmBus()
+    : m_memFd(-1), m_readOnlyFd(-1), m_listenFd(-1), m_stopFd(-1)
+    , m_control(nullptr), m_ring(nullptr), m_ringBytes(0)
+    , m_readerCount(0), m_running(false), m_writePos(0), m_blocks(0), m_bytes(0)
+{
+}
+
+IqShmBus::~IqShmBus() {}
+
+bool IqShmBus::start(quint16, size_t, QString* error)
+{
+    if (error) *error = "shared memory IQ needs Linux";
+    return false;
+}
+
+void IqShmBus::stop() {}
+void IqShmBus::pushBlock(const int8_t*, size_t, const IqCodec::BlockInfo&) {}
+QString IqShmBus::statusText() const { return "OFF"; }
+void IqShmBus::run() {}
+void IqShmBus::addReader(int) {}
+
+IqShmReader::IqShmReader()
+    : m_socket(-1), m_eventFd(-1), m_memFd(-1), m_control(nullptr), m_ring(nullptr)
+    , m_ringBytes(0), m_cursor(0), m_peeked(false), m_overruns(0)
+{
+}
+
+IqShmReader::~IqShmReader() {}
+
+bool IqShmReader::open(quint16, QString* error)
+{
+    if (error) *error = "shared memory IQ needs Linux";
+    return false;
+}
+
+void IqShmReader::close() {}
+void IqShmReader::clearNotify() {}
+bool IqShmReader::stillValid(uint64_t) const { return false; }
+void IqShmReader::resync() {}
+bool IqShmReader::peek(IqCodec::FrameHeader*) { return false; }
+bool IqShmReader::take(QByteArray&) { return false; }
+void IqShmReader::skip() {}
+
+#endif
@@ -0,0 +1,137 @@
+#ifndef IQSHMBUS_H
+#define IQSHMBUS_H
+
+#include <QString>
+#include <QByteArray>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <vector>
+#include <cstdint>
+#include "iqcodec.h"
+
+// Same-host IQ transport (Linux): one shared-memory ring that the server
+// fills once for any number of local readers, instead of one loopback TCP
+// stream of ~40 MB/s per consumer.
+//
+// The ring is a memfd, mapped twice back to back so a record that wraps
+// is still contiguous. Records are IqCodec Raw frames (header with the
+// BlockInfo, then the int8 block), one after another. Readers connect to
+// the abstract unix socket socketName(<data port>) and get, via
+// SCM_RIGHTS, a read-only descriptor of the memfd and an eventfd of their
+// own that the server signals after every block. Each reader keeps its
+// own cursor. The writer announces the range it is about to overwrite
+// before touching it, so a reader that fell a ring behind can tell and
+// skips to the newest block.
+//
+// Control page (first CONTROL_BYTES of the memfd), host byte order:
+//    0  char[4]  "HRSM"
+//    4  uint32   version (1)
+//    8  uint64   ring bytes (the ring starts at CONTROL_BYTES)
+//   16  uint64   write position: bytes ever written, records end here
+//   24  uint64   write end: write position + the record being written
+//   32  uint64   stream position of the newest complete record
+class IqShmBus
+{
+public:
+    static constexpr size_t CONTROL_BYTES = 4096;
+    static constexpr uint32_t VERSION = 1;
+
+    struct Control {
+        char magic[4];
+        uint32_t version;
+        uint64_t ringBytes;
+        std::atomic<uint64_t> writePos;
+        std::atomic<uint64_t> writeEnd;
+        std::atomic<uint64_t> newest;
+    };
+
+    static QString socketName(quint16 dataPort);
+
+    IqShmBus();
+    ~IqShmBus();
+
+    bool start(quint16 dataPort, size_t ringBytes, QString* error = nullptr);
+    void stop();
+    bool isRunning() const { return m_running.load(); }
+    int readerCount() const { return m_readerCount.load(); }
+
+    // Producer side: RX callback thread, copies the block into the ring
+    void pushBlock(const int8_t* data, size_t len, const IqCodec::BlockInfo& info);
+
+    QString statusText() const;
+
+private:
+    struct Reader {
+        int socket;
+        int eventFd;
+    };
+
+    void run();
+    void addReader(int socket);
+
+    QString m_name;
+    int m_memFd;
+    int m_readOnlyFd;
+    int m_listenFd;
+    int m_stopFd;
+    Control* m_control;
+    char* m_ring;
+    size_t m_ringBytes;
+
+    std::thread m_thread;
+    std::mutex m_readersMutex;             // guards m_readers
+    std::vector<Reader> m_readers;
+    std::atomic<int> m_readerCount;
+    std::atomic<bool> m_running;
+
+    // RX callback thread only
+    uint64_t m_writePos;
+
+    std::atomic<quint64> m_blocks;
+    std::atomic<quint64> m_bytes;
+};
+
+// Reader side, used by HackRfRadio's TcpClient when the server is local
+class IqShmReader
+{
+public:
+    IqShmReader();
+    ~IqShmReader();
+
+    bool open(quint16 dataPort, QString* error = nullptr);
+    void close();
+    bool isOpen() const { return m_control != nullptr; }
+
+    // Readable when blocks arrived (eventfd) / when the server went away
+    int notifyFd() const { return m_eventFd; }
+    int socketFd() const { return m_socket; }
+    void clearNotify();
+
+    // Header of the next record; false when caught up
+    bool peek(IqCodec::FrameHeader* header);
+    // Appends the peeked record's payload to out, false if the server
+    // overwrote it meanwhile (counted as an overrun, nothing appended)
+    bool take(QByteArray& out);
+    void skip();
+
+    quint64 overruns() const { return m_overruns; }
+
+private:
+    bool stillValid(uint64_t position) const;
+    void resync();
+
+    int m_socket;
+    int m_eventFd;
+    int m_memFd;
+    const IqShmBus::Control* m_control;
+    const char* m_ring;
+    size_t m_ringBytes;
+
+    uint64_t m_cursor;
+    bool m_peeked;
+    IqCodec::FrameHeader m_header;
+    quint64 m_overruns;
+};
+
+#endif // IQSHMBUS_H
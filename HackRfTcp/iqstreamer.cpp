@@ -0,0 +1,1313 @@
+#include "iqstreamer.h"
+#include "latencyhistogram.h"
+#include "threadplacement.h"
+#include <QThread>
+#include <QDebug>
+#include <vector>
+#include <algorithm>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+#ifdef Q_OS_LINUX
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <linux/errqueue.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+#endif
+
+// int8 two's complement -> rtl_tcp uint8 offset binary: flip the sign bit
+static void toOffsetBinary(const char* in, char* out, size_t len)
+{
+    size_t i = 0;
+#if defined(__SSE2__)
+    const __m128i bias = _mm_set1_epi8(static_cast<char>(0x80));
+    for (; i + 16 <= len; i += 16) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm_xor_si128(v, bias));
+    }
+#elif defined(__ARM_NEON)
+    const uint8x16_t bias = vdupq_n_u8(0x80);
+    for (; i + 16 <= len; i += 16) {
+        uint8x16_t v = vld1q_u8(reinterpret_cast<const uint8_t*>(in + i));
+        vst1q_u8(reinterpret_cast<uint8_t*>(out + i), veorq_u8(v, bias));
+    }
+#endif
+    for (; i < len; i++) {
+        out[i] = static_cast<char>(in[i] ^ 0x80);
+    }
+}
+
+IqStreamer::IqStreamer(QObject *parent)
+    : QObject(parent)
+    , m_server(nullptr)
+    , m_nextId(0)
+    , m_workers(&m_ownWorkers)
+    , m_queueHead(0)
+    , m_queueTail(0)
+    , m_drainPending(false)
+    , m_commandSize(0)
+    , m_offsetBinary(false)
+    , m_convertBusy(false)
+    , m_defaultPolicy(DropOldest)
+    , m_defaultMaxBlocks(16)
+    , m_sampleRate(2000000)
+    , m_listening(false)
+    , m_clientCount(0)
+    , m_bytesSent(0)
+    , m_inputOverruns(0)
+    , m_droppedBlocks(0)
+    , m_lastTransferEmit(0)
+    , m_queueLatency(nullptr)
+    , m_encodeLatency(nullptr)
+    , m_backlogLatency(nullptr)
+{
+}
+
+IqStreamer::~IqStreamer()
+{
+    m_workers->waitForDone();
+    m_ownWorkers.waitForDone();
+}
+
+template <typename F>
+auto IqStreamer::runInThread(F f) -> decltype(f())
+{
+    if (QThread::currentThread() == thread()) {
+        return f();
+    }
+    decltype(f()) result{};
+    QMetaObject::invokeMethod(this, [&]() { result = f(); }, Qt::BlockingQueuedConnection);
+    return result;
+}
+
+// ============================================================
+// Server
+// ============================================================
+
+bool IqStreamer::listen(quint16 port, QString* error)
+{
+    return runInThread([this, port, error]() {
+        if (m_server) return true;
+
+        m_server = new Server(this);
+        m_server->setMaxPendingConnections(10);
+        connect(m_server, &QTcpServer::newConnection, this, &IqStreamer::onNewConnection);
+
+        if (!m_server->listen(QHostAddress::Any, port)) {
+            if (error) *error = m_server->errorString();
+            delete m_server;
+            m_server = nullptr;
+            return false;
+        }
+
+        m_listening.store(true);
+        qDebug() << "Data server listening on port:" << port << "(network thread)";
+        return true;
+    });
+}
+
+void IqStreamer::close()
+{
+    runInThread([this]() {
+        std::vector<quint64> ids;
+        for (const auto& entry : m_clients) ids.push_back(entry.first);
+        for (quint64 id : ids) {
+            Client* c = client(id);
+            if (!c) continue;
+            if (c->socket) c->socket->disconnectFromHost();
+            removeClient(id);
+        }
+
+        if (m_server) {
+            m_server->close();
+            m_server->deleteLater();
+            m_server = nullptr;
+        }
+        m_listening.store(false);
+        return true;
+    });
+}
+
+void IqStreamer::Server::incomingConnection(qintptr fd)
+{
+    // Direct path takes the descriptor; otherwise the usual QTcpSocket
+    if (!m_streamer->acceptDirect(fd)) {
+        QTcpServer::incomingConnection(fd);
+    }
+}
+
+void IqStreamer::onNewConnection()
+{
+    while (m_server->hasPendingConnections()) {
+        QTcpSocket* socket = m_server->nextPendingConnection();
+        if (!socket) continue;
+
+        socket->setSocketOption(QAbstractSocket::LowDelayOption, m_sendOptions.noDelay ? 1 : 0);
+        socket->setSocketOption(QAbstractSocket::KeepAliveOption, 1);
+        socket->setReadBufferSize(0);
+        socket->setSocketOption(QAbstractSocket::SendBufferSizeSocketOption, m_sendOptions.sendBuffer);
+
+        auto c = std::make_unique<Client>();
+        c->socket = socket;
+        c->address = socket->peerAddress();
+        c->port = socket->peerPort();
+        route(std::move(c));
+    }
+}
+
+bool IqStreamer::acceptDirect(qintptr fd)
+{
+#ifdef Q_OS_LINUX
+    if (!m_sendOptions.direct) return false;
+
+    int sock = static_cast<int>(fd);
+    sockaddr_storage peer;
+    socklen_t peerLen = sizeof(peer);
+    if (getpeername(sock, reinterpret_cast<sockaddr*>(&peer), &peerLen) != 0) {
+        ::close(sock);
+        return true;
+    }
+
+    fcntl(sock, F_SETFL, fcntl(sock, F_GETFL) | O_NONBLOCK);
+
+    int one = 1;
+    int noDelay = m_sendOptions.noDelay ? 1 : 0;
+    int sendBuffer = m_sendOptions.sendBuffer;
+    setsockopt(sock, SOL_SOCKET, SO_KEEPALIVE, &one, sizeof(one));
+    setsockopt(sock, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+    setsockopt(sock, SOL_SOCKET, SO_SNDBUF, &sendBuffer, sizeof(sendBuffer));
+
+    auto c = std::make_unique<Client>();
+    c->fd = sock;
+    c->address = QHostAddress(reinterpret_cast<const sockaddr*>(&peer));
+    c->port = (peer.ss_family == AF_INET6)
+                  ? ntohs(reinterpret_cast<const sockaddr_in6*>(&peer)->sin6_port)
+                  : ntohs(reinterpret_cast<const sockaddr_in*>(&peer)->sin_port);
+    c->cork = m_sendOptions.cork;
+
+#ifdef SO_ZEROCOPY
+    // Needs Linux 4.14+; without it the client just uses copying sends
+    if (m_sendOptions.zeroCopy) {
+        c->zeroCopy = (setsockopt(sock, SOL_SOCKET, SO_ZEROCOPY, &one, sizeof(one)) == 0);
+        if (!c->zeroCopy) {
+            qDebug() << "MSG_ZEROCOPY not available:" << strerror(errno);
+        }
+    }
+#endif
+
+    route(std::move(c));
+    return true;
+#else
+    Q_UNUSED(fd);
+    return false;
+#endif
+}
+
+// New connection: here, or on the streamer the router picks
+void IqStreamer::route(std::unique_ptr<Client> c)
+{
+    IqStreamer* owner = m_router ? m_router(c->address) : nullptr;
+    if (!owner || owner->thread() != thread()) owner = this;
+
+    c->id = ++owner->m_nextId;
+    owner->attach(*c);
+    owner->addClient(std::move(c));
+}
+
+// Socket signals (Qt path) or notifiers (direct path) to this streamer
+void IqStreamer::attach(Client& c)
+{
+    const quint64 id = c.id;
+    if (c.socket) {
+        QTcpSocket* socket = c.socket;
+        socket->setParent(this);
+        connect(socket, &QTcpSocket::bytesWritten, this, [this, id](qint64) {
+            if (Client* c = client(id)) pump(*c);
+        });
+        connect(socket, &QTcpSocket::readyRead, this, [this, id]() {
+            Client* c = client(id);
+            if (!c) return;
+            QByteArray data = c->socket->readAll();
+            handleInput(*c, data.constData(), data.size());
+        });
+        connect(socket, &QTcpSocket::disconnected, this, [this, id]() {
+            removeClient(id);
+        });
+        connect(socket, &QTcpSocket::errorOccurred, this, [this, id](QAbstractSocket::SocketError error) {
+            if (Client* c = client(id)) {
+                qDebug() << "Data socket error:" << error << c->socket->errorString();
+            }
+            removeClient(id);
+        });
+        return;
+    }
+
+    // Read side only watches for hang-up and zero-copy completions (POLLERR);
+    // write side is enabled while the socket buffer is full.
+    c.readNotifier = new QSocketNotifier(c.fd, QSocketNotifier::Read, this);
+    connect(c.readNotifier, &QSocketNotifier::activated, this, [this, id]() { readDirect(id); });
+    c.writeNotifier = new QSocketNotifier(c.fd, QSocketNotifier::Write, this);
+    c.writeNotifier->setEnabled(false);
+    connect(c.writeNotifier, &QSocketNotifier::activated, this, [this, id]() {
+        if (Client* c = client(id)) {
+            c->writeNotifier->setEnabled(false);
+            pump(*c);
+        }
+    });
+}
+
+void IqStreamer::detach(Client& c)
+{
+    if (c.socket) {
+        c.socket->disconnect(this);
+    }
+    if (c.readNotifier) {
+        // May be inside one of their activated() signals
+        c.readNotifier->setEnabled(false);
+        c.writeNotifier->setEnabled(false);
+        c.readNotifier->deleteLater();
+        c.writeNotifier->deleteLater();
+        c.readNotifier = nullptr;
+        c.writeNotifier = nullptr;
+    }
+}
+
+void IqStreamer::addClient(std::unique_ptr<Client> c)
+{
+    c->name = QString("%1:%2").arg(c->address.toString()).arg(c->port);
+    c->policy = static_cast<DropPolicy>(m_defaultPolicy.load());
+    c->maxBlocks = m_defaultMaxBlocks.load();
+
+    QString name = c->name;
+    Client& added = *c;
+    m_clients[c->id] = std::move(c);
+    m_clientCount.store(static_cast<int>(m_clients.size()));
+
+    if (!m_greeting.isEmpty()) {
+        added.backlog.push_back(m_greeting);
+        added.backlogBytes += m_greeting.size();
+        pump(added);
+    }
+    emit clientConnected(name);
+}
+
+void IqStreamer::handleInput(Client& c, const char* data, qint64 len)
+{
+    if (m_commandSize <= 0 || len <= 0) return;
+
+    c.input.append(data, static_cast<int>(len));
+    int pos = 0;
+    while (c.input.size() - pos >= m_commandSize) {
+        emit commandReceived(c.id, c.input.mid(pos, m_commandSize));
+        pos += m_commandSize;
+    }
+    c.input.remove(0, pos);
+}
+
+void IqStreamer::removeClient(quint64 id)
+{
+    auto it = m_clients.find(id);
+    if (it == m_clients.end()) return;
+
+    std::unique_ptr<Client> c = std::move(it->second);
+    m_clients.erase(it);
+    m_clientCount.store(static_cast<int>(m_clients.size()));
+    if (c->spectrum) pruneSpectrum();
+
+    detach(*c);
+    if (c->socket) {
+        c->socket->deleteLater();
+    }
+#ifdef Q_OS_LINUX
+    if (c->fd >= 0) {
+        // Closing drops pending zero-copy completions; the kernel keeps its
+        // own page references, so the blocks can go with the client.
+        ::close(c->fd);
+    }
+#endif
+    emit clientDisconnected(c->name);
+}
+
+int IqStreamer::handOver(const QList<quint64>& ids, IqStreamer* target)
+{
+    if (!target || target == this || target->thread() != thread()) return 0;
+
+    return runInThread([this, &ids, target]() {
+        int moved = 0;
+        bool hadSpectrum = false;
+        for (quint64 id : ids) {
+            auto it = m_clients.find(id);
+            if (it == m_clients.end() || it->second->closing) continue;
+
+            std::unique_ptr<Client> c = std::move(it->second);
+            m_clients.erase(it);
+            detach(*c);
+            hadSpectrum = hadSpectrum || c->spectrum;
+            c->ddc.reset();
+            c->spectrum.reset();
+            c->input.clear();
+
+            c->id = ++target->m_nextId;
+            target->attach(*c);
+            Client& added = *c;
+            target->m_clients[c->id] = std::move(c);
+            target->pump(added);
+            moved++;
+        }
+
+        m_clientCount.store(static_cast<int>(m_clients.size()));
+        target->m_clientCount.store(static_cast<int>(target->m_clients.size()));
+        if (hadSpectrum) pruneSpectrum();
+        return moved;
+    });
+}
+
+void IqStreamer::setRouter(Router router)
+{
+    runInThread([this, &router]() {
+        m_router = std::move(router);
+        return true;
+    });
+}
+
+void IqStreamer::setWorkerPool(QThreadPool* pool)
+{
+    m_workers = pool ? pool : &m_ownWorkers;
+}
+
+void IqStreamer::setLatencyStages(LatencyHistogram* queue, LatencyHistogram* encode, LatencyHistogram* backlog)
+{
+    m_queueLatency = queue;
+    m_encodeLatency = encode;
+    m_backlogLatency = backlog;
+}
+
+bool IqStreamer::isConnected(const Client& c) const
+{
+    if (c.closing) return false;
+    if (c.socket) return c.socket->state() == QAbstractSocket::ConnectedState;
+    return c.fd >= 0;
+}
+
+void IqStreamer::abortClient(Client& c)
+{
+    c.closing = true;
+    // Not from inside the drain loop
+    const quint64 id = c.id;
+    QMetaObject::invokeMethod(this, [this, id]() {
+        Client* c = client(id);
+        if (!c) return;
+        if (c->socket) {
+            c->socket->abort();     // disconnected -> removeClient
+        } else {
+            removeClient(id);
+        }
+    }, Qt::QueuedConnection);
+}
+
+IqStreamer::Client* IqStreamer::client(quint64 id)
+{
+    auto it = m_clients.find(id);
+    return (it != m_clients.end()) ? it->second.get() : nullptr;
+}
+
+// ============================================================
+// Block queue (RX callback -> network thread)
+// ============================================================
+
+void IqStreamer::pushBlock(const int8_t* data, size_t len, const IqCodec::BlockInfo& info)
+{
+    // Nobody listening: skip the copy
+    if (m_clientCount.load(std::memory_order_relaxed) == 0) return;
+
+    size_t head = m_queueHead.load(std::memory_order_relaxed);
+    size_t next = (head + 1) % QUEUE_BLOCKS;
+    if (next == m_queueTail.load(std::memory_order_acquire)) {
+        // Network thread stalled, do not block the USB callback
+        m_inputOverruns.fetch_add(1, std::memory_order_relaxed);
+    } else {
+        m_queue[head].data = QByteArray(reinterpret_cast<const char*>(data), static_cast<int>(len));
+        m_queue[head].info = info;
+        m_queue[head].queuedUs = m_queueLatency ? LatencyHistogram::steadyUs() : 0;
+        m_queueHead.store(next, std::memory_order_release);
+    }
+
+    // One wake-up per burst, not per block
+    if (!m_drainPending.exchange(true)) {
+        QMetaObject::invokeMethod(this, [this]() { drain(); }, Qt::QueuedConnection);
+    }
+}
+
+void IqStreamer::drain()
+{
+    m_drainPending.store(false);
+
+    std::vector<quint64> ids;
+    ids.reserve(m_clients.size());
+    for (const auto& entry : m_clients) ids.push_back(entry.first);
+
+    // Encodings somebody wants (Raw frames are cheap, built inline)
+    bool encode[IqCodec::Deflate + 1] = {};
+    for (const auto& entry : m_clients) {
+        const Client& c = *entry.second;
+        if (!c.ddc && !c.spectrum && c.framed) encode[c.encoding] = true;
+    }
+
+    size_t tail = m_queueTail.load(std::memory_order_relaxed);
+    while (tail != m_queueHead.load(std::memory_order_acquire)) {
+        Block block = std::move(m_queue[tail]);
+        m_queue[tail].data = QByteArray();
+        tail = (tail + 1) % QUEUE_BLOCKS;
+        m_queueTail.store(tail, std::memory_order_release);
+        if (m_queueLatency && block.queuedUs) {
+            m_queueLatency->record(LatencyHistogram::steadyUs() - block.queuedUs);
+        }
+
+        const bool convert = m_offsetBinary.load(std::memory_order_relaxed);
+        QByteArray rawFrame;
+        for (quint64 id : ids) {
+            Client* c = client(id);
+            if (!c || c->spectrum) continue;
+            if (c->ddc) {
+                enqueueDdc(id, c->ddc, block);
+            } else if (convert) {
+                continue;
+            } else if (!c->framed) {
+                enqueue(*c, block.data);
+            } else if (c->encoding == IqCodec::Raw) {
+                if (rawFrame.isEmpty()) rawFrame = IqCodec::encodeFrame(IqCodec::Raw, block.data, block.info);
+                enqueue(*c, rawFrame);
+            }
+        }
+        for (const auto& stream : m_spectrumStreams) {
+            enqueueSpectrum(stream, block);
+        }
+        if (convert) {
+            enqueueConvert(block.data);
+        } else {
+            for (int e = IqCodec::Raw + 1; e <= IqCodec::Deflate; e++) {
+                if (encode[e]) enqueueEncode(static_cast<IqCodec::Encoding>(e), block);
+            }
+        }
+    }
+
+    quint64 sent = m_bytesSent.load();
+    if (sent - m_lastTransferEmit > 10 * 1024 * 1024) {
+        m_lastTransferEmit = sent;
+        emit dataTransferred(sent);
+    }
+}
+
+void IqStreamer::broadcast(const QByteArray& block)
+{
+    for (const auto& entry : m_clients) {
+        if (!entry.second->ddc && !entry.second->spectrum) enqueue(*entry.second, block);
+    }
+}
+
+// ============================================================
+// Offset binary conversion (rtl_tcp)
+// ============================================================
+
+void IqStreamer::setGreeting(const QByteArray& greeting)
+{
+    runInThread([this, greeting]() { m_greeting = greeting; return true; });
+}
+
+void IqStreamer::setCommandSize(int bytes)
+{
+    runInThread([this, bytes]() { m_commandSize = std::max(0, bytes); return true; });
+}
+
+void IqStreamer::setOffsetBinary(bool enable)
+{
+    m_offsetBinary.store(enable);
+}
+
+void IqStreamer::enqueueConvert(const QByteArray& block)
+{
+    bool startWorker = false;
+    {
+        std::lock_guard<std::mutex> lock(m_convertMutex);
+        if (m_convertPending.size() >= DDC_MAX_PENDING) {
+            m_convertPending.pop_front();
+            m_droppedBlocks.fetch_add(1, std::memory_order_relaxed);
+        }
+        m_convertPending.push_back(block);
+        if (!m_convertBusy) {
+            m_convertBusy = true;
+            startWorker = true;
+        }
+    }
+
+    // Converted once for every client, off the network thread
+    if (startWorker) {
+        m_workers->start([this]() { runConvert(); });
+    }
+}
+
+void IqStreamer::runConvert()
+{
+    ThreadPlacement::apply(ThreadPlacement::Dsp);
+    for (;;) {
+        QByteArray block;
+        {
+            std::lock_guard<std::mutex> lock(m_convertMutex);
+            if (m_convertPending.empty()) {
+                m_convertBusy = false;
+                return;
+            }
+            block = std::move(m_convertPending.front());
+            m_convertPending.pop_front();
+        }
+
+        QByteArray out(block.size(), Qt::Uninitialized);
+        toOffsetBinary(block.constData(), out.data(), static_cast<size_t>(block.size()));
+
+        QMetaObject::invokeMethod(this, [this, out]() { broadcast(out); }, Qt::QueuedConnection);
+    }
+}
+
+// ============================================================
+// Transport encodings
+// ============================================================
+
+int IqStreamer::setEncoding(const QList<quint64>& ids, IqCodec::Encoding encoding)
+{
+    return runInThread([&]() {
+        int count = 0;
+        for (quint64 id : ids) {
+            if (Client* c = client(id)) {
+                c->framed = true;
+                c->encoding = encoding;
+                count++;
+            }
+        }
+        return count;
+    });
+}
+
+void IqStreamer::enqueueEncode(IqCodec::Encoding encoding, const Block& block)
+{
+    EncodeStream& stream = m_encoders[encoding];
+    if (stream.inFlight >= ENCODE_MAX_IN_FLIGHT) {
+        // Pool saturated: the block never gets a sequence number, so no hole
+        m_droppedBlocks.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    const quint64 seq = stream.nextSeq++;
+    stream.inFlight++;
+    stream.inputBytes += block.data.size();
+
+    // Blocks are independent, so any number of workers can take them
+    const qint64 startUs = m_encodeLatency ? LatencyHistogram::steadyUs() : 0;
+    m_workers->start([this, encoding, seq, block, startUs]() {
+        ThreadPlacement::apply(ThreadPlacement::Dsp);
+        QByteArray frame = IqCodec::encodeFrame(encoding, block.data, block.info);
+        QMetaObject::invokeMethod(this, [this, encoding, seq, frame, startUs]() {
+            deliverEncoded(encoding, seq, frame, startUs);
+        }, Qt::QueuedConnection);
+    });
+}
+
+void IqStreamer::deliverEncoded(IqCodec::Encoding encoding, quint64 seq, const QByteArray& frame, qint64 startUs)
+{
+    EncodeStream& stream = m_encoders[encoding];
+    stream.inFlight--;
+    stream.done.emplace(seq, frame);
+    if (m_encodeLatency && startUs) {
+        m_encodeLatency->record(LatencyHistogram::steadyUs() - startUs);
+    }
+
+    while (!stream.done.empty() && stream.done.begin()->first == stream.nextDeliver) {
+        QByteArray next = std::move(stream.done.begin()->second);
+        stream.done.erase(stream.done.begin());
+        stream.nextDeliver++;
+        stream.outputBytes += next.size();
+
+        for (const auto& entry : m_clients) {
+            Client& c = *entry.second;
+            if (!c.ddc && !c.spectrum && c.framed && c.encoding == encoding) enqueue(c, next);
+        }
+    }
+}
+
+// ============================================================
+// Per-client backlog
+// ============================================================
+
+void IqStreamer::enqueue(Client& c, const QByteArray& block)
+{
+    if (!isConnected(c)) return;
+
+    if (static_cast<int>(c.backlog.size()) >= c.maxBlocks) {
+        switch (c.policy) {
+        case DropOldest:
+            // A partly sent block has to finish, or the stream loses framing
+            if (c.frontOffset > 0 && c.backlog.size() > 1) {
+                c.backlogBytes -= c.backlog[1].size();
+                c.backlog.erase(c.backlog.begin() + 1);
+            } else if (c.frontOffset == 0) {
+                c.backlogBytes -= c.backlog.front().size();
+                c.backlog.pop_front();
+            } else {
+                c.dropped++;
+                m_droppedBlocks.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+            c.dropped++;
+            c.markUs = 0;
+            m_droppedBlocks.fetch_add(1, std::memory_order_relaxed);
+            break;
+        case DropNewest:
+            c.dropped++;
+            m_droppedBlocks.fetch_add(1, std::memory_order_relaxed);
+            return;
+        case Disconnect:
+            qDebug() << "Data client" << c.name << "too slow, disconnecting";
+            c.dropped++;
+            m_droppedBlocks.fetch_add(1, std::memory_order_relaxed);
+            abortClient(c);
+            return;
+        }
+    }
+
+    c.backlog.push_back(block);
+    c.backlogBytes += block.size();
+    c.peakBlocks = std::max(c.peakBlocks, c.backlog.size());
+    if (m_backlogLatency && c.markUs == 0) {
+        c.markBytes = c.sentBytes + (c.backlogBytes - c.frontOffset);
+        c.markUs = LatencyHistogram::steadyUs();
+    }
+    pump(c);
+}
+
+// The timed block has gone to the socket
+void IqStreamer::backlogSent(Client& c)
+{
+    if (c.markUs != 0 && c.sentBytes >= c.markBytes && m_backlogLatency) {
+        m_backlogLatency->record(LatencyHistogram::steadyUs() - c.markUs);
+        c.markUs = 0;
+    }
+}
+
+void IqStreamer::pump(Client& c)
+{
+    if (c.fd >= 0) {
+        pumpDirect(c);
+        return;
+    }
+
+    // Only a couple of blocks go into QTcpSocket's own (unbounded) buffer
+    while (!c.backlog.empty() && c.socket->bytesToWrite() < SOCKET_HIGH_WATER) {
+        const QByteArray& block = c.backlog.front();
+        qint64 written = c.socket->write(block);
+        if (written < 0) break;
+
+        c.syscalls++;
+        c.sentBytes += written;
+        m_bytesSent.fetch_add(written, std::memory_order_relaxed);
+        c.backlogBytes -= block.size();
+        c.backlog.pop_front();
+        backlogSent(c);
+    }
+}
+
+// ============================================================
+// Direct send path (Linux)
+// ============================================================
+
+void IqStreamer::pumpDirect(Client& c)
+{
+#ifdef Q_OS_LINUX
+    if (c.closing) return;
+
+    int one = 1, zero = 0;
+    if (c.cork && !c.backlog.empty()) {
+        setsockopt(c.fd, IPPROTO_TCP, TCP_CORK, &one, sizeof(one));
+    }
+
+    while (!c.backlog.empty()) {
+        // The backlog itself is the iovec: no copy on our side
+        iovec iov[IOV_BATCH];
+        int count = 0;
+        size_t total = 0;
+        for (size_t i = 0; i < c.backlog.size() && count < IOV_BATCH; i++) {
+            const QByteArray& block = c.backlog[i];
+            size_t skip = (i == 0) ? c.frontOffset : 0;
+            iov[count].iov_base = const_cast<char*>(block.constData()) + skip;
+            iov[count].iov_len = static_cast<size_t>(block.size()) - skip;
+            total += iov[count].iov_len;
+            count++;
+        }
+
+        msghdr msg;
+        std::memset(&msg, 0, sizeof(msg));
+        msg.msg_iov = iov;
+        msg.msg_iovlen = count;
+
+        int flags = MSG_DONTWAIT | MSG_NOSIGNAL;
+#ifdef MSG_ZEROCOPY
+        bool zeroCopy = c.zeroCopy && total >= ZEROCOPY_MIN &&
+                        c.zcPending.size() < ZEROCOPY_MAX_PENDING;
+        if (zeroCopy) flags |= MSG_ZEROCOPY;
+#else
+        bool zeroCopy = false;
+#endif
+
+        ssize_t sent = sendmsg(c.fd, &msg, flags);
+        c.syscalls++;
+
+        if (sent < 0) {
+            if (errno == EINTR) continue;
+            if (errno == ENOBUFS && zeroCopy) {
+                // optmem exhausted by pinned pages: collect completions, then copy
+                reapZeroCopy(c);
+                c.zeroCopy = false;
+                qDebug() << "Data client" << c.name << "MSG_ZEROCOPY out of option memory, copying";
+                continue;
+            }
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                c.writeNotifier->setEnabled(true);
+            } else {
+                qDebug() << "Data client" << c.name << "send failed:" << strerror(errno);
+                abortClient(c);
+            }
+            break;
+        }
+
+        // Every block the send touched stays referenced until completion
+        if (zeroCopy) {
+            const uint32_t seq = c.zcNextSeq++;
+            size_t covered = 0;
+            for (int i = 0; i < count && covered < static_cast<size_t>(sent); i++) {
+                c.zcPending.push_back({seq, c.backlog[i]});
+                covered += iov[i].iov_len;
+            }
+            c.zcSends++;
+        }
+
+        c.sentBytes += sent;
+        m_bytesSent.fetch_add(sent, std::memory_order_relaxed);
+        backlogSent(c);
+
+        size_t left = static_cast<size_t>(sent);
+        while (left > 0) {
+            size_t remaining = static_cast<size_t>(c.backlog.front().size()) - c.frontOffset;
+            if (left < remaining) {
+                c.frontOffset += left;
+                break;
+            }
+            left -= remaining;
+            c.backlogBytes -= c.backlog.front().size();
+            c.backlog.pop_front();
+            c.frontOffset = 0;
+        }
+
+        if (static_cast<size_t>(sent) < total) {
+            // Socket buffer full; resume on POLLOUT
+            c.writeNotifier->setEnabled(true);
+            break;
+        }
+    }
+
+    if (c.cork) {
+        setsockopt(c.fd, IPPROTO_TCP, TCP_CORK, &zero, sizeof(zero));
+    }
+
+    if (!c.zcPending.empty()) {
+        reapZeroCopy(c);
+    }
+#else
+    Q_UNUSED(c);
+#endif
+}
+
+void IqStreamer::readDirect(quint64 id)
+{
+#ifdef Q_OS_LINUX
+    Client* c = client(id);
+    if (!c) return;
+
+    // POLLERR also lands here: zero-copy completions on the error queue
+    if (c->zcSends > 0) {
+        reapZeroCopy(*c);
+    }
+
+    // Data port clients do not send; rtl_tcp clients send 5-byte commands
+    char buf[4096];
+    for (;;) {
+        ssize_t n = recv(c->fd, buf, sizeof(buf), MSG_DONTWAIT);
+        if (n > 0) {
+            handleInput(*c, buf, n);
+            if (!client(id)) return;
+            continue;
+        }
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) return;
+
+        if (n < 0) {
+            qDebug() << "Data socket error:" << c->name << strerror(errno);
+        }
+        removeClient(id);
+        return;
+    }
+#else
+    Q_UNUSED(id);
+#endif
+}
+
+void IqStreamer::reapZeroCopy(Client& c)
+{
+#if defined(Q_OS_LINUX) && defined(SO_EE_ORIGIN_ZEROCOPY)
+    for (;;) {
+        char control[CMSG_SPACE(sizeof(sock_extended_err) + sizeof(sockaddr_in6))];
+        msghdr msg;
+        std::memset(&msg, 0, sizeof(msg));
+        msg.msg_control = control;
+        msg.msg_controllen = sizeof(control);
+
+        if (recvmsg(c.fd, &msg, MSG_ERRQUEUE | MSG_DONTWAIT) < 0) {
+            return;     // EAGAIN: nothing (more) completed
+        }
+
+        for (cmsghdr* cm = CMSG_FIRSTHDR(&msg); cm; cm = CMSG_NXTHDR(&msg, cm)) {
+            if (!((cm->cmsg_level == SOL_IP && cm->cmsg_type == IP_RECVERR) ||
+                  (cm->cmsg_level == SOL_IPV6 && cm->cmsg_type == IPV6_RECVERR))) {
+                continue;
+            }
+            const sock_extended_err* err = reinterpret_cast<const sock_extended_err*>(CMSG_DATA(cm));
+            if (err->ee_origin != SO_EE_ORIGIN_ZEROCOPY || err->ee_errno != 0) continue;
+
+            // Sends [ee_info, ee_data] are done; TCP completes them in order
+            const uint32_t last = err->ee_data;
+            while (!c.zcPending.empty() &&
+                   static_cast<int32_t>(c.zcPending.front().seq - last) <= 0) {
+                c.zcPending.pop_front();
+            }
+
+            if (err->ee_code & SO_EE_CODE_ZEROCOPY_COPIED) {
+                // Kernel copied anyway (loopback, or a device without SG):
+                // pinning pages only costs us, go back to plain sends
+                c.zcCopied += err->ee_data - err->ee_info + 1;
+                if (c.zeroCopy && c.zcCopied >= 8 && c.zcCopied * 2 > c.zcSends) {
+                    c.zeroCopy = false;
+                    qDebug() << "Data client" << c.name << "MSG_ZEROCOPY deferred to copies, disabled";
+                }
+            }
+        }
+    }
+#else
+    Q_UNUSED(c);
+#endif
+}
+
+void IqStreamer::setSendOptions(const SendOptions& options)
+{
+    runInThread([this, options]() {
+        m_sendOptions = options;
+        m_sendOptions.sendBuffer = std::max(64 * 1024, options.sendBuffer);
+        return true;
+    });
+}
+
+void IqStreamer::setDefaultPolicy(DropPolicy policy, int maxBlocks)
+{
+    m_defaultPolicy.store(policy);
+    m_defaultMaxBlocks.store(std::max(1, maxBlocks));
+}
+
+int IqStreamer::setPolicy(const QList<quint64>& ids, DropPolicy policy, int maxBlocks)
+{
+    return runInThread([&]() {
+        int count = 0;
+        for (quint64 id : ids) {
+            if (Client* c = client(id)) {
+                c->policy = policy;
+                c->maxBlocks = std::max(1, maxBlocks);
+                count++;
+            }
+        }
+        return count;
+    });
+}
+
+bool IqStreamer::parsePolicy(const QString& name, DropPolicy* policy)
+{
+    QString n = name.trimmed().toLower();
+    if (n == "drop-oldest")      *policy = DropOldest;
+    else if (n == "drop-newest") *policy = DropNewest;
+    else if (n == "disconnect")  *policy = Disconnect;
+    else return false;
+    return true;
+}
+
+QString IqStreamer::policyName(DropPolicy policy)
+{
+    switch (policy) {
+    case DropOldest: return "drop-oldest";
+    case DropNewest: return "drop-newest";
+    case Disconnect: return "disconnect";
+    }
+    return "unknown";
+}
+
+QList<IqStreamer::ClientRef> IqStreamer::findClients(const QHostAddress& address, int port)
+{
+    return runInThread([&]() {
+        QList<ClientRef> result;
+        for (const auto& entry : m_clients) {
+            const Client& c = *entry.second;
+            if (c.address.isEqual(address) && (port <= 0 || c.port == port)) {
+                result.append({entry.first, c.address, c.port});
+            }
+        }
+        return result;
+    });
+}
+
+// ============================================================
+// Per-client DDC
+// ============================================================
+
+bool IqStreamer::setDdc(const QList<quint64>& ids, uint32_t sampleRate,
+                        double offset, double bandwidth, DdcInfo* info)
+{
+    return runInThread([&]() {
+        bool any = false;
+        for (quint64 id : ids) {
+            Client* c = client(id);
+            if (!c) continue;
+            if (!c->ddc) c->ddc = std::make_shared<DdcStream>();
+            c->spectrum.reset();            // a sub-band means IQ again
+
+            std::lock_guard<std::mutex> lock(c->ddc->dspMutex);
+            c->ddc->ddc = std::make_unique<DdcChannel>(sampleRate, offset, bandwidth);
+            if (info) {
+                info->outputRate = c->ddc->ddc->outputRate();
+                info->decimation = c->ddc->ddc->decimation();
+                info->taps = c->ddc->ddc->taps();
+            }
+            any = true;
+        }
+        pruneSpectrum();
+        return any;
+    });
+}
+
+int IqStreamer::clearDdc(const QList<quint64>& ids)
+{
+    return runInThread([&]() {
+        int count = 0;
+        for (quint64 id : ids) {
+            Client* c = client(id);
+            if (c && c->ddc) {
+                c->ddc.reset();
+                count++;
+            }
+        }
+        return count;
+    });
+}
+
+void IqStreamer::setSampleRate(uint32_t sampleRate)
+{
+    m_sampleRate.store(sampleRate);
+
+    // Decimation and filter depend on the radio rate
+    runInThread([this, sampleRate]() {
+        for (const auto& entry : m_clients) {
+            const std::shared_ptr<DdcStream>& stream = entry.second->ddc;
+            if (!stream) continue;
+            std::lock_guard<std::mutex> lock(stream->dspMutex);
+            if (stream->ddc) {
+                stream->ddc = std::make_unique<DdcChannel>(sampleRate,
+                                                           stream->ddc->offset(),
+                                                           stream->ddc->bandwidth());
+            }
+        }
+        return true;
+    });
+}
+
+void IqStreamer::enqueueDdc(quint64 id, const std::shared_ptr<DdcStream>& stream, const Block& block)
+{
+    bool startWorker = false;
+    {
+        std::lock_guard<std::mutex> lock(stream->queueMutex);
+        if (stream->pending.size() >= DDC_MAX_PENDING) {
+            // Workers cannot keep up; count it as a drop for this client
+            stream->pending.pop_front();
+            if (Client* c = client(id)) c->dropped++;
+            m_droppedBlocks.fetch_add(1, std::memory_order_relaxed);
+        }
+        stream->pending.push_back(block);
+        if (!stream->busy) {
+            stream->busy = true;
+            startWorker = true;
+        }
+    }
+
+    // One worker per stream at a time keeps its blocks in order
+    if (startWorker) {
+        m_workers->start([this, id, stream]() { runDdc(id, stream); });
+    }
+}
+
+void IqStreamer::runDdc(quint64 id, std::shared_ptr<DdcStream> stream)
+{
+    ThreadPlacement::apply(ThreadPlacement::Dsp);
+    for (;;) {
+        Block block;
+        {
+            std::lock_guard<std::mutex> lock(stream->queueMutex);
+            if (stream->pending.empty()) {
+                stream->busy = false;
+                return;
+            }
+            block = std::move(stream->pending.front());
+            stream->pending.pop_front();
+        }
+
+        QByteArray out;
+        IqCodec::BlockInfo info = block.info;
+        {
+            std::lock_guard<std::mutex> lock(stream->dspMutex);
+            if (!stream->ddc) continue;
+            stream->ddc->process(reinterpret_cast<const int8_t*>(block.data.constData()),
+                                 static_cast<size_t>(block.data.size()), out);
+
+            // The frame describes the sub-band, not the radio
+            info.format = IqCodec::FormatCi16;
+            info.sampleIndex /= static_cast<uint64_t>(stream->ddc->decimation());
+            info.sampleRate = static_cast<uint32_t>(stream->ddc->outputRate() + 0.5);
+            info.frequency = static_cast<uint64_t>(static_cast<double>(info.frequency) + stream->ddc->offset());
+        }
+        if (out.isEmpty()) continue;
+
+        // Back to the network thread, through the client's backlog
+        QMetaObject::invokeMethod(this, [this, id, stream, out, info]() {
+            Client* c = client(id);
+            if (c && c->ddc == stream) {
+                // DDC output stays ci16; framed clients get it as Raw frames
+                enqueue(*c, c->framed ? IqCodec::encodeFrame(IqCodec::Raw, out, info) : out);
+            }
+        }, Qt::QueuedConnection);
+    }
+}
+
+// ============================================================
+// Spectrum subscriptions
+// ============================================================
+
+int IqStreamer::setSpectrum(const QList<quint64>& ids, const SpectrumAnalyzer::Config& config,
+                            SpectrumAnalyzer::BinFormat format, float minDb, float maxDb)
+{
+    return runInThread([&]() {
+        // Subscribers with the same size, rate and averaging share the FFTs
+        std::shared_ptr<SpectrumStream> stream;
+        for (const auto& existing : m_spectrumStreams) {
+            if (existing->analyzer.config() == config) stream = existing;
+        }
+
+        int count = 0;
+        for (quint64 id : ids) {
+            Client* c = client(id);
+            if (!c) continue;
+            if (!stream) {
+                stream = std::make_shared<SpectrumStream>(config);
+                m_spectrumStreams.push_back(stream);
+            }
+            c->spectrum = stream;
+            c->spectrumFormat = format;
+            c->spectrumMinDb = minDb;
+            c->spectrumMaxDb = maxDb;
+            c->ddc.reset();
+            count++;
+        }
+        pruneSpectrum();
+        return count;
+    });
+}
+
+int IqStreamer::clearSpectrum(const QList<quint64>& ids)
+{
+    return runInThread([&]() {
+        int count = 0;
+        for (quint64 id : ids) {
+            Client* c = client(id);
+            if (c && c->spectrum) {
+                c->spectrum.reset();
+                count++;
+            }
+        }
+        pruneSpectrum();
+        return count;
+    });
+}
+
+// Analyzers nobody subscribes to any more stop getting blocks
+void IqStreamer::pruneSpectrum()
+{
+    m_spectrumStreams.erase(
+        std::remove_if(m_spectrumStreams.begin(), m_spectrumStreams.end(),
+                       [this](const std::shared_ptr<SpectrumStream>& stream) {
+                           for (const auto& entry : m_clients) {
+                               if (entry.second->spectrum == stream) return false;
+                           }
+                           return true;
+                       }),
+        m_spectrumStreams.end());
+}
+
+void IqStreamer::enqueueSpectrum(const std::shared_ptr<SpectrumStream>& stream, const Block& block)
+{
+    bool startWorker = false;
+    {
+        std::lock_guard<std::mutex> lock(stream->queueMutex);
+        if (stream->pending.size() >= DDC_MAX_PENDING) {
+            // Only costs a gap in the averaging, not a client drop
+            stream->pending.pop_front();
+        }
+        stream->pending.push_back(block);
+        if (!stream->busy) {
+            stream->busy = true;
+            startWorker = true;
+        }
+    }
+
+    if (startWorker) {
+        m_workers->start([this, stream]() { runSpectrum(stream); });
+    }
+}
+
+void IqStreamer::runSpectrum(std::shared_ptr<SpectrumStream> stream)
+{
+    ThreadPlacement::apply(ThreadPlacement::Dsp);
+    std::vector<SpectrumAnalyzer::Frame> frames;
+    for (;;) {
+        Block block;
+        {
+            std::lock_guard<std::mutex> lock(stream->queueMutex);
+            if (stream->pending.empty()) {
+                stream->busy = false;
+                return;
+            }
+            block = std::move(stream->pending.front());
+            stream->pending.pop_front();
+        }
+
+        frames.clear();
+        stream->analyzer.process(reinterpret_cast<const int8_t*>(block.data.constData()),
+                                 static_cast<size_t>(block.data.size()), block.info, frames);
+
+        for (SpectrumAnalyzer::Frame& frame : frames) {
+            QMetaObject::invokeMethod(this, [this, stream, frame = std::move(frame)]() {
+                deliverSpectrum(stream, frame);
+            }, Qt::QueuedConnection);
+        }
+    }
+}
+
+void IqStreamer::deliverSpectrum(const std::shared_ptr<SpectrumStream>& stream,
+                                 const SpectrumAnalyzer::Frame& frame)
+{
+    stream->frames++;
+
+    // Clients usually agree on format and range: quantize once for them
+    QByteArray encoded;
+    SpectrumAnalyzer::BinFormat encodedFormat = SpectrumAnalyzer::BinsU8;
+    float encodedMin = 0.0f, encodedMax = 0.0f;
+
+    for (const auto& entry : m_clients) {
+        Client& c = *entry.second;
+        if (c.spectrum != stream) continue;
+        if (encoded.isEmpty() || c.spectrumFormat != encodedFormat ||
+            c.spectrumMinDb != encodedMin || c.spectrumMaxDb != encodedMax) {
+            encodedFormat = c.spectrumFormat;
+            encodedMin = c.spectrumMinDb;
+            encodedMax = c.spectrumMaxDb;
+            encoded = SpectrumAnalyzer::encodeFrame(frame, encodedFormat, encodedMin, encodedMax);
+        }
+        enqueue(c, encoded);
+    }
+}
+
+// ============================================================
+// Status
+// ============================================================
+
+QString IqStreamer::statusText()
+{
+    return runInThread([this]() {
+        QString text = QString("%1 client(s), %2 input overruns")
+                           .arg(m_clients.size()).arg(m_inputOverruns.load());
+        for (int e = IqCodec::Raw + 1; e <= IqCodec::Deflate; e++) {
+            const EncodeStream& stream = m_encoders[e];
+            if (stream.outputBytes == 0) continue;
+            text += QString(", %1 %2:1").arg(IqCodec::encodingName(static_cast<IqCodec::Encoding>(e)))
+                        .arg(static_cast<double>(stream.inputBytes) / stream.outputBytes, 0, 'f', 2);
+        }
+
+        for (const auto& entry : m_clients) {
+            const Client& c = *entry.second;
+
+            // Lag in time at the rate this client is fed
+            double bytesPerSecond = m_sampleRate.load() * 2.0;
+            QString ddcText;
+            if (c.ddc) {
+                std::lock_guard<std::mutex> lock(c.ddc->dspMutex);
+                if (c.ddc->ddc) {
+                    bytesPerSecond = c.ddc->ddc->outputRate() * 4.0;
+                    ddcText = QString(", DDC %1 Hz / %2 Hz -> %3 S/s")
+                                  .arg(c.ddc->ddc->offset()).arg(c.ddc->ddc->bandwidth())
+                                  .arg(c.ddc->ddc->outputRate(), 0, 'f', 1);
+                }
+            }
+            if (c.framed) {
+                ddcText += QString(", %1 frames").arg(IqCodec::encodingName(c.encoding));
+            }
+            if (c.spectrum) {
+                const SpectrumAnalyzer::Config& config = c.spectrum->analyzer.config();
+                bytesPerSecond = (config.size * (c.spectrumFormat == SpectrumAnalyzer::BinsF16 ? 2 : 1) +
+                                  SpectrumAnalyzer::HEADER) * static_cast<double>(config.fps);
+                ddcText = QString(", spectrum %1 bins %2 fps avg %3 %4 (%5 frames)")
+                              .arg(config.size).arg(config.fps).arg(config.averages)
+                              .arg(SpectrumAnalyzer::formatName(c.spectrumFormat))
+                              .arg(c.spectrum->frames);
+            }
+            double lagMs = bytesPerSecond > 0 ? c.backlogBytes * 1000.0 / bytesPerSecond : 0.0;
+
+            QString path = c.socket ? QString("qt")
+                         : QString("sendmsg%1%2, %3 KB/call")
+                               .arg(c.zeroCopy ? "+zerocopy" : "")
+                               .arg(c.cork ? "+cork" : "")
+                               .arg(c.syscalls ? c.sentBytes / 1024.0 / c.syscalls : 0.0, 0, 'f', 0);
+            if (c.zcSends > 0) {
+                path += QString(", %1 zc sends (%2 copied, %3 pending)")
+                            .arg(c.zcSends).arg(c.zcCopied).arg(c.zcPending.size());
+            }
+
+            text += QString("\n    %1  [%10]  %2/%3 blk, backlog %4 blk (%5 ms), peak %6, sent %7 MB, dropped %8%9")
+                        .arg(c.name)
+                        .arg(policyName(c.policy)).arg(c.maxBlocks)
+                        .arg(c.backlog.size()).arg(lagMs, 0, 'f', 0)
+                        .arg(c.peakBlocks)
+                        .arg(c.sentBytes / (1024.0 * 1024.0), 0, 'f', 1)
+                        .arg(c.dropped)
+                        .arg(ddcText)
+                        .arg(path);
+        }
+        return text;
+    });
+}
@@ -0,0 +1,336 @@
+#ifndef IQSTREAMER_H
+#define IQSTREAMER_H
+
+#include <QObject>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QHostAddress>
+#include <QThreadPool>
+#include <QSocketNotifier>
+#include <QList>
+#include <map>
+#include <deque>
+#include <vector>
+#include <array>
+#include <memory>
+#include <mutex>
+#include <functional>
+#include <atomic>
+#include "ddcchannel.h"
+#include "spectrumanalyzer.h"
+#include "iqcodec.h"
+
+// Data port (IQ out) of HackRfTcp, running on its own network thread.
+//
+// The RX callback hands blocks over through a lock-free single-producer
+// queue and never touches a socket. Every client has a bounded backlog of
+// shared (implicitly refcounted) blocks, so N clients cost one copy; only
+// about two blocks at a time are handed to QTcpSocket, the rest waits in
+// the backlog where the drop policy can act on it. Clients that asked for
+// a sub-band get DdcChannel output (computed on a worker pool) through the
+// same backlog instead of full-rate IQ. Clients that picked a transport
+// encoding get framed blocks (IqCodec), each block encoded once per
+// encoding on the same pool, several blocks in parallel, and handed out
+// in order. Display-only clients can take averaged spectrum frames instead
+// of IQ (SpectrumAnalyzer): one analyzer per distinct size/rate/averaging
+// runs on the pool for all of its subscribers. Every frame carries the BlockInfo the producer attached to the
+// block (sequence, sample index, capture time, tuning and tuning epoch);
+// bare int8 clients do not see it.
+//
+// On Linux the data sockets bypass QTcpSocket: the backlog blocks are
+// handed to sendmsg() as one iovec array, straight from the shared
+// buffers, optionally with MSG_ZEROCOPY (the blocks are held until the
+// kernel reports completion on the socket error queue).
+//
+// Several streamers (one per radio) can share one network thread and one
+// worker pool: a router on the listening streamer hands each accepted
+// connection to the streamer of the radio its host selected, and
+// handOver() moves live connections between them without closing them.
+//
+// The same class serves the rtl_tcp port: a greeting (dongle header) goes
+// out first, blocks are converted to offset binary once on a worker for
+// all clients, and client input is cut into fixed-size command frames.
+class LatencyHistogram;
+
+class IqStreamer : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum DropPolicy {
+        DropOldest,     // keep the newest data, lose the head of the backlog
+        DropNewest,     // keep what is queued, lose the incoming block
+        Disconnect      // the client is too slow, close it
+    };
+
+    struct ClientRef {
+        quint64 id;
+        QHostAddress address;
+        quint16 port;
+    };
+
+    struct DdcInfo {
+        double outputRate = 0.0;
+        int decimation = 1;
+        size_t taps = 0;
+    };
+
+    // Data socket tuning, applied to connections accepted after the change
+    struct SendOptions {
+        bool direct = true;             // Linux: sendmsg() on the fd instead of QTcpSocket
+        bool zeroCopy = false;          // Linux: MSG_ZEROCOPY for sends of ZEROCOPY_MIN and up
+        bool cork = false;              // Linux: TCP_CORK around each batch of blocks
+        bool noDelay = true;            // TCP_NODELAY
+        int sendBuffer = 1024 * 1024;   // SO_SNDBUF (the kernel caps it at net.core.wmem_max)
+    };
+
+    explicit IqStreamer(QObject *parent = nullptr);
+    ~IqStreamer();
+
+    // Called from other threads; each blocks until the network thread ran it
+    bool listen(quint16 port, QString* error = nullptr);
+    void close();
+    QList<ClientRef> findClients(const QHostAddress& address, int port);
+    bool setDdc(const QList<quint64>& ids, uint32_t sampleRate,
+                double offset, double bandwidth, DdcInfo* info);
+    int clearDdc(const QList<quint64>& ids);
+    int setPolicy(const QList<quint64>& ids, DropPolicy policy, int maxBlocks);
+    int setEncoding(const QList<quint64>& ids, IqCodec::Encoding encoding);
+    int setSpectrum(const QList<quint64>& ids, const SpectrumAnalyzer::Config& config,
+                    SpectrumAnalyzer::BinFormat format, float minDb, float maxDb);
+    int clearSpectrum(const QList<quint64>& ids);
+    void setSampleRate(uint32_t sampleRate);
+    void setSendOptions(const SendOptions& options);
+    QString statusText();
+
+    // Moves connections to another streamer on the same thread. Transport
+    // settings (backlog policy, encoding) and queued blocks go along; DDC
+    // and spectrum subscriptions belong to this streamer's radio and do not.
+    int handOver(const QList<quint64>& ids, IqStreamer* target);
+
+    // Picks the streamer for a new connection (network thread; nullptr or
+    // a streamer on another thread keeps it here), before listen()
+    using Router = std::function<IqStreamer*(const QHostAddress&)>;
+    void setRouter(Router router);
+
+    // DDC, encoder, spectrum and conversion work; nullptr: this streamer's
+    // own pool. Before the first client.
+    void setWorkerPool(QThreadPool* pool);
+    QThreadPool* workerPool() const { return m_workers; }
+
+    // Latency histograms, before the first client (nullptr: not recorded):
+    // RX callback to network thread, block to encoded frame, and one block
+    // at a time through a client's backlog until the socket takes it
+    void setLatencyStages(LatencyHistogram* queue, LatencyHistogram* encode, LatencyHistogram* backlog);
+
+    // Protocol setup, before listen()
+    void setGreeting(const QByteArray& greeting);        // sent first on every connection
+    void setCommandSize(int bytes);                      // 0: client input is discarded
+    void setOffsetBinary(bool enable);                   // int8 -> uint8 (x ^ 0x80), any thread
+
+    // Policy for new clients (any thread)
+    void setDefaultPolicy(DropPolicy policy, int maxBlocks);
+
+    // Producer side: RX callback thread only, copies the block once
+    void pushBlock(const int8_t* data, size_t len, const IqCodec::BlockInfo& info = IqCodec::BlockInfo());
+
+    bool isListening() const { return m_listening.load(); }
+    int clientCount() const { return m_clientCount.load(); }
+    quint64 bytesSent() const { return m_bytesSent.load(); }
+    quint64 inputOverruns() const { return m_inputOverruns.load(); }
+    quint64 droppedBlocks() const { return m_droppedBlocks.load(); }
+
+    static bool parsePolicy(const QString& name, DropPolicy* policy);
+    static QString policyName(DropPolicy policy);
+
+signals:
+    void clientConnected(const QString& address);
+    void clientDisconnected(const QString& address);
+    void dataTransferred(quint64 bytes);
+    void commandReceived(quint64 clientId, const QByteArray& command);
+
+private slots:
+    void onNewConnection();
+
+private:
+    struct Block {
+        QByteArray data;
+        IqCodec::BlockInfo info;
+        qint64 queuedUs = 0;               // steady clock, at pushBlock
+    };
+
+    struct DdcStream {
+        std::mutex dspMutex;               // guards ddc
+        std::unique_ptr<DdcChannel> ddc;
+        std::mutex queueMutex;             // guards pending / busy
+        std::deque<Block> pending;
+        bool busy = false;
+    };
+
+    // Shared by every client with the same analyzer config; one worker at
+    // a time runs the analyzer
+    struct SpectrumStream {
+        explicit SpectrumStream(const SpectrumAnalyzer::Config& config) : analyzer(config) {}
+        SpectrumAnalyzer analyzer;
+        std::mutex queueMutex;             // guards pending / busy
+        std::deque<Block> pending;
+        bool busy = false;
+        quint64 frames = 0;                // network thread
+    };
+
+    // One per encoding; network thread only, the workers just encode
+    struct EncodeStream {
+        quint64 nextSeq = 0;
+        quint64 nextDeliver = 0;
+        int inFlight = 0;
+        std::map<quint64, QByteArray> done;    // finished out of order
+        quint64 inputBytes = 0;
+        quint64 outputBytes = 0;
+    };
+
+    // MSG_ZEROCOPY send still referenced by the kernel
+    struct ZeroCopySend {
+        uint32_t seq;
+        QByteArray block;
+    };
+
+    struct Client {
+        quint64 id = 0;
+        QTcpSocket* socket = nullptr;      // Qt path
+        int fd = -1;                       // direct path (Linux)
+        QSocketNotifier* readNotifier = nullptr;
+        QSocketNotifier* writeNotifier = nullptr;
+        QHostAddress address;
+        quint16 port = 0;
+        QString name;
+        std::deque<QByteArray> backlog;
+        size_t backlogBytes = 0;
+        size_t frontOffset = 0;            // bytes of backlog.front() already sent (direct)
+        QByteArray input;                  // partial command frame
+        DropPolicy policy = DropOldest;
+        int maxBlocks = 0;
+        size_t peakBlocks = 0;
+        quint64 sentBytes = 0;
+        quint64 dropped = 0;
+        quint64 markBytes = 0;             // timed block is out when sentBytes gets here
+        qint64 markUs = 0;                 // when it was queued, 0: none in flight
+        bool closing = false;
+        std::shared_ptr<DdcStream> ddc;
+        bool framed = false;               // asked for an encoding once, framed from then on
+        IqCodec::Encoding encoding = IqCodec::Raw;
+        std::shared_ptr<SpectrumStream> spectrum;  // spectrum frames instead of IQ
+        SpectrumAnalyzer::BinFormat spectrumFormat = SpectrumAnalyzer::BinsU8;
+        float spectrumMinDb = -120.0f;
+        float spectrumMaxDb = 0.0f;
+
+        // MSG_ZEROCOPY bookkeeping (direct path)
+        bool zeroCopy = false;
+        bool cork = false;
+        uint32_t zcNextSeq = 0;
+        std::deque<ZeroCopySend> zcPending;
+        quint64 zcSends = 0;
+        quint64 zcCopied = 0;
+        quint64 syscalls = 0;
+    };
+
+    // Hands accepted descriptors to the streamer before QTcpSocket sees them
+    class Server : public QTcpServer
+    {
+    public:
+        explicit Server(IqStreamer* streamer) : QTcpServer(streamer), m_streamer(streamer) {}
+    protected:
+        void incomingConnection(qintptr fd) override;
+    private:
+        IqStreamer* m_streamer;
+    };
+
+    // Network thread
+    void drain();
+    void enqueue(Client& client, const QByteArray& block);
+    void pump(Client& client);
+    void removeClient(quint64 id);
+    void addClient(std::unique_ptr<Client> client);
+    void route(std::unique_ptr<Client> client);
+    void attach(Client& client);
+    void detach(Client& client);
+    bool acceptDirect(qintptr fd);
+    bool isConnected(const Client& client) const;
+    void abortClient(Client& client);
+
+    // Direct path (Linux)
+    void pumpDirect(Client& client);
+    void readDirect(quint64 id);
+    void reapZeroCopy(Client& client);
+
+    void handleInput(Client& client, const char* data, qint64 len);
+    void broadcast(const QByteArray& block);
+    void enqueueConvert(const QByteArray& block);
+    void runConvert();
+    void enqueueDdc(quint64 id, const std::shared_ptr<DdcStream>& stream, const Block& block);
+    void runDdc(quint64 id, std::shared_ptr<DdcStream> stream);
+    void enqueueSpectrum(const std::shared_ptr<SpectrumStream>& stream, const Block& block);
+    void runSpectrum(std::shared_ptr<SpectrumStream> stream);
+    void deliverSpectrum(const std::shared_ptr<SpectrumStream>& stream, const SpectrumAnalyzer::Frame& frame);
+    void pruneSpectrum();
+    void enqueueEncode(IqCodec::Encoding encoding, const Block& block);
+    void deliverEncoded(IqCodec::Encoding encoding, quint64 seq, const QByteArray& frame, qint64 startUs);
+    void backlogSent(Client& client);
+    Client* client(quint64 id);
+
+    template <typename F>
+    auto runInThread(F f) -> decltype(f());
+
+    Server* m_server;
+    std::map<quint64, std::unique_ptr<Client>> m_clients;
+    quint64 m_nextId;
+    Router m_router;
+    QThreadPool m_ownWorkers;
+    QThreadPool* m_workers;
+    std::array<EncodeStream, IqCodec::Deflate + 1> m_encoders;
+    std::vector<std::shared_ptr<SpectrumStream>> m_spectrumStreams;
+
+    // Lock-free block queue: RX callback -> network thread
+    static constexpr size_t QUEUE_BLOCKS = 64;
+    std::array<Block, QUEUE_BLOCKS> m_queue;
+    std::atomic<size_t> m_queueHead;       // written by producer
+    std::atomic<size_t> m_queueTail;       // written by network thread
+    std::atomic<bool> m_drainPending;
+
+    // Backlog handed to QTcpSocket at a time
+    static constexpr qint64 SOCKET_HIGH_WATER = 512 * 1024;
+    static constexpr size_t DDC_MAX_PENDING = 32;
+    static constexpr int ENCODE_MAX_IN_FLIGHT = 32;
+
+    // Direct path: blocks per sendmsg(), smallest send worth pinning pages
+    // for, and sends the kernel may hold before we fall back to copying
+    static constexpr int IOV_BATCH = 16;
+    static constexpr size_t ZEROCOPY_MIN = 64 * 1024;
+    static constexpr size_t ZEROCOPY_MAX_PENDING = 256;
+
+    SendOptions m_sendOptions;
+    QByteArray m_greeting;
+    int m_commandSize;
+
+    // Offset binary conversion: one worker at a time keeps blocks in order
+    std::atomic<bool> m_offsetBinary;
+    std::mutex m_convertMutex;             // guards pending / busy
+    std::deque<QByteArray> m_convertPending;
+    bool m_convertBusy;
+
+    std::atomic<int> m_defaultPolicy;
+    std::atomic<int> m_defaultMaxBlocks;
+    std::atomic<uint32_t> m_sampleRate;
+
+    std::atomic<bool> m_listening;
+    std::atomic<int> m_clientCount;
+    std::atomic<quint64> m_bytesSent;
+    std::atomic<quint64> m_inputOverruns;
+    std::atomic<quint64> m_droppedBlocks;
+    quint64 m_lastTransferEmit;
+
+    LatencyHistogram* m_queueLatency;
+    LatencyHistogram* m_encodeLatency;
+    LatencyHistogram* m_backlogLatency;
+};
+
+#endif // IQSTREAMER_H
@@ -0,0 +1,279 @@
+#include "iqtimemachine.h"
+#include <QDateTime>
+#include <QDir>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QJsonArray>
+#include <QDebug>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+#include <algorithm>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#endif
+
+static constexpr size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+static constexpr size_t DUMP_CHUNK = 4 * 1024 * 1024;
+// Largest block the RX callback hands over in one write(); the dump worker
+// treats data this close to the write position as possibly being overwritten.
+static constexpr quint64 WRITE_GUARD = 1024 * 1024;
+
+IqTimeMachine::IqTimeMachine()
+    : m_buffer(nullptr)
+    , m_capacity(0)
+    , m_mappedSize(0)
+    , m_hugePages(false)
+    , m_written(0)
+    , m_validFrom(0)
+    , m_dumping(false)
+{
+}
+
+IqTimeMachine::~IqTimeMachine()
+{
+    release();
+}
+
+// ============================================================
+// Ring allocation
+// ============================================================
+
+bool IqTimeMachine::allocate(size_t bytes)
+{
+    release();
+
+    // Whole IQ pairs, whole huge pages
+    bytes = (bytes + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+    void* mem = nullptr;
+
+#ifdef _WIN32
+    mem = VirtualAlloc(nullptr, bytes, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+#else
+#ifdef MAP_HUGETLB
+    // Explicit huge pages need vm.nr_hugepages; fall back silently
+    mem = mmap(nullptr, bytes, PROT_READ | PROT_WRITE,
+               MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    if (mem == MAP_FAILED) {
+        mem = nullptr;
+    } else {
+        m_hugePages = true;
+    }
+#endif
+    if (!mem) {
+        mem = mmap(nullptr, bytes, PROT_READ | PROT_WRITE,
+                   MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (mem == MAP_FAILED) {
+            mem = nullptr;
+        }
+#ifdef MADV_HUGEPAGE
+        // Transparent huge pages, if enabled
+        else if (madvise(mem, bytes, MADV_HUGEPAGE) == 0) {
+            m_hugePages = true;
+        }
+#endif
+    }
+#endif
+
+    if (!mem) {
+        qDebug() << "Time machine: cannot allocate" << bytes / (1024 * 1024) << "MB";
+        m_hugePages = false;
+        return false;
+    }
+
+    // Fault every page in now so the RX callback never takes a page fault
+    std::memset(mem, 0, bytes);
+
+    m_buffer = static_cast<int8_t*>(mem);
+    m_capacity = bytes;
+    m_mappedSize = bytes;
+    m_written.store(0);
+    m_validFrom.store(0);
+
+    qDebug() << "Time machine:" << bytes / (1024 * 1024) << "MB ring"
+             << (m_hugePages ? "(huge pages)" : "");
+    return true;
+}
+
+void IqTimeMachine::release()
+{
+    joinDump();
+
+    if (!m_buffer) return;
+
+#ifdef _WIN32
+    VirtualFree(m_buffer, 0, MEM_RELEASE);
+#else
+    munmap(m_buffer, m_mappedSize);
+#endif
+    m_buffer = nullptr;
+    m_capacity = 0;
+    m_mappedSize = 0;
+    m_hugePages = false;
+}
+
+// ============================================================
+// Producer
+// ============================================================
+
+void IqTimeMachine::write(const int8_t* data, size_t len)
+{
+    if (!m_buffer || !data || len == 0) return;
+
+    // Only the newest 'capacity' bytes of an oversized block are kept
+    if (len > m_capacity) {
+        data += len - m_capacity;
+        len = m_capacity;
+    }
+
+    quint64 written = m_written.load(std::memory_order_relaxed);
+    size_t pos = static_cast<size_t>(written % m_capacity);
+    size_t first = std::min(len, m_capacity - pos);
+
+    std::memcpy(m_buffer + pos, data, first);
+    if (first < len) {
+        std::memcpy(m_buffer, data + first, len - first);
+    }
+
+    m_written.store(written + len, std::memory_order_release);
+}
+
+void IqTimeMachine::reset()
+{
+    m_validFrom.store(m_written.load(std::memory_order_acquire));
+}
+
+quint64 IqTimeMachine::available() const
+{
+    if (!m_buffer) return 0;
+
+    quint64 end = m_written.load(std::memory_order_acquire);
+    quint64 start = std::max(m_validFrom.load(), end > m_capacity ? end - m_capacity : 0);
+    return end - start;
+}
+
+// ============================================================
+// Dump
+// ============================================================
+
+bool IqTimeMachine::dump(double seconds, const QString& dir, uint32_t sampleRate,
+                         uint64_t frequency, DumpCallback done)
+{
+    if (!m_buffer || sampleRate == 0) return false;
+
+    std::lock_guard<std::mutex> lock(m_dumpMutex);
+    if (m_dumping.load()) return false;
+
+    // Keep the write guard out of a full ring so the oldest chunk is not
+    // already being overwritten when the worker gets to it.
+    quint64 end = m_written.load(std::memory_order_acquire);
+    quint64 held = std::min<quint64>(available(), m_capacity - WRITE_GUARD);
+
+    quint64 wanted = held;
+    if (seconds > 0.0) {
+        wanted = std::min<quint64>(held, static_cast<quint64>(seconds * sampleRate) * 2);
+    }
+    wanted &= ~quint64(1);   // whole IQ pairs
+    if (wanted == 0) return false;
+
+    quint64 start = end - wanted;
+    qint64 startMs = QDateTime::currentMSecsSinceEpoch() -
+                     static_cast<qint64>(wanted / 2 * 1000.0 / sampleRate);
+
+    if (m_dumpThread.joinable()) {
+        m_dumpThread.join();
+    }
+    m_dumping.store(true);
+    m_dumpThread = std::thread(&IqTimeMachine::dumpWorker, this, start, end, dir,
+                               sampleRate, frequency, startMs, std::move(done));
+    return true;
+}
+
+void IqTimeMachine::dumpWorker(quint64 start, quint64 end, QString dir, uint32_t sampleRate,
+                               uint64_t frequency, qint64 startMs, DumpCallback done)
+{
+    DumpResult result;
+    QDateTime startTime = QDateTime::fromMSecsSinceEpoch(startMs).toUTC();
+    result.name = QString("iq_%1_%2Hz")
+                      .arg(startTime.toString("yyyyMMdd_HHmmss"))
+                      .arg(frequency);
+    QString base = QDir(dir).filePath(result.name);
+    result.path = base + ".sigmf-data";
+
+    QDir().mkpath(dir);
+    FILE* f = fopen(result.path.toLocal8Bit().constData(), "wb");
+    if (!f) {
+        result.error = QString("cannot create %1").arg(result.path);
+        m_dumping.store(false);
+        if (done) done(result);
+        return;
+    }
+
+    // Oldest data first: it is the first to be overwritten by the producer
+    std::vector<int8_t> chunk(DUMP_CHUNK);
+    quint64 pos = start;
+    while (pos < end) {
+        size_t n = static_cast<size_t>(std::min<quint64>(DUMP_CHUNK, end - pos));
+        size_t ringPos = static_cast<size_t>(pos % m_capacity);
+        size_t first = std::min(n, m_capacity - ringPos);
+        std::memcpy(chunk.data(), m_buffer + ringPos, first);
+        if (first < n) {
+            std::memcpy(chunk.data() + first, m_buffer, n - first);
+        }
+
+        // Producer lapped us while copying: the disk is slower than the stream
+        if (m_written.load(std::memory_order_acquire) + WRITE_GUARD > pos + m_capacity) {
+            result.error = "overrun, disk slower than the IQ stream";
+            break;
+        }
+
+        if (fwrite(chunk.data(), 1, n, f) != n) {
+            result.error = "write failed";
+            break;
+        }
+        pos += n;
+    }
+    fclose(f);
+
+    result.bytes = pos - start;
+    result.seconds = result.bytes / 2.0 / sampleRate;
+
+    // SigMF metadata so the dump can be replayed with -o file:<path>
+    QJsonObject global;
+    global["core:datatype"] = "ci8";
+    global["core:sample_rate"] = static_cast<double>(sampleRate);
+    global["core:version"] = "1.0.0";
+    global["core:recorder"] = "HackRfTcp";
+
+    QJsonObject capture;
+    capture["core:sample_start"] = 0;
+    capture["core:frequency"] = static_cast<double>(frequency);
+    capture["core:datetime"] = startTime.toString(Qt::ISODateWithMs);
+
+    QJsonObject meta;
+    meta["global"] = global;
+    meta["captures"] = QJsonArray{capture};
+    meta["annotations"] = QJsonArray();
+
+    FILE* m = fopen((base + ".sigmf-meta").toLocal8Bit().constData(), "wb");
+    if (m) {
+        QByteArray json = QJsonDocument(meta).toJson();
+        fwrite(json.constData(), 1, json.size(), m);
+        fclose(m);
+    }
+
+    result.ok = result.error.isEmpty();
+    m_dumping.store(false);
+    if (done) done(result);
+}
+
+void IqTimeMachine::joinDump()
+{
+    std::lock_guard<std::mutex> lock(m_dumpMutex);
+    if (m_dumpThread.joinable()) {
+        m_dumpThread.join();
+    }
+}
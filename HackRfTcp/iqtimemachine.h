@@ -0,0 +1,74 @@
+#ifndef IQTIMEMACHINE_H
+#define IQTIMEMACHINE_H
+
+#include <QString>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <functional>
+#include <cstdint>
+
+// Rolling window of raw int8 IQ kept in RAM ("time machine").
+//
+// write() is called from the HackTvLib RX callback and only does a memcpy
+// into a pre-faulted ring (huge pages where the OS allows it). dump() takes
+// the last N seconds and writes them to a SigMF pair on a worker thread,
+// oldest data first, so the USB callback never waits on the disk.
+class IqTimeMachine
+{
+public:
+    struct DumpResult {
+        bool ok = false;
+        QString name;       // file name without extension
+        QString path;       // full path of the .sigmf-data file
+        quint64 bytes = 0;
+        double seconds = 0.0;
+        QString error;
+    };
+    using DumpCallback = std::function<void(const DumpResult&)>;
+
+    IqTimeMachine();
+    ~IqTimeMachine();
+
+    bool allocate(size_t bytes);
+    void release();
+    bool isEnabled() const { return m_buffer != nullptr; }
+    bool isHugePages() const { return m_hugePages; }
+    size_t capacity() const { return m_capacity; }
+
+    // Producer side (RX callback thread, single writer)
+    void write(const int8_t* data, size_t len);
+    // Drop the current window, e.g. after a retune or rate change
+    void reset();
+
+    // Bytes currently held (<= capacity)
+    quint64 available() const;
+
+    // Start an asynchronous dump of the last 'seconds' (<= 0: everything held)
+    bool dump(double seconds, const QString& dir, uint32_t sampleRate,
+              uint64_t frequency, DumpCallback done);
+    bool isDumping() const { return m_dumping.load(); }
+
+private:
+    void dumpWorker(quint64 start, quint64 end, QString dir, uint32_t sampleRate,
+                    uint64_t frequency, qint64 startMs, DumpCallback done);
+    void joinDump();
+
+    // Ring storage
+    int8_t* m_buffer;
+    size_t m_capacity;
+    size_t m_mappedSize;
+    bool m_hugePages;
+
+    // Total bytes ever written; position in ring = m_written % m_capacity
+    std::atomic<quint64> m_written;
+    // Bytes before this point belong to an older tuning and are not dumped
+    std::atomic<quint64> m_validFrom;
+
+    // Dump worker
+    std::thread m_dumpThread;
+    std::mutex m_dumpMutex;
+    std::atomic<bool> m_dumping;
+};
+
+#endif // IQTIMEMACHINE_H
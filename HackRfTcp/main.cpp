@@ -3,9 +3,11 @@
 #include <QThread>
 #include <QTimer>
 #include <QCommandLineParser>
+#include <QDir>
 #include <QHostInfo>
 #include <QNetworkInterface>
 #include "sdrdevice.h"
+#include "threadplacement.h"
 
 QString getLocalIPAddress()
 {
@@ -85,11 +87,98 @@ int main(int argc, char *argv[])
     parser.addOption(modeOption);
 
     QCommandLineOption deviceOption(QStringList() << "o" << "device",
-                                    "SDR device type (hackrf, rtlsdr, or auto)", "device", "auto");
+                                    "SDR device type (hackrf, rtlsdr, or auto), optionally :<serial>", "device", "auto");
     parser.addOption(deviceOption);
 
+    QCommandLineOption devicesOption(QStringList() << "devices",
+                                     "Serve several radios: 'all' or a comma-separated list of hackrf:<serial> / "
+                                     "rtlsdr:<serial>; the first one replaces --device", "list");
+    parser.addOption(devicesOption);
+
+    QCommandLineOption listDevicesOption(QStringList() << "list-devices",
+                                         "List the attached radios and exit");
+    parser.addOption(listDevicesOption);
+
+    QCommandLineOption noPinOption(QStringList() << "no-pin",
+                                   "Linux, several radios: do not pin each capture thread to its own CPU");
+    parser.addOption(noPinOption);
+
+    QCommandLineOption rtlTcpOption(QStringList() << "rtl-tcp",
+                                    "Also serve the rtl_tcp protocol on this port (0 = off, usually 1234)", "port", "0");
+    parser.addOption(rtlTcpOption);
+
+    QCommandLineOption timeMachineOption(QStringList() << "time-machine",
+                                         "Keep the last N seconds of RX IQ in RAM for DUMP, per radio (0 = off)", "seconds", "0");
+    parser.addOption(timeMachineOption);
+
+    QCommandLineOption dumpDirOption(QStringList() << "dump-dir",
+                                     "Directory for time machine dumps", "dir", "dumps");
+    parser.addOption(dumpDirOption);
+
+    QCommandLineOption backlogOption(QStringList() << "backlog",
+                                     "Per data client backlog in RX blocks", "blocks", "16");
+    parser.addOption(backlogOption);
+
+    QCommandLineOption dropPolicyOption(QStringList() << "drop-policy",
+                                        "Slow data client policy (drop-oldest, drop-newest, disconnect)", "policy", "drop-oldest");
+    parser.addOption(dropPolicyOption);
+
+    QCommandLineOption sendBufferOption(QStringList() << "send-buffer",
+                                        "Data socket SO_SNDBUF in KB", "KB", "1024");
+    parser.addOption(sendBufferOption);
+
+    QCommandLineOption zeroCopyOption(QStringList() << "zerocopy",
+                                      "Linux: send IQ with MSG_ZEROCOPY");
+    parser.addOption(zeroCopyOption);
+
+    QCommandLineOption corkOption(QStringList() << "tcp-cork",
+                                  "Linux: TCP_CORK each batch instead of TCP_NODELAY");
+    parser.addOption(corkOption);
+
+    QCommandLineOption qtSocketsOption(QStringList() << "qt-sockets",
+                                       "Send IQ through QTcpSocket instead of sendmsg()");
+    parser.addOption(qtSocketsOption);
+
+    QCommandLineOption multicastOption(QStringList() << "multicast",
+                                       "Also send RX IQ as UDP multicast to group:port (e.g. 239.10.0.1:5004)", "group:port");
+    parser.addOption(multicastOption);
+
+    QCommandLineOption multicastTtlOption(QStringList() << "multicast-ttl",
+                                          "Multicast TTL (1 = local subnet)", "hops", "1");
+    parser.addOption(multicastTtlOption);
+
+    QCommandLineOption multicastMtuOption(QStringList() << "multicast-mtu",
+                                          "Path MTU the datagrams must fit in", "bytes", "1500");
+    parser.addOption(multicastMtuOption);
+
+    QCommandLineOption noShmOption(QStringList() << "no-shm",
+                                   "Do not offer the shared-memory IQ ring to clients on this host");
+    parser.addOption(noShmOption);
+
+    QCommandLineOption shmSizeOption(QStringList() << "shm-size",
+                                     "Shared-memory IQ ring size", "MB", "64");
+    parser.addOption(shmSizeOption);
+
+    QCommandLineOption threadOption(QStringList() << "thread",
+                                    QString("Scheduling and CPUs of a group of hot threads, repeatable: %1")
+                                        .arg(ThreadPlacement::usage()), "role=settings");
+    parser.addOption(threadOption);
+
+    QCommandLineOption mlockOption(QStringList() << "mlock",
+                                   "Lock the process memory (mlockall) once the radio runs");
+    parser.addOption(mlockOption);
+
     parser.process(a);
 
+    if (parser.isSet(listDevicesOption)) {
+        std::vector<std::string> devices = HackTvLib::listDevices();
+        qDebug() << "Attached radios:" << devices.size();
+        for (const std::string& device : devices) {
+            qDebug().noquote() << " " << QString::fromStdString(device);
+        }
+        return 0;
+    }
+
     quint16 dataPort = parser.value(dataPortOption).toUShort();
     quint16 controlPort = parser.value(controlPortOption).toUShort();
     quint16 audioPort = parser.value(audioPortOption).toUShort();
@@ -97,6 +186,66 @@ int main(int argc, char *argv[])
     uint64_t frequency = parser.value(frequencyOption).toULongLong();
     QString mode = parser.value(modeOption).toLower();
     QString device = parser.value(deviceOption).toLower();
+    quint16 rtlTcpPort = parser.value(rtlTcpOption).toUShort();
+    double timeMachineSeconds = parser.value(timeMachineOption).toDouble();
+    QString dumpDir = parser.value(dumpDirOption);
+    int backlogBlocks = parser.value(backlogOption).toInt();
+    QString dropPolicy = parser.value(dropPolicyOption).toLower();
+
+    IqStreamer::SendOptions sendOptions;
+    sendOptions.sendBuffer = parser.value(sendBufferOption).toInt() * 1024;
+    sendOptions.zeroCopy = parser.isSet(zeroCopyOption);
+    sendOptions.cork = parser.isSet(corkOption);
+    sendOptions.noDelay = !sendOptions.cork;
+    sendOptions.direct = !parser.isSet(qtSocketsOption);
+
+    QHostAddress multicastGroup;
+    quint16 multicastPort = 0;
+    if (parser.isSet(multicastOption)) {
+        QString value = parser.value(multicastOption);
+        int colon = value.lastIndexOf(':');
+        bool okPort = false;
+        if (colon > 0) {
+            multicastGroup = QHostAddress(value.left(colon));
+            multicastPort = value.mid(colon + 1).toUShort(&okPort);
+        }
+        if (!okPort || multicastPort == 0 || !multicastGroup.isMulticast()) {
+            qDebug() << "Invalid multicast target:" << value << "(use group:port, e.g. 239.10.0.1:5004)";
+            return 1;
+        }
+    }
+    int multicastTtl = parser.value(multicastTtlOption).toInt();
+    int multicastMtu = parser.value(multicastMtuOption).toInt();
+    bool useShm = !parser.isSet(noShmOption);
+    size_t shmBytes = static_cast<size_t>(qMax(4, parser.value(shmSizeOption).toInt())) * 1024 * 1024;
+
+    for (const QString& spec : parser.values(threadOption)) {
+        std::string error;
+        if (!ThreadPlacement::parse(spec.toStdString(), &error)) {
+            qDebug() << "Invalid --thread:" << QString::fromStdString(error) << "(" << ThreadPlacement::usage() << ")";
+            return 1;
+        }
+    }
+    ThreadPlacement::setLockMemory(parser.isSet(mlockOption));
+
+    // Several radios: the first one takes the place of --device
+    QStringList deviceList;
+    if (parser.isSet(devicesOption)) {
+        QString value = parser.value(devicesOption).trimmed();
+        if (value.toLower() == "all") {
+            for (const std::string& found : HackTvLib::listDevices()) {
+                deviceList.append(QString::fromStdString(found));
+            }
+        } else {
+            deviceList = value.split(',', Qt::SkipEmptyParts);
+            for (QString& entry : deviceList) entry = entry.trimmed();
+        }
+        if (deviceList.isEmpty()) {
+            qDebug() << "No radios to serve (see --list-devices)";
+            return 1;
+        }
+        device = deviceList.first();
+    }
 
     // Auto-detect device - try hackrf first, fall back to rtlsdr
     if (device == "auto") {
@@ -105,13 +254,16 @@ int main(int argc, char *argv[])
     }
 
     // Validate device type
-    if (device != "hackrf" && device != "rtlsdr") {
-        qDebug() << "Invalid device type:" << device << "(use 'hackrf', 'rtlsdr', or 'auto')";
-        return 1;
+    for (const QString& entry : deviceList.isEmpty() ? QStringList{device} : deviceList) {
+        QString type = entry.section(':', 0, 0).toLower();
+        if (type != "hackrf" && type != "rtlsdr") {
+            qDebug() << "Invalid device type:" << entry << "(use 'hackrf', 'rtlsdr', or 'auto', optionally :<serial>)";
+            return 1;
+        }
     }
 
     // RTL-SDR only supports RX
-    if (device == "rtlsdr" && mode == "tx") {
+    if (device.startsWith("rtlsdr") && mode == "tx") {
         qDebug() << "RTL-SDR does not support TX mode, forcing RX";
         mode = "rx";
     }
@@ -127,18 +279,61 @@ int main(int argc, char *argv[])
 
     qDebug() << "Configuration:";
     qDebug() << "  Device:         " << device;
+    if (deviceList.size() > 1) {
+        qDebug() << "  More Radios:    " << deviceList.mid(1).join(", ");
+    }
     qDebug() << "  Data Port:      " << dataPort;
     qDebug() << "  Control Port:   " << controlPort;
     qDebug() << "  Audio Port:     " << audioPort;
+    qDebug() << "  rtl_tcp Port:   " << (rtlTcpPort ? QString::number(rtlTcpPort) : QString("off"));
+    qDebug() << "  Multicast:      " << (multicastPort ? QString("%1:%2 TTL %3 MTU %4").arg(multicastGroup.toString())
+                                                       .arg(multicastPort).arg(multicastTtl).arg(multicastMtu)
+                                                 : QString("off"));
+    qDebug() << "  Shared Memory:  " << (useShm ? QString("%1 MB ring").arg(shmBytes / (1024 * 1024)) : QString("off"));
     qDebug() << "  Sample Rate:    " << sampleRate << "Hz (" << sampleRate/1000000.0 << "MHz)";
     qDebug() << "  Frequency:      " << frequency << "Hz (" << frequency/1000000.0 << "MHz)";
     qDebug() << "  Mode:           " << mode;
+    qDebug() << "  Data Backlog:   " << backlogBlocks << "blocks," << dropPolicy;
+    qDebug() << "  Data Sockets:   " << (sendOptions.direct ? "sendmsg" : "QTcpSocket")
+             << (sendOptions.zeroCopy ? "+ MSG_ZEROCOPY" : "") << (sendOptions.cork ? "+ TCP_CORK" : "")
+             << "SO_SNDBUF" << sendOptions.sendBuffer / 1024 << "KB";
+    qDebug() << "  Time Machine:   " << (timeMachineSeconds > 0 ? QString("%1 s").arg(timeMachineSeconds) : QString("off"));
+    for (const std::string& line : ThreadPlacement::report()) {
+        qDebug().noquote() << "  Threads:        " << QString::fromStdString(line);
+    }
+
+    if (!hackrf.setBacklogPolicy(dropPolicy, backlogBlocks)) {
+        qDebug() << "\nInvalid backlog:" << backlogBlocks << dropPolicy
+                 << "(use 'drop-oldest', 'drop-newest' or 'disconnect', at least 1 block)";
+        return 1;
+    }
+
+    hackrf.setSendOptions(sendOptions);
 
     if (!hackrf.startTcpServer(dataPort, controlPort, audioPort)) {
         qDebug() << "\nFailed to start TCP servers";
         return 1;
     }
 
+    if (rtlTcpPort && !hackrf.startRtlTcpServer(rtlTcpPort)) {
+        qDebug() << "\nFailed to start rtl_tcp server";
+        return 1;
+    }
+
+    if (multicastPort && !hackrf.startMulticast(multicastGroup, multicastPort, multicastTtl, multicastMtu)) {
+        qDebug() << "\nFailed to start multicast";
+        return 1;
+    }
+
+    // Not fatal: local clients fall back to the data port
+    bool shmRunning = useShm && hackrf.startSharedMemory(shmBytes);
+
+    // Size the ring for the initial rate; higher rates shorten the window
+    if (timeMachineSeconds > 0 && !hackrf.enableTimeMachine(timeMachineSeconds, sampleRate, dumpDir)) {
+        qDebug() << "\nFailed to allocate time machine ring";
+        return 1;
+    }
+
     if (!hackrf.initialize(hacktvArgs)) {
         qDebug() << "\nFailed to initialize" << device;
         return 1;
@@ -151,8 +346,8 @@ int main(int argc, char *argv[])
 
     bool started = hackrf.start();
 
-    // Auto-fallback: if hackrf failed, try rtlsdr
-    if (!started && device == "hackrf") {
+    // Auto-fallback: if hackrf failed, try rtlsdr (not for a given serial)
+    if (!started && device == "hackrf" && deviceList.isEmpty()) {
         qDebug() << "\nHackRF not found, falling back to RTL-SDR...";
         device = "rtlsdr";
         hackrf.setDeviceType("rtlsdr");
@@ -166,6 +361,55 @@ int main(int argc, char *argv[])
 
     qDebug() << "\nDevice started:" << device.toUpper();
 
+    // The other radios: own capture pipeline each, same ports, network
+    // thread and worker pool; they start in RX. --thread usb=cpus:...
+    // replaces the CPU per radio.
+    const int cpus = QThread::idealThreadCount();
+    const bool pin = deviceList.size() > 1 && !parser.isSet(noPinOption) && cpus > deviceList.size() &&
+                     ThreadPlacement::policy(ThreadPlacement::Usb).cpuMask == 0;
+    if (pin) {
+        hackrf.setCaptureCpu(1);
+    }
+    for (int i = 1; i < deviceList.size(); i++) {
+        const QString name = deviceList[i];
+        SdrDevice* radio = hackrf.addDevice();
+        QObject::connect(radio, &SdrDevice::statusMessage, [name](const QString& msg) {
+            qDebug() << "Status:" << name << msg;
+        });
+        QObject::connect(radio, &SdrDevice::errorOccurred, [name](const QString& error) {
+            qDebug() << "Error:" << name << error;
+        });
+
+        radio->setBacklogPolicy(dropPolicy, backlogBlocks);
+        radio->setSendOptions(sendOptions);
+        if (pin) {
+            radio->setCaptureCpu(1 + i);
+        }
+        // Own window; dumps go to a subdirectory named like LIST_DEVICES' #
+        if (timeMachineSeconds > 0 &&
+            !radio->enableTimeMachine(timeMachineSeconds, sampleRate,
+                                      QDir(dumpDir).filePath(QString("radio%1").arg(i)))) {
+            qDebug() << "\nFailed to allocate time machine ring for" << name;
+            return 1;
+        }
+
+        std::vector<std::string> radioArgs = {
+            "-o", name.toStdString(),
+            "--rx-tx-mode", "rx"
+        };
+        if (!radio->initialize(radioArgs)) {
+            qDebug() << "\nFailed to initialize" << name;
+            return 1;
+        }
+        radio->setSampleRate(sampleRate);
+        radio->setFrequency(frequency);
+        if (!radio->start()) {
+            qDebug() << "\nFailed to start" << name;
+            return 1;
+        }
+        qDebug() << "Device started:" << name;
+    }
+
     QString localIP = getLocalIPAddress();
 
     qDebug() << "\n========================================";
@@ -177,9 +421,21 @@ int main(int argc, char *argv[])
     qDebug() << "  IQ Data Stream: " << localIP << ":" << dataPort;
     qDebug() << "  Control:        " << localIP << ":" << controlPort;
     qDebug() << "  TX Audio In:    " << localIP << ":" << audioPort;
+    if (rtlTcpPort) {
+        qDebug() << "  rtl_tcp:        " << localIP << ":" << rtlTcpPort;
+    }
+    if (multicastPort) {
+        qDebug() << "  Multicast IQ:   " << multicastGroup.toString() << ":" << multicastPort;
+    }
+    if (shmRunning) {
+        qDebug() << "  Local IQ (shm): " << "@" + IqShmBus::socketName(dataPort);
+    }
     qDebug() << "";
-    qDebug() << "Control commands: SWITCH_RX, SWITCH_TX, SET_FREQ:<Hz>, etc.";
-    qDebug() << "Audio format: float32 PCM, mono, 44100 Hz";
+    if (deviceList.size() > 1) {
+        qDebug() << "  Radios:         " << deviceList.join(", ") << "(LIST_DEVICES, SELECT_DEVICE:<serial>)";
+    }
+    qDebug() << "Control commands: SWITCH_RX, SWITCH_TX, SET_FREQ:<Hz>, DUMP:<s>, etc.";
+    qDebug() << "Audio format: HRAU packets, or bare float32 PCM mono 44100 Hz";
     qDebug() << "\n========================================";
     qDebug() << "  Server Ready - Press Ctrl+C to stop";
     qDebug() << "  Device:" << device.toUpper();
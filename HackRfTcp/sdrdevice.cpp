@@ -1,17 +1,40 @@
 #include "sdrdevice.h"
+#include "threadplacement.h"
 #include <QDebug>
 #include <QHostAddress>
 #include <QThread>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
 #include <cstring>
+#include <cmath>
+#include <algorithm>
+
+#ifdef Q_OS_LINUX
+#include <pthread.h>
+#include <sched.h>
+#endif
 
 SdrDevice::SdrDevice(QObject *parent)
+    : SdrDevice(nullptr, parent)
+{
+}
+
+SdrDevice::SdrDevice(SdrDevice* host, QObject *parent)
     : QObject(parent)
     , m_hackTvLib(nullptr)
-    , m_tcpServer(nullptr)
+    , m_host(host)
+    , m_streamer(new IqStreamer)
+    , m_rtlStreamer(new IqStreamer)
+    , m_rtlTcpPort(0)
     , m_controlServer(nullptr)
     , m_audioServer(nullptr)
-    , m_totalBytesSent(0)
     , m_totalBytesReceived(0)
+    , m_rxFrequency(100000000)
+    , m_rxSampleRate(2000000)
+    , m_tuningEpoch(0)
+    , m_blockSequence(0)
+    , m_lastBlockEpoch(0)
     , m_currentFrequency(100000000)
     , m_currentSampleRate(2000000)
     , m_currentVgaGain(30)
@@ -24,11 +47,17 @@ SdrDevice::SdrDevice(QObject *parent)
     , m_currentModulationType(0)
     , m_isTxMode(false)
     , m_deviceType("hackrf")
+    , m_captureCpu(-1)
+    , m_txAudio(TX_AUDIO_RATE)
+    , m_txAudioTimer(new QTimer(this))
     , m_dataPort(5000)
     , m_controlPort(5001)
     , m_audioPort(5002)
 {
-    m_txAudioRing.resize(TX_AUDIO_RING_SIZE, 0.0f);
+    m_audioClock.start();
+    m_txAudioTimer->setTimerType(Qt::PreciseTimer);
+    m_txAudioTimer->setInterval(TX_AUDIO_TICK_MS);
+    connect(m_txAudioTimer, &QTimer::timeout, this, &SdrDevice::onTxAudioTick);
 
     m_hackTvLib = std::make_unique<HackTvLib>(this);
 
@@ -38,21 +67,83 @@ SdrDevice::SdrDevice(QObject *parent)
         qDebug() << "HackTV:" << QString::fromStdString(msg);
     });
 
-    // Set up data callback - raw IQ from HackRF -> TCP broadcast (RX mode)
+    // Set up data callback - raw IQ from HackRF -> network thread (RX mode)
     m_hackTvLib->setReceivedDataCallback([this](const int8_t* data, size_t len) {
-        if (m_hackTvLib && data && len > 0 && !m_isTxMode) {
-            QByteArray dataCopy(reinterpret_cast<const char*>(data), static_cast<int>(len));
-            QMetaObject::invokeMethod(this, [this, dataCopy]() {
-                handleReceivedData(reinterpret_cast<const int8_t*>(dataCopy.data()),
-                                   static_cast<size_t>(dataCopy.size()));
-            }, Qt::QueuedConnection);
+        if (m_hackTvLib && data && len > 0 && !m_isTxMode.load(std::memory_order_acquire)) {
+            handleReceivedData(data, len);
         }
     });
+
+    m_streamer->setLatencyStages(&m_latency.stage("net.queue"), &m_latency.stage("net.encode"),
+                                 &m_latency.stage("net.backlog"));
+    m_txAudio.setLatencyStages(&m_latency.stage("tx.network"), &m_latency.stage("tx.intake"));
+
+    // Data port sockets live on their own thread, away from control traffic;
+    // further radios use the host's thread and worker pool
+    QThread* netThread = m_host ? &m_host->m_netThread : &m_netThread;
+    m_streamer->moveToThread(netThread);
+    m_rtlStreamer->moveToThread(netThread);
+    m_netThread.setObjectName("HackRfTcp-net");
+    connect(netThread, &QThread::finished, m_streamer, &QObject::deleteLater);
+    connect(netThread, &QThread::finished, m_rtlStreamer, &QObject::deleteLater);
+    if (m_host) {
+        m_streamer->setWorkerPool(m_host->m_streamer->workerPool());
+        m_rtlStreamer->setWorkerPool(m_host->m_streamer->workerPool());
+    }
+
+    connect(m_streamer, &IqStreamer::clientConnected, this, [this](const QString& address) {
+        emit clientConnected(address);
+        emit statusMessage(QString("Data client connected: %1 (Total: %2)")
+                               .arg(address).arg(m_streamer->clientCount()));
+    });
+    connect(m_streamer, &IqStreamer::clientDisconnected, this, [this](const QString& address) {
+        emit clientDisconnected(address);
+        emit statusMessage(QString("Data client disconnected: %1 (Remaining: %2)")
+                               .arg(address).arg(m_streamer->clientCount()));
+    });
+    connect(m_streamer, &IqStreamer::dataTransferred, this, &SdrDevice::dataTransferred);
+
+    connect(m_rtlStreamer, &IqStreamer::clientConnected, this, [this](const QString& address) {
+        emit clientConnected(address);
+        emit statusMessage(QString("rtl_tcp client connected: %1 (Total: %2)")
+                               .arg(address).arg(m_rtlStreamer->clientCount()));
+    });
+    connect(m_rtlStreamer, &IqStreamer::clientDisconnected, this, [this](const QString& address) {
+        emit clientDisconnected(address);
+        emit statusMessage(QString("rtl_tcp client disconnected: %1 (Remaining: %2)")
+                               .arg(address).arg(m_rtlStreamer->clientCount()));
+    });
+    connect(m_rtlStreamer, &IqStreamer::commandReceived, this, &SdrDevice::handleRtlTcpCommand);
+
+    if (!m_host) {
+        m_netThread.start();
+    }
 }
 
 SdrDevice::~SdrDevice()
 {
+    // The other radios first, their streamers run on this network thread
+    {
+        std::lock_guard<std::mutex> lock(m_hostMutex);
+        m_hostDevices.clear();
+    }
+    m_controlDevices.clear();
+    m_audioDevices.clear();
+    qDeleteAll(m_devices);
+    m_devices.clear();
+
     stopTcpServer();
+    if (m_host) {
+        // Never listened, but may have been handed connections
+        m_streamer->close();
+    } else {
+        m_netThread.quit();
+        m_netThread.wait();
+    }
+    m_multicaster.stop();
+    m_shmBus.stop();
+    // Join a running dump while this object is still whole
+    m_timeMachine.release();
 }
 
 bool SdrDevice::initialize(const std::vector<std::string>& args)
@@ -62,11 +153,17 @@ bool SdrDevice::initialize(const std::vector<std::string>& args)
         return false;
     }
 
-    // Extract device type from args
+    // Extract device type (and serial) from args
     m_deviceType = "hackrf"; // default
+    m_deviceSerial.clear();
     for (size_t i = 0; i < args.size(); i++) {
         if (args[i] == "-o" && i + 1 < args.size()) {
-            m_deviceType = args[i + 1];
+            const std::string& output = args[i + 1];
+            const size_t colon = output.find(':');
+            m_deviceType = output.substr(0, colon);
+            if (colon != std::string::npos) {
+                m_deviceSerial = output.substr(colon + 1);
+            }
             break;
         }
     }
@@ -76,7 +173,7 @@ bool SdrDevice::initialize(const std::vector<std::string>& args)
         return false;
     }
 
-    emit statusMessage(QString("Initialized with device: %1").arg(QString::fromStdString(m_deviceType)));
+    emit statusMessage(QString("Initialized with device: %1").arg(deviceId()));
     return true;
 }
 
@@ -87,6 +184,7 @@ bool SdrDevice::start()
         return false;
     }
 
+    updateRtlTcpFormat();
     if (!m_hackTvLib->start()) {
         emit errorOccurred("Failed to start");
         return false;
@@ -132,12 +230,8 @@ bool SdrDevice::reinitialize(const std::string& mode)
     });
 
     m_hackTvLib->setReceivedDataCallback([this](const int8_t* data, size_t len) {
-        if (m_hackTvLib && data && len > 0 && !m_isTxMode) {
-            QByteArray dataCopy(reinterpret_cast<const char*>(data), static_cast<int>(len));
-            QMetaObject::invokeMethod(this, [this, dataCopy]() {
-                handleReceivedData(reinterpret_cast<const int8_t*>(dataCopy.data()),
-                                   static_cast<size_t>(dataCopy.size()));
-            }, Qt::QueuedConnection);
+        if (m_hackTvLib && data && len > 0 && !m_isTxMode.load(std::memory_order_acquire)) {
+            handleReceivedData(data, len);
         }
     });
 
@@ -145,7 +239,7 @@ bool SdrDevice::reinitialize(const std::string& mode)
     std::string freqStr = std::to_string(m_currentFrequency);
 
     std::vector<std::string> args = {
-        "-o", m_deviceType,
+        "-o", deviceId().toStdString(),
         "--rx-tx-mode", mode,
         "-s", srStr,
         "-f", freqStr
@@ -163,6 +257,7 @@ bool SdrDevice::reinitialize(const std::string& mode)
         return false;
     }
 
+    updateRtlTcpFormat();
     if (!m_hackTvLib->start()) {
         emit errorOccurred("Failed to start in mode: " + QString::fromStdString(mode));
         return false;
@@ -170,21 +265,31 @@ bool SdrDevice::reinitialize(const std::string& mode)
 
     m_hackTvLib->setSampleRate(m_currentSampleRate);
     m_hackTvLib->setFrequency(m_currentFrequency);
+    bumpTuningEpoch();
 
     if (mode == "tx") {
         QThread::msleep(200);
+    }
+    applyModeSettings(mode == "tx");
+    return true;
+}
+
+// Settings of the direction just started, cold or warm
+void SdrDevice::applyModeSettings(bool tx)
+{
+    if (tx) {
         m_hackTvLib->enableExternalAudioRing();
 
-        // Pre-fill ring buffer with ~100ms of silence to prevent initial crackle
-        std::vector<float> silence(4410, 0.0f);
-        m_hackTvLib->writeExternalAudio(silence.data(), silence.size());
+        // Start from empty jitter buffers; the audio timer fills the ring
+        // (silence until a client has its target depth) from here on
+        m_txAudio.reset();
+        m_txAudioTimer->start();
 
         m_hackTvLib->setModulation_index(m_currentModulationIndex);
         m_hackTvLib->setAmplitude(m_currentAmplitude);
         m_hackTvLib->setTxAmpGain(m_currentTxAmpGain);
 
         // Force TX AMP enable
-        QThread::msleep(50);
         m_hackTvLib->setTxAmpEnable(true);
 
         m_hackTvLib->setTxModulationType(m_currentModulationType);
@@ -201,16 +306,39 @@ bool SdrDevice::reinitialize(const std::string& mode)
             m_hackTvLib->setVgaGain(m_currentVgaGain);
             m_hackTvLib->setLnaGain(m_currentLnaGain);
             m_hackTvLib->setRxAmpGain(m_currentRxAmpGain);
+            // TX forced the amp on; a warm switch would otherwise keep it
+            m_hackTvLib->setAmpEnable(m_currentAmpEnable);
         }
     }
+}
+
+// RX <-> TX on the open HackRF: HackTvLib keeps the device and both
+// directions' contexts, only the settings of the new one are applied.
+// false: reinitialize() instead.
+bool SdrDevice::switchWarm(bool tx)
+{
+    if (!m_hackTvLib || m_deviceType != "hackrf" || !m_hackTvLib->isDeviceReady()) {
+        return false;
+    }
 
+    // The RX callback (libusb thread) drops blocks once its acquire load
+    // sees TX; the release store is published before streaming turns round
+    const bool wasTx = m_isTxMode.load(std::memory_order_acquire);
+    m_isTxMode.store(tx, std::memory_order_release);
+    if (!(tx ? m_hackTvLib->switchToTx() : m_hackTvLib->switchToRx())) {
+        m_isTxMode.store(wasTx, std::memory_order_release);
+        return false;
+    }
+
+    bumpTuningEpoch();
+    applyModeSettings(tx);
     return true;
 }
 
 bool SdrDevice::switchToRx()
 {
     // Already in RX mode and running - skip reinitialize
-    if (!m_isTxMode && m_hackTvLib && m_hackTvLib->isInitialized()) {
+    if (!m_isTxMode.load(std::memory_order_acquire) && m_hackTvLib && m_hackTvLib->isInitialized()) {
         qDebug() << "Already in RX mode, skipping reinitialize";
         emit statusMessage("Already in RX mode");
         return true;
@@ -218,11 +346,13 @@ bool SdrDevice::switchToRx()
 
     qDebug() << "Switching to RX mode...";
 
-    if (!reinitialize("rx")) {
+    const int64_t startUs = LatencyHistogram::steadyUs();
+    if (!switchWarm(false) && !reinitialize("rx")) {
         return false;
     }
+    m_latency.stage("mode.switch").record(LatencyHistogram::steadyUs() - startUs);
 
-    m_isTxMode = false;
+    m_isTxMode.store(false, std::memory_order_release);
     emit parameterChanged("Mode", "RX");
     emit statusMessage("Switched to RX mode");
     qDebug() << "RX mode active";
@@ -232,7 +362,7 @@ bool SdrDevice::switchToRx()
 bool SdrDevice::forceRestart()
 {
     qDebug() << "Force restart with device:" << QString::fromStdString(m_deviceType);
-    m_isTxMode = true;  // force switchToRx to actually reinitialize
+    m_isTxMode.store(true, std::memory_order_release);  // force switchToRx to actually reinitialize
     return switchToRx();
 }
 
@@ -245,13 +375,13 @@ bool SdrDevice::switchToTx()
         return false;
     }
 
-    txRingReset();
-
-    if (!reinitialize("tx")) {
+    const int64_t startUs = LatencyHistogram::steadyUs();
+    if (!switchWarm(true) && !reinitialize("tx")) {
         return false;
     }
+    m_latency.stage("mode.switch").record(LatencyHistogram::steadyUs() - startUs);
 
-    m_isTxMode = true;
+    m_isTxMode.store(true, std::memory_order_release);
     emit parameterChanged("Mode", "TX");
     emit statusMessage("Switched to TX mode");
     qDebug() << "TX mode active";
@@ -268,18 +398,15 @@ bool SdrDevice::startTcpServer(quint16 dataPort, quint16 controlPort, quint16 au
     m_controlPort = controlPort;
     m_audioPort = audioPort;
 
-    // Start data server (IQ output)
-    if (!m_tcpServer) {
-        m_tcpServer = new QTcpServer(this);
-        m_tcpServer->setMaxPendingConnections(10);
-
-        connect(m_tcpServer, &QTcpServer::newConnection,
-                this, &SdrDevice::onNewConnection);
-
-        if (!m_tcpServer->listen(QHostAddress::Any, dataPort)) {
-            emit errorOccurred(QString("Failed to start data server: %1").arg(m_tcpServer->errorString()));
-            delete m_tcpServer;
-            m_tcpServer = nullptr;
+    // Start data server (IQ output), on the network thread. New connections
+    // go to the radio their host selected.
+    if (!m_streamer->isListening()) {
+        m_streamer->setRouter([this](const QHostAddress& address) {
+            return deviceForHost(address)->m_streamer;
+        });
+        QString error;
+        if (!m_streamer->listen(dataPort, &error)) {
+            emit errorOccurred(QString("Failed to start data server: %1").arg(error));
             return false;
         }
 
@@ -331,18 +458,11 @@ bool SdrDevice::startTcpServer(quint16 dataPort, quint16 controlPort, quint16 au
 void SdrDevice::stopTcpServer()
 {
     // Stop data server
-    if (m_tcpServer) {
-        for (QTcpSocket* client : m_clients) {
-            client->disconnectFromHost();
-            if (client->state() != QAbstractSocket::UnconnectedState) {
-                client->waitForDisconnected(1000);
-            }
-            client->deleteLater();
-        }
-        m_clients.clear();
-        m_tcpServer->close();
-        m_tcpServer->deleteLater();
-        m_tcpServer = nullptr;
+    if (m_streamer->isListening()) {
+        m_streamer->close();
+    }
+    if (m_rtlStreamer->isListening()) {
+        m_rtlStreamer->close();
     }
 
     // Stop control server
@@ -380,13 +500,13 @@ void SdrDevice::stopTcpServer()
 
 bool SdrDevice::isTcpServerRunning() const
 {
-    return (m_tcpServer && m_tcpServer->isListening()) &&
+    return m_streamer->isListening() &&
            (m_controlServer && m_controlServer->isListening());
 }
 
 int SdrDevice::getConnectedClientsCount() const
 {
-    return m_clients.size();
+    return m_streamer->clientCount();
 }
 
 int SdrDevice::getConnectedControlClientsCount() const
@@ -394,64 +514,6 @@ int SdrDevice::getConnectedControlClientsCount() const
     return m_controlClients.size();
 }
 
-// ============================================================
-// Data Server Slots (IQ output)
-// ============================================================
-
-void SdrDevice::onNewConnection()
-{
-    while (m_tcpServer->hasPendingConnections()) {
-        QTcpSocket* clientSocket = m_tcpServer->nextPendingConnection();
-        if (!clientSocket) continue;
-
-        clientSocket->setSocketOption(QAbstractSocket::LowDelayOption, 1);
-        clientSocket->setSocketOption(QAbstractSocket::KeepAliveOption, 1);
-        clientSocket->setReadBufferSize(0);
-        clientSocket->setSocketOption(QAbstractSocket::SendBufferSizeSocketOption, 1024 * 1024);
-
-        connect(clientSocket, &QTcpSocket::disconnected,
-                this, &SdrDevice::onClientDisconnected);
-        connect(clientSocket, &QTcpSocket::errorOccurred,
-                this, &SdrDevice::onSocketError);
-
-        m_clients.append(clientSocket);
-
-        QString clientAddress = QString("%1:%2")
-                                    .arg(clientSocket->peerAddress().toString())
-                                    .arg(clientSocket->peerPort());
-
-        emit clientConnected(clientAddress);
-        emit statusMessage(QString("Data client connected: %1 (Total: %2)")
-                               .arg(clientAddress).arg(m_clients.size()));
-    }
-}
-
-void SdrDevice::onClientDisconnected()
-{
-    QTcpSocket* client = qobject_cast<QTcpSocket*>(sender());
-    if (!client) return;
-
-    QString clientAddress = QString("%1:%2")
-                                .arg(client->peerAddress().toString())
-                                .arg(client->peerPort());
-
-    m_clients.removeOne(client);
-    client->deleteLater();
-
-    emit clientDisconnected(clientAddress);
-    emit statusMessage(QString("Data client disconnected: %1 (Remaining: %2)")
-                           .arg(clientAddress).arg(m_clients.size()));
-}
-
-void SdrDevice::onSocketError(QAbstractSocket::SocketError error)
-{
-    QTcpSocket* client = qobject_cast<QTcpSocket*>(sender());
-    if (!client) return;
-    qDebug() << "Data socket error:" << error << client->errorString();
-    m_clients.removeOne(client);
-    client->deleteLater();
-}
-
 // ============================================================
 // Control Server Slots
 // ============================================================
@@ -483,7 +545,10 @@ void SdrDevice::onNewControlConnection()
             QString("HackRF TCP IQ Server v3.0 (Radio Mode) [%1]\n"
                     "Supports RX and TX with FM/AM modulation\n"
                     "Type HELP for available commands.\n"
-                    "Ready.\n").arg(deviceName);
+                    "%2"
+                    "Ready.\n").arg(deviceName)
+                .arg(m_devices.isEmpty() ? QString()
+                     : QString("%1 radios, see LIST_DEVICES and SELECT_DEVICE.\n").arg(m_devices.size() + 1));
 
         clientSocket->write(welcome.toUtf8());
         clientSocket->flush();
@@ -500,6 +565,7 @@ void SdrDevice::onControlClientDisconnected()
                                 .arg(client->peerPort());
 
     m_controlClients.removeOne(client);
+    m_controlDevices.remove(client);
     client->deleteLater();
 
     emit controlClientDisconnected(clientAddress);
@@ -511,7 +577,24 @@ void SdrDevice::onControlDataReceived()
     QTcpSocket* client = qobject_cast<QTcpSocket*>(sender());
     if (!client) return;
 
-    while (client->canReadLine()) {
+    for (;;) {
+        // Binary batch (ControlBatch) or a text line, in any mix
+        if (client->peek(4) == "HRCM") {
+            QByteArray header = client->peek(ControlBatch::HEADER);
+            int size = ControlBatch::frameSize(header.constData(), header.size());
+            if (size < 0) {
+                // No way to find the next command after a broken frame
+                qDebug() << "Bad control frame, closing" << client->peerAddress().toString();
+                client->write("ERROR: Bad control frame\n");
+                client->disconnectFromHost();
+                return;
+            }
+            if (size == 0 || client->bytesAvailable() < size) return;
+            processControlBatch(client, client->read(size));
+            continue;
+        }
+
+        if (!client->canReadLine()) return;
         QByteArray data = client->readLine();
         QString command = QString::fromUtf8(data).trimmed();
 
@@ -528,6 +611,7 @@ void SdrDevice::onControlSocketError(QAbstractSocket::SocketError error)
     if (!client) return;
     qDebug() << "Control socket error:" << error << client->errorString();
     m_controlClients.removeOne(client);
+    m_controlDevices.remove(client);
     client->deleteLater();
 }
 
@@ -552,6 +636,9 @@ void SdrDevice::onNewAudioConnection()
                 this, &SdrDevice::onAudioSocketError);
 
         m_audioClients.append(clientSocket);
+        SdrDevice* device = deviceForHost(clientSocket->peerAddress());
+        device->m_txAudio.addClient(reinterpret_cast<quintptr>(clientSocket));
+        m_audioDevices.insert(clientSocket, device);
 
         QString clientAddress = QString("%1:%2")
                                     .arg(clientSocket->peerAddress().toString())
@@ -568,6 +655,9 @@ void SdrDevice::onAudioClientDisconnected()
     if (!client) return;
 
     m_audioClients.removeOne(client);
+    if (SdrDevice* device = m_audioDevices.take(client)) {
+        device->m_txAudio.removeClient(reinterpret_cast<quintptr>(client));
+    }
     client->deleteLater();
 
     qDebug() << "Audio client disconnected";
@@ -582,14 +672,19 @@ void SdrDevice::onAudioDataReceived()
     QByteArray data = client->readAll();
     if (data.isEmpty()) return;
 
-    if (!m_isTxMode || !m_hackTvLib || !m_hackTvLib->isDeviceReady()) return;
-
-    const float* monoData = reinterpret_cast<const float*>(data.constData());
-    size_t monoCount = data.size() / sizeof(float);
+    // The radio this host selected; the intake moves along with a new selection
+    const quintptr id = reinterpret_cast<quintptr>(client);
+    SdrDevice* device = deviceForHost(client->peerAddress());
+    SdrDevice* owner = m_audioDevices.value(client, nullptr);
+    if (owner != device) {
+        if (owner) owner->m_txAudio.removeClient(id);
+        device->m_txAudio.addClient(id);
+        m_audioDevices.insert(client, device);
+    }
 
-    // Write MONO directly to HackRfDevice ring buffer via DLL
-    // writeExternalAudio handles mono->stereo conversion internally
-    m_hackTvLib->writeExternalAudio(monoData, monoCount);
+    // Parsed in RX too, so the framing survives a mode switch; only the
+    // timer below plays it out
+    device->m_txAudio.receive(id, data.constData(), data.size(), m_audioClock.nsecsElapsed() / 1000);
 }
 
 void SdrDevice::onAudioSocketError(QAbstractSocket::SocketError error)
@@ -598,19 +693,98 @@ void SdrDevice::onAudioSocketError(QAbstractSocket::SocketError error)
     if (!client) return;
     qDebug() << "Audio socket error:" << error << client->errorString();
     m_audioClients.removeOne(client);
+    if (SdrDevice* device = m_audioDevices.take(client)) {
+        device->m_txAudio.removeClient(reinterpret_cast<quintptr>(client));
+    }
     client->deleteLater();
 }
 
+void SdrDevice::onTxAudioTick()
+{
+    if (!m_isTxMode.load(std::memory_order_acquire) || !m_hackTvLib || !m_hackTvLib->isDeviceReady()) {
+        m_txAudioTimer->stop();
+        return;
+    }
+
+    // Top the device ring up to its depth, silence included, so the TX
+    // callback never runs dry between two ticks
+    const size_t target = TX_AUDIO_RATE * TX_AUDIO_QUEUE_MS / 1000;
+    const size_t queued = m_hackTvLib->externalAudioQueued();
+    if (queued >= target) return;
+
+    const size_t frames = target - queued;
+    m_txAudioPull.resize(frames);
+    m_txAudio.pull(m_txAudioPull.data(), frames);
+    m_hackTvLib->writeExternalAudio(m_txAudioPull.data(), frames);
+}
+
 // ============================================================
 // Control Command Processing (RX + TX)
 // ============================================================
 
 void SdrDevice::processControlCommand(QTcpSocket* client, const QString& command)
+{
+    // Text replies would land inside the binary stream of FETCH_DUMP
+    if (client->property("dumpTransfer").toBool()) {
+        qDebug() << "Ignoring command during dump transfer:" << command;
+        return;
+    }
+
+    QString response = executeControlCommand(client, command);
+    if (!response.isEmpty()) {
+        client->write(response.toUtf8());
+        client->flush();
+    }
+}
+
+void SdrDevice::processControlBatch(QTcpSocket* client, const QByteArray& frame)
+{
+    if (client->property("dumpTransfer").toBool()) {
+        qDebug() << "Ignoring control batch during dump transfer";
+        return;
+    }
+
+    ControlBatch batch;
+    if (!ControlBatch::decode(frame, &batch, nullptr)) {
+        qDebug() << "Bad control batch from" << client->peerAddress().toString();
+        client->write("ERROR: Bad control frame\n");
+        client->disconnectFromHost();
+        return;
+    }
+
+    // Same parser as the text protocol, one reply frame for the lot
+    ControlBatch replies;
+    for (const ControlBatch::Message& message : batch.messages()) {
+        QString command = ControlBatch::toCommand(message);
+        if (command.isEmpty()) {
+            replies.addReply(QString("ERROR: Unknown opcode %1\n").arg(static_cast<int>(message.opcode)));
+        } else if (command.section(':', 0, 0).toUpper() == "FETCH_DUMP") {
+            replies.addReply("ERROR: FETCH_DUMP needs the text protocol\n");
+        } else {
+            qDebug() << "Control command received (batch):" << command;
+            replies.addReply(executeControlCommand(client, command));
+        }
+    }
+
+    client->write(replies.encode(m_controlDevices.value(client, this)->m_tuningEpoch.load()));
+    client->flush();
+}
+
+// Runs one command and returns the reply text; FETCH_DUMP writes its own
+QString SdrDevice::executeControlCommand(QTcpSocket* client, const QString& command)
 {
     QStringList parts = command.split(':');
     QString cmd = parts[0].toUpper();
     QString response;
 
+    // Everything else goes to the radio this connection selected
+    if (cmd != "LIST_DEVICES" && cmd != "SELECT_DEVICE") {
+        SdrDevice* device = m_controlDevices.value(client, this);
+        if (device != this) {
+            return device->executeControlCommand(client, command);
+        }
+    }
+
     if (cmd == "SET_FREQ" && parts.size() == 2) {
         bool ok;
         uint64_t freq = parts[1].toULongLong(&ok);
@@ -735,17 +909,22 @@ void SdrDevice::processControlCommand(QTcpSocket* client, const QString& command
         QString dev = parts[1].toLower().trimmed();
         if (dev == "hackrf" || dev == "rtlsdr") {
             std::string oldDevice = m_deviceType;
+            std::string oldSerial = m_deviceSerial;
             m_deviceType = dev.toStdString();
+            if (m_deviceType != oldDevice) {
+                m_deviceSerial.clear();     // a serial names one radio of one type
+            }
             // Re-initialize with new device
-            if (m_isTxMode && dev == "rtlsdr") {
-                m_isTxMode = false;
+            if (m_isTxMode.load(std::memory_order_acquire) && dev == "rtlsdr") {
+                m_isTxMode.store(false, std::memory_order_release);
             }
-            QString modeName = m_isTxMode ? "tx" : "rx";
+            QString modeName = m_isTxMode.load(std::memory_order_acquire) ? "tx" : "rx";
             if (reinitialize(modeName.toStdString())) {
                 response = QString("OK: Device switched to %1\n").arg(dev.toUpper());
                 emit parameterChanged("Device", dev.toUpper());
             } else {
                 m_deviceType = oldDevice;  // revert on failure
+                m_deviceSerial = oldSerial;
                 response = QString("ERROR: Failed to switch to %1\n").arg(dev.toUpper());
             }
         } else {
@@ -774,6 +953,191 @@ void SdrDevice::processControlCommand(QTcpSocket* client, const QString& command
     else if (cmd == "GET_STATUS") {
         response = getCurrentStatus();
     }
+    else if (cmd == "SET_DDC" && (parts.size() == 3 || parts.size() == 4)) {
+        bool okOffset, okBw, okPort = true;
+        double offset = parts[1].toDouble(&okOffset);
+        double bandwidth = parts[2].toDouble(&okBw);
+        int port = (parts.size() == 4) ? parts[3].toInt(&okPort) : 0;
+        QList<quint64> targets = findDataClients(client, port);
+
+        if (!okOffset || !okBw || !okPort ||
+            std::abs(offset) >= m_currentSampleRate / 2.0 ||
+            bandwidth < 1000.0 || bandwidth > m_currentSampleRate) {
+            response = "ERROR: Invalid DDC (offset within +/- sample rate / 2, bandwidth 1 kHz - sample rate)\n";
+        } else if (targets.isEmpty()) {
+            response = "ERROR: No data connection from this host, connect to the data port first\n";
+        } else {
+            IqStreamer::DdcInfo info;
+            m_streamer->setDdc(targets, m_currentSampleRate, offset, bandwidth, &info);
+            response = QString("OK: DDC offset %1 Hz, bandwidth %2 Hz -> %3 S/s ci16_le "
+                               "(decimation %4, %5 taps, %6 client(s))\n")
+                           .arg(offset).arg(bandwidth)
+                           .arg(info.outputRate, 0, 'f', 1)
+                           .arg(info.decimation).arg(info.taps)
+                           .arg(targets.size());
+            emit parameterChanged("DDC", QString("%1 Hz / %2 Hz").arg(offset).arg(bandwidth));
+        }
+    }
+    else if (cmd == "CLEAR_DDC") {
+        int port = (parts.size() == 2) ? parts[1].toInt() : 0;
+        int cleared = m_streamer->clearDdc(findDataClients(client, port));
+        response = QString("OK: Full-rate IQ restored for %1 client(s)\n").arg(cleared);
+    }
+    else if (cmd == "SET_BACKLOG" && parts.size() >= 2 && parts.size() <= 4) {
+        // SET_BACKLOG:<policy>[:<blocks>[:<port>]]
+        IqStreamer::DropPolicy policy;
+        bool okBlocks = true, okPort = true;
+        int blocks = (parts.size() >= 3) ? parts[2].toInt(&okBlocks) : 16;
+        int port = (parts.size() == 4) ? parts[3].toInt(&okPort) : 0;
+
+        if (!IqStreamer::parsePolicy(parts[1], &policy) || !okBlocks || !okPort ||
+            blocks < 1 || blocks > 4096) {
+            response = "ERROR: Invalid backlog (drop-oldest, drop-newest or disconnect; 1-4096 blocks)\n";
+        } else {
+            int count = m_streamer->setPolicy(findDataClients(client, port), policy, blocks);
+            if (count == 0) {
+                response = "ERROR: No data connection from this host, connect to the data port first\n";
+            } else {
+                response = QString("OK: Backlog %1, %2 blocks for %3 client(s)\n")
+                               .arg(IqStreamer::policyName(policy)).arg(blocks).arg(count);
+            }
+        }
+    }
+    else if (cmd == "SET_ENCODING" && (parts.size() == 2 || parts.size() == 3)) {
+        // SET_ENCODING:<raw|bfp4|deflate>[:<port>]
+        IqCodec::Encoding encoding;
+        bool okPort = true;
+        int port = (parts.size() == 3) ? parts[2].toInt(&okPort) : 0;
+
+        if (!IqCodec::parseEncoding(parts[1], &encoding) || !okPort) {
+            response = "ERROR: Invalid encoding (raw, bfp4 or deflate)\n";
+        } else {
+            int count = m_streamer->setEncoding(findDataClients(client, port), encoding);
+            if (count == 0) {
+                response = "ERROR: No data connection from this host, connect to the data port first\n";
+            } else {
+                response = QString("OK: Encoding %1 (framed) for %2 client(s)\n")
+                               .arg(IqCodec::encodingName(encoding)).arg(count);
+            }
+        }
+    }
+    else if (cmd == "SET_SPECTRUM" && (parts.size() == 7 || parts.size() == 8)) {
+        // SET_SPECTRUM:<bins>:<fps>:<averages>:<min dB>:<max dB>:<u8|f16>[:<port>]
+        SpectrumAnalyzer::Config config;
+        SpectrumAnalyzer::BinFormat format;
+        bool okSize, okFps, okAvg, okMin, okMax, okPort = true;
+        config.size = parts[1].toInt(&okSize);
+        config.fps = parts[2].toInt(&okFps);
+        config.averages = parts[3].toInt(&okAvg);
+        float minDb = parts[4].toFloat(&okMin);
+        float maxDb = parts[5].toFloat(&okMax);
+        int port = (parts.size() == 8) ? parts[7].toInt(&okPort) : 0;
+
+        if (!okSize || !okFps || !okAvg || !okMin || !okMax || !okPort ||
+            !SpectrumAnalyzer::isValid(config) || maxDb <= minDb ||
+            !SpectrumAnalyzer::parseFormat(parts[6], &format)) {
+            response = QString("ERROR: Invalid spectrum (bins power of two %1-%2, fps 1-%3, "
+                               "averages 1-%4, min dB < max dB, u8 or f16)\n")
+                           .arg(SpectrumAnalyzer::MIN_SIZE).arg(SpectrumAnalyzer::MAX_SIZE)
+                           .arg(SpectrumAnalyzer::MAX_FPS).arg(SpectrumAnalyzer::MAX_AVERAGES);
+        } else {
+            int count = m_streamer->setSpectrum(findDataClients(client, port), config, format, minDb, maxDb);
+            if (count == 0) {
+                response = "ERROR: No data connection from this host, connect to the data port first\n";
+            } else {
+                const int frameBytes = SpectrumAnalyzer::HEADER +
+                                       config.size * (format == SpectrumAnalyzer::BinsF16 ? 2 : 1);
+                response = QString("OK: Spectrum %1 bins, %2 fps, %3 averages, %4 (%5 KB/s) for %6 client(s)\n")
+                               .arg(config.size).arg(config.fps).arg(config.averages)
+                               .arg(SpectrumAnalyzer::formatName(format))
+                               .arg(frameBytes * config.fps / 1024.0, 0, 'f', 1)
+                               .arg(count);
+            }
+        }
+    }
+    else if (cmd == "CLEAR_SPECTRUM") {
+        int port = (parts.size() == 2) ? parts[1].toInt() : 0;
+        int cleared = m_streamer->clearSpectrum(findDataClients(client, port));
+        response = QString("OK: IQ restored for %1 client(s)\n").arg(cleared);
+    }
+    else if (cmd == "DUMP" || cmd.startsWith("DUMP ")) {
+        // DUMP, DUMP:<seconds> or DUMP <seconds>
+        QString arg = (parts.size() == 2) ? parts[1] : cmd.mid(4).trimmed();
+        bool ok = true;
+        double seconds = arg.isEmpty() ? 0.0 : arg.toDouble(&ok);
+        if (!m_timeMachine.isEnabled()) {
+            response = "ERROR: Time machine disabled (start with --time-machine <seconds>)\n";
+        } else if (!ok || seconds < 0.0) {
+            response = "ERROR: Invalid dump length in seconds\n";
+        } else if (m_timeMachine.isDumping()) {
+            response = "ERROR: Dump already in progress\n";
+        } else if (m_timeMachine.dump(seconds, m_dumpDir, m_currentSampleRate, m_currentFrequency,
+                                      [this](const IqTimeMachine::DumpResult& result) {
+                                          QMetaObject::invokeMethod(this, [this, result]() {
+                                              onDumpFinished(result);
+                                          }, Qt::QueuedConnection);
+                                      })) {
+            response = QString("OK: Dumping %1 s of IQ to %2\n")
+                           .arg(seconds > 0.0 ? QString::number(seconds) : QString("all"))
+                           .arg(m_dumpDir);
+        } else {
+            response = "ERROR: Nothing to dump yet\n";
+        }
+    }
+    else if (cmd == "GET_DUMPS") {
+        response = listDumps();
+    }
+    else if (cmd == "FETCH_DUMP" && parts.size() == 2) {
+        sendDumpFile(client, parts[1].trimmed());
+        return QString();
+    }
+    else if (cmd == "GET_MULTICAST") {
+        if (m_multicaster.isRunning()) {
+            response = QString("MULTICAST:%1:%2\n").arg(m_multicaster.group().toString()).arg(m_multicaster.port());
+        } else if (m_host) {
+            response = "ERROR: Multicast carries the first radio (#0) only\n";
+        } else {
+            response = "ERROR: Multicast is not enabled (start HackRfTcp with --multicast)\n";
+        }
+    }
+    else if (cmd == "LIST_DEVICES") {
+        response = (m_host ? m_host : this)->listDevices(client);
+    }
+    else if (cmd == "SELECT_DEVICE" && (parts.size() == 2 || parts.size() == 3)) {
+        // SELECT_DEVICE:<serial or #>[:<port>]
+        bool okPort = true;
+        int port = (parts.size() == 3) ? parts[2].toInt(&okPort) : 0;
+        if (!okPort) {
+            response = "ERROR: Invalid data port\n";
+        } else {
+            response = (m_host ? m_host : this)->selectDevice(client, parts[1].trimmed(), port);
+        }
+    }
+    else if (cmd == "GET_AUDIO") {
+        response = QString("AUDIO: %1\n").arg(m_txAudio.statusText());
+    }
+    else if (cmd == "SET_AUDIO_BUFFER" && parts.size() == 3) {
+        // SET_AUDIO_BUFFER:<min ms>:<max ms>
+        bool okMin, okMax;
+        double minMs = parts[1].toDouble(&okMin);
+        double maxMs = parts[2].toDouble(&okMax);
+        if (!okMin || !okMax || minMs < 5.0 || maxMs < 2.0 * minMs || maxMs > 5000.0) {
+            response = "ERROR: Invalid audio buffer (min >= 5 ms, max >= 2 x min, max <= 5000 ms)\n";
+        } else {
+            m_txAudio.setDepthLimits(minMs, maxMs);
+            response = QString("OK: TX audio buffer %1-%2 ms\n").arg(minMs).arg(maxMs);
+        }
+    }
+    else if (cmd == "GET_LATENCY") {
+        response = latencyReport();
+    }
+    else if (cmd == "RESET_LATENCY") {
+        m_latency.reset();
+        if (m_hackTvLib) {
+            m_hackTvLib->latency().reset();
+        }
+        response = "OK: Latency histograms cleared\n";
+    }
     else if (cmd == "HELP") {
         response =
             "Available commands:\n"
@@ -791,14 +1155,53 @@ void SdrDevice::processControlCommand(QTcpSocket* client, const QString& command
             "  SWITCH_RX                     - Switch to receive mode\n"
             "  SWITCH_TX                     - Switch to transmit mode\n"
             "  GET_STATUS                    - Get current settings\n"
-            "  HELP                          - Show this help\n";
+            "  LIST_DEVICES                  - Radios served by this server\n"
+            "  SELECT_DEVICE:<serial or #>[:<port>] - Send the following commands, and\n"
+            "                                  this host's data and audio, to that radio\n"
+            "  SET_DDC:<offset>:<bw>[:<port>] - Stream only a sub-band to this host's data\n"
+            "                                  connection(s) as ci16_le at a reduced rate\n"
+            "  CLEAR_DDC[:<port>]            - Back to full-rate int8 IQ\n"
+            "  SET_BACKLOG:<policy>[:<blocks>[:<port>]] - Slow data client handling:\n"
+            "                                  drop-oldest, drop-newest or disconnect\n"
+            "  SET_ENCODING:<enc>[:<port>]   - Framed data port: raw, bfp4 (4-bit, lossy)\n"
+            "                                  or deflate (lossless)\n"
+            "  SET_SPECTRUM:<bins>:<fps>:<avg>:<min dB>:<max dB>:<u8|f16>[:<port>]\n"
+            "                                - Averaged FFT frames (HRSP) instead of IQ\n"
+            "                                  on this host's data connection(s)\n"
+            "  CLEAR_SPECTRUM[:<port>]       - Back to IQ\n"
+            "  DUMP[:<seconds>]              - Write the last seconds of IQ to disk (async)\n"
+            "  GET_DUMPS                     - List finished dumps\n"
+            "  FETCH_DUMP:<name>             - Download a dump (DUMP_DATA header + raw bytes)\n"
+            "  GET_MULTICAST                 - Multicast IQ group and port (MULTICAST:<group>:<port>)\n"
+            "  GET_AUDIO                     - TX audio buffer depth, jitter, drift, underruns\n"
+            "  SET_AUDIO_BUFFER:<min ms>:<max ms> - TX audio jitter buffer bounds\n"
+            "  GET_LATENCY                   - Per-stage latency histograms (LATENCY:<n>, then\n"
+            "                                  <stage> n= mean= p50= p90= p99= max= in ms)\n"
+            "  RESET_LATENCY                 - Clear the latency histograms\n"
+            "  HELP                          - Show this help\n"
+            "Any of these can also be sent in binary batches (HRCM frames, see controlbatch.h).\n";
     }
     else {
         response = "ERROR: Unknown command. Type HELP for available commands.\n";
     }
 
-    client->write(response.toUtf8());
-    client->flush();
+    return response;
+}
+
+// "LATENCY:<n>" and one line per stage with samples, USB callbacks first
+QString SdrDevice::latencyReport() const
+{
+    // No HackTvLib before the device opens or after it closes
+    auto stages = m_hackTvLib ? m_hackTvLib->latency().summaries()
+                              : decltype(m_latency.summaries())();
+    const auto own = m_latency.summaries();
+    stages.insert(stages.end(), own.begin(), own.end());
+
+    QString response = QString("LATENCY:%1\n").arg(stages.size());
+    for (const auto& stage : stages) {
+        response += QString::fromStdString(LatencyRecorder::formatLine(stage.first, stage.second));
+    }
+    return response;
 }
 
 QString SdrDevice::getCurrentStatus()
@@ -821,8 +1224,15 @@ QString SdrDevice::getCurrentStatus()
                "  Control Clients: %16\n"
                "  Audio Clients:  %17\n"
                "  Data Sent:      %18 MB\n"
-               ).arg(QString::fromStdString(m_deviceType).toUpper())
-        .arg(m_isTxMode ? "TX" : "RX")
+               "  Time Machine:   %19\n"
+               "  Data Streams:   %20\n"
+               "  rtl_tcp:        %21\n"
+               "  Multicast:      %22\n"
+               "  Shared Memory:  %23\n"
+               "  TX Audio:       %24\n"
+               ).arg(QString::fromStdString(m_deviceType).toUpper() +
+                     (m_deviceSerial.empty() ? QString() : " " + QString::fromStdString(m_deviceSerial)))
+        .arg(m_isTxMode.load(std::memory_order_acquire) ? "TX" : "RX")
         .arg(m_currentFrequency)
         .arg(m_currentFrequency / 1000000.0, 0, 'f', 3)
         .arg(m_currentSampleRate)
@@ -835,10 +1245,136 @@ QString SdrDevice::getCurrentStatus()
         .arg(m_currentModulationIndex)
         .arg(m_currentAmplitude)
         .arg(m_currentModulationType == 0 ? "NFM" : m_currentModulationType == 1 ? "WFM" : "AM")
-        .arg(m_clients.size())
+        .arg(m_streamer->clientCount())
         .arg(m_controlClients.size())
         .arg(m_audioClients.size())
-        .arg(m_totalBytesSent.load() / (1024.0 * 1024.0), 0, 'f', 2);
+        .arg(m_streamer->bytesSent() / (1024.0 * 1024.0), 0, 'f', 2)
+        .arg(!m_timeMachine.isEnabled() ? QString("OFF")
+             : QString("%1 / %2 s%3%4")
+                   .arg(m_timeMachine.available() / 2.0 / m_currentSampleRate, 0, 'f', 1)
+                   .arg(m_timeMachine.capacity() / 2.0 / m_currentSampleRate, 0, 'f', 1)
+                   .arg(m_timeMachine.isHugePages() ? ", huge pages" : "")
+                   .arg(m_timeMachine.isDumping() ? ", dumping" : ""))
+        .arg(m_streamer->statusText())
+        .arg(!m_rtlStreamer->isListening() ? QString("OFF")
+             : QString("port %1, %2").arg(m_rtlTcpPort).arg(m_rtlStreamer->statusText()))
+        .arg(m_multicaster.statusText())
+        .arg(m_shmBus.statusText())
+        .arg(m_txAudio.statusText()) + threadPlacementStatus();
+}
+
+// --thread / --mlock: what the hot threads actually got
+QString SdrDevice::threadPlacementStatus()
+{
+    QString out;
+    for (const std::string& line : ThreadPlacement::report()) {
+        out += "  Threads:        " + QString::fromStdString(line) + "\n";
+    }
+    return out;
+}
+
+// ============================================================
+// IQ Time Machine
+// ============================================================
+
+bool SdrDevice::enableTimeMachine(double seconds, uint32_t sampleRate, const QString& dumpDir)
+{
+    m_dumpDir = dumpDir;
+
+    // Window plus a little slack for the block being written during a dump
+    size_t bytes = static_cast<size_t>(seconds * sampleRate) * 2 + 4 * 1024 * 1024;
+    if (!m_timeMachine.allocate(bytes)) {
+        emit errorOccurred(QString("Time machine: cannot allocate %1 MB").arg(bytes / (1024 * 1024)));
+        return false;
+    }
+
+    emit statusMessage(QString("Time machine: %1 s at %2 MS/s (%3 MB%4), dumps to %5")
+                           .arg(seconds)
+                           .arg(sampleRate / 1e6)
+                           .arg(m_timeMachine.capacity() / (1024 * 1024))
+                           .arg(m_timeMachine.isHugePages() ? ", huge pages" : "")
+                           .arg(QDir(dumpDir).absolutePath()));
+    return true;
+}
+
+void SdrDevice::onDumpFinished(const IqTimeMachine::DumpResult& result)
+{
+    QString message;
+    if (result.ok) {
+        message = QString("DUMP_DONE:%1:%2:%3\n")
+                      .arg(result.name).arg(result.bytes).arg(result.seconds, 0, 'f', 2);
+        emit statusMessage(QString("Dump written: %1 (%2 s, %3 MB)")
+                               .arg(result.path).arg(result.seconds, 0, 'f', 2)
+                               .arg(result.bytes / (1024.0 * 1024.0), 0, 'f', 1));
+    } else {
+        message = QString("DUMP_FAILED:%1:%2\n").arg(result.name, result.error);
+        emit errorOccurred(QString("Dump %1 failed: %2").arg(result.path, result.error));
+    }
+
+    // Tell every control client, except those in the middle of a binary
+    // transfer; they are all connected to the host
+    for (QTcpSocket* client : (m_host ? m_host : this)->m_controlClients) {
+        if (client->state() == QAbstractSocket::ConnectedState &&
+            !client->property("dumpTransfer").toBool()) {
+            client->write(message.toUtf8());
+            client->flush();
+        }
+    }
+}
+
+QString SdrDevice::listDumps() const
+{
+    QFileInfoList files = QDir(m_dumpDir).entryInfoList(QStringList() << "*.sigmf-data",
+                                                          QDir::Files, QDir::Name);
+    QString response = QString("DUMPS:%1\n").arg(files.size());
+    for (const QFileInfo& info : files) {
+        response += QString("%1 %2\n").arg(info.completeBaseName()).arg(info.size());
+    }
+    return response;
+}
+
+void SdrDevice::sendDumpFile(QTcpSocket* client, const QString& name)
+{
+    // Bare file names only, default to the data half of the SigMF pair
+    QString fileName = name;
+    if (!fileName.endsWith(".sigmf-data") && !fileName.endsWith(".sigmf-meta")) {
+        fileName += ".sigmf-data";
+    }
+    if (fileName.isEmpty() || QFileInfo(fileName).fileName() != fileName || fileName.startsWith('.')) {
+        client->write("ERROR: Invalid dump name\n");
+        return;
+    }
+    if (client->property("dumpTransfer").toBool()) {
+        client->write("ERROR: Transfer already in progress\n");
+        return;
+    }
+
+    QFile* file = new QFile(QDir(m_dumpDir).filePath(fileName), client);
+    if (!file->open(QIODevice::ReadOnly)) {
+        delete file;
+        client->write(QString("ERROR: No such dump: %1\n").arg(name).toUtf8());
+        return;
+    }
+
+    client->setProperty("dumpTransfer", true);
+    client->write(QString("DUMP_DATA:%1:%2\n").arg(fileName).arg(file->size()).toUtf8());
+
+    // Keep a few MB queued in the socket instead of loading the whole file
+    auto pump = [client, file]() {
+        if (!file->isOpen()) return;
+        while (client->bytesToWrite() < 4 * 1024 * 1024) {
+            QByteArray chunk = file->read(1024 * 1024);
+            if (chunk.isEmpty()) {
+                file->close();
+                file->deleteLater();
+                client->setProperty("dumpTransfer", false);
+                return;
+            }
+            client->write(chunk);
+        }
+    };
+    connect(client, &QTcpSocket::bytesWritten, file, [pump](qint64) { pump(); });
+    pump();
 }
 
 // ============================================================
@@ -847,46 +1383,386 @@ QString SdrDevice::getCurrentStatus()
 
 void SdrDevice::handleReceivedData(const int8_t *data, size_t len)
 {
-    if (!data || len == 0) return;
+    // RX callback thread: nothing here may block on a socket
+#ifdef Q_OS_LINUX
+    // Once per capture thread (a restart brings a new one)
+    const int cpu = m_captureCpu.load(std::memory_order_relaxed);
+    if (cpu >= 0 && m_pinnedThread != std::this_thread::get_id()) {
+        m_pinnedThread = std::this_thread::get_id();
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(cpu, &set);
+        int r = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+        qDebug() << "Capture thread of" << deviceId() << (r == 0 ? "pinned to CPU" : "could not be pinned to CPU") << cpu;
+    }
+#endif
+    const quint64 offset = m_totalBytesReceived.fetch_add(len);
+
+    // Straight into the RAM window, no queueing on this thread
+    m_timeMachine.write(data, len);
+
+    // What framed clients learn about the block. The epoch is read when the
+    // block arrives, so a block or two of USB transfers queued before a
+    // retune can still carry the new one.
+    IqCodec::BlockInfo info;
+    info.sequence = m_blockSequence++;
+    info.sampleIndex = offset / 2;
+    info.frequency = m_rxFrequency.load(std::memory_order_relaxed);
+    info.sampleRate = m_rxSampleRate.load(std::memory_order_relaxed);
+    info.epoch = m_tuningEpoch.load(std::memory_order_acquire);
+    if (info.epoch != m_lastBlockEpoch) {
+        info.flags = IqCodec::FLAG_RETUNED;
+        m_lastBlockEpoch = info.epoch;
+    }
+    info.timeUs = m_hackTvLib->blockTimeUs();
 
-    m_totalBytesReceived += len;
+    // One copy, shared by every data client on the network thread
+    m_streamer->pushBlock(data, len, info);
+    m_shmBus.pushBlock(data, len, info);
+    m_rtlStreamer->pushBlock(data, len);
+    m_multicaster.pushBlock(data, len);
+}
 
-    if (!m_clients.isEmpty()) {
-        QByteArray dataArray(reinterpret_cast<const char*>(data), static_cast<int>(len));
-        broadcastData(dataArray);
+// ============================================================
+// Several radios
+// ============================================================
+
+SdrDevice* SdrDevice::addDevice()
+{
+    if (m_host) {
+        return m_host->addDevice();
+    }
+
+    SdrDevice* device = new SdrDevice(this, this);
+    m_devices.append(device);
+    return device;
+}
+
+QString SdrDevice::deviceId() const
+{
+    QString id = QString::fromStdString(m_deviceType);
+    if (!m_deviceSerial.empty()) {
+        id += ":" + QString::fromStdString(m_deviceSerial);
     }
+    return id;
 }
 
-void SdrDevice::broadcastData(const QByteArray& data)
+// Host only: a serial (or its tail, as hackrf_open_by_serial takes it),
+// the full id, or the number LIST_DEVICES shows
+SdrDevice* SdrDevice::findDevice(const QString& name) const
 {
-    if (m_clients.isEmpty()) return;
+    QList<SdrDevice*> all;
+    all.append(const_cast<SdrDevice*>(this));
+    all.append(m_devices);
+
+    for (SdrDevice* device : all) {
+        const QString serial = QString::fromStdString(device->m_deviceSerial);
+        if (name.compare(device->deviceId(), Qt::CaseInsensitive) == 0 ||
+            (!serial.isEmpty() && name.compare(serial, Qt::CaseInsensitive) == 0)) {
+            return device;
+        }
+    }
+    for (SdrDevice* device : all) {
+        const QString serial = QString::fromStdString(device->m_deviceSerial);
+        if (name.size() >= 4 && serial.endsWith(name, Qt::CaseInsensitive)) {
+            return device;
+        }
+    }
 
-    removeDisconnectedClients();
+    bool ok;
+    int index = name.startsWith('#') ? name.mid(1).toInt(&ok) : name.toInt(&ok);
+    return (ok && index >= 0 && index < all.size()) ? all[index] : nullptr;
+}
 
-    for (QTcpSocket* client : m_clients) {
-        if (client->state() == QAbstractSocket::ConnectedState) {
-            qint64 bytesWritten = client->write(data);
-            if (bytesWritten > 0) {
-                m_totalBytesSent += bytesWritten;
-            }
-            client->flush();
+// Host only, any thread (the data port router runs on the network thread)
+SdrDevice* SdrDevice::deviceForHost(const QHostAddress& address) const
+{
+    std::lock_guard<std::mutex> lock(m_hostMutex);
+    for (const auto& entry : m_hostDevices) {
+        if (entry.first.isEqual(address)) {
+            return entry.second;
         }
     }
+    return const_cast<SdrDevice*>(this);
+}
 
-    static quint64 lastEmit = 0;
-    if (m_totalBytesSent - lastEmit > 10 * 1024 * 1024) {
-        emit dataTransferred(m_totalBytesSent);
-        lastEmit = m_totalBytesSent;
+void SdrDevice::setHostDevice(const QHostAddress& address, SdrDevice* device)
+{
+    std::lock_guard<std::mutex> lock(m_hostMutex);
+    m_hostDevices.erase(std::remove_if(m_hostDevices.begin(), m_hostDevices.end(),
+                                       [&address](const std::pair<QHostAddress, SdrDevice*>& entry) {
+                                           return entry.first.isEqual(address);
+                                       }),
+                        m_hostDevices.end());
+    if (device != this) {
+        m_hostDevices.emplace_back(address, device);
     }
 }
 
-void SdrDevice::removeDisconnectedClients()
+// Host only. The control connection follows at once; the host's data
+// connections are moved (one port, or all of them) and later ones, like
+// its audio, arrive at the selected radio. The last selection of a host
+// wins for data and audio.
+QString SdrDevice::selectDevice(QTcpSocket* client, const QString& name, int clientPort)
 {
-    for (int i = m_clients.size() - 1; i >= 0; --i) {
-        if (m_clients[i]->state() != QAbstractSocket::ConnectedState) {
-            QTcpSocket* client = m_clients.takeAt(i);
-            client->deleteLater();
+    SdrDevice* device = findDevice(name);
+    if (!device) {
+        return QString("ERROR: No radio %1, see LIST_DEVICES\n").arg(name);
+    }
+
+    SdrDevice* current = m_controlDevices.value(client, this);
+    int moved = 0;
+    if (current != device) {
+        moved = current->m_streamer->handOver(current->findDataClients(client, clientPort),
+                                              device->m_streamer);
+    }
+
+    if (device == this) {
+        m_controlDevices.remove(client);
+    } else {
+        m_controlDevices.insert(client, device);
+    }
+    setHostDevice(client->peerAddress(), device);
+
+    emit statusMessage(QString("%1 selected %2").arg(client->peerAddress().toString()).arg(device->deviceId()));
+    return QString("OK: %1 selected, %2 data connection(s) moved\n").arg(device->deviceId()).arg(moved);
+}
+
+QString SdrDevice::listDevices(QTcpSocket* client) const
+{
+    QList<SdrDevice*> all;
+    all.append(const_cast<SdrDevice*>(this));
+    all.append(m_devices);
+
+    const SdrDevice* selected = m_controlDevices.value(client, const_cast<SdrDevice*>(this));
+    QString response = QString("DEVICES: %1\n").arg(all.size());
+    for (int i = 0; i < all.size(); i++) {
+        const SdrDevice* device = all[i];
+        response += QString("  #%1 %2  %3  %4 MHz  %5 MS/s  %6 data client(s)%7\n")
+                        .arg(i)
+                        .arg(device->deviceId())
+                        .arg(device->m_isTxMode.load(std::memory_order_acquire) ? "TX" : "RX")
+                        .arg(device->m_currentFrequency / 1000000.0, 0, 'f', 3)
+                        .arg(device->m_currentSampleRate / 1000000.0, 0, 'f', 1)
+                        .arg(device->m_streamer->clientCount())
+                        .arg(device == selected ? "  (selected)" : "");
+    }
+    return response;
+}
+
+// ============================================================
+// Data client lookup
+// ============================================================
+
+QList<quint64> SdrDevice::findDataClients(QTcpSocket* controlClient, int clientPort)
+{
+    // Control and data are separate connections: pair them by host, and by
+    // the client's data socket port when the host has several connections.
+    QList<quint64> ids;
+    for (const IqStreamer::ClientRef& ref : m_streamer->findClients(controlClient->peerAddress(), clientPort)) {
+        ids.append(ref.id);
+    }
+    return ids;
+}
+
+bool SdrDevice::setBacklogPolicy(const QString& policy, int maxBlocks)
+{
+    IqStreamer::DropPolicy p;
+    if (!IqStreamer::parsePolicy(policy, &p) || maxBlocks < 1) {
+        return false;
+    }
+    m_streamer->setDefaultPolicy(p, maxBlocks);
+    qDebug() << "Data backlog:" << maxBlocks << "blocks," << IqStreamer::policyName(p);
+    return true;
+}
+
+void SdrDevice::setSendOptions(const IqStreamer::SendOptions& options)
+{
+    m_streamer->setSendOptions(options);
+    m_rtlStreamer->setSendOptions(options);
+}
+
+// ============================================================
+// rtl_tcp
+// ============================================================
+
+// rtl_tcp command ids (librtlsdr rtl_tcp.c)
+enum RtlTcpCommand {
+    RTL_TCP_SET_FREQ = 0x01,
+    RTL_TCP_SET_SAMPLE_RATE = 0x02,
+    RTL_TCP_SET_GAIN_MODE = 0x03,
+    RTL_TCP_SET_GAIN = 0x04,
+    RTL_TCP_SET_FREQ_CORRECTION = 0x05,
+    RTL_TCP_SET_IF_GAIN = 0x06,
+    RTL_TCP_SET_TEST_MODE = 0x07,
+    RTL_TCP_SET_AGC_MODE = 0x08,
+    RTL_TCP_SET_DIRECT_SAMPLING = 0x09,
+    RTL_TCP_SET_OFFSET_TUNING = 0x0a,
+    RTL_TCP_SET_RTL_XTAL = 0x0b,
+    RTL_TCP_SET_TUNER_XTAL = 0x0c,
+    RTL_TCP_SET_GAIN_BY_INDEX = 0x0d,
+    RTL_TCP_SET_TUNER_BANDWIDTH = 0x0e,
+    RTL_TCP_SET_BIAS_TEE = 0x0f
+};
+
+// The header announces an R820T, so clients offer its gain table (tenths of dB)
+static const int RTL_TCP_TUNER_R820T = 5;
+static const int R820T_GAINS[] = {
+    0, 9, 14, 27, 37, 77, 87, 125, 144, 157, 166, 197, 207, 229, 254,
+    280, 297, 328, 338, 364, 372, 386, 402, 421, 434, 439, 445, 480, 496
+};
+static const int R820T_GAIN_COUNT = sizeof(R820T_GAINS) / sizeof(R820T_GAINS[0]);
+
+bool SdrDevice::startRtlTcpServer(quint16 port)
+{
+    if (m_rtlStreamer->isListening()) return true;
+
+    // "RTL0", tuner type, gain count; all big endian
+    QByteArray header("RTL0");
+    const quint32 fields[] = { RTL_TCP_TUNER_R820T, R820T_GAIN_COUNT };
+    for (quint32 value : fields) {
+        header.append(static_cast<char>((value >> 24) & 0xff));
+        header.append(static_cast<char>((value >> 16) & 0xff));
+        header.append(static_cast<char>((value >> 8) & 0xff));
+        header.append(static_cast<char>(value & 0xff));
+    }
+    m_rtlStreamer->setGreeting(header);
+    m_rtlStreamer->setCommandSize(5);
+    updateRtlTcpFormat();
+
+    QString error;
+    if (!m_rtlStreamer->listen(port, &error)) {
+        emit errorOccurred(QString("Failed to start rtl_tcp server: %1").arg(error));
+        return false;
+    }
+
+    m_rtlTcpPort = port;
+    emit statusMessage(QString("rtl_tcp server started on port %1").arg(port));
+    qDebug() << "rtl_tcp server listening on port:" << port;
+    return true;
+}
+
+bool SdrDevice::startMulticast(const QHostAddress& group, quint16 port, int ttl, int mtu)
+{
+    if (m_multicaster.isRunning()) return true;
+
+    m_multicaster.setTuning(m_currentFrequency, m_currentSampleRate);
+    updateRtlTcpFormat();
+
+    QString error;
+    if (!m_multicaster.start(group, port, ttl, mtu, &error)) {
+        emit errorOccurred(QString("Failed to start multicast: %1").arg(error));
+        return false;
+    }
+
+    emit statusMessage(QString("Multicast IQ to %1:%2 (TTL %3)").arg(group.toString()).arg(port).arg(ttl));
+    return true;
+}
+
+bool SdrDevice::startSharedMemory(size_t ringBytes)
+{
+    if (m_shmBus.isRunning()) return true;
+
+    // Named after the data port, so clients find it without asking
+    QString error;
+    if (!m_shmBus.start(m_dataPort, ringBytes, &error)) {
+        emit errorOccurred(QString("Shared memory IQ unavailable: %1").arg(error));
+        return false;
+    }
+
+    emit statusMessage(QString("Shared memory IQ for local clients: @%1 (%2 MB)")
+                           .arg(IqShmBus::socketName(m_dataPort)).arg(ringBytes / (1024 * 1024)));
+    return true;
+}
+
+void SdrDevice::updateRtlTcpFormat()
+{
+    // librtlsdr already delivers offset binary; HackRF int8 needs the sign bit flipped
+    m_rtlStreamer->setOffsetBinary(m_deviceType != "rtlsdr");
+    m_multicaster.setFormat(m_deviceType == "rtlsdr" ? IqMulticaster::FORMAT_CU8
+                                                     : IqMulticaster::FORMAT_CI8);
+}
+
+void SdrDevice::setRtlTcpGain(int gainTenthDb)
+{
+    if (m_deviceType == "rtlsdr") {
+        if (m_hackTvLib) m_hackTvLib->setTunerGain(gainTenthDb);
+        return;
+    }
+
+    // R820T 0-49.6 dB onto HackRF LNA (0-40, 8 dB steps) + VGA (0-62, 2 dB steps),
+    // LNA first for the noise figure
+    int total = std::clamp(gainTenthDb, 0, 496) * 102 / 496;
+    unsigned int lna = static_cast<unsigned int>(std::min(40, total / 8 * 8));
+    unsigned int vga = static_cast<unsigned int>(std::min(62, (total - static_cast<int>(lna)) / 2 * 2));
+    setLnaGain(lna);
+    setVgaGain(vga);
+}
+
+void SdrDevice::handleRtlTcpCommand(quint64 clientId, const QByteArray& command)
+{
+    Q_UNUSED(clientId);
+    if (command.size() != 5) return;
+
+    const uchar* b = reinterpret_cast<const uchar*>(command.constData());
+    const quint32 param = (quint32(b[1]) << 24) | (quint32(b[2]) << 16) |
+                          (quint32(b[3]) << 8) | quint32(b[4]);
+    const bool rtl = (m_deviceType == "rtlsdr");
+
+    switch (b[0]) {
+    case RTL_TCP_SET_FREQ:
+        if (param >= 1000000) {
+            setFrequency(param);
+            emit parameterChanged("Frequency", QString::number(param));
+        }
+        break;
+    case RTL_TCP_SET_SAMPLE_RATE:
+        // rtl_tcp clients ask for dongle rates; HackRF takes 2-20 MS/s
+        if ((rtl && param >= 225001 && param <= 3200000) ||
+            (!rtl && param >= 2000000 && param <= 20000000)) {
+            setSampleRate(param);
+            emit parameterChanged("SampleRate", QString::number(param));
+        } else {
+            qDebug() << "rtl_tcp: sample rate" << param << "not supported by" << QString::fromStdString(m_deviceType);
+        }
+        break;
+    case RTL_TCP_SET_GAIN_MODE:
+        // 0 = automatic; HackRF has no tuner AGC, keep the manual gains
+        if (rtl && m_hackTvLib) m_hackTvLib->setTunerAutoGain(param == 0);
+        break;
+    case RTL_TCP_SET_GAIN:
+        setRtlTcpGain(static_cast<int>(param));
+        emit parameterChanged("Gain", QString::number(param / 10.0, 'f', 1));
+        break;
+    case RTL_TCP_SET_GAIN_BY_INDEX:
+        if (param < static_cast<quint32>(R820T_GAIN_COUNT)) {
+            setRtlTcpGain(R820T_GAINS[param]);
+            emit parameterChanged("Gain", QString::number(R820T_GAINS[param] / 10.0, 'f', 1));
         }
+        break;
+    case RTL_TCP_SET_FREQ_CORRECTION:
+        if (m_hackTvLib) m_hackTvLib->setFreqCorrection(static_cast<int>(param));
+        break;
+    case RTL_TCP_SET_AGC_MODE:
+        if (m_hackTvLib) m_hackTvLib->setAgcMode(param != 0);
+        break;
+    case RTL_TCP_SET_DIRECT_SAMPLING:
+        if (m_hackTvLib) m_hackTvLib->setDirectSampling(static_cast<int>(param));
+        break;
+    case RTL_TCP_SET_OFFSET_TUNING:
+        if (m_hackTvLib) m_hackTvLib->setOffsetTuning(param != 0);
+        break;
+    case RTL_TCP_SET_IF_GAIN:
+    case RTL_TCP_SET_TEST_MODE:
+    case RTL_TCP_SET_RTL_XTAL:
+    case RTL_TCP_SET_TUNER_XTAL:
+    case RTL_TCP_SET_TUNER_BANDWIDTH:
+    case RTL_TCP_SET_BIAS_TEE:
+        // Not mapped onto HackTvLib; accepted so clients do not stall
+        break;
+    default:
+        qDebug() << "rtl_tcp: unknown command" << b[0] << param;
+        break;
     }
 }
 
@@ -898,6 +1774,10 @@ void SdrDevice::setFrequency(uint64_t frequency_hz)
 {
     if (m_hackTvLib) {
         m_hackTvLib->setFrequency(frequency_hz);
+        m_currentFrequency = frequency_hz;
+        m_timeMachine.reset();
+        m_multicaster.setTuning(frequency_hz, m_currentSampleRate);
+        bumpTuningEpoch();
         qDebug() << "Frequency set to:" << frequency_hz << "Hz";
     }
 }
@@ -906,6 +1786,12 @@ void SdrDevice::setSampleRate(uint32_t sample_rate)
 {
     if (m_hackTvLib) {
         m_hackTvLib->setSampleRate(sample_rate);
+        m_currentSampleRate = sample_rate;
+        m_timeMachine.reset();
+        m_streamer->setSampleRate(sample_rate);
+        m_rtlStreamer->setSampleRate(sample_rate);
+        m_multicaster.setTuning(m_currentFrequency, sample_rate);
+        bumpTuningEpoch();
         qDebug() << "Sample rate set to:" << sample_rate << "Hz";
     }
 }
@@ -920,6 +1806,7 @@ void SdrDevice::setLnaGain(unsigned int gain)
         } else {
             m_hackTvLib->setLnaGain(gain);
         }
+        bumpTuningEpoch();
         qDebug() << "LNA gain set to:" << gain;
     }
 }
@@ -933,6 +1820,7 @@ void SdrDevice::setVgaGain(unsigned int gain)
         } else {
             m_hackTvLib->setVgaGain(gain);
         }
+        bumpTuningEpoch();
         qDebug() << "VGA gain set to:" << gain;
     }
 }
@@ -942,6 +1830,7 @@ void SdrDevice::setRxAmpGain(unsigned int gain)
     m_currentRxAmpGain = gain;
     if (m_hackTvLib) {
         m_hackTvLib->setRxAmpGain(gain);
+        bumpTuningEpoch();
         qDebug() << "RX amp gain set to:" << gain;
     }
 }
@@ -960,6 +1849,7 @@ void SdrDevice::setAmpEnable(bool enable)
     m_currentAmpEnable = enable;
     if (m_hackTvLib) {
         m_hackTvLib->setAmpEnable(enable);
+        bumpTuningEpoch();
         qDebug() << "RF amp enable set to:" << enable;
     }
 }
@@ -992,42 +1882,9 @@ void SdrDevice::setTxModulationType(int type)
     }
 }
 
-// ============================================================
-// TX Audio Ring Buffer
-// ============================================================
-
-void SdrDevice::txRingWrite(const float* data, size_t count)
-{
-    size_t w = m_txRingWritePos.load(std::memory_order_relaxed);
-    for (size_t i = 0; i < count; i++) {
-        m_txAudioRing[w] = data[i];
-        w = (w + 1) % TX_AUDIO_RING_SIZE;
-    }
-    m_txRingWritePos.store(w, std::memory_order_release);
-}
-
-size_t SdrDevice::txRingRead(float* out, size_t count)
-{
-    size_t avail = txRingAvailable();
-    size_t toRead = std::min(count, avail);
-    size_t r = m_txRingReadPos.load(std::memory_order_relaxed);
-    for (size_t i = 0; i < toRead; i++) {
-        out[i] = m_txAudioRing[r];
-        r = (r + 1) % TX_AUDIO_RING_SIZE;
-    }
-    m_txRingReadPos.store(r, std::memory_order_release);
-    return toRead;
-}
-
-size_t SdrDevice::txRingAvailable() const
-{
-    size_t w = m_txRingWritePos.load(std::memory_order_acquire);
-    size_t r = m_txRingReadPos.load(std::memory_order_acquire);
-    return (w >= r) ? (w - r) : (TX_AUDIO_RING_SIZE - r + w);
-}
-
-void SdrDevice::txRingReset()
+void SdrDevice::bumpTuningEpoch()
 {
-    m_txRingWritePos.store(0, std::memory_order_relaxed);
-    m_txRingReadPos.store(0, std::memory_order_relaxed);
+    m_rxFrequency.store(m_currentFrequency, std::memory_order_relaxed);
+    m_rxSampleRate.store(m_currentSampleRate, std::memory_order_relaxed);
+    m_tuningEpoch.fetch_add(1, std::memory_order_release);
 }
@@ -5,11 +5,24 @@
 #include <QTcpServer>
 #include <QTcpSocket>
 #include <QList>
+#include <QHash>
+#include <QThread>
+#include <QTimer>
+#include <QElapsedTimer>
 #include <memory>
 #include <vector>
 #include <string>
 #include <atomic>
+#include <mutex>
+#include <thread>
+#include <utility>
 #include "hacktvlib.h"
+#include "iqtimemachine.h"
+#include "iqstreamer.h"
+#include "iqmulticaster.h"
+#include "controlbatch.h"
+#include "iqshmbus.h"
+#include "txaudiointake.h"
 
 class SdrDevice : public QObject
 {
@@ -19,9 +32,23 @@ public:
     explicit SdrDevice(QObject *parent = nullptr);
     ~SdrDevice();
 
-    // Initialize with command-line arguments
+    // Initialize with command-line arguments; "-o hackrf:<serial>" or
+    // "-o rtlsdr:<serial>" picks one of several attached radios
     bool initialize(const std::vector<std::string>& args);
 
+    // Another radio served through this server's ports and network thread,
+    // with its own capture pipeline; initialize() and start() it like this
+    // one. Control clients pick it with SELECT_DEVICE. Owned by this object.
+    // enableTimeMachine() works per radio; rtl_tcp, multicast and shared
+    // memory are tied to the shared ports and serve this one only.
+    SdrDevice* addDevice();
+
+    // "hackrf:<serial>", "rtlsdr:<serial>", or just the type
+    QString deviceId() const;
+
+    // Pin the RX callback thread of this radio to a CPU (Linux; -1: not)
+    void setCaptureCpu(int cpu) { m_captureCpu.store(cpu); }
+
     // Start/Stop operations
     bool start();
     bool stop();
@@ -50,10 +77,28 @@ public:
     // Mode switching
     bool switchToRx();
     bool switchToTx();
-    bool isTxMode() const { return m_isTxMode; }
-    void setDeviceType(const std::string& type) { m_deviceType = type; }
+    bool isTxMode() const { return m_isTxMode.load(std::memory_order_acquire); }
+    void setDeviceType(const std::string& type) { m_deviceType = type; m_deviceSerial.clear(); }
     bool forceRestart();
 
+    // IQ time machine: keep the last 'seconds' of RX IQ in RAM for DUMP
+    bool enableTimeMachine(double seconds, uint32_t sampleRate, const QString& dumpDir);
+
+    // Backlog policy for new data clients: drop-oldest, drop-newest or disconnect
+    bool setBacklogPolicy(const QString& policy, int maxBlocks);
+
+    // Data socket tuning (sendmsg / MSG_ZEROCOPY on Linux), before startTcpServer
+    void setSendOptions(const IqStreamer::SendOptions& options);
+
+    // rtl_tcp compatible listener (dongle header, uint8 IQ, 5-byte commands)
+    bool startRtlTcpServer(quint16 port = 1234);
+
+    // UDP multicast of the RX IQ, one send for any number of receivers
+    bool startMulticast(const QHostAddress& group, quint16 port, int ttl, int mtu);
+
+    // Shared-memory IQ ring for clients on this host (Linux), after startTcpServer
+    bool startSharedMemory(size_t ringBytes);
+
 signals:
     void statusMessage(const QString& message);
     void errorOccurred(const QString& error);
@@ -65,11 +110,6 @@ signals:
     void parameterChanged(const QString& param, const QString& value);
 
 private slots:
-    // Data server (IQ out)
-    void onNewConnection();
-    void onClientDisconnected();
-    void onSocketError(QAbstractSocket::SocketError error);
-
     // Control server
     void onNewControlConnection();
     void onControlClientDisconnected();
@@ -81,22 +121,74 @@ private slots:
     void onAudioClientDisconnected();
     void onAudioDataReceived();
     void onAudioSocketError(QAbstractSocket::SocketError error);
+    void onTxAudioTick();
 
 private:
+    // Radio added with addDevice(), sharing the host's network thread
+    SdrDevice(SdrDevice* host, QObject *parent);
+
+    // Radio a control connection / host talks to (this one by default)
+    SdrDevice* findDevice(const QString& name) const;
+    SdrDevice* deviceForHost(const QHostAddress& address) const;
+    QString selectDevice(QTcpSocket* client, const QString& name, int clientPort);
+    QString listDevices(QTcpSocket* client) const;
+    void setHostDevice(const QHostAddress& address, SdrDevice* device);
+
+    // RX callback thread: time machine + hand-off to the network thread
     void handleReceivedData(const int8_t *data, size_t len);
-    void broadcastData(const QByteArray& data);
-    void removeDisconnectedClients();
     void processControlCommand(QTcpSocket* client, const QString& command);
+    void processControlBatch(QTcpSocket* client, const QByteArray& frame);
+    QString executeControlCommand(QTcpSocket* client, const QString& command);
+    void bumpTuningEpoch();
     QString getCurrentStatus();
+    static QString threadPlacementStatus();
+    QString latencyReport() const;
+
+    // Data connections from the same host as a control client
+    QList<quint64> findDataClients(QTcpSocket* controlClient, int clientPort);
+
+    // rtl_tcp
+    void handleRtlTcpCommand(quint64 clientId, const QByteArray& command);
+    void setRtlTcpGain(int gainTenthDb);
+    void updateRtlTcpFormat();
+
+    // Time machine dumps
+    void onDumpFinished(const IqTimeMachine::DumpResult& result);
+    QString listDumps() const;
+    void sendDumpFile(QTcpSocket* client, const QString& name);
 
     // Re-initialize HackTvLib in a given mode
     bool reinitialize(const std::string& mode);
+    // Mode switch keeping the HackRF open; false: reinitialize()
+    bool switchWarm(bool tx);
+    void applyModeSettings(bool tx);
 
     std::unique_ptr<HackTvLib> m_hackTvLib;
 
-    // Data streaming (IQ output for RX)
-    QTcpServer* m_tcpServer;
-    QList<QTcpSocket*> m_clients;
+    // Latency per stage of the server side (GET_LATENCY); the RX and TX
+    // callback stages are HackTvLib's own
+    LatencyRecorder m_latency;
+
+    // Several radios: the first one (no host) owns the ports and the network
+    // thread, the others are in m_devices. Selections are made on the host.
+    SdrDevice* m_host;
+    QList<SdrDevice*> m_devices;
+    QHash<QTcpSocket*, SdrDevice*> m_controlDevices;
+    QHash<QTcpSocket*, SdrDevice*> m_audioDevices;     // whose intake has the client
+    mutable std::mutex m_hostMutex;                     // the router reads it on the network thread
+    std::vector<std::pair<QHostAddress, SdrDevice*>> m_hostDevices;
+
+    // Data streaming (IQ output for RX), on its own network thread
+    QThread m_netThread;
+    IqStreamer* m_streamer;
+    IqStreamer* m_rtlStreamer;          // rtl_tcp port, same thread
+    quint16 m_rtlTcpPort;
+
+    // Multicast IQ, own sender thread
+    IqMulticaster m_multicaster;
+
+    // Local readers map this ring instead of using the data port
+    IqShmBus m_shmBus;
 
     // Control connection
     QTcpServer* m_controlServer;
@@ -106,9 +198,18 @@ private:
     QTcpServer* m_audioServer;
     QList<QTcpSocket*> m_audioClients;
 
-    std::atomic<quint64> m_totalBytesSent;
     std::atomic<quint64> m_totalBytesReceived;
 
+    // Tuning as the RX callback stamps it on every block (IqCodec::BlockInfo);
+    // the epoch moves on every frequency, rate, gain or mode change
+    std::atomic<uint64_t> m_rxFrequency;
+    std::atomic<uint32_t> m_rxSampleRate;
+    std::atomic<uint32_t> m_tuningEpoch;
+
+    // RX callback thread only
+    uint32_t m_blockSequence;
+    uint32_t m_lastBlockEpoch;
+
     // Current settings
     uint64_t m_currentFrequency;
     uint32_t m_currentSampleRate;
@@ -121,20 +222,28 @@ private:
     float m_currentAmplitude;
     int m_currentModulationType; // 0=NFM, 1=WFM, 2=AM
 
-    // Mode tracking
-    bool m_isTxMode;
+    // Mode tracking; the RX callback thread reads it to drop blocks in TX
+    std::atomic<bool> m_isTxMode;
     std::string m_deviceType;  // "hackrf" or "rtlsdr"
-
-    // Audio ring buffer for TX (receives PCM float from TCP audio clients)
-    static constexpr size_t TX_AUDIO_RING_SIZE = 1048576;
-    std::vector<float> m_txAudioRing;
-    std::atomic<size_t> m_txRingWritePos{0};
-    std::atomic<size_t> m_txRingReadPos{0};
-
-    void txRingWrite(const float* data, size_t count);
-    size_t txRingRead(float* out, size_t count);
-    size_t txRingAvailable() const;
-    void txRingReset();
+    std::string m_deviceSerial; // empty: the first one found
+
+    // RX callback thread pinning
+    std::atomic<int> m_captureCpu;
+    std::thread::id m_pinnedThread;
+
+    // TX audio: per-client jitter buffers, drained into the HackTvLib ring
+    // by a timer so that it holds about TX_AUDIO_QUEUE_MS, never bursts
+    static constexpr int TX_AUDIO_TICK_MS = 5;
+    static constexpr int TX_AUDIO_QUEUE_MS = 40;
+    static constexpr uint32_t TX_AUDIO_RATE = 44100;
+    TxAudioIntake m_txAudio;
+    QTimer* m_txAudioTimer;
+    QElapsedTimer m_audioClock;
+    std::vector<float> m_txAudioPull;
+
+    // Rolling IQ window, filled from the RX callback thread
+    IqTimeMachine m_timeMachine;
+    QString m_dumpDir;
 
     // Port storage for re-init
     quint16 m_dataPort;
@@ -0,0 +1,209 @@
+#include "spectrumanalyzer.h"
+#include <QFloat16>
+#include <QtEndian>
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+SpectrumAnalyzer::SpectrumAnalyzer(const Config& config)
+    : m_config(config)
+    , m_started(false)
+    , m_epoch(0)
+    , m_sampleRate(0)
+    , m_stride(config.size)
+    , m_skip(0)
+    , m_fill(0)
+    , m_count(0)
+    , m_sequence(0)
+{
+    const int N = m_config.size;
+
+    // Hann as in getFft, with int8 -> +/-1.0 folded in
+    m_window.resize(N);
+    for (int i = 0; i < N; i++) {
+        m_window[i] = 0.5f * (1.0f - static_cast<float>(std::cos(2.0 * M_PI * i / (N - 1)))) / 128.0f;
+    }
+
+    int bits = 0;
+    while ((1 << bits) < N) bits++;
+    m_bitReverse.resize(N);
+    for (int i = 0; i < N; i++) {
+        uint32_t r = 0;
+        for (int b = 0; b < bits; b++) {
+            if (i & (1 << b)) r |= 1u << (bits - 1 - b);
+        }
+        m_bitReverse[i] = r;
+    }
+
+    m_twiddles.resize(N / 2);
+    for (int k = 0; k < N / 2; k++) {
+        double w = -2.0 * M_PI * k / N;
+        m_twiddles[k] = std::complex<float>(static_cast<float>(std::cos(w)), static_cast<float>(std::sin(w)));
+    }
+
+    m_buffer.assign(N, {0.0f, 0.0f});
+    m_power.assign(N, 0.0f);
+}
+
+bool SpectrumAnalyzer::isValid(const Config& config)
+{
+    const bool powerOfTwo = config.size > 0 && (config.size & (config.size - 1)) == 0;
+    return powerOfTwo && config.size >= MIN_SIZE && config.size <= MAX_SIZE &&
+           config.fps >= 1 && config.fps <= MAX_FPS &&
+           config.averages >= 1 && config.averages <= MAX_AVERAGES;
+}
+
+bool SpectrumAnalyzer::parseFormat(const QString& name, BinFormat* format)
+{
+    QString n = name.trimmed().toLower();
+    if (n == "u8") { *format = BinsU8; return true; }
+    if (n == "f16") { *format = BinsF16; return true; }
+    return false;
+}
+
+QString SpectrumAnalyzer::formatName(BinFormat format)
+{
+    return (format == BinsF16) ? "f16" : "u8";
+}
+
+void SpectrumAnalyzer::reset(const IqCodec::BlockInfo& info)
+{
+    m_started = true;
+    m_epoch = info.epoch;
+    m_sampleRate = info.sampleRate;
+
+    // Spread the windows of one frame over the frame period
+    const uint64_t period = std::max<uint64_t>(1, info.sampleRate / static_cast<uint32_t>(m_config.fps));
+    m_stride = std::max<uint64_t>(m_config.size, period / static_cast<uint64_t>(m_config.averages));
+    m_skip = 0;
+    m_fill = 0;
+    m_count = 0;
+    std::fill(m_power.begin(), m_power.end(), 0.0f);
+}
+
+// Iterative radix-2, input already in bit-reversed order
+void SpectrumAnalyzer::transform()
+{
+    const int N = m_config.size;
+    std::complex<float>* x = m_buffer.data();
+    for (int len = 2; len <= N; len <<= 1) {
+        const int half = len / 2;
+        const int step = N / len;
+        for (int start = 0; start < N; start += len) {
+            for (int k = 0; k < half; k++) {
+                // Spelled out: std::complex operator* checks for NaN/inf
+                const std::complex<float> w = m_twiddles[k * step];
+                const std::complex<float> b = x[start + k + half];
+                const std::complex<float> t(w.real() * b.real() - w.imag() * b.imag(),
+                                            w.real() * b.imag() + w.imag() * b.real());
+                x[start + k + half] = x[start + k] - t;
+                x[start + k] += t;
+            }
+        }
+    }
+}
+
+void SpectrumAnalyzer::process(const int8_t* in, size_t len, const IqCodec::BlockInfo& info,
+                               std::vector<Frame>& frames)
+{
+    if (!m_started || info.epoch != m_epoch || info.sampleRate != m_sampleRate) {
+        reset(info);
+    }
+
+    const int N = m_config.size;
+    const size_t samples = len / 2;
+    size_t i = 0;
+
+    while (i < samples) {
+        if (m_skip > 0) {
+            size_t n = static_cast<size_t>(std::min<uint64_t>(m_skip, samples - i));
+            m_skip -= n;
+            i += n;
+            continue;
+        }
+
+        // Window straight into bit-reversed positions
+        size_t n = std::min<size_t>(N - m_fill, samples - i);
+        for (size_t k = 0; k < n; k++) {
+            const int pos = m_fill + static_cast<int>(k);
+            const float w = m_window[pos];
+            m_buffer[m_bitReverse[pos]] = std::complex<float>(in[(i + k) * 2] * w, in[(i + k) * 2 + 1] * w);
+        }
+        m_fill += static_cast<int>(n);
+        i += n;
+        if (m_fill < N) break;
+
+        transform();
+        // Not std::norm, which goes through hypot()
+        for (int k = 0; k < N; k++) {
+            const std::complex<float> v = m_buffer[k];
+            m_power[k] += v.real() * v.real() + v.imag() * v.imag();
+        }
+        m_fill = 0;
+        m_skip = m_stride - N;
+        if (++m_count < m_config.averages) continue;
+
+        // Full-scale sine = 0 dBFS before the window loss, as in getFft
+        Frame frame;
+        frame.info = info;
+        frame.info.timeUs = info.timeUs + (info.sampleRate ? i * 1000000ULL / info.sampleRate : 0);
+        frame.sequence = m_sequence++;
+        frame.averages = m_count;
+        frame.db.resize(N);
+        const float scale = 1.0f / (static_cast<float>(m_count) * N * N);
+        for (int k = 0; k < N; k++) {
+            // FFT shift: negative frequencies first
+            float power = m_power[(k + N / 2) & (N - 1)] * scale;
+            frame.db[k] = 10.0f * std::log10(std::max(power, 1e-20f));
+        }
+        frames.push_back(std::move(frame));
+
+        m_count = 0;
+        std::fill(m_power.begin(), m_power.end(), 0.0f);
+    }
+}
+
+QByteArray SpectrumAnalyzer::encodeFrame(const Frame& frame, BinFormat format, float minDb, float maxDb)
+{
+    const int bins = static_cast<int>(frame.db.size());
+    const int binBytes = (format == BinsF16) ? 2 : 1;
+
+    QByteArray out(HEADER + bins * binBytes, Qt::Uninitialized);
+    char* p = out.data();
+    std::memcpy(p, "HRSP", 4);
+    p[4] = static_cast<char>(VERSION);
+    p[5] = static_cast<char>(format);
+    qToLittleEndian<quint16>(HEADER, p + 6);
+    qToLittleEndian<quint32>(static_cast<quint32>(bins), p + 8);
+    qToLittleEndian<quint32>(frame.sequence, p + 12);
+    qToLittleEndian<quint64>(frame.info.timeUs, p + 16);
+    qToLittleEndian<quint64>(frame.info.frequency, p + 24);
+    qToLittleEndian<quint32>(frame.info.sampleRate, p + 32);
+    qToLittleEndian<quint32>(frame.info.epoch, p + 36);
+    qToLittleEndian<quint16>(static_cast<quint16>(std::min(frame.averages, 0xffff)), p + 40);
+    qToLittleEndian<quint16>(0, p + 42);
+    qToLittleEndian<float>(minDb, p + 44);
+    qToLittleEndian<float>(maxDb, p + 48);
+
+    p += HEADER;
+    if (format == BinsF16) {
+        for (int k = 0; k < bins; k++) {
+            qfloat16 h(frame.db[k]);
+            quint16 bitsValue;
+            std::memcpy(&bitsValue, &h, sizeof(bitsValue));
+            qToLittleEndian<quint16>(bitsValue, p + k * 2);
+        }
+    } else {
+        const float range = std::max(maxDb - minDb, 1.0f);
+        const float scale = 255.0f / range;
+        for (int k = 0; k < bins; k++) {
+            float v = (frame.db[k] - minDb) * scale + 0.5f;
+            p[k] = static_cast<char>(static_cast<uint8_t>(std::clamp(v, 0.0f, 255.0f)));
+        }
+    }
+    return out;
+}
@@ -0,0 +1,105 @@
+#ifndef SPECTRUMANALYZER_H
+#define SPECTRUMANALYZER_H
+
+#include <QByteArray>
+#include <QString>
+#include <complex>
+#include <vector>
+#include <cstdint>
+#include "iqcodec.h"
+
+// Server-side spectrum for display-only clients of HackRfTcp.
+//
+// int8 IQ at the radio rate -> Hann window -> radix-2 FFT -> |X|^2 averaged
+// over 'averages' windows -> dBFS, DC in the middle (same scale as
+// HackRfRadio's getFft). The windows are spread evenly over each frame
+// period, so the cost is fps x averages FFTs per second whatever the
+// sample rate; at high fps x averages x size the windows touch and the
+// frame rate drops instead. Accumulation restarts on a new tuning epoch or
+// sample rate, so no frame mixes two tunings.
+//
+// Frame on the data port, little endian:
+//    0  char[4]  "HRSP"
+//    4  uint8    version (1)
+//    5  uint8    bin format (1 = uint8, 2 = float16 dBFS)
+//    6  uint16   header bytes (52; newer versions may append fields)
+//    8  uint32   bins
+//   12  uint32   frame sequence of this analyzer (a gap = dropped frames)
+//   16  uint64   capture time of the last sample, UTC microseconds
+//   24  uint64   centre frequency in Hz
+//   32  uint32   sample rate
+//   36  uint32   tuning epoch (see IqCodec)
+//   40  uint16   FFTs averaged
+//   42  uint16   reserved (0)
+//   44  float32  dBFS at uint8 0
+//   48  float32  dBFS at uint8 255
+// then the bins, lowest frequency first. uint8 bins map the dB range
+// linearly and clamp; float16 bins are dBFS as is.
+class SpectrumAnalyzer
+{
+public:
+    enum BinFormat : uint8_t {
+        BinsU8 = 1,
+        BinsF16 = 2
+    };
+
+    struct Config {
+        int size = 2048;            // bins, power of two
+        int fps = 25;               // frames per second (upper bound)
+        int averages = 8;           // FFTs per frame
+
+        bool operator==(const Config& other) const {
+            return size == other.size && fps == other.fps && averages == other.averages;
+        }
+    };
+
+    struct Frame {
+        std::vector<float> db;
+        IqCodec::BlockInfo info;    // timeUs: last sample of the frame
+        uint32_t sequence = 0;
+        int averages = 0;
+    };
+
+    static constexpr int HEADER = 52;
+    static constexpr uint8_t VERSION = 1;
+    static constexpr int MIN_SIZE = 64;
+    static constexpr int MAX_SIZE = 65536;
+    static constexpr int MAX_FPS = 60;
+    static constexpr int MAX_AVERAGES = 1000;
+
+    explicit SpectrumAnalyzer(const Config& config);
+
+    const Config& config() const { return m_config; }
+
+    // Appends the frames completed by this block
+    void process(const int8_t* in, size_t len, const IqCodec::BlockInfo& info, std::vector<Frame>& frames);
+
+    static bool isValid(const Config& config);
+    static bool parseFormat(const QString& name, BinFormat* format);
+    static QString formatName(BinFormat format);
+
+    // Whole frame (header + bins)
+    static QByteArray encodeFrame(const Frame& frame, BinFormat format, float minDb, float maxDb);
+
+private:
+    void reset(const IqCodec::BlockInfo& info);
+    void transform();
+
+    Config m_config;
+    std::vector<float> m_window;                // Hann, scaled to int8 full scale
+    std::vector<uint32_t> m_bitReverse;
+    std::vector<std::complex<float>> m_twiddles;
+    std::vector<std::complex<float>> m_buffer;  // filled in bit-reversed order
+    std::vector<float> m_power;                 // sum of |X|^2 over this frame
+
+    bool m_started;
+    uint32_t m_epoch;
+    uint32_t m_sampleRate;
+    uint64_t m_stride;          // samples from one window start to the next
+    uint64_t m_skip;            // samples to drop before the next window
+    int m_fill;                 // samples in m_buffer
+    int m_count;                // windows in m_power
+    uint32_t m_sequence;
+};
+
+#endif // SPECTRUMANALYZER_H
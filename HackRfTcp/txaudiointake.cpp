@@ -0,0 +1,355 @@
+#include "txaudiointake.h"
+#include "latencyhistogram.h"
+#include <QtEndian>
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+
+// Longer silences are the end of a talk spurt, not network trouble
+static constexpr qint64 SPURT_GAP_US = 500000;
+// Extra depth per underrun, and how fast it is given back (ms per second)
+static constexpr double UNDERRUN_MARGIN_MS = 10.0;
+static constexpr double MARGIN_DECAY_MS = 0.5;
+
+TxAudioIntake::TxAudioIntake(uint32_t deviceRate)
+    : m_deviceRate(deviceRate)
+    , m_minMs(40.0)
+    , m_maxMs(500.0)
+    , m_underruns(0)
+    , m_late(0)
+    , m_lost(0)
+    , m_overruns(0)
+    , m_badPackets(0)
+    , m_networkLatency(nullptr)
+    , m_bufferLatency(nullptr)
+{
+}
+
+void TxAudioIntake::setDepthLimits(double minMs, double maxMs)
+{
+    m_minMs = std::max(5.0, minMs);
+    m_maxMs = std::max(m_minMs * 2.0, maxMs);
+}
+
+void TxAudioIntake::setLatencyStages(LatencyHistogram* network, LatencyHistogram* buffer)
+{
+    m_networkLatency = network;
+    m_bufferLatency = buffer;
+}
+
+void TxAudioIntake::addClient(quint64 id)
+{
+    m_clients[id] = Client();
+}
+
+void TxAudioIntake::removeClient(quint64 id)
+{
+    m_clients.erase(id);
+}
+
+void TxAudioIntake::reset()
+{
+    for (auto& entry : m_clients) {
+        Client& c = entry.second;
+        c.buffer.clear();
+        c.head = 0;
+        c.position = 0.0;
+        c.drift = 1.0;
+        c.depthAvg = 0.0;
+        c.playing = false;
+        c.starved = false;
+    }
+}
+
+double TxAudioIntake::targetSamples(const Client& c) const
+{
+    // Three times the jitter on top of one packet covers nearly all arrivals
+    double ms = 3.0 * c.jitterUs / 1000.0 + c.lastPacketUs / 1000.0 + c.marginMs;
+    ms = std::clamp(ms, m_minMs, m_maxMs * 0.5);
+    return ms * c.rate / 1000.0;
+}
+
+// ============================================================
+// Reassembly
+// ============================================================
+
+void TxAudioIntake::receive(quint64 id, const char* data, qint64 len, qint64 nowUs)
+{
+    if (len <= 0) return;
+    Client& c = m_clients[id];
+    c.input.append(data, static_cast<int>(len));
+    parse(c, nowUs);
+}
+
+void TxAudioIntake::parse(Client& c, qint64 nowUs)
+{
+    if (!c.decided) {
+        if (c.input.size() < 4) return;
+        c.framed = std::memcmp(c.input.constData(), "HRAU", 4) == 0;
+        c.decided = true;
+    }
+
+    if (!c.framed) {
+        // Bare float32 at 44100 Hz; a partial float waits for the next read
+        const size_t count = c.input.size() / sizeof(float);
+        if (count == 0) return;
+        std::vector<float> samples(count);
+        std::memcpy(samples.data(), c.input.constData(), count * sizeof(float));
+        c.input.remove(0, static_cast<int>(count * sizeof(float)));
+        append(c, samples.data(), count, nowUs);
+        return;
+    }
+
+    int pos = 0;
+    while (c.input.size() - pos >= PACKET_HEADER) {
+        const char* p = c.input.constData() + pos;
+        const int headerBytes = qFromLittleEndian<quint16>(p + 6);
+        const uint8_t format = static_cast<uint8_t>(p[5]);
+        const uint32_t samples = qFromLittleEndian<quint32>(p + 12);
+        const uint32_t rate = qFromLittleEndian<quint32>(p + 16);
+
+        if (std::memcmp(p, "HRAU", 4) != 0 || static_cast<uint8_t>(p[4]) != VERSION ||
+            headerBytes < PACKET_HEADER || samples > MAX_PACKET_SAMPLES ||
+            rate < 8000 || rate > 192000 || (format != FormatF32 && format != FormatS16)) {
+            // Lost framing (should not happen on TCP): skip to the next packet
+            m_badPackets++;
+            int next = c.input.indexOf("HRAU", pos + 1);
+            pos = (next >= 0) ? next : std::max(pos + 1, static_cast<int>(c.input.size()) - 3);
+            if (next < 0) break;
+            continue;
+        }
+
+        const int bytesPerSample = (format == FormatF32) ? 4 : 2;
+        const int total = headerBytes + static_cast<int>(samples) * bytesPerSample;
+        if (c.input.size() - pos < total) break;
+        pos += total;
+
+        if (headerBytes >= TIMED_HEADER && m_networkLatency) {
+            const quint64 captureUs = qFromLittleEndian<quint64>(p + 24);
+            if (captureUs != 0) {
+                m_networkLatency->record(LatencyHistogram::utcUs() - static_cast<qint64>(captureUs));
+            }
+        }
+
+        const uint32_t sequence = qFromLittleEndian<quint32>(p + 8);
+        if (c.haveSequence) {
+            const int32_t gap = static_cast<int32_t>(sequence - c.nextSequence);
+            if (gap < 0) {
+                // Repeated or older than what we already play
+                m_late++;
+                continue;
+            }
+            m_lost += static_cast<quint32>(gap);
+        }
+        c.haveSequence = true;
+        c.nextSequence = sequence + 1;
+
+        if (rate != c.rate) {
+            // New rate: queued audio would play at the wrong speed
+            c.rate = rate;
+            c.buffer.clear();
+            c.head = 0;
+            c.position = 0.0;
+            c.playing = false;
+        }
+
+        const char* payload = p + headerBytes;
+        if (format == FormatF32) {
+            std::vector<float> values(samples);
+            for (uint32_t i = 0; i < samples; i++) {
+                values[i] = qFromLittleEndian<float>(payload + i * 4);
+            }
+            append(c, values.data(), samples, nowUs);
+        } else {
+            appendS16(c, payload, samples, nowUs);
+        }
+    }
+    c.input.remove(0, pos);
+}
+
+void TxAudioIntake::appendS16(Client& c, const char* data, size_t count, qint64 nowUs)
+{
+    std::vector<float> values(count);
+    for (size_t i = 0; i < count; i++) {
+        values[i] = qFromLittleEndian<qint16>(data + i * 2) / 32768.0f;
+    }
+    append(c, values.data(), count, nowUs);
+}
+
+// Jitter of arrival times against the audio they carry (RFC 3550, 6.4.1)
+void TxAudioIntake::arrival(Client& c, size_t count, qint64 nowUs)
+{
+    const double packetUs = count * 1.0e6 / c.rate;
+    const qint64 gap = nowUs - c.lastArrivalUs;
+    if (c.lastArrivalUs != 0 && gap < SPURT_GAP_US) {
+        const double d = static_cast<double>(gap) - c.lastPacketUs;
+        c.jitterUs += (std::fabs(d) - c.jitterUs) / 16.0;
+    }
+    c.lastArrivalUs = nowUs;
+    c.lastPacketUs = packetUs;
+}
+
+void TxAudioIntake::append(Client& c, const float* samples, size_t count, qint64 nowUs)
+{
+    if (count == 0) return;
+
+    // Ran dry while the client was still talking: its audio came too late
+    if (c.starved && nowUs - c.lastArrivalUs < SPURT_GAP_US) {
+        m_underruns++;
+        m_late++;
+        c.marginMs = std::min(c.marginMs + UNDERRUN_MARGIN_MS, m_maxMs * 0.5);
+    }
+    c.starved = false;
+    arrival(c, count, nowUs);
+
+    if (c.head > 0 && c.head >= c.buffer.size() / 2) {
+        c.buffer.erase(c.buffer.begin(), c.buffer.begin() + c.head);
+        c.head = 0;
+    }
+    c.buffer.insert(c.buffer.end(), samples, samples + count);
+
+    // Far too deep (client clock much faster, or we were not pulling):
+    // drop the oldest audio back to the target
+    const size_t maxSamples = static_cast<size_t>(m_maxMs * c.rate / 1000.0);
+    if (queued(c) > maxSamples) {
+        c.head += queued(c) - static_cast<size_t>(targetSamples(c));
+        c.position = 0.0;
+        m_overruns++;
+    }
+}
+
+// ============================================================
+// Device side
+// ============================================================
+
+size_t TxAudioIntake::pull(float* out, size_t frames)
+{
+    std::fill(out, out + frames, 0.0f);
+    size_t produced = 0;
+
+    for (auto& entry : m_clients) {
+        Client& c = entry.second;
+        const double target = targetSamples(c);
+        if (!c.playing) {
+            if (queued(c) == 0 || queued(c) < target) continue;
+            c.playing = true;
+            c.depthAvg = static_cast<double>(queued(c));
+        }
+
+        // Steer the average depth (packets make it a sawtooth) back to the
+        // target over about ten seconds, slow enough not to be heard
+        const double seconds = static_cast<double>(frames) / m_deviceRate;
+        c.depthAvg += std::min(1.0, seconds) * (static_cast<double>(queued(c)) - c.depthAvg);
+        c.marginMs = std::max(0.0, c.marginMs - MARGIN_DECAY_MS * seconds);
+        const double error = (c.depthAvg - target) / c.rate;
+        const double want = 1.0 + std::clamp(error / 10.0, -MAX_DRIFT, MAX_DRIFT);
+        c.drift += 0.02 * (want - c.drift);
+        const double step = c.drift * c.rate / m_deviceRate;
+
+        if (m_bufferLatency) {
+            m_bufferLatency->record(static_cast<int64_t>(queued(c)) * 1000000 / c.rate);
+        }
+
+        const float* s = c.buffer.data() + c.head;
+        const size_t avail = queued(c);
+        size_t i = 0;
+        for (; i < frames; i++) {
+            const size_t idx = static_cast<size_t>(c.position);
+            if (idx + 1 >= avail) break;
+            const float frac = static_cast<float>(c.position - idx);
+            out[i] += s[idx] + (s[idx + 1] - s[idx]) * frac;
+            c.position += step;
+        }
+
+        const size_t used = std::min(static_cast<size_t>(c.position), avail);
+        c.head += used;
+        c.position -= used;
+        produced = std::max(produced, i);
+
+        if (i < frames) {
+            // Empty: wait for the target depth again (counted if more comes soon)
+            c.playing = false;
+            c.starved = true;
+        }
+    }
+
+    for (size_t i = 0; i < produced; i++) {
+        out[i] = std::clamp(out[i], -1.0f, 1.0f);
+    }
+    return produced;
+}
+
+// ============================================================
+// Statistics
+// ============================================================
+
+TxAudioIntake::Stats TxAudioIntake::stats() const
+{
+    Stats s;
+    s.clients = static_cast<int>(m_clients.size());
+    double driftSum = 0.0;
+    for (const auto& entry : m_clients) {
+        const Client& c = entry.second;
+        const double depthMs = queued(c) * 1000.0 / c.rate;
+        if (depthMs >= s.depthMs) {
+            s.depthMs = depthMs;
+            s.targetMs = targetSamples(c) * 1000.0 / c.rate;
+        }
+        s.jitterMs = std::max(s.jitterMs, c.jitterUs / 1000.0);
+        if (c.playing) {
+            s.playing++;
+            driftSum += (c.drift - 1.0) * 1.0e6;
+        }
+    }
+    if (s.playing > 0) s.driftPpm = driftSum / s.playing;
+    if (s.clients > 0 && s.targetMs == 0.0) s.targetMs = m_minMs;
+    s.underruns = m_underruns;
+    s.late = m_late;
+    s.lost = m_lost;
+    s.overruns = m_overruns;
+    s.badPackets = m_badPackets;
+    return s;
+}
+
+QString TxAudioIntake::statusText() const
+{
+    const Stats s = stats();
+    return QString("%1 client(s), %2 playing, depth %3 ms (target %4 ms, limits %5-%6 ms), "
+                   "jitter %7 ms, drift %8 ppm, %9 underruns, %10 late, %11 lost, %12 overruns, %13 bad")
+        .arg(s.clients).arg(s.playing)
+        .arg(s.depthMs, 0, 'f', 1).arg(s.targetMs, 0, 'f', 1)
+        .arg(m_minMs, 0, 'f', 0).arg(m_maxMs, 0, 'f', 0)
+        .arg(s.jitterMs, 0, 'f', 1).arg(s.driftPpm, 0, 'f', 0)
+        .arg(s.underruns).arg(s.late).arg(s.lost).arg(s.overruns).arg(s.badPackets);
+}
+
+QByteArray TxAudioIntake::encodePacket(uint32_t sequence, const float* samples, size_t count,
+                                       uint32_t sampleRate, SampleFormat format, uint64_t captureUs)
+{
+    const int bytesPerSample = (format == FormatF32) ? 4 : 2;
+    const int headerBytes = captureUs ? TIMED_HEADER : PACKET_HEADER;
+    QByteArray packet(headerBytes + static_cast<int>(count) * bytesPerSample, Qt::Uninitialized);
+    char* p = packet.data();
+    std::memcpy(p, "HRAU", 4);
+    p[4] = static_cast<char>(VERSION);
+    p[5] = static_cast<char>(format);
+    qToLittleEndian<quint16>(static_cast<quint16>(headerBytes), p + 6);
+    qToLittleEndian<quint32>(sequence, p + 8);
+    qToLittleEndian<quint32>(static_cast<quint32>(count), p + 12);
+    qToLittleEndian<quint32>(sampleRate, p + 16);
+    qToLittleEndian<quint32>(0, p + 20);
+    if (captureUs) {
+        qToLittleEndian<quint64>(captureUs, p + 24);
+    }
+
+    p += headerBytes;
+    for (size_t i = 0; i < count; i++) {
+        if (format == FormatF32) {
+            qToLittleEndian<float>(samples[i], p + i * 4);
+        } else {
+            const float v = std::clamp(samples[i], -1.0f, 1.0f) * 32767.0f;
+            qToLittleEndian<qint16>(static_cast<qint16>(std::lround(v)), p + i * 2);
+        }
+    }
+    return packet;
+}
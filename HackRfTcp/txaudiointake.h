@@ -0,0 +1,147 @@
+#ifndef TXAUDIOINTAKE_H
+#define TXAUDIOINTAKE_H
+
+#include <QByteArray>
+#include <QString>
+#include <map>
+#include <vector>
+#include <cstdint>
+
+// TX audio port (5002) of HackRfTcp: TCP in, paced mono audio out.
+//
+// Every client gets its own reassembly and jitter buffer. The first bytes
+// of a connection decide the framing: "HRAU" packets, or bare float32
+// mono at 44100 Hz as older clients send it (partial floats are kept for
+// the next read). The device side pulls at its own clock, a little at a
+// time, through a linear interpolator whose ratio is the client rate over
+// the device rate, nudged by up to MAX_DRIFT so that the buffer settles
+// at its target depth instead of slowly running dry or full when the two
+// sound clocks disagree. The target follows the measured arrival jitter
+// (RFC 3550 estimator) between the configured minimum and maximum, plus a
+// margin that every underrun raises and clean playback slowly lowers
+// again, for networks whose delay has a long tail. An empty buffer stops
+// the client until the target depth is back (an underrun); packets that
+// arrive while it waits are late. Clients mix.
+//
+// Packet, little endian:
+//    0  char[4]  "HRAU"
+//    4  uint8    version (1)
+//    5  uint8    sample format (1 = float32, 2 = int16)
+//    6  uint16   header bytes (24; newer versions may append fields)
+//    8  uint32   packet sequence (a gap = packets the client dropped)
+//   12  uint32   samples that follow (mono)
+//   16  uint32   sample rate
+//   20  uint32   reserved (0)
+//   24  uint64   capture time of the first sample, UTC microseconds
+//                (0: unknown); only in headers of TIMED_HEADER bytes
+class LatencyHistogram;
+
+class TxAudioIntake
+{
+public:
+    enum SampleFormat : uint8_t {
+        FormatF32 = 1,
+        FormatS16 = 2
+    };
+
+    struct Stats {
+        int clients = 0;
+        int playing = 0;
+        double depthMs = 0.0;           // deepest client buffer
+        double targetMs = 0.0;
+        double jitterMs = 0.0;
+        double driftPpm = 0.0;          // ratio adjust applied on top of the rates
+        quint64 underruns = 0;
+        quint64 late = 0;
+        quint64 lost = 0;               // sequence gaps
+        quint64 overruns = 0;           // samples dropped from a full buffer, in blocks
+        quint64 badPackets = 0;
+    };
+
+    static constexpr int PACKET_HEADER = 24;
+    static constexpr int TIMED_HEADER = 32;
+    static constexpr uint8_t VERSION = 1;
+    static constexpr uint32_t MAX_PACKET_SAMPLES = 48000;
+    static constexpr uint32_t LEGACY_RATE = 44100;
+    static constexpr double MAX_DRIFT = 0.005;
+
+    explicit TxAudioIntake(uint32_t deviceRate = 44100);
+
+    // Latency histograms (nullptr: not recorded): capture to arrival for
+    // packets that carry a capture time, and the depth a playing client's
+    // audio waits in its buffer, sampled at every pull
+    void setLatencyStages(LatencyHistogram* network, LatencyHistogram* buffer);
+
+    // Target depth follows the jitter within these bounds
+    void setDepthLimits(double minMs, double maxMs);
+    double minDepthMs() const { return m_minMs; }
+    double maxDepthMs() const { return m_maxMs; }
+
+    void addClient(quint64 id);
+    void removeClient(quint64 id);
+    void receive(quint64 id, const char* data, qint64 len, qint64 nowUs);
+
+    // Device side: fills out with 'frames' mixed samples at the device
+    // rate, returns how many carried audio (0: everybody is buffering)
+    size_t pull(float* out, size_t frames);
+
+    // Drop buffered audio (TX stopped), keep clients and totals
+    void reset();
+
+    Stats stats() const;
+    QString statusText() const;
+
+    // Client side
+    // captureUs: when the first sample was taken (UTC us); 0 leaves the
+    // short header that servers before the capture time expect
+    static QByteArray encodePacket(uint32_t sequence, const float* samples, size_t count,
+                                   uint32_t sampleRate, SampleFormat format = FormatF32,
+                                   uint64_t captureUs = 0);
+
+private:
+    struct Client {
+        QByteArray input;               // unparsed bytes
+        bool decided = false;           // framing known
+        bool framed = false;
+        bool haveSequence = false;
+        uint32_t nextSequence = 0;
+        uint32_t rate = LEGACY_RATE;
+
+        std::vector<float> buffer;      // samples from head on are queued
+        size_t head = 0;
+        double position = 0.0;          // fractional read position past head
+        double drift = 1.0;
+        double depthAvg = 0.0;          // samples, ~1 s average for the drift loop
+        double marginMs = 0.0;          // raised by underruns
+        bool playing = false;
+        bool starved = false;           // underran, waiting for the target again
+
+        qint64 lastArrivalUs = 0;
+        double lastPacketUs = 0.0;      // audio duration of the previous arrival
+        double jitterUs = 0.0;
+    };
+
+    void parse(Client& c, qint64 nowUs);
+    void append(Client& c, const float* samples, size_t count, qint64 nowUs);
+    void appendS16(Client& c, const char* data, size_t count, qint64 nowUs);
+    void arrival(Client& c, size_t count, qint64 nowUs);
+    size_t queued(const Client& c) const { return c.buffer.size() - c.head; }
+    double targetSamples(const Client& c) const;
+
+    uint32_t m_deviceRate;
+    double m_minMs;
+    double m_maxMs;
+    std::map<quint64, Client> m_clients;
+
+    // Totals, kept when clients leave
+    quint64 m_underruns;
+    quint64 m_late;
+    quint64 m_lost;
+    quint64 m_overruns;
+    quint64 m_badPackets;
+
+    LatencyHistogram* m_networkLatency;
+    LatencyHistogram* m_bufferLatency;
+};
+
+#endif // TXAUDIOINTAKE_H
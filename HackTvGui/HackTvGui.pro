@@ -9,6 +9,12 @@ PARENT_DIR = $$absolute_path($$PWD/../)
 INCLUDEPATH += $$PARENT_DIR/include
 message($$PARENT_DIR)
 
+# Band scanner, shared with HackRfRadio, and the spectrum analyser it
+# measures with, shared with the server
+RADIO_DIR = $$absolute_path($$PWD/../HackRfRadio)
+TCP_DIR = $$absolute_path($$PWD/../HackRfTcp)
+INCLUDEPATH += $$RADIO_DIR $$TCP_DIR
+
 win32 {
     WIN_LIB_DIR = $$absolute_path($$PARENT_DIR/lib/windows)
     INCLUDEPATH += $$PARENT_DIR/HackTvLib
@@ -57,24 +63,33 @@ linux {
 
 SOURCES += \
     audiooutput.cpp \
+    audioring.cpp \
     glplotter.cpp \
     freqctrl.cpp \
     fmdemodulator.cpp \
     amdemodulator.cpp \
+    polyphaseresampler.cpp \
     main.cpp \
     mainwindow.cpp \
-    meter.cpp
+    meter.cpp \
+    $$RADIO_DIR/bandscanner.cpp \
+    $$TCP_DIR/spectrumanalyzer.cpp
 
 HEADERS += \
     audiooutput.h \
+    audioring.h \
     constants.h \
     glplotter.h \
     freqctrl.h \
     fmdemodulator.h \
     amdemodulator.h \
+    polyphaseresampler.h \
     mainwindow.h \
     meter.h \
-    modulator.h
+    modulator.h \
+    $$RADIO_DIR/bandscanner.h \
+    $$TCP_DIR/spectrumanalyzer.h \
+    $$TCP_DIR/iqcodec.h
 
 FORMS += \
     mainwindow.ui
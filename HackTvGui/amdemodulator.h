@@ -7,87 +7,149 @@
 #include <cmath>
 #include <numeric>
 #include <algorithm>
+#include "polyphaseresampler.h"
 
 #ifndef M_PI
 #define M_PI 3.14159265358979323846
 #endif
 
+// AM family receiver: IQ decimation -> channel filter -> detector -> AGC
+// -> 48 kHz mono audio.
+//
+// Detectors:
+//  Envelope     |x|, the classic AM detector.
+//  Synchronous  SAM: a PLL locks an NCO to the carrier and the in-phase
+//               part is the audio, so selective fading and a carrier
+//               weaker than its sidebands do not distort it. Until the
+//               loop locks the envelope is played.
+//  USB / LSB    Weaver method on the complex baseband: shift the middle
+//               of the passband (300 Hz to bandwidth / 2, at most 3 kHz)
+//               to DC, low-pass, shift back and keep the real part. The
+//               IQ chain decimates to SSB_IQ_RATE (16 kHz) for these, or
+//               to under 1.5x that where the integer factors fall short.
+//
+// All state persists across blocks and the work buffers are members, so
+// after the first block nothing is allocated; FIRs, magnitude and the NCO
+// mixers run four lanes at a time on SSE / NEON.
 class AMDemodulator : public QObject
 {
     Q_OBJECT
 
 public:
+    enum Mode { Envelope, Synchronous, UpperSideband, LowerSideband };
+    static constexpr int MODE_COUNT = 4;
+
     explicit AMDemodulator(double inputSampleRate, double bandwidth = 10000.0, QObject *parent = nullptr);
 
     std::vector<float> demodulate(const std::vector<std::complex<float>>& samples);
+    // Same into 'audio' (replaced), without allocating once it has grown
+    void demodulate(const std::complex<float>* samples, size_t count, std::vector<float>& audio);
 
     void setSampleRate(double newRate);
     void setBandwidth(double bandwidthHz);
     double bandwidth() const { return m_bandwidth; }
 
+    void setMode(Mode mode);
+    Mode mode() const { return m_mode; }
+    static const char* modeName(Mode mode);
+
+    // SAM: carrier lock, and where the carrier sits against the tuning
+    bool carrierLocked() const { return m_pllLocked; }
+    double carrierOffsetHz() const { return m_ncoFreq * m_iqRate / (2.0 * M_PI); }
+
 private:
     struct DecimStage {
         std::vector<float> taps;
+        std::vector<float> taps2;       // each tap twice, for interleaved I/Q
         int factor;
         double outputRate;
-        std::vector<std::complex<float>> iqHistory;
-        std::vector<float> realHistory;
+        std::vector<std::complex<float>> iqLine;    // history + current block
+        std::vector<float> realLine;
+        int phase = 0;                  // first input to keep in the next block
     };
 
+    static constexpr size_t PLL_BLOCK = 32;     // samples per loop filter update
+    static constexpr int SSB_TAPS = 161;
+    static constexpr float AGC_MAX_GAIN = 50.0f;
+    static constexpr double SSB_LOW_HZ = 300.0;
+    static constexpr double SSB_MAX_HIGH_HZ = 3000.0;
+    static constexpr double SSB_IQ_RATE = 16000.0;
+
+    bool isSideband() const { return m_mode == UpperSideband || m_mode == LowerSideband; }
+
     double m_inputRate;
     double m_bandwidth;
+    Mode m_mode = Envelope;
+    double m_iqRate = 0.0;              // after the IQ decimation
 
     std::vector<DecimStage> m_iqStages;
     std::vector<DecimStage> m_realStages;
     std::vector<float> m_audioFilterTaps;
-    std::vector<float> m_iqBandwidthTaps;
+    std::vector<float> m_iqBandwidthTaps;   // interleaved (taps2) form
 
     // Persistent filter state
-    std::vector<std::complex<float>> m_iqBwHistory;
-    std::vector<float> m_audioFilterHistory;
-
-    // DC blocker state (SDR++ style)
-    float m_dcOffset = 0.0f;
+    std::vector<std::complex<float>> m_iqBwLine;
+    std::vector<float> m_audioFilterLine;
+    PolyphaseResampler m_resampler;  // -> 48 kHz
+
+    // Work buffers, reused every block
+    std::vector<std::complex<float>> m_iqA;
+    std::vector<std::complex<float>> m_iqB;
+    std::vector<float> m_realA;
+    std::vector<float> m_realB;
+    std::vector<std::complex<float>> m_shifted;     // SAM / Weaver mixer output
+    std::vector<std::complex<float>> m_filtered;    // Weaver low-pass output
 
     // Proper DC blocker state (first-order HPF)
     float m_dcBlockerX = 0.0f;  // previous input
     float m_dcBlockerY = 0.0f;  // previous output
 
-    // Running IQ DC removal
-    float m_dcI = 0.0f;
-    float m_dcQ = 0.0f;
-
     // AGC state
     float m_agcAmp = 0.0f;  // 0 = auto-init from first chunk
 
     // Output peak limiter
     float m_audioRms = 0.05f;  // running RMS estimate
 
+    // SAM carrier PLL: NCO phasor e^-j(phase), stepped by e^-j(freq)
+    std::complex<float> m_ncoPhasor{1.0f, 0.0f};
+    std::complex<float> m_ncoStep{1.0f, 0.0f};
+    double m_ncoFreq = 0.0;             // carrier, rad/sample
+    double m_ncoFreqLimit = 0.0;
+    float m_pllKpWide = 0.0f, m_pllKiWide = 0.0f;       // acquiring
+    float m_pllKpNarrow = 0.0f, m_pllKiNarrow = 0.0f;   // locked
+    float m_lockMetric = 0.0f;          // smoothed cos(phase error)
+    bool m_pllLocked = false;
+
+    // SSB (Weaver): shift by -/+ the passband middle, low-pass, shift back
+    std::vector<float> m_ssbTaps;       // interleaved (taps2) form
+    std::vector<std::complex<float>> m_ssbLine;
+    std::complex<float> m_weaverDown{1.0f, 0.0f};
+    std::complex<float> m_weaverUp{1.0f, 0.0f};
+    std::complex<float> m_weaverDownStep{1.0f, 0.0f};
+    std::complex<float> m_weaverUpStep{1.0f, 0.0f};
+    float m_ssbLevel = 0.0f;
+    float m_ssbAttack = 0.0f;
+    float m_ssbDecay = 0.0f;
+
     void rebuildChain();
+    void designFilters();
+    void resetPll();
 
     static std::vector<float> designLPF(int numTaps, float cutoff, float sampleRate);
-    void decimateComplex(
-        const std::vector<std::complex<float>>& in,
-        std::vector<std::complex<float>>& out,
-        const std::vector<float>& taps, int factor,
-        std::vector<std::complex<float>>& history);
-    void applyComplexFIR(
-        const std::vector<std::complex<float>>& in,
-        std::vector<std::complex<float>>& out,
-        const std::vector<float>& taps,
-        std::vector<std::complex<float>>& history);
-    void decimateReal(
-        const std::vector<float>& in,
-        std::vector<float>& out,
-        const std::vector<float>& taps, int factor,
-        std::vector<float>& history);
-    void applyFIR(
-        const std::vector<float>& in,
-        std::vector<float>& out,
-        const std::vector<float>& taps,
-        std::vector<float>& history);
-    std::vector<float> amDemod(const std::vector<std::complex<float>>& signal);
-    static std::vector<float> resample(const std::vector<float>& in, double inRate, double outRate);
+    static std::vector<float> interleaveTaps(const std::vector<float>& taps);
+    static void decimateComplex(const std::complex<float>* in, size_t n, DecimStage& stage,
+                                std::vector<std::complex<float>>& out);
+    static void applyComplexFIR(const std::complex<float>* in, size_t n, const std::vector<float>& taps2,
+                                std::vector<std::complex<float>>& line, std::vector<std::complex<float>>& out);
+    static void decimateReal(const float* in, size_t n, DecimStage& stage, std::vector<float>& out);
+    static void applyFIR(const float* in, size_t n, const std::vector<float>& taps,
+                         std::vector<float>& line, std::vector<float>& out);
+
+    void envelopeDetect(const std::complex<float>* in, size_t n, std::vector<float>& out);
+    void synchronousDetect(const std::complex<float>* in, size_t n, std::vector<float>& out);
+    void sidebandDetect(const std::complex<float>* in, size_t n, std::vector<float>& out);
+    void carrierAgc(float* audio, size_t n);
+    void sidebandAgc(float* audio, size_t n);
 };
 
 #endif // AMDEMODULATOR_H
@@ -1,11 +1,152 @@
 #include "fmdemodulator.h"
 #include <QDebug>
 
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#include <xmmintrin.h>
+#define FMDEMOD_SSE 1
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define FMDEMOD_NEON 1
+#endif
+
+namespace {
+
+// atan2 with the atan polynomial of Abramowitz & Stegun 4.4.49
+// (|error| < 1e-5 rad) on the octant-reduced argument; the SIMD versions
+// below compute the same thing with selects instead of branches
+constexpr float ATAN_C1 = 0.9998660f;
+constexpr float ATAN_C3 = -0.3302995f;
+constexpr float ATAN_C5 = 0.1801410f;
+constexpr float ATAN_C7 = -0.0851330f;
+constexpr float ATAN_C9 = 0.0208351f;
+constexpr float HALF_PI_F = 1.57079632679f;
+constexpr float PI_F = 3.14159265359f;
+
+inline float fastAtan2(float y, float x)
+{
+    const float ax = std::abs(x), ay = std::abs(y);
+    const float a = std::min(ax, ay) / (std::max(ax, ay) + 1e-30f);
+    const float s = a * a;
+    float r = a * (ATAN_C1 + s * (ATAN_C3 + s * (ATAN_C5 + s * (ATAN_C7 + s * ATAN_C9))));
+    if (ay > ax) r = HALF_PI_F - r;
+    if (x < 0.0f) r = PI_F - r;
+    return (y < 0.0f) ? -r : r;
+}
+
+#if defined(FMDEMOD_SSE)
+inline __m128 fastAtan2(__m128 y, __m128 x)
+{
+    const __m128 sign = _mm_set1_ps(-0.0f);
+    const __m128 ax = _mm_andnot_ps(sign, x);
+    const __m128 ay = _mm_andnot_ps(sign, y);
+    const __m128 a = _mm_div_ps(_mm_min_ps(ax, ay), _mm_add_ps(_mm_max_ps(ax, ay), _mm_set1_ps(1e-30f)));
+    const __m128 s = _mm_mul_ps(a, a);
+    __m128 r = _mm_add_ps(_mm_set1_ps(ATAN_C7), _mm_mul_ps(s, _mm_set1_ps(ATAN_C9)));
+    r = _mm_add_ps(_mm_set1_ps(ATAN_C5), _mm_mul_ps(s, r));
+    r = _mm_add_ps(_mm_set1_ps(ATAN_C3), _mm_mul_ps(s, r));
+    r = _mm_add_ps(_mm_set1_ps(ATAN_C1), _mm_mul_ps(s, r));
+    r = _mm_mul_ps(a, r);
+    __m128 m = _mm_cmpgt_ps(ay, ax);
+    r = _mm_or_ps(_mm_and_ps(m, _mm_sub_ps(_mm_set1_ps(HALF_PI_F), r)), _mm_andnot_ps(m, r));
+    m = _mm_cmplt_ps(x, _mm_setzero_ps());
+    r = _mm_or_ps(_mm_and_ps(m, _mm_sub_ps(_mm_set1_ps(PI_F), r)), _mm_andnot_ps(m, r));
+    return _mm_xor_ps(r, _mm_and_ps(y, sign));
+}
+#elif defined(FMDEMOD_NEON)
+inline float32x4_t fastAtan2(float32x4_t y, float32x4_t x)
+{
+    const float32x4_t ax = vabsq_f32(x);
+    const float32x4_t ay = vabsq_f32(y);
+    const float32x4_t mx = vaddq_f32(vmaxq_f32(ax, ay), vdupq_n_f32(1e-30f));
+    // Reciprocal estimate + two Newton steps (ARMv7 has no vector divide)
+    float32x4_t inv = vrecpeq_f32(mx);
+    inv = vmulq_f32(inv, vrecpsq_f32(mx, inv));
+    inv = vmulq_f32(inv, vrecpsq_f32(mx, inv));
+    const float32x4_t a = vmulq_f32(vminq_f32(ax, ay), inv);
+    const float32x4_t s = vmulq_f32(a, a);
+    float32x4_t r = vmlaq_f32(vdupq_n_f32(ATAN_C7), s, vdupq_n_f32(ATAN_C9));
+    r = vmlaq_f32(vdupq_n_f32(ATAN_C5), s, r);
+    r = vmlaq_f32(vdupq_n_f32(ATAN_C3), s, r);
+    r = vmlaq_f32(vdupq_n_f32(ATAN_C1), s, r);
+    r = vmulq_f32(a, r);
+    r = vbslq_f32(vcgtq_f32(ay, ax), vsubq_f32(vdupq_n_f32(HALF_PI_F), r), r);
+    r = vbslq_f32(vcltq_f32(x, vdupq_n_f32(0.0f)), vsubq_f32(vdupq_n_f32(PI_F), r), r);
+    const uint32x4_t ySign = vandq_u32(vreinterpretq_u32_f32(y), vdupq_n_u32(0x80000000u));
+    return vreinterpretq_f32_u32(veorq_u32(vreinterpretq_u32_f32(r), ySign));
+}
+#endif
+
+// FIR inner product, 4 taps per step
+inline float dotProduct(const float* x, const float* h, size_t n)
+{
+    size_t j = 0;
+    float sum = 0.0f;
+#if defined(FMDEMOD_SSE)
+    __m128 acc = _mm_setzero_ps();
+    for (; j + 4 <= n; j += 4) {
+        acc = _mm_add_ps(acc, _mm_mul_ps(_mm_loadu_ps(x + j), _mm_loadu_ps(h + j)));
+    }
+    alignas(16) float lanes[4];
+    _mm_store_ps(lanes, acc);
+    sum = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+#elif defined(FMDEMOD_NEON)
+    float32x4_t acc = vdupq_n_f32(0.0f);
+    for (; j + 4 <= n; j += 4) {
+        acc = vmlaq_f32(acc, vld1q_f32(x + j), vld1q_f32(h + j));
+    }
+    float lanes[4];
+    vst1q_f32(lanes, acc);
+    sum = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+#endif
+    for (; j < n; j++) sum += x[j] * h[j];
+    return sum;
+}
+
+// Real taps over interleaved I/Q, 2 taps (4 floats) per step: each tap is
+// duplicated across its I and Q lanes with an unpack, so the samples are
+// used as loaded
+inline void complexDotProduct(const float* iq, const float* h, size_t n, float& re, float& im)
+{
+    size_t j = 0;
+    re = 0.0f;
+    im = 0.0f;
+#if defined(FMDEMOD_SSE)
+    __m128 acc0 = _mm_setzero_ps(), acc1 = _mm_setzero_ps();
+    for (; j + 4 <= n; j += 4) {
+        const __m128 t = _mm_loadu_ps(h + j);
+        acc0 = _mm_add_ps(acc0, _mm_mul_ps(_mm_loadu_ps(iq + 2 * j), _mm_unpacklo_ps(t, t)));
+        acc1 = _mm_add_ps(acc1, _mm_mul_ps(_mm_loadu_ps(iq + 2 * j + 4), _mm_unpackhi_ps(t, t)));
+    }
+    alignas(16) float lanes[4];
+    _mm_store_ps(lanes, _mm_add_ps(acc0, acc1));
+    re = lanes[0] + lanes[2];
+    im = lanes[1] + lanes[3];
+#elif defined(FMDEMOD_NEON)
+    float32x4_t acc0 = vdupq_n_f32(0.0f), acc1 = vdupq_n_f32(0.0f);
+    for (; j + 4 <= n; j += 4) {
+        const float32x4_t t = vld1q_f32(h + j);
+        const float32x4x2_t d = vzipq_f32(t, t);
+        acc0 = vmlaq_f32(acc0, vld1q_f32(iq + 2 * j), d.val[0]);
+        acc1 = vmlaq_f32(acc1, vld1q_f32(iq + 2 * j + 4), d.val[1]);
+    }
+    float lanes[4];
+    vst1q_f32(lanes, vaddq_f32(acc0, acc1));
+    re = lanes[0] + lanes[2];
+    im = lanes[1] + lanes[3];
+#endif
+    for (; j < n; j++) {
+        re += iq[2 * j] * h[j];
+        im += iq[2 * j + 1] * h[j];
+    }
+}
+
+} // namespace
+
 FMDemodulator::FMDemodulator(double inputSampleRate, double bandwidth, QObject *parent)
     : QObject(parent)
     , m_inputRate(inputSampleRate)
     , m_bandwidth(bandwidth)
-    , m_lastPhase(0.0f)
+    , m_lastSample(0.0f, 0.0f)
     , m_outputGain(1.0f)
     , m_deemphTau(0.0f)
     , m_deemphPrevL(0.0f)
@@ -21,13 +162,17 @@ std::vector<float> FMDemodulator::demodulate(const std::vector<std::complex<floa
 
     bool isWBFM = (m_bandwidth > 25000.0);
 
-    // 1. Multi-stage complex IQ decimation
-    auto iq = samples;
+    // 1. Multi-stage complex IQ decimation; the first stage reads the
+    // input in place
+    std::vector<std::complex<float>> iq;
+    const std::vector<std::complex<float>>* stageIn = &samples;
     for (auto& stage : m_iqStages) {
         std::vector<std::complex<float>> tmp;
-        decimateComplex(iq, tmp, stage.taps, stage.factor, stage.iqHistory);
+        decimateComplex(*stageIn, tmp, stage.taps, stage.factor, stage.iqHistory);
         iq = std::move(tmp);
+        stageIn = &iq;
     }
+    if (m_iqStages.empty()) iq = samples;
 
     // 2. Adjustable IQ bandwidth filter
     if (!m_iqBandwidthTaps.empty()) {
@@ -53,13 +198,14 @@ std::vector<float> FMDemodulator::demodulate(const std::vector<std::complex<floa
     // NBFM mono path
     for (auto& stage : m_realStages) {
         std::vector<float> tmp;
-        decimateReal(mpx, tmp, stage.taps, stage.factor, stage.realHistory);
+        decimateReal(mpx, tmp, stage.taps, stage.factor, stage.realHistory, stage.realPhase);
         mpx = std::move(tmp);
     }
 
     double lastRate = m_realStages.empty() ? fmRate : m_realStages.back().outputRate;
     if (std::abs(lastRate - 48000.0) > 1.0) {
-        mpx = resample(mpx, lastRate, 48000.0);
+        m_resamplerL.setRates(lastRate, 48000.0);
+        mpx = m_resamplerL.process(mpx);
     }
 
     if (m_deemphTau > 0.0f) {
@@ -118,11 +264,11 @@ std::vector<float> FMDemodulator::demodulate(const std::vector<std::complex<floa
 //   23-53 kHz: L-R on 38 kHz DSB-SC subcarrier
 //
 // Steps:
-//   1. Extract L+R with 15 kHz LPF
+//   1. Extract L+R with 15 kHz LPF, decimating to ~100 kHz
 //   2. Detect 19 kHz pilot via PLL
 //   3. Generate 38 kHz (2x pilot) reference
 //   4. Multiply MPX by 38 kHz ref → demodulate L-R
-//   5. LPF L-R at 15 kHz
+//   5. LPF L-R at 15 kHz, same decimation
 //   6. L = L+R + L-R, R = L+R - L-R
 //   7. Resample both to 48 kHz
 //   8. De-emphasis, HPF, DC removal, interleave
@@ -162,39 +308,77 @@ std::vector<float> FMDemodulator::decodeStereo(const std::vector<float>& mpx, do
     bool doStereo = stereoNow && !m_forceMono;
 
     // --- Extract L+R (mono) with 15 kHz LPF ---
+    // Decimating: only the samples the resampler needs are computed
+    const int decimPhase = m_stereoPhase;
+    const double audioRate = mpxRate / m_stereoDecim;
     std::vector<float> monoSignal;
-    applyFIR(mpx, monoSignal, m_monoFilterTaps, m_monoFilterHistory);
+    decimateReal(mpx, monoSignal, m_monoFilterTaps, m_stereoDecim, m_monoFilterHistory, m_stereoPhase);
 
     std::vector<float> leftAudio, rightAudio;
 
     if (doStereo) {
         // --- PLL-based 38 kHz carrier recovery ---
-        // Multiply MPX by 2x pilot (38 kHz) to demodulate L-R
+        // Pilot = A sin(phi), L-R rides on sin(2 phi). At lock the NCO
+        // phase theta = phi, so the 38 kHz reference sin(2 theta) = 2 sin cos
+        // comes from the NCO phasor without any trig per sample.
         std::vector<float> diffRaw(N);
-        double phaseInc = 2.0 * M_PI * 38000.0 / mpxRate;
 
-        for (size_t i = 0; i < N; i++) {
-            // Generate 38 kHz reference (2x pilot frequency)
-            float ref = static_cast<float>(std::cos(m_pilotPhase * 2.0));
-            diffRaw[i] = mpx[i] * ref * 2.0f;  // x2 to compensate DSB-SC
-
-            // Simple PLL: track pilot at 19 kHz
-            float pilotRef = static_cast<float>(std::sin(m_pilotPhase));
-            float pilotError = mpx[i] * pilotRef;
-
-            // PLL loop filter (narrow bandwidth for stable lock)
-            double loopBw = 50.0;  // Hz
-            double alpha = loopBw / mpxRate;
-            m_pilotFreq += alpha * pilotError * 0.1;
-            m_pilotFreq = std::clamp(m_pilotFreq, 18900.0, 19100.0);
-
-            m_pilotPhase += 2.0 * M_PI * m_pilotFreq / mpxRate;
-            if (m_pilotPhase > 2.0 * M_PI) m_pilotPhase -= 2.0 * M_PI;
+        // Second-order loop (20 Hz natural frequency, damping 0.707),
+        // discretised at the block rate
+        const double blockT = PILOT_BLOCK / mpxRate;
+        const double wnT = 2.0 * M_PI * 20.0 * blockT;
+        const float kp = static_cast<float>(2.0 * 0.707 * wnT);        // rad per rad of error
+        const double ki = wnT * wnT / (2.0 * M_PI * blockT);           // Hz per rad of error
+
+        float c = m_pilotCos, s = m_pilotSin;
+        double w = 2.0 * M_PI * m_pilotFreq / mpxRate;
+        float rc = static_cast<float>(std::cos(w)), rs = static_cast<float>(std::sin(w));
+        float errAcc = m_pilotErrAcc, refAcc = m_pilotRefAcc;
+
+        size_t i = 0;
+        while (i < N) {
+            const size_t run = std::min(N - i, static_cast<size_t>(PILOT_BLOCK - m_pilotCount));
+            for (const size_t end = i + run; i < end; i++) {
+                const float x = mpx[i];
+                diffRaw[i] = x * 4.0f * s * c;  // x * 2 sin(2 theta): x2 compensates DSB-SC
+                errAcc += x * c;                // -> A/2 sin(phi - theta)
+                refAcc += x * s;                // -> A/2 cos(phi - theta)
+                const float nc = c * rc - s * rs;
+                s = s * rc + c * rs;
+                c = nc;
+            }
+            m_pilotCount += static_cast<int>(run);
+            if (m_pilotCount < PILOT_BLOCK) break;
+
+            // Loop filter, once per block: the integrated products give the
+            // phase error over the full circle (no 180 degree false lock)
+            const float err = std::atan2(errAcc, refAcc);
+            m_pilotFreq = std::clamp(m_pilotFreq + ki * err, 18900.0, 19100.0);
+            w = 2.0 * M_PI * m_pilotFreq / mpxRate;
+            rc = static_cast<float>(std::cos(w));
+            rs = static_cast<float>(std::sin(w));
+
+            // Proportional phase step, and back onto the unit circle
+            const float pc = std::cos(kp * err), ps = std::sin(kp * err);
+            const float g = 1.5f - 0.5f * (c * c + s * s);
+            const float nc = (c * pc - s * ps) * g;
+            s = (s * pc + c * ps) * g;
+            c = nc;
+
+            errAcc = 0.0f;
+            refAcc = 0.0f;
+            m_pilotCount = 0;
         }
 
+        m_pilotCos = c;
+        m_pilotSin = s;
+        m_pilotErrAcc = errAcc;
+        m_pilotRefAcc = refAcc;
+
         // LPF the L-R signal at 15 kHz
         std::vector<float> diffSignal;
-        applyFIR(diffRaw, diffSignal, m_diffFilterTaps, m_diffFilterHistory);
+        int diffPhase = decimPhase;
+        decimateReal(diffRaw, diffSignal, m_diffFilterTaps, m_stereoDecim, m_diffFilterHistory, diffPhase);
 
         // L = (L+R) + (L-R), R = (L+R) - (L-R)
         size_t len = std::min(monoSignal.size(), diffSignal.size());
@@ -211,9 +395,11 @@ std::vector<float> FMDemodulator::decodeStereo(const std::vector<float>& mpx, do
     }
 
     // --- Resample L and R to 48 kHz ---
-    if (std::abs(mpxRate - 48000.0) > 1.0) {
-        leftAudio = resample(leftAudio, mpxRate, 48000.0);
-        rightAudio = resample(rightAudio, mpxRate, 48000.0);
+    if (std::abs(audioRate - 48000.0) > 1.0) {
+        m_resamplerL.setRates(audioRate, 48000.0);
+        m_resamplerR.setRates(audioRate, 48000.0);
+        leftAudio = m_resamplerL.process(leftAudio);
+        rightAudio = m_resamplerR.process(rightAudio);
     }
 
     // --- De-emphasis (per channel) ---
@@ -276,9 +462,8 @@ std::vector<float> FMDemodulator::decodeStereo(const std::vector<float>& mpx, do
 void FMDemodulator::setSampleRate(double newRate)
 {
     m_inputRate = newRate;
-    m_lastPhase = 0.0f;
-    m_pilotPhase = 0.0;
-    m_pilotFreq = 19000.0;
+    m_lastSample = {0.0f, 0.0f};
+    resetPilot();
     m_pilotLevel = 0.0f;
     rebuildChain();
 }
@@ -314,7 +499,8 @@ void FMDemodulator::rebuildChain()
     m_monoFilterHistory.clear();
     m_diffFilterHistory.clear();
     m_fmnrBuffer.clear();
-    m_resamplePhase = 0.0;
+    m_resamplerL.reset();
+    m_resamplerR.reset();
 
     double rate = m_inputRate;
     bool isNBFM = (m_bandwidth <= 25000.0);
@@ -361,6 +547,8 @@ void FMDemodulator::rebuildChain()
         // WBFM: NO real decimation here — stereo decode needs high rate
         m_monoFilterTaps = designLPF(63, 15000.0f, static_cast<float>(rate));
         m_diffFilterTaps = designLPF(63, 15000.0f, static_cast<float>(rate));
+        m_stereoDecim = std::max(1, static_cast<int>(rate / 96000.0));
+        m_stereoPhase = 0;
         m_audioFilterTaps = designLPF(31, 15000.0f, 48000.0f);
         if (m_outputGain <= 0.0f) m_outputGain = 0.5f;
     } else {
@@ -438,24 +626,25 @@ void FMDemodulator::decimateComplex(
     if (history.size() != T - 1)
         history.assign(T - 1, {0.0f, 0.0f});
 
-    // Build working buffer: [history | input]
-    std::vector<std::complex<float>> work;
-    work.reserve(history.size() + N);
-    work.insert(work.end(), history.begin(), history.end());
-    work.insert(work.end(), in.begin(), in.end());
-
-    out.clear();
-    out.reserve(N / factor + 1);
+    // Input sample i sits at i + (T-1) in [history | input]. Only outputs
+    // whose window reaches back into the history need that buffer, so just
+    // its head is built; the rest filter the input in place
+    const size_t edge = std::min(N, T - 1);
+    auto& work = m_iqWork;
+    work.assign(history.begin(), history.end());
+    work.insert(work.end(), in.begin(), in.begin() + edge);
+    const float* w = reinterpret_cast<const float*>(work.data());
+    const float* x = reinterpret_cast<const float*>(in.data());
 
-    for (size_t i = 0; i < N; i += factor) {
-        float sumR = 0.0f, sumI = 0.0f;
-        // i in input maps to i + (T-1) in work buffer, filter centered
-        for (size_t j = 0; j < T; j++) {
-            const auto& s = work[i + j];
-            sumR += s.real() * taps[j];
-            sumI += s.imag() * taps[j];
-        }
-        out.emplace_back(sumR, sumI);
+    // Only the kept outputs are computed
+    out.resize((N + factor - 1) / factor);
+    float* o = reinterpret_cast<float*>(out.data());
+    size_t i = 0, k = 0;
+    for (; i < edge; i += factor, k++) {
+        complexDotProduct(w + 2 * i, taps.data(), T, o[2 * k], o[2 * k + 1]);
+    }
+    for (; i < N; i += factor, k++) {
+        complexDotProduct(x + 2 * (i - (T - 1)), taps.data(), T, o[2 * k], o[2 * k + 1]);
     }
 
     // Save last T-1 input samples as history for next block
@@ -477,42 +666,14 @@ void FMDemodulator::applyComplexFIR(
 {
     if (in.empty() || taps.empty()) { out = in; return; }
 
-    const size_t T = taps.size();
-    const size_t N = in.size();
-
-    if (history.size() != T - 1)
-        history.assign(T - 1, {0.0f, 0.0f});
-
-    std::vector<std::complex<float>> work;
-    work.reserve(history.size() + N);
-    work.insert(work.end(), history.begin(), history.end());
-    work.insert(work.end(), in.begin(), in.end());
-
-    out.resize(N);
-    for (size_t i = 0; i < N; i++) {
-        float sumR = 0.0f, sumI = 0.0f;
-        for (size_t j = 0; j < T; j++) {
-            const auto& s = work[i + j];
-            sumR += s.real() * taps[j];
-            sumI += s.imag() * taps[j];
-        }
-        out[i] = {sumR, sumI};
-    }
-
-    if (N >= T - 1) {
-        std::copy(in.end() - (T - 1), in.end(), history.begin());
-    } else {
-        size_t keep = (T - 1) - N;
-        std::copy(history.end() - keep, history.end(), history.begin());
-        std::copy(in.begin(), in.end(), history.begin() + keep);
-    }
+    decimateComplex(in, out, taps, 1, history);
 }
 
 void FMDemodulator::decimateReal(
     const std::vector<float>& in,
     std::vector<float>& out,
     const std::vector<float>& taps, int factor,
-    std::vector<float>& history)
+    std::vector<float>& history, int& phase)
 {
     const size_t T = taps.size();
     const size_t N = in.size();
@@ -520,21 +681,25 @@ void FMDemodulator::decimateReal(
     if (history.size() != T - 1)
         history.assign(T - 1, 0.0f);
 
-    std::vector<float> work;
-    work.reserve(history.size() + N);
-    work.insert(work.end(), history.begin(), history.end());
-    work.insert(work.end(), in.begin(), in.end());
+    // As in decimateComplex, only the head of [history | input] is built
+    const size_t edge = std::min(N, T - 1);
+    auto& work = m_realWork;
+    work.assign(history.begin(), history.end());
+    work.insert(work.end(), in.begin(), in.begin() + edge);
 
     out.clear();
     out.reserve(N / factor + 1);
 
-    for (size_t i = 0; i < N; i += factor) {
-        float sum = 0.0f;
-        for (size_t j = 0; j < T; j++) {
-            sum += work[i + j] * taps[j];
-        }
-        out.push_back(sum);
+    // Carry the decimation phase, so blocks that are not a multiple of
+    // the factor long neither drop nor repeat samples
+    size_t i = static_cast<size_t>(phase);
+    for (; i < edge; i += factor) {
+        out.push_back(dotProduct(work.data() + i, taps.data(), T));
     }
+    for (; i < N; i += factor) {
+        out.push_back(dotProduct(in.data() + i - (T - 1), taps.data(), T));
+    }
+    phase = static_cast<int>(i - N);
 
     if (N >= T - 1) {
         std::copy(in.end() - (T - 1), in.end(), history.begin());
@@ -559,18 +724,13 @@ void FMDemodulator::applyFIR(
     if (history.size() != T - 1)
         history.assign(T - 1, 0.0f);
 
-    std::vector<float> work;
-    work.reserve(history.size() + N);
-    work.insert(work.end(), history.begin(), history.end());
+    auto& work = m_realWork;
+    work.assign(history.begin(), history.end());
     work.insert(work.end(), in.begin(), in.end());
 
     out.resize(N);
     for (size_t i = 0; i < N; i++) {
-        float sum = 0.0f;
-        for (size_t j = 0; j < T; j++) {
-            sum += work[i + j] * taps[j];
-        }
-        out[i] = sum;
+        out[i] = dotProduct(work.data() + i, taps.data(), T);
     }
 
     if (N >= T - 1) {
@@ -585,11 +745,15 @@ void FMDemodulator::applyFIR(
 // FM Demodulation — SDR++/GNU Radio Quadrature Demod approach
 // gain = sampleRate / (2π × deviation)
 // For NBFM 12.5kHz BW at 50kHz rate: deviation = 6250, gain = 1.273
+//
+// Phase step = arg(x[n] * conj(x[n-1])): no unwrapping, and with the
+// polynomial atan2 it runs 4 samples per step on SSE/NEON.
 std::vector<float> FMDemodulator::fmDemod(const std::vector<std::complex<float>>& signal, double rate)
 {
     if (signal.empty()) return {};
 
-    std::vector<float> out(signal.size());
+    const size_t n = signal.size();
+    std::vector<float> out(n);
 
     bool isNBFM = (m_bandwidth <= 25000.0);
 
@@ -600,68 +764,53 @@ std::vector<float> FMDemodulator::fmDemod(const std::vector<std::complex<float>>
     float deviationRads = 2.0f * static_cast<float>(M_PI) * deviation / static_cast<float>(rate);
     float gain = 1.0f / deviationRads;
 
-    for (size_t i = 0; i < signal.size(); i++) {
-        float cphase = std::atan2(signal[i].imag(), signal[i].real());
-
-        float delta = cphase - m_lastPhase;
-
-        if (delta > static_cast<float>(M_PI)) delta -= 2.0f * static_cast<float>(M_PI);
-        if (delta < -static_cast<float>(M_PI)) delta += 2.0f * static_cast<float>(M_PI);
-
-        out[i] = delta * gain;
-
-        // Clamp FM demod output to reasonable range (±1.0)
-        // Real NFM with 2.5kHz deviation at 50kHz rate produces ±0.3 max
-        // Anything beyond ±1.0 is phase noise or transient
-        if (out[i] > 1.0f) out[i] = 1.0f;
-        else if (out[i] < -1.0f) out[i] = -1.0f;
-
-        m_lastPhase = cphase;
-    }
-
-    return out;
-}
-
-// Stateful windowed sinc resampler — carries fractional phase between blocks
-std::vector<float> FMDemodulator::resample(const std::vector<float>& in, double inRate, double outRate)
-{
-    if (in.empty()) return in;
-    double ratio = inRate / outRate;
-    std::vector<float> out;
-    out.reserve(static_cast<size_t>(in.size() / ratio) + 1);
-
-    const int halfKernel = 3;
-    double pos = m_resamplePhase;  // start from where last block ended
-
-    while (pos < static_cast<double>(in.size())) {
-        int center = static_cast<int>(pos);
-        double frac = pos - center;
-
-        float sample = 0.0f;
-        float weightSum = 0.0f;
-        for (int j = -halfKernel + 1; j <= halfKernel; j++) {
-            int idx = center + j;
-            if (idx < 0 || idx >= static_cast<int>(in.size())) continue;
-            double x = j - frac;
-            float sinc = (std::abs(x) < 1e-6) ? 1.0f
-                : static_cast<float>(std::sin(x * M_PI) / (x * M_PI));
-            double wpos = (j - frac + halfKernel) / (2.0 * halfKernel);
-            float w = 0.35875f - 0.48829f * std::cos(2.0f * static_cast<float>(M_PI) * wpos)
-                     + 0.14128f * std::cos(4.0f * static_cast<float>(M_PI) * wpos)
-                     - 0.01168f * std::cos(6.0f * static_cast<float>(M_PI) * wpos);
-            float weight = sinc * w;
-            sample += in[idx] * weight;
-            weightSum += weight;
-        }
-        if (weightSum > 0.0f) sample /= weightSum;
-        out.push_back(sample);
-
-        pos += ratio;
-    }
-
-    // Save fractional remainder for next block
-    m_resamplePhase = pos - static_cast<double>(in.size());
-
+    // Clamp FM demod output to reasonable range (±1.0)
+    // Real NFM with 2.5kHz deviation at 50kHz rate produces ±0.3 max
+    // Anything beyond ±1.0 is phase noise or transient
+    auto discriminate = [gain](float pr, float pi, float cr, float ci) {
+        const float d = fastAtan2(ci * pr - cr * pi, cr * pr + ci * pi) * gain;
+        return std::clamp(d, -1.0f, 1.0f);
+    };
+
+    const float* iq = reinterpret_cast<const float*>(signal.data());
+    out[0] = discriminate(m_lastSample.real(), m_lastSample.imag(), iq[0], iq[1]);
+    size_t i = 1;
+
+#if defined(FMDEMOD_SSE)
+    const __m128 g = _mm_set1_ps(gain);
+    const __m128 lo = _mm_set1_ps(-1.0f), hi = _mm_set1_ps(1.0f);
+    for (; i + 4 <= n; i += 4) {
+        const __m128 p0 = _mm_loadu_ps(iq + 2 * (i - 1));
+        const __m128 p1 = _mm_loadu_ps(iq + 2 * (i - 1) + 4);
+        const __m128 c0 = _mm_loadu_ps(iq + 2 * i);
+        const __m128 c1 = _mm_loadu_ps(iq + 2 * i + 4);
+        const __m128 pr = _mm_shuffle_ps(p0, p1, _MM_SHUFFLE(2, 0, 2, 0));
+        const __m128 pi = _mm_shuffle_ps(p0, p1, _MM_SHUFFLE(3, 1, 3, 1));
+        const __m128 cr = _mm_shuffle_ps(c0, c1, _MM_SHUFFLE(2, 0, 2, 0));
+        const __m128 ci = _mm_shuffle_ps(c0, c1, _MM_SHUFFLE(3, 1, 3, 1));
+        const __m128 re = _mm_add_ps(_mm_mul_ps(cr, pr), _mm_mul_ps(ci, pi));
+        const __m128 im = _mm_sub_ps(_mm_mul_ps(ci, pr), _mm_mul_ps(cr, pi));
+        const __m128 d = _mm_mul_ps(fastAtan2(im, re), g);
+        _mm_storeu_ps(out.data() + i, _mm_min_ps(_mm_max_ps(d, lo), hi));
+    }
+#elif defined(FMDEMOD_NEON)
+    const float32x4_t g = vdupq_n_f32(gain);
+    const float32x4_t lo = vdupq_n_f32(-1.0f), hi = vdupq_n_f32(1.0f);
+    for (; i + 4 <= n; i += 4) {
+        const float32x4x2_t p = vld2q_f32(iq + 2 * (i - 1));
+        const float32x4x2_t c = vld2q_f32(iq + 2 * i);
+        const float32x4_t re = vmlaq_f32(vmulq_f32(c.val[0], p.val[0]), c.val[1], p.val[1]);
+        const float32x4_t im = vmlsq_f32(vmulq_f32(c.val[1], p.val[0]), c.val[0], p.val[1]);
+        const float32x4_t d = vmulq_f32(fastAtan2(im, re), g);
+        vst1q_f32(out.data() + i, vminq_f32(vmaxq_f32(d, lo), hi));
+    }
+#endif
+
+    for (; i < n; i++) {
+        out[i] = discriminate(iq[2 * (i - 1)], iq[2 * (i - 1) + 1], iq[2 * i], iq[2 * i + 1]);
+    }
+
+    m_lastSample = signal.back();
     return out;
 }
 
@@ -676,6 +825,16 @@ void FMDemodulator::removeDC(float& dcX1, float& dcY1, std::vector<float>& audio
     }
 }
 
+void FMDemodulator::resetPilot()
+{
+    m_pilotCos = 1.0f;
+    m_pilotSin = 0.0f;
+    m_pilotFreq = 19000.0;
+    m_pilotErrAcc = 0.0f;
+    m_pilotRefAcc = 0.0f;
+    m_pilotCount = 0;
+}
+
 // ========== FM IF Noise Reduction ==========
 // Two-stage approach:
 // 1. IQ Hard Limiter — normalize each sample to unit magnitude.
@@ -1,6 +1,8 @@
 #include "mainwindow.h"
+#include "threadplacement.h"
 
 #include <QApplication>
+#include <QCommandLineParser>
 #include <QtWidgets/QStyleFactory>
 #include <QDebug>
 #include <QMessageBox>
@@ -16,6 +18,22 @@ int main(int argc, char *argv[])
     QApplication a(argc, argv);
     a.setWindowIcon(QIcon(":/ico/hacktv.ico"));
 
+    // Hot thread scheduling (threadplacement.h); HackTvLib locks memory on start
+    QCommandLineParser parser;
+    QCommandLineOption threadOption(QStringList() << "thread",
+                                    QString("Scheduling and CPUs of a group of hot threads, repeatable: %1")
+                                        .arg(ThreadPlacement::usage()), "role=settings");
+    QCommandLineOption mlockOption(QStringList() << "mlock", "Lock the process memory (mlockall) once the radio runs");
+    parser.addOption(threadOption);
+    parser.addOption(mlockOption);
+    parser.parse(a.arguments());
+    for (const QString& spec : parser.values(threadOption)) {
+        std::string error;
+        if (!ThreadPlacement::parse(spec.toStdString(), &error))
+            qDebug() << "Ignoring --thread:" << QString::fromStdString(error);
+    }
+    ThreadPlacement::setLockMemory(parser.isSet(mlockOption));
+
     a.setStyle(QStyleFactory::create("Fusion"));
 
     // Setup palette with cyber blue-green accents for SDR tech look
@@ -1,4 +1,5 @@
 #include "mainwindow.h"
+#include "threadplacement.h"
 #include <QApplication>
 #include <QFuture>
 #include <QLabel>
@@ -28,6 +29,7 @@ MainWindow::MainWindow(QWidget *parent)
     QString homePath = QStandardPaths::writableLocation(QStandardPaths::HomeLocation);
     m_sSettingsFile = homePath + "/hacktv_settings.ini";
 
+    m_scanner = new BandScanner(this);
     if (QFile::exists(m_sSettingsFile)) loadSettings();
 
     logBrowser = new QTextBrowser(this);
@@ -37,10 +39,41 @@ MainWindow::MainWindow(QWidget *parent)
 
     m_threadPool = new QThreadPool(this);
     m_threadPool->setMaxThreadCount(QThread::idealThreadCount() / 2);
+    // Demodulation in order on one thread: the demodulators keep state and
+    // the audio ring takes a single producer
+    m_demodPool = new QThreadPool(this);
+    m_demodPool->setMaxThreadCount(1);
 
     setupUi();
     applyModePresets();
 
+    // Band scanner: retunes through HackTvLib; the blocks still in flight
+    // from the previous hop carry an older epoch and are dropped
+    connect(m_scanner, &BandScanner::retuneRequested, this, [this](quint64 freq) {
+        if (!m_hackTvLib) return;
+        m_hackTvLib->setFrequency(freq);
+        m_scanEpoch = m_hackTvLib->tuneEpoch();
+        cPlotter->setCenterFreq(freq);
+    });
+    connect(m_scanner, &BandScanner::activity, this, [this](const BandScanner::Activity& a) {
+        pendingLogs.append(QString("Scan %1 %2 MHz %3 (%4 dBFS, %5 dB over floor) %6%7")
+                               .arg(a.time.toString("HH:mm:ss.zzz"))
+                               .arg(a.frequency / 1e6, 0, 'f', 5)
+                               .arg(a.open ? "active" : "quiet")
+                               .arg(a.levelDb, 0, 'f', 1)
+                               .arg(a.snrDb, 0, 'f', 1)
+                               .arg(a.label)
+                               .arg(a.priority ? " (priority)" : ""));
+    });
+    connect(m_scanner, &BandScanner::sweepCompleted, this, [this](double mhzPerSecond, double sweepMs, double retuneMs) {
+        scanButton->setText(QString("SCAN %1 MHz/s").arg(mhzPerSecond, 0, 'f', 0));
+        if (m_scanLogTimer.isValid() && m_scanLogTimer.elapsed() < 10000) return;
+        m_scanLogTimer.start();
+        pendingLogs.append(QString("Scan: %1 hops in %2 ms, %3 MHz/s, %4 ms per retune")
+                               .arg(m_scanner->hopCount()).arg(sweepMs, 0, 'f', 0)
+                               .arg(mhzPerSecond, 0, 'f', 1).arg(retuneMs, 0, 'f', 1));
+    });
+
     logTimer = new QTimer(this);
     connect(logTimer, &QTimer::timeout, this, &MainWindow::updateLogDisplay);
     logTimer->start(500);
@@ -60,6 +93,8 @@ MainWindow::~MainWindow()
         delete m_hackTvLib;
         m_hackTvLib = nullptr;
     }
+    // Queued demodulation still writes into audioOutput
+    if (m_demodPool) m_demodPool->waitForDone();
 }
 
 // ============================================================
@@ -127,7 +162,19 @@ void MainWindow::setupUi()
     exitButton->setMinimumHeight(28);
     connect(exitButton, &QPushButton::clicked, this, &MainWindow::exitApp);
 
+    latencyButton = new QPushButton("LATENCY", this);
+    latencyButton->setMinimumHeight(28);
+    connect(latencyButton, &QPushButton::clicked, this, &MainWindow::logLatencyReport);
+
+    scanButton = new QPushButton("SCAN", this);
+    scanButton->setMinimumHeight(28);
+    scanButton->setCheckable(true);
+    scanButton->setStyleSheet("QPushButton:checked { background-color: #1f6feb; color: #ffffff; }");
+    connect(scanButton, &QPushButton::toggled, this, &MainWindow::setScanning);
+
     btnLayout->addWidget(startStopButton, 2);
+    btnLayout->addWidget(scanButton, 1);
+    btnLayout->addWidget(latencyButton, 1);
     btnLayout->addWidget(hardResetButton, 1);
     btnLayout->addWidget(exitButton, 1);
     mainLayout->addLayout(btnLayout);
@@ -232,6 +279,25 @@ void MainWindow::addDeviceGroup()
         if (m_initDone) saveSettings();
     });
 
+    // AM detector, in the stereo checkbox's place for AM Radio
+    amDetectorCombo = new QComboBox(this);
+    amDetectorCombo->addItem("Envelope", AMDemodulator::Envelope);
+    amDetectorCombo->addItem("SAM",      AMDemodulator::Synchronous);
+    amDetectorCombo->addItem("USB",      AMDemodulator::UpperSideband);
+    amDetectorCombo->addItem("LSB",      AMDemodulator::LowerSideband);
+    amDetectorCombo->setCurrentIndex(m_amDetector);
+    amDetectorCombo->setVisible(false);
+    connect(amDetectorCombo, QOverload<int>::of(&QComboBox::currentIndexChanged), [this](int index) {
+        m_amDetector = amDetectorCombo->itemData(index).toInt();
+        if (m_opMode == MODE_AM) m_stereoLabel->setText(AMDemodulator::modeName(AMDemodulator::Mode(m_amDetector)));
+        // The demod thread owns the chain, switch between blocks
+        const int detector = m_amDetector;
+        QtConcurrent::run(m_demodPool, [this, detector]() {
+            if (amDemodulator) amDemodulator->setMode(AMDemodulator::Mode(detector));
+        });
+        if (m_initDone) saveSettings();
+    });
+
     lay->addWidget(devLabel, 0, 0);
     lay->addWidget(outputCombo, 0, 1);
     lay->addWidget(modeLabel, 0, 2);
@@ -240,6 +306,7 @@ void MainWindow::addDeviceGroup()
     lay->addWidget(sampleRateCombo, 1, 1);
     lay->addWidget(ampEnabled, 1, 2);
     lay->addWidget(stereoEnabled, 1, 3);
+    lay->addWidget(amDetectorCombo, 1, 3);
     lay->addWidget(tcpAddressLabel, 1, 4);
     lay->addWidget(tcpAddressEdit, 1, 5);
 
@@ -279,6 +346,7 @@ void MainWindow::addRxGroup()
     connect(cPlotter, &CPlotter::newDemodFreq, this, &MainWindow::on_plotter_newDemodFreq);
     connect(cPlotter, &CPlotter::newFilterFreq, this, &MainWindow::on_plotter_newFilterFreq);
     connect(cPlotter, &CPlotter::wheelFreqChange, this, [this](int dir) {
+        scanButton->setChecked(false);
         qint64 step = freqCtrl->getActiveStep();
         m_frequency += dir * step;
         freqCtrl->setFrequency(m_frequency);
@@ -643,10 +711,11 @@ void MainWindow::onOperatingModeChanged(int index)
 
     // Stereo checkbox only relevant for WFM
     stereoEnabled->setVisible(m_opMode == MODE_WFM);
+    amDetectorCombo->setVisible(m_opMode == MODE_AM);
 
     // Stereo label
     if (m_opMode == MODE_AM) {
-        m_stereoLabel->setText("AM");
+        m_stereoLabel->setText(AMDemodulator::modeName(AMDemodulator::Mode(m_amDetector)));
         m_stereoLabel->setStyleSheet("QLabel { font-weight: bold; font-size: 18px; color: #FF9900; }");
     } else if (isTvMode) {
         m_stereoLabel->setText("");
@@ -902,16 +971,40 @@ void MainWindow::startRx()
     });
 
     if (!isTvTx && !isFmFileTx) {
-        m_hackTvLib->setReceivedDataCallback([this](const int8_t* data, size_t len) {
+        // Full-rate IQ feeds the spectrum (and the scanner) only; the
+        // demodulator gets the channel from HackTvLib's DDC, already
+        // decimated on its DSP thread
+        HackTvLib* lib = m_hackTvLib;
+        m_hackTvLib->setReceivedDataCallback([this, lib](const int8_t* data, size_t len) {
             if (!m_isProcessing.load() || !data || len != 262144 || m_shuttingDown.load() || m_isTx) return;
+            if (m_scanning.load()) {
+                const quint32 epoch = lib->blockEpoch();
+                QByteArray block(reinterpret_cast<const char*>(data), static_cast<int>(len));
+                QMetaObject::invokeMethod(this, [this, block, epoch]() {
+                    processScanBlock(block, epoch);
+                }, Qt::QueuedConnection);
+            }
             const int n = len / 2;
             auto sp = std::make_shared<std::vector<std::complex<float>>>(n);
             for (int i = 0; i < n; i++)
                 (*sp)[i] = std::complex<float>(static_cast<int8_t>(data[i*2]) / 128.0f,
                                                static_cast<int8_t>(data[i*2+1]) / 128.0f);
-            QtConcurrent::run(m_threadPool, [this, sp]() { processDemod(*sp); });
             QtConcurrent::run(m_threadPool, [this, sp]() { processFft(*sp); });
         });
+
+        DdcConfig ddc;
+        ddc.outputRate = (m_opMode == MODE_WFM) ? 400000.0 : 200000.0;
+        m_hackTvLib->setDdc(ddc, [this](const DdcBlock& block) {
+            // Nothing to listen to while the scanner hops
+            if (!m_isProcessing.load() || m_shuttingDown.load() || m_isTx || m_scanning.load()) return;
+            auto sp = std::make_shared<std::vector<std::complex<float>>>(block.iq, block.iq + block.samples);
+            const qint64 queuedUs = LatencyHistogram::steadyUs();
+            const qint64 captureUs = static_cast<qint64>(block.timeUs);
+            const double rate = block.sampleRate;
+            QtConcurrent::run(m_demodPool, [this, sp, queuedUs, captureUs, rate]() {
+                processDemod(*sp, queuedUs, captureUs, rate);
+            });
+        });
     }
 
     if (!m_hackTvLib->start()) {
@@ -936,10 +1029,12 @@ void MainWindow::startRx()
     if (!isTvTx && !isFmFileTx) {
         amDemodulator.reset();
         fmDemodulator.reset();
+        m_demodRate.store(static_cast<double>(m_sampleRate));
 
         if (m_opMode == MODE_AM) {
             amDemodulator = std::make_unique<AMDemodulator>(
                 static_cast<double>(m_sampleRate), static_cast<double>(m_rxBandwidth));
+            amDemodulator->setMode(AMDemodulator::Mode(m_amDetector));
 
         } else {
             double fmBw = (m_opMode == MODE_WFM) ? 150000.0 : 12500.0;
@@ -995,6 +1090,7 @@ void MainWindow::startRx()
 
 void MainWindow::stopAll()
 {
+    scanButton->setChecked(false);
     m_isProcessing.store(false);
     m_isTx = false;
     stopMicCapture();
@@ -1028,7 +1124,17 @@ void MainWindow::onPttPressed()
     if (m_opMode < MODE_NFM || m_opMode > MODE_AM) return;
 
     qDebug() << "=== PTT PRESSED ===";
+    scanButton->setChecked(false);
     m_isTx = true;
+    const qint64 pttUs = LatencyHistogram::steadyUs();
+
+    // HackRF: the running device turns around, RX callbacks and DDC stay
+    // and drop their blocks while m_isTx is set
+    m_pttWarm = m_hackTvLib->switchToTx();
+    if (m_pttWarm) {
+        startPttTx(pttUs);
+        return;
+    }
 
     // Stop current RX, reinitialize as TX
     m_hackTvLib->clearCallbacks();
@@ -1070,6 +1176,12 @@ void MainWindow::onPttPressed()
     }
 
     QThread::msleep(200);
+    startPttTx(pttUs);
+}
+
+// TX side of PTT once the device transmits; pttUs: when PTT was pressed
+void MainWindow::startPttTx(qint64 pttUs)
+{
     m_hackTvLib->enableExternalAudioRing();
 
     // Set TX params
@@ -1105,6 +1217,7 @@ void MainWindow::onPttPressed()
         "font-size: 16px; font-weight: bold; color: #FF4444; "
         "background-color: #3A1A1A; border: 2px solid #FF4444; border-radius: 8px; padding: 6px;");
 
+    m_pttSwitch.record(LatencyHistogram::steadyUs() - pttUs);
     qDebug() << "TX mode active - modType:" << txModType;
 }
 
@@ -1114,6 +1227,18 @@ void MainWindow::onPttReleased()
 
     qDebug() << "=== PTT RELEASED ===";
     m_isTx = false;
+    const qint64 pttUs = LatencyHistogram::steadyUs();
+
+    // Warm switch: demodulators, callbacks and DDC were kept through TX.
+    // A TX instance built on press has no RX side and restarts.
+    if (m_pttWarm && m_hackTvLib && m_hackTvLib->switchToRx()) {
+        txRxIndicator->setText("RX - Listening");
+        txRxIndicator->setStyleSheet(
+            "font-size: 16px; font-weight: bold; color: #00FF66; "
+            "background-color: #1A3A1A; border: 2px solid #00FF66; border-radius: 8px; padding: 6px;");
+        m_pttSwitch.record(LatencyHistogram::steadyUs() - pttUs);
+        return;
+    }
 
     // Stop TX, go back to RX
     if (m_hackTvLib) {
@@ -1126,6 +1251,7 @@ void MainWindow::onPttReleased()
 
     // Restart RX
     startRx();
+    m_pttSwitch.record(LatencyHistogram::steadyUs() - pttUs);
 }
 
 // ============================================================
@@ -1221,10 +1347,28 @@ QStringList MainWindow::buildTvTxCommand()
 // IQ Processing
 // ============================================================
 
-void MainWindow::processDemod(const std::vector<std::complex<float>>& samples)
+void MainWindow::dispatchIq(const std::shared_ptr<std::vector<std::complex<float>>>& samples, qint64 captureUs)
+{
+    const qint64 queuedUs = LatencyHistogram::steadyUs();
+    QtConcurrent::run(m_demodPool, [this, samples, queuedUs, captureUs]() {
+        processDemod(*samples, queuedUs, captureUs);
+    });
+    QtConcurrent::run(m_threadPool, [this, samples]() { processFft(*samples); });
+}
+
+void MainWindow::processDemod(const std::vector<std::complex<float>>& samples, qint64 queuedUs, qint64 captureUs, double rate)
 {
     if (!audioOutput || m_isTx) return;
+    ThreadPlacement::apply(ThreadPlacement::Dsp);
+    const qint64 startUs = LatencyHistogram::steadyUs();
+    m_demodDispatch.record(startUs - queuedUs);
     try {
+        // DDC blocks carry their rate; it changes with the device sample rate
+        if (rate > 0.0 && rate != m_demodRate.load()) {
+            m_demodRate.store(rate);
+            if (fmDemodulator) fmDemodulator->setSampleRate(rate);
+            if (amDemodulator) amDemodulator->setSampleRate(rate);
+        }
         std::vector<float> audio;
         if (m_opMode == MODE_AM && amDemodulator) {
             auto mono = amDemodulator->demodulate(samples);
@@ -1272,10 +1416,18 @@ void MainWindow::processDemod(const std::vector<std::complex<float>>& samples)
     } catch (const std::exception& e) {
         qCritical() << "Demod error:" << e.what();
     }
+
+    m_demodLatency.record(LatencyHistogram::steadyUs() - startUs);
+    const double audioMs = audioOutput->latencyMs();
+    m_audioOut.recordMs(audioMs);
+    if (captureUs) {
+        m_rxTotal.record(LatencyHistogram::utcUs() - captureUs + static_cast<int64_t>(audioMs * 1000.0));
+    }
 }
 
 void MainWindow::processFft(const std::vector<std::complex<float>>& samples)
 {
+    ThreadPlacement::apply(ThreadPlacement::Dsp);
     static QMutex fftMutex;
     QMutexLocker locker(&fftMutex);
 
@@ -1307,6 +1459,8 @@ void MainWindow::updatePlotter(float* fft_data, int size)
 
 void MainWindow::onFreqCtrl_setFrequency(qint64 freq)
 {
+    // Tuning by hand ends the scan
+    scanButton->setChecked(false);
     m_frequency = freq;
     cPlotter->setCenterFreq(static_cast<quint64>(freq));
     if (m_isProcessing && m_hackTvLib) m_hackTvLib->setFrequency(freq);
@@ -1317,6 +1471,7 @@ void MainWindow::onFreqCtrl_setFrequency(qint64 freq)
 void MainWindow::on_plotter_newDemodFreq(qint64 freq, qint64 delta)
 {
     (void)delta;
+    scanButton->setChecked(false);
     m_frequency = freq;
     cPlotter->setCenterFreq(static_cast<quint64>(freq));
     freqCtrl->setFrequency(freq);
@@ -1344,8 +1499,12 @@ void MainWindow::onSampleRateChanged(int index)
     cPlotter->setSpanFreq(static_cast<quint32>(m_sampleRate));
     if (m_isProcessing && m_hackTvLib) m_hackTvLib->setSampleRate(m_sampleRate);
     if (m_tcpConnected) sendTcpCommand(QString("SET_SAMPLE_RATE:%1").arg(m_sampleRate));
-    if (fmDemodulator) fmDemodulator->setSampleRate(static_cast<double>(m_sampleRate));
-    if (amDemodulator) amDemodulator->setSampleRate(static_cast<double>(m_sampleRate));
+    // Behind the DDC the demodulators follow the rate of its blocks instead
+    const bool ddc = m_isProcessing && m_hackTvLib && m_hackTvLib->ddcOutputRate() > 0.0;
+    if (!ddc && fmDemodulator) fmDemodulator->setSampleRate(static_cast<double>(m_sampleRate));
+    if (!ddc && amDemodulator) amDemodulator->setSampleRate(static_cast<double>(m_sampleRate));
+    // New rate, new hop plan
+    if (m_scanner->isRunning()) setScanning(true);
     saveSettings();
 }
 
@@ -1365,6 +1524,57 @@ void MainWindow::setCurrentSampleRate(int sr)
     if (idx >= 0) sampleRateCombo->setCurrentIndex(idx);
 }
 
+// ============================================================
+// Band scanner
+// ============================================================
+
+// Turning on while running restarts with the current rate
+void MainWindow::setScanning(bool on)
+{
+    if (on) {
+        // Hops a local receiver only; TCP mode and TX have no retune epoch
+        const bool radioRx = m_opMode >= MODE_NFM && m_opMode <= MODE_AM;
+        if (!m_isProcessing.load() || !m_hackTvLib || m_isTx || isTcpMode() || !radioRx) {
+            scanButton->setChecked(false);
+            return;
+        }
+        const QString dir = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
+        QDir().mkpath(dir);
+        m_scanner->setLogFile(dir + "/scan.csv");
+        m_scanner->setSampleRate(m_sampleRate);
+        m_scanner->setRetuneConfirmation(true);
+        // A restart does not know where the radio is: always retune first
+        const quint64 tuned = m_scanner->isRunning() ? 0 : static_cast<quint64>(m_frequency);
+        m_scanEpoch = m_hackTvLib->tuneEpoch();
+        m_scanning.store(true);
+        if (!m_scanner->start(tuned)) {
+            m_scanning.store(false);
+            scanButton->setChecked(false);
+            pendingLogs.append("Scan: no channels in the band list");
+            return;
+        }
+        m_scanLogTimer.invalidate();
+        pendingLogs.append(QString("Scanning %1 hops, activity logged to %2/scan.csv").arg(m_scanner->hopCount()).arg(dir));
+        return;
+    }
+
+    if (!m_scanner->isRunning()) return;
+    m_scanning.store(false);
+    m_scanner->stop();
+    scanButton->setText("SCAN");
+    // Back to the frequency on the dial
+    if (m_isProcessing.load() && m_hackTvLib) m_hackTvLib->setFrequency(m_frequency);
+    cPlotter->setCenterFreq(static_cast<quint64>(m_frequency));
+}
+
+void MainWindow::processScanBlock(const QByteArray& block, quint32 epoch)
+{
+    // In flight when the radio hopped: still the previous frequency
+    if (!m_scanner->isRunning() || epoch != m_scanEpoch) return;
+    m_scanner->onRetuned();
+    m_scanner->processIq(block);
+}
+
 // ============================================================
 // HackTvLib Init
 // ============================================================
@@ -1589,6 +1799,22 @@ void MainWindow::hardReset()
     m_fftUpdatePending.storeRelease(0);
 }
 
+void MainWindow::logLatencyReport()
+{
+    // Ours, then HackTvLib's USB and TX stages; both start over afterwards
+    QString report = QString::fromStdString(m_latency.report());
+    if (m_hackTvLib) report += QString::fromStdString(m_hackTvLib->latency().report());
+    if (report.isEmpty()) report = "no samples yet\n";
+    for (const std::string& line : ThreadPlacement::report()) {
+        report += "threads " + QString::fromStdString(line) + "\n";
+    }
+    qDebug().noquote() << "Latency (ms):\n" + report.trimmed();
+    pendingLogs.append("Latency (ms):");
+    pendingLogs.append(report.trimmed().split('\n'));
+    m_latency.reset();
+    if (m_hackTvLib) m_hackTvLib->latency().reset();
+}
+
 void MainWindow::updateLogDisplay()
 {
     if (!pendingLogs.isEmpty()) {
@@ -1617,8 +1843,18 @@ void MainWindow::saveSettings()
     s.setValue("rxModIndex_i", static_cast<int>(rxModIndex * 1000));
     s.setValue("rxDeemph", rxDeemph);
     s.setValue("rxBandwidth", m_rxBandwidth);
+    s.setValue("amDetector", m_amDetector);
     s.setValue("ampEnabled", ampEnabled->isChecked());
     s.endGroup();
+
+    // Scanner: "label:start:stop:step:bandwidth" per band, "frequency:bandwidth[:label]" per priority channel
+    const BandScanner::Config& scan = m_scanner->config();
+    s.beginGroup("Scan");
+    s.setValue("bands", BandScanner::formatBands(scan.bands));
+    s.setValue("priority", BandScanner::formatChannels(scan.priority));
+    s.setValue("dwellMs", scan.dwellMs);
+    s.setValue("thresholdDb", scan.thresholdDb);
+    s.endGroup();
 }
 
 void MainWindow::loadSettings()
@@ -1640,7 +1876,17 @@ void MainWindow::loadSettings()
     if (s.contains("rxModIndex_i")) rxModIndex = s.value("rxModIndex_i").toInt() / 1000.0f;
     rxDeemph = s.value("rxDeemph", 0).toInt();
     m_rxBandwidth = s.value("rxBandwidth", 12500).toInt();
+    m_amDetector = std::clamp(s.value("amDetector", 0).toInt(), 0, AMDemodulator::MODE_COUNT - 1);
+    s.endGroup();
+
+    BandScanner::Config scan = m_scanner->config();
+    s.beginGroup("Scan");
+    if (s.contains("bands")) scan.bands = BandScanner::parseBands(s.value("bands").toStringList());
+    scan.priority = BandScanner::parseChannels(s.value("priority").toStringList());
+    scan.dwellMs = s.value("dwellMs", scan.dwellMs).toInt();
+    scan.thresholdDb = s.value("thresholdDb", scan.thresholdDb).toFloat();
     s.endGroup();
+    m_scanner->setConfig(scan);
 }
 
 void MainWindow::closeEvent(QCloseEvent *event)
@@ -1735,8 +1981,7 @@ void MainWindow::startTcpRx()
                     (*sp)[i] = std::complex<float>((data[i*2] - 127.5f) / 128.0f,
                                                     (data[i*2+1] - 127.5f) / 128.0f);
 
-                QtConcurrent::run(m_threadPool, [this, sp]() { processDemod(*sp); });
-                QtConcurrent::run(m_threadPool, [this, sp]() { processFft(*sp); });
+                dispatchIq(sp);
             }
         });
 
@@ -1809,8 +2054,7 @@ void MainWindow::startTcpRx()
                 for (int i = 0; i < n; i++)
                     (*sp)[i] = std::complex<float>(data[i*2] / 128.0f, data[i*2+1] / 128.0f);
 
-                QtConcurrent::run(m_threadPool, [this, sp]() { processDemod(*sp); });
-                QtConcurrent::run(m_threadPool, [this, sp]() { processFft(*sp); });
+                dispatchIq(sp);
             }
         });
 
@@ -1833,6 +2077,7 @@ void MainWindow::startTcpRx()
     if (m_opMode == MODE_AM) {
         amDemodulator = std::make_unique<AMDemodulator>(
             static_cast<double>(m_sampleRate), static_cast<double>(m_rxBandwidth));
+        amDemodulator->setMode(AMDemodulator::Mode(m_amDetector));
     } else {
         double fmBw = (m_opMode == MODE_WFM) ? 150000.0 : 12500.0;
         fmDemodulator = std::make_unique<FMDemodulator>(
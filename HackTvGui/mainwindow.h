@@ -23,11 +23,13 @@
 #include <QLabel>
 #include <QKeyEvent>
 #include <QTcpSocket>
+#include <QElapsedTimer>
 
 #include <memory>
 #include <vector>
 #include <complex>
 #include "hacktvlib.h"
+#include "latencyhistogram.h"
 #include "freqctrl.h"
 #include "glplotter.h"
 #include "meter.h"
@@ -35,6 +37,7 @@
 #include "modulator.h"
 #include "fmdemodulator.h"
 #include "amdemodulator.h"
+#include "bandscanner.h"
 
 class MainWindow : public QMainWindow
 {
@@ -67,6 +70,7 @@ private slots:
     void updateLogDisplay();
     void exitApp();
     void hardReset();
+    void logLatencyReport();
 
 private:
     void initializeHackTvLib();
@@ -82,12 +86,18 @@ private:
     QStringList buildTvTxCommand();
     void setCurrentSampleRate(int sampleRate);
     void processFft(const std::vector<std::complex<float>>& samples);
-    void processDemod(const std::vector<std::complex<float>>& samples);
+    // queuedUs: steady time the block was handed over; captureUs: UTC time
+    // of its first sample, 0 when unknown
+    void processDemod(const std::vector<std::complex<float>>& samples, qint64 queuedUs, qint64 captureUs, double rate = 0.0);
+    void dispatchIq(const std::shared_ptr<std::vector<std::complex<float>>>& samples, qint64 captureUs = 0);
     void handleReceivedData(const int8_t *data, size_t len);
     void startRx();
     void stopAll();
     void switchToTx();
     void switchToRx();
+    void startPttTx(qint64 pttUs);
+    void setScanning(bool on);
+    void processScanBlock(const QByteArray& block, quint32 epoch);
     void applyModePresets();
     void applyModeTheme();
 
@@ -97,6 +107,7 @@ private:
     QComboBox *outputCombo, *sampleRateCombo;
     QCheckBox *ampEnabled;
     QCheckBox *stereoEnabled;
+    QComboBox *amDetectorCombo;
     QLineEdit *tcpAddressEdit;
     QLabel *tcpAddressLabel;
 
@@ -134,7 +145,7 @@ private:
     QCheckBox *colorDisabled;
 
     // Bottom buttons
-    QPushButton *startStopButton, *exitButton, *hardResetButton;
+    QPushButton *startStopButton, *exitButton, *hardResetButton, *latencyButton, *scanButton;
 
     // Log
     QTextBrowser *logBrowser;
@@ -145,6 +156,17 @@ private:
     HackTvLib* m_hackTvLib = nullptr;
     std::unique_ptr<AudioOutput> audioOutput;
     QThreadPool* m_threadPool = nullptr;
+    QThreadPool* m_demodPool = nullptr;
+
+    // Per-stage latency on this side; HackTvLib keeps the USB stages.
+    // rx.total (capture -> speaker) is only known for a local device;
+    // ptt.switch is PTT press/release to the other direction running.
+    LatencyRecorder m_latency;
+    LatencyHistogram& m_demodDispatch = m_latency.stage("demod.dispatch");
+    LatencyHistogram& m_demodLatency = m_latency.stage("demod");
+    LatencyHistogram& m_audioOut = m_latency.stage("audio.out");
+    LatencyHistogram& m_rxTotal = m_latency.stage("rx.total");
+    LatencyHistogram& m_pttSwitch = m_latency.stage("ptt.switch");
 
     QString m_sSettingsFile;
 
@@ -169,18 +191,29 @@ private:
     int m_rxBandwidth = 12500;
 
     bool m_isTx = false;
+    bool m_pttWarm = false;     // PTT turned the RX instance around; release can too
     bool m_pttHeld = false;
     bool m_isRadioMode = true;
     std::atomic<bool> m_shuttingDown{false};
     std::atomic<bool> m_isProcessing{false};
+    std::atomic<double> m_demodRate{0.0};   // rate the demodulators run at
     bool m_initDone = false;
     bool m_forceMono = false;
+    int m_amDetector = AMDemodulator::Envelope;
     QAtomicInt m_fftUpdatePending{0};
 
     // Demod
     std::unique_ptr<FMDemodulator> fmDemodulator;
     std::unique_ptr<AMDemodulator> amDemodulator;
 
+    // Band scanner (local device only): hops the radio itself, the dial
+    // stays put. Raw blocks go to it tagged with HackTvLib's tuning epoch;
+    // those older than the current hop are dropped
+    BandScanner* m_scanner = nullptr;
+    std::atomic<bool> m_scanning{false};    // read on the data callback thread
+    quint32 m_scanEpoch = 0;                // tuning epoch of the current hop
+    QElapsedTimer m_scanLogTimer;           // sweep rate logs, every ten seconds
+
     // Mic capture
     QAudioSource* m_micSource = nullptr;
     QIODevice* m_micDevice = nullptr;
@@ -170,6 +170,9 @@ linux {
 }
 
 SOURCES += \
+    ddcchain.cpp \
+    ddcprocessor.cpp \
+    filesourcedevice.cpp \
     hackrfdevice.cpp \
     hacktv/acp.c \
     hacktv/av.c \
@@ -195,10 +198,15 @@ SOURCES += \
     hacktv/vits.c \
     hacktv/wss.c \
     hacktvlib.cpp \
-    rtlsdrdevice.cpp
+    loopbackdevice.cpp \
+    rtlsdrdevice.cpp \
+    threadplacement.cpp
 
 HEADERS += \
     constants.h \
+    ddcchain.h \
+    ddcprocessor.h \
+    filesourcedevice.h \
     hackrfdevice.h \
     hacktv/acp.h \
     hacktv/av.h \
@@ -226,8 +234,11 @@ HEADERS += \
     hacktv/vits.h \
     hacktv/wss.h \
     hacktvlib.h \
+    latencyhistogram.h \
+    loopbackdevice.h \
     modulation.h \
     rtlsdrdevice.h \
+    threadplacement.h \
     types.h
 
 TRANSLATIONS += \
@@ -0,0 +1,335 @@
+#include "ddcchain.h"
+#include <cmath>
+#include <algorithm>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define DDC_SSE 1
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define DDC_NEON 1
+#endif
+
+namespace {
+
+// Complex samples against real taps given twice each (h0 h0 h1 h1 ...):
+// the interleaved I/Q line multiplies straight through and the even / odd
+// lanes sum to I / Q
+inline std::complex<float> complexDot(const std::complex<float>* x, const float* h2, size_t taps)
+{
+    const float* xf = reinterpret_cast<const float*>(x);
+    const size_t n = taps * 2;
+    size_t j = 0;
+    float re = 0.0f, im = 0.0f;
+#if defined(DDC_SSE)
+    // Four accumulators: the adds are latency bound with fewer
+    __m128 acc0 = _mm_setzero_ps(), acc1 = _mm_setzero_ps();
+    __m128 acc2 = _mm_setzero_ps(), acc3 = _mm_setzero_ps();
+    for (; j + 16 <= n; j += 16) {
+        acc0 = _mm_add_ps(acc0, _mm_mul_ps(_mm_loadu_ps(xf + j), _mm_loadu_ps(h2 + j)));
+        acc1 = _mm_add_ps(acc1, _mm_mul_ps(_mm_loadu_ps(xf + j + 4), _mm_loadu_ps(h2 + j + 4)));
+        acc2 = _mm_add_ps(acc2, _mm_mul_ps(_mm_loadu_ps(xf + j + 8), _mm_loadu_ps(h2 + j + 8)));
+        acc3 = _mm_add_ps(acc3, _mm_mul_ps(_mm_loadu_ps(xf + j + 12), _mm_loadu_ps(h2 + j + 12)));
+    }
+    for (; j + 4 <= n; j += 4) {
+        acc0 = _mm_add_ps(acc0, _mm_mul_ps(_mm_loadu_ps(xf + j), _mm_loadu_ps(h2 + j)));
+    }
+    alignas(16) float lanes[4];
+    _mm_store_ps(lanes, _mm_add_ps(_mm_add_ps(acc0, acc1), _mm_add_ps(acc2, acc3)));
+    re = lanes[0] + lanes[2];
+    im = lanes[1] + lanes[3];
+#elif defined(DDC_NEON)
+    float32x4_t acc0 = vdupq_n_f32(0.0f), acc1 = vdupq_n_f32(0.0f);
+    float32x4_t acc2 = vdupq_n_f32(0.0f), acc3 = vdupq_n_f32(0.0f);
+    for (; j + 16 <= n; j += 16) {
+        acc0 = vmlaq_f32(acc0, vld1q_f32(xf + j), vld1q_f32(h2 + j));
+        acc1 = vmlaq_f32(acc1, vld1q_f32(xf + j + 4), vld1q_f32(h2 + j + 4));
+        acc2 = vmlaq_f32(acc2, vld1q_f32(xf + j + 8), vld1q_f32(h2 + j + 8));
+        acc3 = vmlaq_f32(acc3, vld1q_f32(xf + j + 12), vld1q_f32(h2 + j + 12));
+    }
+    for (; j + 4 <= n; j += 4) {
+        acc0 = vmlaq_f32(acc0, vld1q_f32(xf + j), vld1q_f32(h2 + j));
+    }
+    float lanes[4];
+    vst1q_f32(lanes, vaddq_f32(vaddq_f32(acc0, acc1), vaddq_f32(acc2, acc3)));
+    re = lanes[0] + lanes[2];
+    im = lanes[1] + lanes[3];
+#endif
+    for (; j < n; j += 2) {
+        re += xf[j] * h2[j];
+        im += xf[j + 1] * h2[j + 1];
+    }
+    return {re, im};
+}
+
+// Zeroth order modified Bessel function, for the Kaiser window
+double besselI0(double x)
+{
+    double sum = 1.0, term = 1.0;
+    for (int k = 1; k < 50; k++) {
+        term *= (x / (2.0 * k)) * (x / (2.0 * k));
+        sum += term;
+        if (term < sum * 1e-12) break;
+    }
+    return sum;
+}
+
+} // namespace
+
+int DdcChain::smoothDecimation(int maxDecimation)
+{
+    for (int d = std::max(1, maxDecimation); d > 1; d--) {
+        int rest = d;
+        for (int p : {2, 3, 5, 7}) {
+            while (rest % p == 0) rest /= p;
+        }
+        if (rest == 1) return d;
+    }
+    return 1;
+}
+
+void DdcChain::configure(uint32_t inputRate, int decimation, double offsetHz,
+                         double passbandHz, double stopbandDb)
+{
+    m_stages.clear();
+    m_taps = 0;
+    m_decimation = std::max(1, decimation);
+    m_rate = inputRate ? static_cast<double>(inputRate) / m_decimation : 0.0;
+    if (inputRate == 0) return;
+
+    const double pass = passbandHz;
+    const double attenuation = std::clamp(stopbandDb, 20.0, 120.0);
+
+    // Stage factors: the smallest prime factor last, so the sharp channel
+    // filter runs at twice (or three times...) the output rate; the rest
+    // grouped into factors up to 10, large first while the rate is high and
+    // the transition band wide. A prime over 10 is one stage of its own.
+    std::vector<int> primes;
+    int remaining = m_decimation;
+    for (int p = 2; p * p <= remaining; p++) {
+        while (remaining % p == 0) { primes.push_back(p); remaining /= p; }
+    }
+    if (remaining > 1) primes.push_back(remaining);
+
+    std::vector<int> factors;
+    if (!primes.empty()) {
+        const int last = primes.front();
+        primes.erase(primes.begin());
+        std::sort(primes.rbegin(), primes.rend());
+        while (!primes.empty()) {
+            int factor = primes.front();
+            primes.erase(primes.begin());
+            for (auto it = primes.begin(); it != primes.end();) {
+                if (factor * *it <= 10) { factor *= *it; it = primes.erase(it); }
+                else ++it;
+            }
+            factors.push_back(factor);
+        }
+        std::sort(factors.rbegin(), factors.rend());
+        factors.push_back(last);
+    }
+    if (factors.empty()) factors.push_back(1);
+
+    // Each stage keeps 0..pass and stops what would fold onto it at its
+    // output rate (output - pass); the last one is the channel filter
+    double rate = inputRate;
+    for (int factor : factors) {
+        const double out = rate / factor;
+        const double stop = std::max(out - pass, pass * 1.05);
+        std::vector<float> taps = designKaiserLPF(pass, stop, rate, attenuation);
+        Stage stage;
+        stage.factor = factor;
+        stage.taps2.resize(taps.size() * 2);
+        for (size_t j = 0; j < taps.size(); j++) stage.taps2[j * 2] = stage.taps2[j * 2 + 1] = taps[j];
+        m_taps += taps.size();
+        m_stages.push_back(std::move(stage));
+        rate = out;
+    }
+
+    m_shift = (offsetHz != 0.0);
+    m_ncoInc = -2.0 * M_PI * offsetHz / inputRate;
+    m_ncoPhase = 0.0;
+    m_step4r = static_cast<float>(std::cos(4.0 * m_ncoInc));
+    m_step4i = static_cast<float>(std::sin(4.0 * m_ncoInc));
+}
+
+std::vector<float> DdcChain::designKaiserLPF(double passHz, double stopHz, double rate, double attenuationDb)
+{
+    const double transition = 2.0 * M_PI * (stopHz - passHz) / rate;
+    int numTaps = static_cast<int>(std::ceil((attenuationDb - 8.0) / (2.285 * transition))) + 1;
+    numTaps = std::clamp(numTaps | 1, 3, MAX_TAPS);
+
+    double beta = 0.0;
+    if (attenuationDb > 50.0) beta = 0.1102 * (attenuationDb - 8.7);
+    else if (attenuationDb >= 21.0) beta = 0.5842 * std::pow(attenuationDb - 21.0, 0.4) + 0.07886 * (attenuationDb - 21.0);
+
+    const double fc = (passHz + stopHz) / 2.0 / rate;
+    const int M = numTaps / 2;
+    const double i0Beta = besselI0(beta);
+    std::vector<float> h(numTaps);
+    double sum = 0.0;
+    for (int n = 0; n < numTaps; n++) {
+        const double m = n - M;
+        const double sinc = (m == 0.0) ? 2.0 * fc : std::sin(2.0 * M_PI * fc * m) / (M_PI * m);
+        const double r = m / M;
+        const double window = besselI0(beta * std::sqrt(std::max(0.0, 1.0 - r * r))) / i0Beta;
+        h[n] = static_cast<float>(sinc * window);
+        sum += h[n];
+    }
+    if (sum != 0.0) for (auto& t : h) t = static_cast<float>(t / sum);
+    return h;
+}
+
+// ============================================================
+// Processing
+// ============================================================
+
+const std::vector<std::complex<float>>& DdcChain::process(const int8_t* in, size_t len)
+{
+    const size_t n = len / 2;
+    if (n == 0 || m_stages.empty()) {
+        m_bufB.clear();
+        return m_bufB;
+    }
+
+    m_bufA.resize(n);
+    if (m_shift) {
+        mixDown(in, n, m_bufA.data());
+    } else {
+        for (size_t i = 0; i < n; i++) {
+            m_bufA[i] = std::complex<float>(in[i * 2] / 128.0f, in[i * 2 + 1] / 128.0f);
+        }
+    }
+
+    std::vector<std::complex<float>>* cur = &m_bufA;
+    std::vector<std::complex<float>>* next = &m_bufB;
+    for (auto& stage : m_stages) {
+        decimate(cur->data(), cur->size(), stage, *next);
+        std::swap(cur, next);
+    }
+    return *cur;
+}
+
+// int8 -> float, shifted by the NCO; the 1/128 scale rides on the phasors.
+// Four float phasors a sample apart each step by e^(j 4 inc), so the four
+// recurrences are independent and sit in two SIMD registers, and every
+// NCO_SPAN samples they are set again from the double phase, which also
+// keeps them on the unit circle. Written out: std::complex multiplies go
+// through the NaN-checking library call and cost several times as much.
+void DdcChain::mixDown(const int8_t* in, size_t n, std::complex<float>* out)
+{
+    float* o = reinterpret_cast<float*>(out);
+    const float sr = m_step4r, si = m_step4i;
+    for (size_t start = 0; start < n; start += NCO_SPAN) {
+        const size_t end = std::min(n, start + NCO_SPAN);
+        // Interleaved like the samples: re0 im0 re1 im1 | re2 im2 re3 im3
+        alignas(16) float p[8];
+        for (int k = 0; k < 4; k++) {
+            const double phase = m_ncoPhase + k * m_ncoInc;
+            p[k * 2] = static_cast<float>(std::cos(phase) / 128.0);
+            p[k * 2 + 1] = static_cast<float>(std::sin(phase) / 128.0);
+        }
+
+        size_t i = start;
+#if defined(DDC_SSE)
+        // (a + jb)(c + jd): a*(c, d) + b*(-d, c), for two samples per register
+        const __m128 sign = _mm_setr_ps(-1.0f, 1.0f, -1.0f, 1.0f);
+        const __m128 stepRe = _mm_set1_ps(sr);
+        const __m128 stepIm = _mm_setr_ps(-si, si, -si, si);
+        __m128 pA = _mm_load_ps(p), pB = _mm_load_ps(p + 4);
+        for (; i + 4 <= end; i += 4) {
+            // Eight int8 -> sign extended int32 -> float
+            const __m128i raw = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(in + i * 2));
+            const __m128i s16 = _mm_srai_epi16(_mm_unpacklo_epi8(raw, raw), 8);
+            const __m128 xA = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(s16, s16), 16));
+            const __m128 xB = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(s16, s16), 16));
+
+            const __m128 swapA = _mm_shuffle_ps(pA, pA, _MM_SHUFFLE(2, 3, 0, 1));
+            const __m128 swapB = _mm_shuffle_ps(pB, pB, _MM_SHUFFLE(2, 3, 0, 1));
+            const __m128 yA = _mm_add_ps(_mm_mul_ps(_mm_shuffle_ps(xA, xA, _MM_SHUFFLE(2, 2, 0, 0)), pA),
+                                         _mm_mul_ps(_mm_shuffle_ps(xA, xA, _MM_SHUFFLE(3, 3, 1, 1)), _mm_mul_ps(swapA, sign)));
+            const __m128 yB = _mm_add_ps(_mm_mul_ps(_mm_shuffle_ps(xB, xB, _MM_SHUFFLE(2, 2, 0, 0)), pB),
+                                         _mm_mul_ps(_mm_shuffle_ps(xB, xB, _MM_SHUFFLE(3, 3, 1, 1)), _mm_mul_ps(swapB, sign)));
+            _mm_storeu_ps(o + i * 2, yA);
+            _mm_storeu_ps(o + i * 2 + 4, yB);
+
+            pA = _mm_add_ps(_mm_mul_ps(pA, stepRe), _mm_mul_ps(swapA, stepIm));
+            pB = _mm_add_ps(_mm_mul_ps(pB, stepRe), _mm_mul_ps(swapB, stepIm));
+        }
+        _mm_store_ps(p, pA);
+        _mm_store_ps(p + 4, pB);
+#elif defined(DDC_NEON)
+        const float signs[4] = {-1.0f, 1.0f, -1.0f, 1.0f};
+        const float stepIms[4] = {-si, si, -si, si};
+        const float32x4_t sign = vld1q_f32(signs);
+        const float32x4_t stepRe = vdupq_n_f32(sr);
+        const float32x4_t stepIm = vld1q_f32(stepIms);
+        float32x4_t pA = vld1q_f32(p), pB = vld1q_f32(p + 4);
+        for (; i + 4 <= end; i += 4) {
+            const int16x8_t s16 = vmovl_s8(vld1_s8(in + i * 2));
+            const float32x4_t xA = vcvtq_f32_s32(vmovl_s16(vget_low_s16(s16)));
+            const float32x4_t xB = vcvtq_f32_s32(vmovl_s16(vget_high_s16(s16)));
+
+            // vtrnq(x, x): re0 re0 re1 re1 / im0 im0 im1 im1
+            const float32x4x2_t tA = vtrnq_f32(xA, xA);
+            const float32x4x2_t tB = vtrnq_f32(xB, xB);
+            const float32x4_t swapA = vrev64q_f32(pA);
+            const float32x4_t swapB = vrev64q_f32(pB);
+            vst1q_f32(o + i * 2, vmlaq_f32(vmulq_f32(tA.val[0], pA), tA.val[1], vmulq_f32(swapA, sign)));
+            vst1q_f32(o + i * 2 + 4, vmlaq_f32(vmulq_f32(tB.val[0], pB), tB.val[1], vmulq_f32(swapB, sign)));
+
+            pA = vmlaq_f32(vmulq_f32(pA, stepRe), swapA, stepIm);
+            pB = vmlaq_f32(vmulq_f32(pB, stepRe), swapB, stepIm);
+        }
+        vst1q_f32(p, pA);
+        vst1q_f32(p + 4, pB);
+#else
+        for (; i + 4 <= end; i += 4) {
+            for (int k = 0; k < 4; k++) {
+                const float x = in[(i + k) * 2], y = in[(i + k) * 2 + 1];
+                float& pr = p[k * 2];
+                float& pi = p[k * 2 + 1];
+                o[(i + k) * 2] = x * pr - y * pi;
+                o[(i + k) * 2 + 1] = x * pi + y * pr;
+                const float t = pr * sr - pi * si;
+                pi = pr * si + pi * sr;
+                pr = t;
+            }
+        }
+#endif
+        for (int k = 0; i < end; i++, k++) {
+            const float x = in[i * 2], y = in[i * 2 + 1];
+            o[i * 2] = x * p[k * 2] - y * p[k * 2 + 1];
+            o[i * 2 + 1] = x * p[k * 2 + 1] + y * p[k * 2];
+        }
+
+        m_ncoPhase = std::remainder(m_ncoPhase + static_cast<double>(end - start) * m_ncoInc, 2.0 * M_PI);
+    }
+}
+
+// FIR decimator: the line holds taps - 1 history samples and the block, so
+// only the kept outputs are computed, each straight through the line
+void DdcChain::decimate(const std::complex<float>* in, size_t n, Stage& stage,
+                        std::vector<std::complex<float>>& out)
+{
+    const size_t T = stage.taps2.size() / 2;
+    auto& line = stage.line;
+    if (line.size() != T - 1) line.assign(T - 1, {0.0f, 0.0f});
+    line.resize(T - 1 + n);
+    std::copy(in, in + n, line.begin() + (T - 1));
+
+    size_t i = static_cast<size_t>(stage.phase);
+    out.resize(i < n ? (n - i + stage.factor - 1) / stage.factor : 0);
+    std::complex<float>* dst = out.data();
+    for (; i < n; i += stage.factor) {
+        *dst++ = complexDot(line.data() + i, stage.taps2.data(), T);
+    }
+    stage.phase = static_cast<int>(i - n);
+
+    std::copy(line.end() - (T - 1), line.end(), line.begin());
+    line.resize(T - 1);
+}
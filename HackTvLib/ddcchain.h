@@ -0,0 +1,72 @@
+#ifndef DDCCHAIN_H
+#define DDCCHAIN_H
+
+#include <vector>
+#include <complex>
+#include <cstdint>
+#include <cstddef>
+
+// The signal path of a DDC, without threads: int8 IQ -> NCO shift by
+// -offset -> cascade of FIR decimators (factors 2-10, the channel filter
+// last, at the lowest rate) -> complex float, full scale 1.0. Only the kept
+// outputs are computed, through SSE/NEON dot products. Filters are Kaiser
+// windowed for the stopband attenuation. Filter state, NCO phase and
+// decimation phase carry across blocks until configure() is called again.
+//
+// DdcProcessor runs one on its DSP thread; HackRfTcp and IqStreamBench
+// compile this file themselves for the per-client DdcChannel.
+class DdcChain
+{
+public:
+    static constexpr int MAX_TAPS = 4095;
+
+    // passbandHz is one-sided (0..passbandHz is kept)
+    void configure(uint32_t inputRate, int decimation, double offsetHz,
+                   double passbandHz, double stopbandDb);
+
+    // The decimated samples, valid until the next call
+    const std::vector<std::complex<float>>& process(const int8_t* in, size_t len);
+
+    int decimation() const { return m_decimation; }
+    double outputRate() const { return m_rate; }
+    size_t stages() const { return m_stages.size(); }
+    size_t taps() const { return m_taps; }
+
+    // Largest decimation <= maxDecimation whose prime factors are all 7 or
+    // less, so every stage decimates by 10 or less
+    static int smoothDecimation(int maxDecimation);
+
+    static std::vector<float> designKaiserLPF(double passHz, double stopHz, double rate, double attenuationDb);
+
+private:
+    struct Stage {
+        std::vector<float> taps2;       // each tap twice, for interleaved I/Q
+        int factor = 1;
+        std::vector<std::complex<float>> line;     // history + current block
+        int phase = 0;                  // first input to keep in the next block
+    };
+
+    // Samples between NCO re-seeds from the exact phase
+    static constexpr size_t NCO_SPAN = 1024;
+
+    void mixDown(const int8_t* in, size_t n, std::complex<float>* out);
+    static void decimate(const std::complex<float>* in, size_t n, Stage& stage,
+                         std::vector<std::complex<float>>& out);
+
+    int m_decimation = 1;
+    double m_rate = 0.0;
+    size_t m_taps = 0;
+    std::vector<Stage> m_stages;
+
+    // NCO: phase per sample and the running phase, in radians
+    bool m_shift = false;
+    double m_ncoInc = 0.0;
+    double m_ncoPhase = 0.0;
+    float m_step4r = 1.0f;              // e^(j 4 inc): four phasors, a sample apart
+    float m_step4i = 0.0f;
+
+    std::vector<std::complex<float>> m_bufA;
+    std::vector<std::complex<float>> m_bufB;
+};
+
+#endif // DDCCHAIN_H
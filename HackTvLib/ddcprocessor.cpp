@@ -0,0 +1,186 @@
+#include "ddcprocessor.h"
+#include "threadplacement.h"
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <algorithm>
+
+DdcProcessor::DdcProcessor(uint32_t inputRate, const DdcConfig& config, Callback callback)
+    : m_slots(SLOTS)
+    , m_config(config)
+    , m_inputRate(inputRate)
+    , m_callback(std::move(callback))
+{
+    for (auto& slot : m_slots) slot.data.resize(SLOT_BYTES);
+    m_outputRate.store(inputRate ? static_cast<double>(inputRate) / decimationFor(inputRate, config.outputRate) : 0.0);
+    m_thread = std::make_unique<std::thread>(&DdcProcessor::dspLoop, this);
+}
+
+DdcProcessor::~DdcProcessor()
+{
+    m_running.store(false);
+    {
+        std::lock_guard<std::mutex> lock(m_wakeMutex);
+    }
+    m_wake.notify_one();
+    if (m_thread && m_thread->joinable()) {
+        m_thread->join();
+    }
+
+    if (m_dropped.load() > 0) {
+        fprintf(stderr, "DDC: %llu blocks dropped (DSP thread behind)\n",
+                (unsigned long long)m_dropped.load());
+        fflush(stderr);
+    }
+}
+
+int DdcProcessor::decimationFor(uint32_t inputRate, double outputRate)
+{
+    if (outputRate <= 0.0) return 1;
+    return std::max(1, static_cast<int>(std::floor(inputRate / outputRate)));
+}
+
+void DdcProcessor::setConfig(const DdcConfig& config)
+{
+    std::lock_guard<std::mutex> lock(m_configMutex);
+    m_config = config;
+    if (m_inputRate) {
+        m_outputRate.store(static_cast<double>(m_inputRate) / decimationFor(m_inputRate, config.outputRate));
+    }
+    m_configChanged.store(true);
+}
+
+void DdcProcessor::setInputRate(uint32_t inputRate)
+{
+    std::lock_guard<std::mutex> lock(m_configMutex);
+    if (inputRate == m_inputRate || inputRate == 0) return;
+    m_inputRate = inputRate;
+    m_outputRate.store(static_cast<double>(inputRate) / decimationFor(inputRate, m_config.outputRate));
+    m_configChanged.store(true);
+}
+
+DdcConfig DdcProcessor::config() const
+{
+    std::lock_guard<std::mutex> lock(m_configMutex);
+    return m_config;
+}
+
+// ============================================================
+// Hand-off
+// ============================================================
+
+bool DdcProcessor::push(const int8_t* data, size_t len, uint64_t timeUs)
+{
+    const uint64_t head = m_head.load(std::memory_order_relaxed);
+    if (head - m_tail.load(std::memory_order_acquire) >= SLOTS) {
+        m_dropped.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    Slot& slot = m_slots[head % SLOTS];
+    if (slot.data.size() < len) slot.data.resize(len);     // only for blocks over SLOT_BYTES
+    std::memcpy(slot.data.data(), data, len);
+    slot.len = len;
+    slot.timeUs = timeUs;
+    slot.pushedUs = LatencyHistogram::steadyUs();
+    m_head.store(head + 1, std::memory_order_release);
+
+    // Taking the lock orders this against the DSP thread's check, so the
+    // wakeup cannot fall between its check and its wait
+    {
+        std::lock_guard<std::mutex> lock(m_wakeMutex);
+    }
+    m_wake.notify_one();
+    return true;
+}
+
+void DdcProcessor::dspLoop()
+{
+    ThreadPlacement::apply(ThreadPlacement::Dsp);
+
+    while (true) {
+        const uint64_t tail = m_tail.load(std::memory_order_relaxed);
+        {
+            std::unique_lock<std::mutex> lock(m_wakeMutex);
+            m_wake.wait(lock, [&]() {
+                return !m_running.load() || m_head.load(std::memory_order_acquire) != tail;
+            });
+        }
+        if (!m_running.load()) break;
+
+        if (m_configChanged.exchange(false)) rebuild();
+
+        const Slot& slot = m_slots[tail % SLOTS];
+        const int64_t startUs = LatencyHistogram::steadyUs();
+        if (m_queueLatency) m_queueLatency->record(startUs - slot.pushedUs);
+        process(slot);
+        if (m_workLatency) m_workLatency->record(LatencyHistogram::steadyUs() - startUs);
+
+        m_tail.store(tail + 1, std::memory_order_release);
+    }
+}
+
+// ============================================================
+// Chain
+// ============================================================
+
+void DdcProcessor::rebuild()
+{
+    DdcConfig config;
+    uint32_t inputRate;
+    {
+        std::lock_guard<std::mutex> lock(m_configMutex);
+        config = m_config;
+        inputRate = m_inputRate;
+    }
+    m_format = config.format;
+    if (inputRate == 0) {
+        m_chain.configure(0, 1, 0.0, 0.0, config.stopbandDb);
+        return;
+    }
+
+    const int decimation = decimationFor(inputRate, config.outputRate);
+    const double rate = static_cast<double>(inputRate) / decimation;
+    const double bandwidth = (config.bandwidthHz > 0.0) ? std::min(config.bandwidthHz, rate * 0.95)
+                                                        : rate * 0.8;
+    m_chain.configure(inputRate, decimation, config.offsetHz, bandwidth / 2.0, config.stopbandDb);
+
+    fprintf(stderr, "DDC: %.3f MS/s -> %.1f kS/s (/%d in %zu stages, %zu taps), offset %.1f Hz, passband %.1f kHz\n",
+            inputRate / 1e6, rate / 1e3, decimation, m_chain.stages(), m_chain.taps(),
+            config.offsetHz, bandwidth / 1e3);
+    fflush(stderr);
+}
+
+// ============================================================
+// Processing
+// ============================================================
+
+void DdcProcessor::process(const Slot& slot)
+{
+    const std::vector<std::complex<float>>& out = m_chain.process(slot.data.data(), slot.len);
+    const std::complex<float>* iq = out.data();
+    const size_t count = out.size();
+    if (count == 0 || !m_callback) return;
+
+    DdcBlock block;
+    block.samples = count;
+    block.sampleRate = m_chain.outputRate();
+    block.timeUs = slot.timeUs;
+    if (m_format == DdcConfig::Int16) {
+        m_out16.resize(count * 2);
+        for (size_t i = 0; i < count; i++) {
+            m_out16[i * 2] = static_cast<int16_t>(std::clamp(iq[i].real() * 32767.0f, -32767.0f, 32767.0f));
+            m_out16[i * 2 + 1] = static_cast<int16_t>(std::clamp(iq[i].imag() * 32767.0f, -32767.0f, 32767.0f));
+        }
+        block.iq16 = m_out16.data();
+    } else {
+        block.iq = iq;
+    }
+
+    try {
+        m_callback(block);
+    } catch (...) {
+        fprintf(stderr, "DDC: exception in callback\n");
+        fflush(stderr);
+    }
+}
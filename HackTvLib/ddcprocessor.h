@@ -0,0 +1,112 @@
+#ifndef DDCPROCESSOR_H
+#define DDCPROCESSOR_H
+
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <memory>
+#include <functional>
+#include <vector>
+#include <complex>
+#include <cstdint>
+#include "latencyhistogram.h"
+#include "ddcchain.h"
+
+// Channel wanted from the RX stream (HackTvLib::setDdc)
+struct DdcConfig {
+    enum Format { ComplexFloat, Int16 };
+
+    double offsetHz = 0.0;          // channel centre against the tuned frequency
+    double outputRate = 200000.0;   // at least this; the rate is input / integer
+    double bandwidthHz = 0.0;       // two-sided passband, 0: 0.8 x output rate
+    double stopbandDb = 60.0;       // attenuation of everything that would alias into it
+    Format format = ComplexFloat;
+};
+
+// One decimated block. Only the pointer for the configured format is set.
+struct DdcBlock {
+    const std::complex<float>* iq = nullptr;    // full scale 1.0
+    const int16_t* iq16 = nullptr;              // interleaved I/Q, full scale 32767
+    size_t samples = 0;
+    double sampleRate = 0.0;
+    uint64_t timeUs = 0;                        // UTC capture time of the first sample
+};
+
+// Digital down converter on a DSP thread of its own.
+//
+// push() is called from the device callback: it copies the int8 block into
+// a free slot and wakes the DSP thread, nothing else, so the USB thread is
+// back in libhackrf at once. The DSP thread runs a DdcChain: NCO shift to
+// 0 Hz, then a cascade of FIR stages (factors 2-10, the channel filter last,
+// at the lowest rate), Kaiser windowed for stopbandDb. Filter state, NCO
+// phase and decimation phase carry across blocks, and the configuration can
+// change while running (the chain is rebuilt between blocks).
+// When the DSP thread falls behind, whole blocks are dropped (dropped()).
+class DdcProcessor
+{
+public:
+    using Callback = std::function<void(const DdcBlock&)>;
+
+    static constexpr size_t SLOTS = 16;
+    static constexpr size_t SLOT_BYTES = 262144;    // a HackRF USB transfer
+
+    DdcProcessor(uint32_t inputRate, const DdcConfig& config, Callback callback);
+    ~DdcProcessor();
+
+    void setConfig(const DdcConfig& config);
+    void setInputRate(uint32_t inputRate);
+    DdcConfig config() const;
+
+    // Input rate / decimation for the current settings
+    double outputRate() const { return m_outputRate.load(); }
+    static int decimationFor(uint32_t inputRate, double outputRate);
+
+    // Device callback thread. Returns false when the block was dropped.
+    bool push(const int8_t* data, size_t len, uint64_t timeUs);
+
+    uint64_t dropped() const { return m_dropped.load(); }
+
+    // queue: push to start of processing, work: processing and callback
+    void setLatencyStages(LatencyHistogram* queue, LatencyHistogram* work) { m_queueLatency = queue; m_workLatency = work; }
+
+private:
+    struct Slot {
+        std::vector<int8_t> data;
+        size_t len = 0;
+        uint64_t timeUs = 0;
+        int64_t pushedUs = 0;
+    };
+
+    void dspLoop();
+    void rebuild();
+    void process(const Slot& slot);
+
+    // Hand-off, single producer (push) / single consumer (dspLoop)
+    std::vector<Slot> m_slots;
+    std::atomic<uint64_t> m_head{0};        // blocks ever pushed
+    std::atomic<uint64_t> m_tail{0};        // blocks ever processed
+    std::atomic<uint64_t> m_dropped{0};
+    std::mutex m_wakeMutex;
+    std::condition_variable m_wake;
+    std::atomic<bool> m_running{true};
+    std::unique_ptr<std::thread> m_thread;
+
+    // Settings, applied by the DSP thread before the next block
+    mutable std::mutex m_configMutex;
+    DdcConfig m_config;
+    uint32_t m_inputRate;
+    std::atomic<bool> m_configChanged{true};
+    std::atomic<double> m_outputRate{0.0};
+    Callback m_callback;
+
+    // DSP thread only
+    DdcConfig::Format m_format = DdcConfig::ComplexFloat;
+    DdcChain m_chain;
+    std::vector<int16_t> m_out16;
+
+    LatencyHistogram* m_queueLatency = nullptr;
+    LatencyHistogram* m_workLatency = nullptr;
+};
+
+#endif // DDCPROCESSOR_H
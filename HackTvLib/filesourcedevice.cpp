@@ -0,0 +1,348 @@
+#include "filesourcedevice.h"
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QJsonArray>
+#include <cstdio>
+#include <cmath>
+#include <algorithm>
+
+FileSourceDevice::FileSourceDevice(QObject *parent)
+    : QObject(parent)
+    , m_data(nullptr)
+    , m_fileType(RF_INT8)
+    , m_bytesPerSample(2)
+    , m_totalSamples(0)
+    , m_frequency(0)
+    , m_isRunning(false)
+    , m_sampleRate(DEFAULT_SAMPLE_RATE)
+    , m_realtime(true)
+    , m_loop(false)
+    , m_position(0)
+    , m_seekRequest(-1)
+    , m_samplesDelivered(0)
+{
+}
+
+FileSourceDevice::~FileSourceDevice()
+{
+    stop();
+    close();
+}
+
+// ============================================================
+// Open / SigMF
+// ============================================================
+
+bool FileSourceDevice::open(const std::string& path, int fileType, uint32_t sampleRate)
+{
+    close();
+
+    QString dataPath = QString::fromStdString(path);
+    m_fileType = fileType;
+    m_sampleRate.store(sampleRate);
+    m_frequency = 0;
+
+    // SigMF: either half of the pair may be given
+    if (dataPath.endsWith(".sigmf-meta") || dataPath.endsWith(".sigmf-data")) {
+        QString base = dataPath.left(dataPath.lastIndexOf('.'));
+        dataPath = base + ".sigmf-data";
+        if (!readSigMF(base + ".sigmf-meta")) {
+            return false;
+        }
+    }
+
+    switch (m_fileType) {
+    case RF_UINT8:
+    case RF_INT8:  m_bytesPerSample = 2; break;
+    case RF_INT16: m_bytesPerSample = 4; break;
+    case RF_FLOAT: m_bytesPerSample = 8; break;
+    default:
+        fprintf(stderr, "FileSourceDevice: unsupported sample type %d (use uint8, int8, int16 or float)\n", m_fileType);
+        fflush(stderr);
+        return false;
+    }
+
+    m_file.setFileName(dataPath);
+    if (!m_file.open(QIODevice::ReadOnly)) {
+        fprintf(stderr, "FileSourceDevice: cannot open %s\n", qPrintable(dataPath));
+        fflush(stderr);
+        return false;
+    }
+
+    m_totalSamples = static_cast<uint64_t>(m_file.size()) / m_bytesPerSample;
+    if (m_totalSamples == 0) {
+        fprintf(stderr, "FileSourceDevice: %s is empty\n", qPrintable(dataPath));
+        fflush(stderr);
+        m_file.close();
+        return false;
+    }
+
+    m_data = m_file.map(0, m_file.size());
+    if (!m_data) {
+        fprintf(stderr, "FileSourceDevice: cannot map %s\n", qPrintable(dataPath));
+        fflush(stderr);
+        m_file.close();
+        return false;
+    }
+
+    m_position.store(0);
+    m_seekRequest.store(-1);
+    if (m_fileType != RF_INT8) {
+        m_convertBuffer.resize(BLOCK_SAMPLES * 2);
+    }
+
+    fprintf(stderr, "FileSourceDevice: %s, %llu samples (%.2f s at %.3f MS/s)\n",
+            qPrintable(dataPath), (unsigned long long)m_totalSamples,
+            m_totalSamples / static_cast<double>(std::max(1u, m_sampleRate.load())),
+            m_sampleRate.load() / 1e6);
+    fflush(stderr);
+    return true;
+}
+
+bool FileSourceDevice::readSigMF(const QString& metaPath)
+{
+    QFile meta(metaPath);
+    if (!meta.open(QIODevice::ReadOnly)) {
+        fprintf(stderr, "FileSourceDevice: cannot open SigMF metadata %s\n", qPrintable(metaPath));
+        fflush(stderr);
+        return false;
+    }
+
+    QJsonParseError err;
+    QJsonDocument doc = QJsonDocument::fromJson(meta.readAll(), &err);
+    if (doc.isNull()) {
+        fprintf(stderr, "FileSourceDevice: SigMF parse error: %s\n", qPrintable(err.errorString()));
+        fflush(stderr);
+        return false;
+    }
+
+    QJsonObject global = doc.object().value("global").toObject();
+    QString datatype = global.value("core:datatype").toString();
+
+    if (datatype == "ci8")                                 m_fileType = RF_INT8;
+    else if (datatype == "cu8")                            m_fileType = RF_UINT8;
+    else if (datatype == "ci16_le" || datatype == "ci16")  m_fileType = RF_INT16;
+    else if (datatype == "cf32_le" || datatype == "cf32")  m_fileType = RF_FLOAT;
+    else {
+        fprintf(stderr, "FileSourceDevice: unsupported SigMF datatype '%s'\n", qPrintable(datatype));
+        fflush(stderr);
+        return false;
+    }
+
+    double rate = global.value("core:sample_rate").toDouble(0.0);
+    if (rate > 0.0) {
+        m_sampleRate.store(static_cast<uint32_t>(std::lround(rate)));
+    }
+
+    QJsonArray captures = doc.object().value("captures").toArray();
+    if (!captures.isEmpty()) {
+        m_frequency = static_cast<uint64_t>(
+            captures.at(0).toObject().value("core:frequency").toDouble(0.0));
+    }
+
+    fprintf(stderr, "FileSourceDevice: SigMF %s, %.3f MS/s, %.3f MHz\n",
+            qPrintable(datatype), m_sampleRate.load() / 1e6, m_frequency / 1e6);
+    fflush(stderr);
+    return true;
+}
+
+void FileSourceDevice::close()
+{
+    if (m_data) {
+        m_file.unmap(const_cast<uchar*>(m_data));
+        m_data = nullptr;
+    }
+    if (m_file.isOpen()) {
+        m_file.close();
+    }
+    m_totalSamples = 0;
+}
+
+// ============================================================
+// Control
+// ============================================================
+
+bool FileSourceDevice::start()
+{
+    if (!m_data) {
+        fprintf(stderr, "FileSourceDevice: no file open\n");
+        fflush(stderr);
+        return false;
+    }
+    if (m_isRunning.load()) {
+        return false;
+    }
+
+    m_samplesDelivered.store(0);
+    m_isRunning.store(true);
+    m_playThread = std::make_unique<std::thread>(&FileSourceDevice::playbackLoop, this);
+    return true;
+}
+
+bool FileSourceDevice::stop()
+{
+    m_isRunning.store(false);
+
+    if (m_playThread && m_playThread->joinable()) {
+        m_playThread->join();
+    }
+    m_playThread.reset();
+    return true;
+}
+
+void FileSourceDevice::playbackLoop()
+{
+    fprintf(stderr, "FileSourceDevice: playback started (%s%s)\n",
+            m_realtime.load() ? "real-time" : "unthrottled",
+            m_loop.load() ? ", loop" : "");
+    fflush(stderr);
+
+    auto startTime = std::chrono::steady_clock::now();
+    auto clockOrigin = startTime;
+    uint64_t pacedSamples = 0;
+    uint32_t pacedRate = m_sampleRate.load();
+
+    while (m_isRunning.load()) {
+        int64_t seekTo = m_seekRequest.exchange(-1);
+        if (seekTo >= 0) {
+            m_position.store(std::min<uint64_t>(static_cast<uint64_t>(seekTo), m_totalSamples));
+        }
+
+        uint64_t pos = m_position.load();
+        if (pos >= m_totalSamples) {
+            if (!m_loop.load()) {
+                fprintf(stderr, "FileSourceDevice: end of file\n");
+                fflush(stderr);
+                break;
+            }
+            pos = 0;
+        }
+
+        // Last block of a file may be short; consumers already cope with
+        // the 262144-byte HackRF block being the usual, not the only size.
+        size_t count = static_cast<size_t>(std::min<uint64_t>(BLOCK_SAMPLES, m_totalSamples - pos));
+        const int8_t* block = convertBlock(pos, count);
+        m_position.store(pos + count);
+
+        {
+            std::lock_guard<std::mutex> lock(m_callbackMutex);
+            if (m_dataCallback) {
+                try {
+                    m_dataCallback(block, count * 2);
+                } catch (...) {
+                    fprintf(stderr, "FileSourceDevice: exception in data callback\n");
+                    fflush(stderr);
+                }
+            }
+        }
+        m_samplesDelivered.fetch_add(count);
+
+        if (!m_realtime.load()) {
+            continue;
+        }
+
+        // Pace on the nominal sample clock; restart the clock on rate
+        // changes, and re-base instead of bursting after a long stall.
+        uint32_t rate = m_sampleRate.load();
+        if (rate == 0) continue;
+        if (rate != pacedRate) {
+            pacedRate = rate;
+            pacedSamples = 0;
+            clockOrigin = std::chrono::steady_clock::now();
+        }
+        pacedSamples += count;
+        auto due = clockOrigin + std::chrono::nanoseconds(
+            static_cast<int64_t>(pacedSamples * 1e9 / rate));
+        auto now = std::chrono::steady_clock::now();
+        if (due > now) {
+            std::this_thread::sleep_until(due);
+        } else if (now - due > std::chrono::milliseconds(100)) {
+            clockOrigin += (now - due);
+        }
+    }
+
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+    uint64_t samples = m_samplesDelivered.load();
+    fprintf(stderr, "FileSourceDevice: playback stopped, %.1f MS in %.2f s (%.2f MS/s)\n",
+            samples / 1e6, elapsed, elapsed > 0 ? samples / elapsed / 1e6 : 0.0);
+    fflush(stderr);
+
+    m_isRunning.store(false);
+}
+
+const int8_t* FileSourceDevice::convertBlock(uint64_t pos, size_t count)
+{
+    const uchar* src = m_data + pos * m_bytesPerSample;
+    int8_t* out = m_convertBuffer.data();
+
+    switch (m_fileType) {
+    case RF_INT8:
+        // Native HackRF format: straight from the mapping
+        return reinterpret_cast<const int8_t*>(src);
+
+    case RF_UINT8:
+        for (size_t i = 0; i < count * 2; i++) {
+            out[i] = static_cast<int8_t>(src[i] ^ 0x80);
+        }
+        break;
+
+    case RF_INT16: {
+        const int16_t* p = reinterpret_cast<const int16_t*>(src);
+        for (size_t i = 0; i < count * 2; i++) {
+            out[i] = static_cast<int8_t>(p[i] >> 8);
+        }
+        break;
+    }
+
+    case RF_FLOAT: {
+        const float* p = reinterpret_cast<const float*>(src);
+        for (size_t i = 0; i < count * 2; i++) {
+            out[i] = static_cast<int8_t>(std::lround(std::clamp(p[i] * 127.0f, -127.0f, 127.0f)));
+        }
+        break;
+    }
+    }
+    return out;
+}
+
+// ============================================================
+// Parameters
+// ============================================================
+
+void FileSourceDevice::setDataCallback(DataCallback callback)
+{
+    std::lock_guard<std::mutex> lock(m_callbackMutex);
+    m_dataCallback = std::move(callback);
+}
+
+void FileSourceDevice::setSampleRate(uint32_t sampleRate)
+{
+    m_sampleRate.store(sampleRate);
+}
+
+void FileSourceDevice::setRealtime(bool realtime)
+{
+    m_realtime.store(realtime);
+}
+
+void FileSourceDevice::setLoop(bool loop)
+{
+    m_loop.store(loop);
+}
+
+void FileSourceDevice::seek(double seconds)
+{
+    double sample = std::max(0.0, seconds) * m_sampleRate.load();
+    int64_t target = static_cast<int64_t>(sample);
+    if (m_isRunning.load()) {
+        m_seekRequest.store(target);
+    } else {
+        m_position.store(std::min<uint64_t>(static_cast<uint64_t>(target), m_totalSamples));
+    }
+}
+
+double FileSourceDevice::getPosition() const
+{
+    uint32_t rate = m_sampleRate.load();
+    return rate ? static_cast<double>(m_position.load()) / rate : 0.0;
+}
@@ -0,0 +1,96 @@
+#ifndef FILESOURCEDEVICE_H
+#define FILESOURCEDEVICE_H
+
+#include <QObject>
+#include <QFile>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <memory>
+#include <functional>
+#include <vector>
+#include <string>
+#include <chrono>
+#include "hacktv/rf.h"
+#include "constants.h"
+
+// IQ file playback as an RX source (-o file:<path> in RX mode).
+//
+// The file is memory mapped and delivered through the same DataCallback
+// as the hardware devices: int8 interleaved IQ, 131072 samples per block.
+// Sample formats follow hacktv's -t types (uint8, int8, int16, float);
+// int8 is passed straight from the mapping without a copy.
+// SigMF recordings (.sigmf-meta / .sigmf-data) set format, sample rate
+// and centre frequency from the metadata.
+class FileSourceDevice : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit FileSourceDevice(QObject *parent = nullptr);
+    ~FileSourceDevice();
+
+    using DataCallback = std::function<void(const int8_t*, size_t)>;
+
+    static constexpr size_t BLOCK_SAMPLES = 131072;
+
+    // Open / close
+    bool open(const std::string& path, int fileType, uint32_t sampleRate);
+    void close();
+    bool isOpen() const { return m_data != nullptr; }
+
+    // Control
+    bool start();
+    bool stop();
+    bool isRunning() const { return m_isRunning.load(); }
+
+    // Callback
+    void setDataCallback(DataCallback callback);
+
+    // Playback parameters
+    void setSampleRate(uint32_t sampleRate);
+    void setRealtime(bool realtime);
+    void setLoop(bool loop);
+    void seek(double seconds);
+
+    // Info
+    uint32_t getSampleRate() const { return m_sampleRate.load(); }
+    uint64_t getFrequency() const { return m_frequency; }
+    int getFileType() const { return m_fileType; }
+    uint64_t getTotalSamples() const { return m_totalSamples; }
+    double getPosition() const;
+
+private:
+    bool readSigMF(const QString& metaPath);
+    void playbackLoop();
+    const int8_t* convertBlock(uint64_t pos, size_t count);
+
+    // File mapping
+    QFile m_file;
+    const uchar* m_data;
+    int m_fileType;
+    size_t m_bytesPerSample;           // bytes per IQ pair
+    uint64_t m_totalSamples;
+    uint64_t m_frequency;              // from SigMF, 0 if unknown
+
+    // Thread management
+    std::unique_ptr<std::thread> m_playThread;
+    std::atomic<bool> m_isRunning;
+
+    // Callback
+    std::mutex m_callbackMutex;
+    DataCallback m_dataCallback;
+
+    // Playback state
+    std::atomic<uint32_t> m_sampleRate;
+    std::atomic<bool> m_realtime;
+    std::atomic<bool> m_loop;
+    std::atomic<uint64_t> m_position;  // next IQ sample to deliver
+    std::atomic<int64_t> m_seekRequest;  // -1 = none
+    std::vector<int8_t> m_convertBuffer;
+
+    // Statistics
+    std::atomic<uint64_t> m_samplesDelivered;
+};
+
+#endif // FILESOURCEDEVICE_H
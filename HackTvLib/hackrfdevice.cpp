@@ -3,8 +3,10 @@
 #include "hacktv/rf.h"
 #include <iostream>
 #include "constants.h"
+#include "threadplacement.h"
 #include <thread>
 #include <chrono>
+#include <algorithm>
 #include <unistd.h>
 #include <QThread>
 
@@ -109,10 +111,7 @@ HackRfDevice::~HackRfDevice()
                     }
 
                     // Streaming'in durmasını bekle
-                    int timeout = 30;
-                    while (hackrf_is_streaming(h_device) == HACKRF_TRUE && timeout-- > 0) {
-                        std::this_thread::sleep_for(std::chrono::milliseconds(100));
-                    }
+                    waitStreamingStopped(3000);
                 }
 
                 hackrf_close(h_device);
@@ -151,6 +150,24 @@ std::vector<std::string> HackRfDevice::listDevices()
     return device_serials;
 }
 
+// Serials are listed without their leading zeros; either side may be the
+// full serial or just its tail
+std::string HackRfDevice::openSerial() const
+{
+    if (m_serial.empty()) {
+        return device_serials.empty() ? std::string() : device_serials[0];
+    }
+
+    const std::string wanted = removeZerosFromBeginning(m_serial);
+    for (const std::string& serial : device_serials) {
+        const size_t n = std::min(serial.size(), wanted.size());
+        if (n > 0 && serial.compare(serial.size() - n, n, wanted, wanted.size() - n, n) == 0) {
+            return serial;
+        }
+    }
+    return std::string();
+}
+
 int HackRfDevice::stop()
 {
     // Zaten destroying durumundaysa çık
@@ -173,7 +190,14 @@ int HackRfDevice::stop()
         }
 
         // Zaten durdurulmuşsa çık
-        if (m_isStopped.load() || !h_device) {
+        if (m_isStopped.load()) {
+            return RF_OK;
+        }
+
+        // Software TX (startSoftwareTx): no handle to close
+        if (!h_device) {
+            m_isRunning.store(false);
+            m_isStopped.store(true);
             return RF_OK;
         }
 
@@ -200,12 +224,8 @@ int HackRfDevice::stop()
         // Lock'u bırak ve streaming'in durmasını bekle
         lock.unlock();
 
-        // Streaming durması için bekle
-        int timeout = 50; // 5 saniye timeout
-        while (h_device && hackrf_is_streaming(h_device) == HACKRF_TRUE && timeout > 0) {
-            std::this_thread::sleep_for(std::chrono::milliseconds(100));
-            timeout--;
-        }
+        // Streaming durması için bekle (5 saniye timeout)
+        waitStreamingStopped(5000);
 
         // Tekrar lock al ve device'ı kapat
         lock.lock();
@@ -230,6 +250,76 @@ int HackRfDevice::stop()
     }
 }
 
+// Warm RX/TX switch. hackrf_open(), the serial lookup and the settings
+// round trips of start() are skipped: frequency, sample rate and gains are
+// still set on the board, so only the transceiver direction changes.
+int HackRfDevice::switchMode(rf_mode _mode)
+{
+    if (m_isDestroying.load() || !m_deviceMutex) {
+        return RF_ERROR;
+    }
+
+    if (_mode != RX && _mode != TX) {
+        fprintf(stderr, "Invalid mode specified: %d\n", _mode);
+        fflush(stderr);
+        return RF_ERROR;
+    }
+
+    std::lock_guard<std::mutex> lock(*m_deviceMutex);
+
+    // Closed or software TX: nothing to keep warm
+    if (!h_device || m_isStopped.load()) {
+        return RF_ERROR;
+    }
+
+    if (mode == _mode && m_isRunning.load()) {
+        return RF_OK;
+    }
+
+    // Callbacks return -1 from here on; the stop call cancels the transfers
+    m_isRunning.store(false);
+
+    if (hackrf_is_streaming(h_device) == HACKRF_TRUE) {
+        int r = (mode == RX) ? hackrf_stop_rx(h_device) : hackrf_stop_tx(h_device);
+        if (r != HACKRF_SUCCESS) {
+            fprintf(stderr, "hackrf_stop_%s() failed: %s (%d)\n",
+                    (mode == RX ? "rx" : "tx"),
+                    hackrf_error_name(static_cast<hackrf_error>(r)), r);
+            fflush(stderr);
+        }
+    }
+
+    // stop() still closes the handle if this fails
+    if (!waitStreamingStopped(1000)) {
+        fprintf(stderr, "HackRF still streaming, mode switch abandoned\n");
+        fflush(stderr);
+        return RF_ERROR;
+    }
+
+    mode = _mode;
+    m_isRunning.store(true);
+
+    int r = (mode == RX) ? hackrf_start_rx(h_device, _rx_callback, this)
+                         : hackrf_start_tx(h_device, _tx_callback, this);
+    if (r != HACKRF_SUCCESS) {
+        fprintf(stderr, "hackrf_start_%s() failed: %s (%d)\n",
+                (mode == RX ? "rx" : "tx"),
+                hackrf_error_name(static_cast<hackrf_error>(r)), r);
+        fflush(stderr);
+        m_isRunning.store(false);
+        return RF_ERROR;
+    }
+
+    // Same as start(): the amp is forced on once TX streaming runs
+    if (mode == TX && m_ampEnable) {
+        hackrf_set_amp_enable(h_device, 1);
+    }
+
+    fprintf(stderr, "HackRF switched to %s\n", (mode == RX ? "RX" : "TX"));
+    fflush(stderr);
+    return RF_OK;
+}
+
 void HackRfDevice::reset()
 {
     // Tüm durumları sıfırla
@@ -278,10 +368,7 @@ int HackRfDevice::hardReset()
                     hackrf_stop_tx(h_device);
                 }
                 // Wait for streaming to actually stop
-                int timeout = 30;
-                while (hackrf_is_streaming(h_device) == HACKRF_TRUE && timeout-- > 0) {
-                    std::this_thread::sleep_for(std::chrono::milliseconds(100));
-                }
+                waitStreamingStopped(3000);
             }
         }
 
@@ -292,13 +379,14 @@ int HackRfDevice::hardReset()
             fflush(stderr);
 
             listDevices();
-            if (device_serials.empty()) {
+            const std::string serial = openSerial();
+            if (serial.empty()) {
                 fprintf(stderr, "hardReset: no HackRF devices found\n");
                 fflush(stderr);
                 return RF_ERROR;
             }
 
-            int r = hackrf_open_by_serial(device_serials[0].c_str(), &h_device);
+            int r = hackrf_open_by_serial(serial.c_str(), &h_device);
             if (r != HACKRF_SUCCESS || !h_device) {
                 fprintf(stderr, "hardReset: hackrf_open() failed: %s (%d)\n",
                         hackrf_error_name(static_cast<hackrf_error>(r)), r);
@@ -395,18 +483,23 @@ int HackRfDevice::start(rf_mode _mode)
         // Re-enumerate devices in case USB state changed
         listDevices();
 
-        if (device_serials.empty()) {
-            fprintf(stderr, "No HackRF devices found\n");
+        const std::string serial = openSerial();
+        if (serial.empty()) {
+            if (m_serial.empty()) {
+                fprintf(stderr, "No HackRF devices found\n");
+            } else {
+                fprintf(stderr, "HackRF %s not found\n", m_serial.c_str());
+            }
             fflush(stderr);
             return RF_ERROR;
         }
 
         // Open device
         {
-            fprintf(stderr, "Opening HackRF device: %s\n", device_serials[0].c_str());
+            fprintf(stderr, "Opening HackRF device: %s\n", serial.c_str());
             fflush(stderr);
 
-            int r = hackrf_open_by_serial(device_serials[0].c_str(), &h_device);
+            int r = hackrf_open_by_serial(serial.c_str(), &h_device);
             if (r != HACKRF_SUCCESS) {
                 fprintf(stderr, "hackrf_open() failed: %s (%d)\n",
                         hackrf_error_name(static_cast<hackrf_error>(r)), r);
@@ -534,6 +627,20 @@ bool HackRfDevice::applySettings()
     return true;
 }
 
+// hackrf_stop_rx/tx() normally return with the transfers already
+// cancelled; a fine poll keeps a mode switch from paying a coarse sleep
+bool HackRfDevice::waitStreamingStopped(int timeoutMs)
+{
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+    while (h_device && hackrf_is_streaming(h_device) == HACKRF_TRUE) {
+        if (std::chrono::steady_clock::now() >= deadline) {
+            return false;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return true;
+}
+
 void HackRfDevice::cleanup()
 {
     if (h_device) {
@@ -552,30 +659,67 @@ void HackRfDevice::cleanup()
 int HackRfDevice::_tx_callback(hackrf_transfer *transfer)
 {
     HackRfDevice *device = static_cast<HackRfDevice*>(transfer->tx_ctx);
+    ThreadPlacement::apply(ThreadPlacement::Usb);
 
     if (!device || device->m_isDestroying.load() || !device->m_isRunning.load()) {
         return -1;
     }
 
     try {
-        int modType = device->m_txModType.load();
-        if (modType == HackRfDevice::TX_MOD_AM) {
-            return device->apply_am_modulation(
-                reinterpret_cast<int8_t*>(transfer->buffer),
-                transfer->valid_length
-                );
-        } else {
-            return device->apply_fm_modulation(
-                reinterpret_cast<int8_t*>(transfer->buffer),
-                transfer->valid_length
-                );
+        const uint32_t rate = device->m_sampleRate;
+        if (device->m_usbLatency && rate) {
+            device->m_usbLatency->record(static_cast<int64_t>(transfer->valid_length / 2) *
+                                         LIBHACKRF_TRANSFERS * 1000000 / rate);
         }
+        return device->fillTxBuffer(
+            reinterpret_cast<int8_t*>(transfer->buffer),
+            transfer->valid_length
+            );
     }
     catch (...) {
         return -1;
     }
 }
 
+int HackRfDevice::fillTxBuffer(int8_t* buffer, uint32_t length)
+{
+    // The ring holds stereo pairs at 44.1 kHz
+    if (m_ringLatency && m_useAudioFileRing.load()) {
+        m_ringLatency->record(static_cast<int64_t>(ringAvailable() / 2) * 1000000 / 44100);
+    }
+    if (m_txModType.load() == TX_MOD_AM) {
+        return apply_am_modulation(buffer, length);
+    }
+    return apply_fm_modulation(buffer, length);
+}
+
+// ============================================================
+// Software TX (loopback) - modulators run without a HackRF.
+// LoopbackDevice pulls blocks through fillTxBuffer().
+// ============================================================
+int HackRfDevice::startSoftwareTx()
+{
+    if (m_isDestroying.load() || !m_deviceMutex) {
+        return RF_ERROR;
+    }
+
+    std::lock_guard<std::mutex> lock(*m_deviceMutex);
+
+    if (m_isRunning.load() || !m_isStopped.load()) {
+        fprintf(stderr, "HackRF device is already running\n");
+        fflush(stderr);
+        return RF_ERROR;
+    }
+
+    mode = TX;
+    m_isStopped.store(false);
+    m_isRunning.store(true);
+
+    fprintf(stderr, "HackRfDevice: software TX started (no hardware)\n");
+    fflush(stderr);
+    return RF_OK;
+}
+
 int HackRfDevice::_rx_callback(hackrf_transfer *transfer)
 {
     HackRfDevice *device = static_cast<HackRfDevice*>(transfer->rx_ctx);
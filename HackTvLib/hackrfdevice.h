@@ -14,6 +14,7 @@
 #include <memory>
 #include <functional>
 #include "types.h"
+#include "latencyhistogram.h"
 
 typedef enum RfMode {
     TX,
@@ -30,9 +31,19 @@ public:
 
     using DataCallback = std::function<void(const int8_t*, size_t)>;
 
+    // libhackrf keeps this many transfers in flight: a TX block filled now
+    // goes out after the others, an RX block handed out after a retune may
+    // still hold samples from before it
+    static constexpr int LIBHACKRF_TRANSFERS = 4;
+
     // Core functions
     int start(rf_mode mode);
     int stop();
+    // Warm RX/TX switch: streaming is stopped and restarted in the other
+    // direction on the open handle, tuning and gains stay on the board.
+    // RF_ERROR when nothing is open (start() it) or streaming did not stop.
+    int switchMode(rf_mode mode);
+    rf_mode currentMode() const { return mode; }
     void reset();
     int hardReset();
     bool isRunning() const { return m_isRunning.load() && !m_isStopped.load(); }
@@ -41,6 +52,11 @@ public:
     bool isInitialized() const { return h_device != nullptr; }
     std::vector<std::string> listDevices();
 
+    // Serial to open (a suffix is enough, as with hackrf_open_by_serial);
+    // empty: the first device found
+    void setSerial(const std::string& serial) { m_serial = serial; }
+    const std::string& serial() const { return m_serial; }
+
     // Callback
     void setDataCallback(DataCallback callback);
 
@@ -80,6 +96,17 @@ public:
     // AM TX modulation
     int apply_am_modulation(int8_t* buffer, uint32_t length);
 
+    // Fill one TX block with the selected modulation (tx_callback / loopback)
+    int fillTxBuffer(int8_t* buffer, uint32_t length);
+
+    // TX latency: audio waiting in the ring when a block is filled, and the
+    // transfers libhackrf sends before it (nullptr: not recorded). Before start().
+    void setLatencyStages(LatencyHistogram* ring, LatencyHistogram* usb) { m_ringLatency = ring; m_usbLatency = usb; }
+
+    // Mark the device running in TX without opening hardware, so the
+    // modulators can be pulled by LoopbackDevice. stop() ends it.
+    int startSoftwareTx();
+
     // Modulation type selection for TX
     enum TxModulationType { TX_MOD_NFM = 0, TX_MOD_WFM = 1, TX_MOD_AM = 2 };
     void setTxModulationType(TxModulationType type) { m_txModType.store(static_cast<int>(type)); }
@@ -92,6 +119,9 @@ private:
 
     bool applySettings();
     void cleanup();
+    // Polls hackrf_is_streaming(); false if still streaming after timeoutMs
+    bool waitStreamingStopped(int timeoutMs);
+    std::string openSerial() const;
 
     // Thread safety
     std::shared_ptr<std::mutex> m_deviceMutex;
@@ -104,6 +134,7 @@ private:
     // Device info
     std::vector<std::string> device_serials;
     std::vector<hackrf_usb_board_id> device_board_ids;
+    std::string m_serial;
 
     // Current mode
     rf_mode mode;
@@ -135,6 +166,9 @@ private:
     // TX modulation type (atomic for tx_callback thread safety)
     std::atomic<int> m_txModType{0}; // 0=NFM, 1=WFM, 2=AM
 
+    LatencyHistogram* m_ringLatency = nullptr;
+    LatencyHistogram* m_usbLatency = nullptr;
+
 public:
     // Ring buffer for external audio (GUI feeds audio here for FM TX)
     // Lock-free SPSC: GUI writes, tx_callback reads
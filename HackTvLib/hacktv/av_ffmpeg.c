@@ -46,6 +46,7 @@
 #include <libavutil/imgutils.h>
 #include <libavutil/cpu.h>
 #include "hacktv.h"
+#include "../threadplacement.h"
 
 /* Maximum length of the packet queue */
 /* Taken from ffplay.c */
@@ -477,6 +478,8 @@ static void *_video_decode_thread(void *arg)
     AVFrame *frame;
     int r, consecutive_errors = 0;
 
+    thread_placement_apply(THREAD_ROLE_MEDIA);
+
     frame = av_frame_alloc();
 
     while(s->thread_abort == 0)
@@ -554,6 +557,8 @@ static void *_video_scaler_thread(void *arg)
     int64_t pts;
     int frame_count = 0;
 
+    thread_placement_apply(THREAD_ROLE_MEDIA);
+
     /* Fetch video frames and pass them through the scaler */
     while((frame = _frame_dbuffer_flip(&s->in_video_buffer)) != NULL)
     {
@@ -818,6 +823,8 @@ static void *_audio_decode_thread(void *arg)
 	AVFrame *frame;
 	int r;
 	
+	thread_placement_apply(THREAD_ROLE_MEDIA);
+	
 	//fprintf(stderr, "_audio_decode_thread(): Starting\n");
 	
 	frame = av_frame_alloc();
@@ -876,6 +883,7 @@ static void *_audio_scaler_thread(void *arg)
     int64_t pts, next_pts;
     uint8_t const *data[AV_NUM_DATA_POINTERS];
     int r, count, drop;
+    thread_placement_apply(THREAD_ROLE_MEDIA);
     //fprintf(stderr, "_audio_scaler_thread(): Starting\n");
 
     /* Fetch audio frames and pass them through the resampler */
@@ -1501,34 +1509,22 @@ int av_ffmpeg_open(av_t *av, char *input_url, char *format, char *options, float
                 );
         }
 
-        // Set high priority for video threads
-        pthread_attr_t attr;
-        struct sched_param param;
-
-        pthread_attr_init(&attr);
-        pthread_attr_setschedpolicy(&attr, SCHED_FIFO);
-        param.sched_priority = 50;
-        pthread_attr_setschedparam(&attr, &param);
-
-        r = pthread_create(&s->video_decode_thread, &attr, &_video_decode_thread, (void *) s);
+        // Priority and CPUs come from the media role (threadplacement.h)
+        r = pthread_create(&s->video_decode_thread, NULL, &_video_decode_thread, (void *) s);
         if(r != 0)
         {
             fprintf(stderr, "Error starting video decoder thread.\n");
-            pthread_attr_destroy(&attr);
             _ffmpeg_close(s);
             return(HACKTV_ERROR);
         }
 
-        r = pthread_create(&s->video_scaler_thread, &attr, &_video_scaler_thread, (void *) s);
+        r = pthread_create(&s->video_scaler_thread, NULL, &_video_scaler_thread, (void *) s);
         if(r != 0)
         {
             fprintf(stderr, "Error starting video scaler thread.\n");
-            pthread_attr_destroy(&attr);
             _ffmpeg_close(s);
             return(HACKTV_ERROR);
         }
-
-        pthread_attr_destroy(&attr);
     }
 
     if(s->audio_stream != NULL)
@@ -1572,34 +1568,22 @@ int av_ffmpeg_open(av_t *av, char *input_url, char *format, char *options, float
             }
         }
 
-        // Set high priority for audio threads
-        pthread_attr_t attr;
-        struct sched_param param;
-
-        pthread_attr_init(&attr);
-        pthread_attr_setschedpolicy(&attr, SCHED_FIFO);
-        param.sched_priority = 55; // Higher priority than video
-        pthread_attr_setschedparam(&attr, &param);
-
-        r = pthread_create(&s->audio_decode_thread, &attr, &_audio_decode_thread, (void *) s);
+        // Media role, like the video threads
+        r = pthread_create(&s->audio_decode_thread, NULL, &_audio_decode_thread, (void *) s);
         if(r != 0)
         {
             fprintf(stderr, "Error starting audio decoder thread.\n");
-            pthread_attr_destroy(&attr);
             _ffmpeg_close(s);
             return(HACKTV_ERROR);
         }
 
-        r = pthread_create(&s->audio_scaler_thread, &attr, &_audio_scaler_thread, (void *) s);
+        r = pthread_create(&s->audio_scaler_thread, NULL, &_audio_scaler_thread, (void *) s);
         if(r != 0)
         {
             fprintf(stderr, "Error starting audio resampler thread.\n");
-            pthread_attr_destroy(&attr);
             _ffmpeg_close(s);
             return(HACKTV_ERROR);
         }
-
-        pthread_attr_destroy(&attr);
     }
 
     // Set normal priority for input thread
@@ -6,6 +6,7 @@
 #include <pthread.h>
 #include <unistd.h>
 #include "rf.h"
+#include "../threadplacement.h"
 /* Value from host/libhackrf/src/hackrf.c */
 #define TRANSFER_BUFFER_SIZE 262144
 
@@ -85,6 +86,7 @@ static int _buffer_init(buffers_t *buffers, size_t count, size_t length)
         pthread_mutex_init(&buffers->buffers[i].mutex, NULL);
         pthread_cond_init(&buffers->buffers[i].cond, NULL);
         buffers->buffers[i].data = malloc(length);
+        thread_placement_prefault(buffers->buffers[i].data, length);
         buffers->buffers[i].start = buffers->length;
         buffers->buffers[i].length = buffers->length;
         buffers->buffers[i].status = BUFFER_EMPTY;
@@ -217,6 +219,8 @@ static int _tx_callback(hackrf_transfer *transfer)
     uint8_t *buf = transfer->buffer;
     int r;
 
+    thread_placement_apply(THREAD_ROLE_USB);
+
     while (l)
     {
         r = _buffer_read(&rf->buffers, (int8_t *)buf, l);
@@ -252,6 +256,8 @@ static int _rx_callback(hackrf_transfer *transfer)
     int8_t *dst;
     size_t r;
 
+    thread_placement_apply(THREAD_ROLE_USB);
+
     while(l > 0)
     {
         r = _buffer_write_ptr(&rf->buffers, &dst);
@@ -31,8 +31,10 @@ extern "C" BOOL WINAPI DllMain(HINSTANCE hinstDLL, DWORD fdwReason, LPVOID lpvRe
 #include <algorithm>
 #include <cstring>
 #include <cstdlib>
+#include <cmath>
 #include "hacktv/av.h"
 #include "hacktv/rf.h"
+#include "threadplacement.h"
 #include <libhackrf/hackrf.h>
 
 #define VERSION "1.0"
@@ -88,6 +90,12 @@ enum {
     _OPT_PILLARBOX,
     _OPT_VERSION,
     _OPT_MODE,
+    _OPT_LOOPBACK_AWGN,
+    _OPT_LOOPBACK_OFFSET,
+    _OPT_LOOPBACK_PPM,
+    _OPT_LOOPBACK_UNTHROTTLED,
+    _OPT_FILE_SEEK,
+    _OPT_FILE_UNTHROTTLED,
 };
 
 
@@ -133,11 +141,22 @@ HackTvLib::HackTvLib(QObject *parent)
     , m_rxTxMode(RX_MODE)
     , hackRfDevice(nullptr)
     , rtlSdrDevice(nullptr)
+    , loopbackDevice(nullptr)
+    , fileSourceDevice(nullptr)
 {
     hackRfDevice = nullptr;
     rtlSdrDevice = nullptr;
     s = nullptr;
 
+    m_rxTransfer = &m_latency.stage("rx.transfer");
+    m_rxInterval = &m_latency.stage("rx.interval");
+    m_rxCallback = &m_latency.stage("rx.callback");
+    m_txRing = &m_latency.stage("tx.ring");
+    m_txUsb = &m_latency.stage("tx.usb");
+    m_rfSwitch = &m_latency.stage("rf.switch");
+    m_rxDdcQueue = &m_latency.stage("rx.ddc.queue");
+    m_rxDdcWork = &m_latency.stage("rx.ddc.work");
+
     fprintf(stderr, "HackTvLib initialized.\n");
     fflush(stderr);
 }
@@ -148,7 +167,7 @@ HackTvLib::~HackTvLib()
     fflush(stderr);
 
     // Only stop if not already stopped
-    if (m_txThread.joinable() || hackRfDevice || rtlSdrDevice) {
+    if (m_txThread.joinable() || hackRfDevice || rtlSdrDevice || loopbackDevice || fileSourceDevice) {
         fprintf(stderr, "Calling stop() from destructor\n");
         fflush(stderr);
         stop();
@@ -157,6 +176,8 @@ HackTvLib::~HackTvLib()
         fflush(stderr);
     }
 
+    clearDdc();
+
     // Final cleanup
     if (hackRfDevice) {
         fprintf(stderr, "Cleaning up hackRfDevice in destructor\n");
@@ -172,6 +193,20 @@ HackTvLib::~HackTvLib()
         rtlSdrDevice = nullptr;
     }
 
+    if (loopbackDevice) {
+        fprintf(stderr, "Cleaning up loopbackDevice in destructor\n");
+        fflush(stderr);
+        delete loopbackDevice;
+        loopbackDevice = nullptr;
+    }
+
+    if (fileSourceDevice) {
+        fprintf(stderr, "Cleaning up fileSourceDevice in destructor\n");
+        fflush(stderr);
+        delete fileSourceDevice;
+        fileSourceDevice = nullptr;
+    }
+
     fprintf(stderr, "=== HackTvLib Destructor Complete ===\n");
     fflush(stderr);
 }
@@ -212,18 +247,27 @@ void HackTvLib::setFrequency(uint64_t frequency_hz)
 
     log("Set Frequency : %d", frequency_hz);
 
+    // Transfers queued or being filled while the tuner moved
+    int inFlight = -1;
     if(strcmp(s->output_type, "hackrf") == 0)
     {
         if (hackRfDevice) {
             hackRfDevice->setFrequency(frequency_hz);
+            inFlight = HackRfDevice::LIBHACKRF_TRANSFERS;
         }
     }
     else if(strcmp(s->output_type, "rtlsdr") == 0)
     {
         if (rtlSdrDevice) {
             rtlSdrDevice->setFrequency(frequency_hz);
+            inFlight = static_cast<int>(RTLSDRDevice::ASYNC_BUFFERS);
         }
     }
+
+    if (inFlight >= 0) {
+        m_staleBlocks.store(inFlight, std::memory_order_relaxed);
+        m_tuneEpoch.fetch_add(1, std::memory_order_release);
+    }
 }
 
 void HackTvLib::setSampleRate(uint32_t sample_rate)
@@ -231,6 +275,7 @@ void HackTvLib::setSampleRate(uint32_t sample_rate)
     if (!s) return;
 
     log("Set SampleRate : %d", sample_rate);
+    m_rxSampleRate.store(sample_rate);
 
     if(strcmp(s->output_type, "hackrf") == 0)
     {
@@ -244,6 +289,23 @@ void HackTvLib::setSampleRate(uint32_t sample_rate)
             rtlSdrDevice->setSampleRate(sample_rate);
         }
     }
+    else if(strcmp(s->output_type, "loopback") == 0)
+    {
+        // FM/AM TX modulators run in hackRfDevice, pacing in loopbackDevice
+        if (hackRfDevice) {
+            hackRfDevice->setSampleRate(sample_rate);
+        }
+        if (loopbackDevice) {
+            loopbackDevice->setSampleRate(sample_rate);
+        }
+    }
+    else if(strcmp(s->output_type, "file") == 0)
+    {
+        // Playback speed only, the recording itself is not resampled
+        if (fileSourceDevice) {
+            fileSourceDevice->setSampleRate(sample_rate);
+        }
+    }
 }
 
 void HackTvLib::setAmplitude(float newAmplitude)
@@ -380,9 +442,113 @@ void HackTvLib::setOffsetTuning(bool enable)
     }
 }
 
+void HackTvLib::setTunerGain(int gain_tenth_db)
+{
+    if (rtlSdrDevice) {
+        rtlSdrDevice->setGain(gain_tenth_db);
+    }
+}
+
+void HackTvLib::setTunerAutoGain(bool enable)
+{
+    if (rtlSdrDevice) {
+        rtlSdrDevice->setAutoGain(enable);
+    }
+}
+
+void HackTvLib::setAgcMode(bool enable)
+{
+    if (rtlSdrDevice) {
+        rtlSdrDevice->setAgcMode(enable);
+    }
+}
+
+void HackTvLib::seekFile(double seconds)
+{
+    if (fileSourceDevice) {
+        fileSourceDevice->seek(seconds);
+    }
+}
+
 void HackTvLib::dataReceived(const int8_t *data, size_t len)
 {
+    ThreadPlacement::apply(ThreadPlacement::Usb);
+
+    // A block arrives with its last sample; the first is a block older
+    const int64_t now = LatencyHistogram::steadyUs();
+    const uint32_t rate = m_rxSampleRate.load(std::memory_order_relaxed);
+    const int64_t blockUs = rate ? static_cast<int64_t>(len / 2) * 1000000 / rate : 0;
+    m_blockTimeUs = static_cast<uint64_t>(LatencyHistogram::utcUs() - blockUs);
+    m_rxTransfer->record(blockUs);
+    if (m_lastBlockUs != 0) {
+        m_rxInterval->record(now - m_lastBlockUs);
+    }
+    m_lastBlockUs = now;
+
+    // Blocks in flight at a retune keep the epoch they were captured in
+    const uint32_t epoch = m_tuneEpoch.load(std::memory_order_acquire);
+    if (epoch != m_blockEpoch && m_staleBlocks.fetch_sub(1, std::memory_order_relaxed) <= 1) {
+        m_blockEpoch = epoch;
+    }
+
+    // The DSP thread starts on its copy while the raw callback runs
+    {
+        std::lock_guard<std::mutex> lock(m_ddcMutex);
+        if (m_ddc) {
+            if (rate != m_ddcInputRate) {
+                m_ddc->setInputRate(rate);
+                m_ddcInputRate = rate;
+            }
+            m_ddc->push(data, len, m_blockTimeUs);
+        }
+    }
+
     emitReceivedData(data, len);
+
+    m_rxCallback->record(LatencyHistogram::steadyUs() - now);
+}
+
+void HackTvLib::setDdc(const DdcConfig& config, DdcCallback callback)
+{
+    const uint32_t rate = m_rxSampleRate.load();
+    DdcProcessor* ddc = new DdcProcessor(rate, config, std::move(callback));
+    ddc->setLatencyStages(m_rxDdcQueue, m_rxDdcWork);
+
+    DdcProcessor* old = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(m_ddcMutex);
+        old = m_ddc;
+        m_ddc = ddc;
+        m_ddcInputRate = rate;
+    }
+    // Joins its DSP thread, outside the lock the data callback takes
+    delete old;
+
+    log("DDC: offset %.1f Hz, output %.1f kS/s", config.offsetHz, ddc->outputRate() / 1e3);
+}
+
+void HackTvLib::setDdcConfig(const DdcConfig& config)
+{
+    std::lock_guard<std::mutex> lock(m_ddcMutex);
+    if (m_ddc) m_ddc->setConfig(config);
+}
+
+void HackTvLib::clearDdc()
+{
+    DdcProcessor* old = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(m_ddcMutex);
+        old = m_ddc;
+        m_ddc = nullptr;
+        m_ddcInputRate = 0;
+    }
+    delete old;
+}
+
+double HackTvLib::ddcOutputRate()
+{
+    std::lock_guard<std::mutex> lock(m_ddcMutex);
+    return m_ddc ? m_ddc->outputRate() : 0.0;
 }
 
 void HackTvLib::cleanupArgv()
@@ -429,7 +595,116 @@ bool HackTvLib::openDevice()
             return false;
         }
     }
+    else if(strcmp(s->output_type, "loopback") == 0)
+    {
+        if(!createLoopbackDevice(s->vid.sample_rate) || loopbackDevice->rfOpen(&s->rf) != RF_OK)
+        {
+            delete loopbackDevice;
+            loopbackDevice = nullptr;
+            vid_free(&s->vid);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// ============================================================
+// Loopback output - TX samples go to the RX data callback
+// ============================================================
+
+bool HackTvLib::createLoopbackDevice(uint32_t sampleRate)
+{
+    if (loopbackDevice) {
+        delete loopbackDevice;
+        loopbackDevice = nullptr;
+    }
 
+    try {
+        loopbackDevice = new LoopbackDevice();
+    } catch (const std::exception& e) {
+        fprintf(stderr, "Exception creating LoopbackDevice: %s\n", e.what());
+        fflush(stderr);
+        return false;
+    }
+
+    loopbackDevice->setSampleRate(sampleRate);
+    m_rxSampleRate.store(sampleRate);
+    loopbackDevice->setNoiseLevel(s->loopback_awgn);
+    loopbackDevice->setFrequencyOffset(s->loopback_offset);
+    loopbackDevice->setSampleRateError(s->loopback_ppm);
+    loopbackDevice->setRealtime(!s->loopback_unthrottled);
+    loopbackDevice->setDataCallback([this](const int8_t* data, size_t len) {
+        this->dataReceived(data, len);
+    });
+
+    log("Loopback: %.3f MS/s, %s, AWGN %.1f dBFS, offset %.1f Hz, rate error %.1f ppm",
+        sampleRate / 1e6,
+        s->loopback_unthrottled ? "unthrottled" : "real-time",
+        s->loopback_awgn, s->loopback_offset, s->loopback_ppm);
+    return true;
+}
+
+// ============================================================
+// IQ file playback - recorded samples go to the RX data callback
+// ============================================================
+
+static int _file_type_from_name(const char *path)
+{
+    const char *ext = strrchr(path, '.');
+    if (ext == NULL) return RF_INT8;
+
+    if (strcmp(ext, ".cu8") == 0)  return RF_UINT8;
+    if (strcmp(ext, ".cs16") == 0 || strcmp(ext, ".ci16") == 0) return RF_INT16;
+    if (strcmp(ext, ".cf32") == 0 || strcmp(ext, ".cfile") == 0) return RF_FLOAT;
+
+    /* .cs8, .ci8, .iq, .raw: HackRF native */
+    return RF_INT8;
+}
+
+bool HackTvLib::createFileSourceDevice()
+{
+    if (fileSourceDevice) {
+        delete fileSourceDevice;
+        fileSourceDevice = nullptr;
+    }
+
+    if (s->output == NULL) {
+        fprintf(stderr, "No input file given, use -o file:<path>\n");
+        fflush(stderr);
+        return false;
+    }
+
+    try {
+        fileSourceDevice = new FileSourceDevice();
+    } catch (const std::exception& e) {
+        fprintf(stderr, "Exception creating FileSourceDevice: %s\n", e.what());
+        fflush(stderr);
+        return false;
+    }
+
+    /* -t wins, otherwise guess from the extension (SigMF overrides both) */
+    int fileType = s->file_type_set ? s->file_type : _file_type_from_name(s->output);
+
+    if (!fileSourceDevice->open(s->output, fileType, s->samplerate)) {
+        delete fileSourceDevice;
+        fileSourceDevice = nullptr;
+        return false;
+    }
+
+    fileSourceDevice->setLoop(s->repeat);
+    fileSourceDevice->setRealtime(!s->file_unthrottled);
+    fileSourceDevice->seek(s->file_seek);
+    fileSourceDevice->setDataCallback([this](const int8_t* data, size_t len) {
+        this->dataReceived(data, len);
+    });
+
+    log("File: %s, %.3f MS/s, %.2f s, %s%s",
+        s->output,
+        fileSourceDevice->getSampleRate() / 1e6,
+        fileSourceDevice->getTotalSamples() / static_cast<double>(std::max(1u, fileSourceDevice->getSampleRate())),
+        s->file_unthrottled ? "unthrottled" : "real-time",
+        s->repeat ? ", loop" : "");
     return true;
 }
 
@@ -838,6 +1113,12 @@ bool HackTvLib::parseArguments()
         { "type",           required_argument, 0, 't' },
         { "version",        no_argument,       0, _OPT_VERSION },
         { "rx-tx-mode",     required_argument, 0, _OPT_MODE },
+        { "loopback-awgn",  required_argument, 0, _OPT_LOOPBACK_AWGN },
+        { "loopback-offset", required_argument, 0, _OPT_LOOPBACK_OFFSET },
+        { "loopback-ppm",   required_argument, 0, _OPT_LOOPBACK_PPM },
+        { "loopback-unthrottled", no_argument, 0, _OPT_LOOPBACK_UNTHROTTLED },
+        { "file-seek",      required_argument, 0, _OPT_FILE_SEEK },
+        { "file-unthrottled", no_argument,     0, _OPT_FILE_UNTHROTTLED },
         { 0,                0,                 0,  0  }
     };  // long_options dizisi sonu
 
@@ -882,6 +1163,11 @@ bool HackTvLib::parseArguments()
                 s->output_type = "rtlsdr";
                 s->output = sub;
             }
+            else if(strcmp(pre, "loopback") == 0)
+            {
+                s->output_type = "loopback";
+                s->output = sub;
+            }
             else
             {
                 /* Unrecognised output type, default to file */
@@ -1198,6 +1484,7 @@ bool HackTvLib::parseArguments()
                 return false;
             }
 
+            s->file_type_set = 1;
             break;
 
         case _OPT_VERSION: /* --version */
@@ -1215,6 +1502,36 @@ bool HackTvLib::parseArguments()
             }
             break;
 
+        case _OPT_LOOPBACK_AWGN: /* --loopback-awgn <dBFS> */
+            s->loopback_awgn = atof(optarg);
+            break;
+
+        case _OPT_LOOPBACK_OFFSET: /* --loopback-offset <Hz> */
+            s->loopback_offset = atof(optarg);
+            break;
+
+        case _OPT_LOOPBACK_PPM: /* --loopback-ppm <ppm> */
+            s->loopback_ppm = atof(optarg);
+            if (!std::isfinite(s->loopback_ppm) ||
+                std::fabs(s->loopback_ppm) > LoopbackDevice::MAX_RATE_ERROR_PPM) {
+                fprintf(stderr, "Invalid loopback rate error. Use -%.0f to %.0f ppm.\n",
+                        LoopbackDevice::MAX_RATE_ERROR_PPM, LoopbackDevice::MAX_RATE_ERROR_PPM);
+                return false;
+            }
+            break;
+
+        case _OPT_LOOPBACK_UNTHROTTLED: /* --loopback-unthrottled */
+            s->loopback_unthrottled = 1;
+            break;
+
+        case _OPT_FILE_SEEK: /* --file-seek <seconds> */
+            s->file_seek = atof(optarg);
+            break;
+
+        case _OPT_FILE_UNTHROTTLED: /* --file-unthrottled */
+            s->file_unthrottled = 1;
+            break;
+
         case '?':
             print_usage();
             return true;
@@ -1239,9 +1556,13 @@ void HackTvLib::setReceivedDataCallback(DataCallback callback)
 
 void HackTvLib::clearCallbacks()
 {
-    std::lock_guard<std::mutex> lock(m_mutex);
-    m_logCallback = nullptr;
-    m_dataCallback = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_logCallback = nullptr;
+        m_dataCallback = nullptr;
+    }
+    // The DDC callback goes with it; its thread is joined here
+    clearDdc();
 }
 
 void HackTvLib::emitReceivedData(const int8_t *data, size_t len)
@@ -1259,6 +1580,7 @@ void HackTvLib::rfTxLoop()
 {
     fprintf(stderr, "[rfTxLoop] Thread started\n");
     fflush(stderr);
+    ThreadPlacement::apply(ThreadPlacement::Tx);
 
     char *pre, *sub;
     size_t l;
@@ -1448,6 +1770,40 @@ bool HackTvLib::stop()
             return true; // Consider it success if already cleaned up
         }
 
+        if (strcmp(s->output_type, "loopback") == 0) {
+            fprintf(stderr, "[2] Stopping loopback...\n");
+            fflush(stderr);
+
+            // Stop the pull thread first, it calls into hackRfDevice
+            if (loopbackDevice) {
+                loopbackDevice->stop();
+                delete loopbackDevice;
+                loopbackDevice = nullptr;
+            }
+            if (hackRfDevice) {
+                hackRfDevice->stop();
+                delete hackRfDevice;
+                hackRfDevice = nullptr;
+            }
+
+            log("Loopback stopped.");
+            return true;
+        }
+
+        if (strcmp(s->output_type, "file") == 0) {
+            fprintf(stderr, "[2] Stopping file playback...\n");
+            fflush(stderr);
+
+            if (fileSourceDevice) {
+                fileSourceDevice->stop();
+                delete fileSourceDevice;
+                fileSourceDevice = nullptr;
+            }
+
+            log("File playback stopped.");
+            return true;
+        }
+
         if (strcmp(s->output_type, "hackrf") == 0) {
             fprintf(stderr, "[2] Stopping HackRF...\n");
             fflush(stderr);
@@ -1609,6 +1965,10 @@ bool HackTvLib::stop()
             rf_close(&s->rf);
             vid_free(&s->vid);
         }
+        if (loopbackDevice) {
+            delete loopbackDevice;
+            loopbackDevice = nullptr;
+        }
         av_ffmpeg_deinit();
 
         fprintf(stderr, "[12]Resources cleaned up\n");
@@ -1628,6 +1988,55 @@ bool HackTvLib::stop()
     return true; // Always return true since thread is stopped
 }
 
+// ============================================================
+// Warm RX/TX switch (HackRF RX and FM transmitter)
+// ============================================================
+
+bool HackTvLib::switchToRx()
+{
+    return switchHackRf(RX_MODE);
+}
+
+bool HackTvLib::switchToTx()
+{
+    return switchHackRf(TX_MODE);
+}
+
+bool HackTvLib::isTxMode() const
+{
+    return m_rxTxMode == TX_MODE;
+}
+
+bool HackTvLib::switchHackRf(rxtx_mode mode)
+{
+    // Video TX owns the device through rf_hackrf; loopback and file have
+    // no direction to change
+    if (!s || !hackRfDevice || m_txThread.joinable() ||
+        strcmp(s->output_type, "hackrf") != 0) {
+        return false;
+    }
+
+    const int64_t startUs = LatencyHistogram::steadyUs();
+
+    // The RX callback thread is stopped while in TX; the first block after
+    // the switch must not count the TX period as an interval
+    if (m_rxTxMode == TX_MODE && mode == RX_MODE) {
+        m_lastBlockUs = 0;
+    }
+
+    if (hackRfDevice->switchMode(mode == TX_MODE ? rf_mode::TX : rf_mode::RX) != RF_OK) {
+        log("Warm switch to %s failed, restart the device.", getRxTxModeString(mode));
+        return false;
+    }
+
+    m_rxTxMode = mode;
+
+    const int64_t tookUs = LatencyHistogram::steadyUs() - startUs;
+    m_rfSwitch->record(tookUs);
+    log("Switched to %s in %.1f ms (device kept open).", getRxTxModeString(mode), tookUs / 1000.0);
+    return true;
+}
+
 int HackTvLib::hardReset()
 {
     fprintf(stderr, "\n========================================\n");
@@ -1646,6 +2055,7 @@ int HackTvLib::hardReset()
         fflush(stderr);
         try {
             hackRfDevice = new HackRfDevice();
+            hackRfDevice->setSerial(s && s->output ? s->output : "");
         } catch (...) {
             fprintf(stderr, "hardReset: failed to create HackRfDevice\n");
             fflush(stderr);
@@ -1765,6 +2175,13 @@ bool HackTvLib::start()
     s->ffmt = nullptr;
     s->fopts = nullptr;
     s->audio_gain = 3.0;
+    s->loopback_awgn = LoopbackDevice::NOISE_OFF;
+    s->loopback_offset = 0.0;
+    s->loopback_ppm = 0.0;
+    s->loopback_unthrottled = 0;
+    s->file_type_set = 0;
+    s->file_seek = 0.0;
+    s->file_unthrottled = 0;
 
     m_rxTxMode = RX_MODE;
     m_abort = false;
@@ -1800,6 +2217,8 @@ bool HackTvLib::start()
     if (m_rxTxMode == RX_MODE) {
         fprintf(stderr, "[5] === RX MODE ===\n");
         fflush(stderr);
+        m_rxSampleRate.store(s->samplerate);
+        m_lastBlockUs = 0;
 
         if (strcmp(s->output_type, "hackrf") == 0) {
             fprintf(stderr, "[6] Setting up HackRF...\n");
@@ -1823,6 +2242,7 @@ bool HackTvLib::start()
             // Create new device
             try {
                 hackRfDevice = new HackRfDevice();
+                hackRfDevice->setSerial(s->output ? s->output : "");
                 fprintf(stderr, "     Created HackRfDevice: %p\n", (void*)hackRfDevice);
                 fflush(stderr);
             } catch (const std::exception& e) {
@@ -1831,10 +2251,11 @@ bool HackTvLib::start()
                 return false;
             }
 
-            // Set callback
+            // Set callback; the TX stages are used after switchToTx()
             hackRfDevice->setDataCallback([this](const int8_t* data, size_t len) {
                 this->dataReceived(data, len);
             });
+            hackRfDevice->setLatencyStages(m_txRing, m_txUsb);
 
             // Start device
             fprintf(stderr, "[7] Starting HackRF in RX mode...\n");
@@ -1856,6 +2277,7 @@ bool HackTvLib::start()
 
             fprintf(stderr, "[8]RX SUCCESS \n");
             fflush(stderr);
+            ThreadPlacement::lockMemory();
             log("HackTvLib started in RX mode with HackRF.");
             return true;
         }
@@ -1881,13 +2303,23 @@ bool HackTvLib::start()
                 fflush(stderr);
                 rtlSampleRate = 2000000;
             }
+            m_rxSampleRate.store(rtlSampleRate);
 
-            if (rtlSdrDevice->initialize(0, rtlSampleRate, s->frequency, 0)) {
+            const int rtlIndex = RTLSDRDevice::findDevice(s->output ? s->output : "");
+            if (rtlIndex < 0) {
+                log("RTL-SDR %s not found.", s->output);
+                delete rtlSdrDevice;
+                rtlSdrDevice = nullptr;
+                return false;
+            }
+
+            if (rtlSdrDevice->initialize(rtlIndex, rtlSampleRate, s->frequency, 0)) {
                 // RTL-SDR: use auto gain for best results
                 rtlSdrDevice->setAutoGain(true);
                 rtlSdrDevice->setAgcMode(true);
 
                 rtlSdrDevice->start();
+                ThreadPlacement::lockMemory();
                 log("HackTvLib started in RX mode with RTL-SDR (auto gain).");
                 return true;
             } else {
@@ -1897,6 +2329,30 @@ bool HackTvLib::start()
                 return false;
             }
         }
+        else if (strcmp(s->output_type, "loopback") == 0) {
+            // Loopback has no receiver of its own: start in TX mode and the
+            // transmitted samples arrive on this instance's data callback.
+            fprintf(stderr, "Loopback output requires --rx-tx-mode tx\n");
+            fflush(stderr);
+            log("Loopback: start in TX mode, RX data is delivered to the data callback.");
+            return false;
+        }
+        else if (strcmp(s->output_type, "file") == 0) {
+            fprintf(stderr, "[9] Setting up IQ file playback...\n");
+            fflush(stderr);
+
+            if (!createFileSourceDevice() || !fileSourceDevice->start()) {
+                log("Could not play IQ file %s.", s->output ? s->output : "");
+                delete fileSourceDevice;
+                fileSourceDevice = nullptr;
+                return false;
+            }
+
+            m_rxSampleRate.store(fileSourceDevice->getSampleRate());
+            ThreadPlacement::lockMemory();
+            log("HackTvLib started in RX mode with IQ file playback.");
+            return true;
+        }
 
         fprintf(stderr, "Unknown output device: %s\n", s->output_type);
         fflush(stderr);
@@ -1933,6 +2389,12 @@ bool HackTvLib::start()
 
             try {
                 hackRfDevice = new HackRfDevice();
+                hackRfDevice->setSerial(s->output ? s->output : "");
+                hackRfDevice->setLatencyStages(m_txRing, m_txUsb);
+                // Used after switchToRx()
+                hackRfDevice->setDataCallback([this](const int8_t* data, size_t len) {
+                    this->dataReceived(data, len);
+                });
                 fprintf(stderr, "    Created HackRfDevice: %p\n", (void*)hackRfDevice);
                 fflush(stderr);
             } catch (const std::exception& e) {
@@ -1996,11 +2458,53 @@ bool HackTvLib::start()
 
             fprintf(stderr, "[18]FM TX SUCCESS\n");
             fflush(stderr);
+            ThreadPlacement::lockMemory();
             log("HackTvLib started in FM TX mode. Audio via ring buffer.");
             return true;
         }
 
-        fprintf(stderr, "FM Transmitter only supports HackRF\n");
+        if (strcmp(s->output_type, "loopback") == 0) {
+            fprintf(stderr, "[12] Starting FM TX in loopback (no hardware)...\n");
+            fflush(stderr);
+
+            if (hackRfDevice) {
+                delete hackRfDevice;
+                hackRfDevice = nullptr;
+            }
+
+            // HackRfDevice hosts the FM/AM modulators and the audio ring;
+            // it is run without opening a device.
+            try {
+                hackRfDevice = new HackRfDevice();
+            } catch (const std::exception& e) {
+                fprintf(stderr, "Exception creating HackRfDevice: %s\n", e.what());
+                fflush(stderr);
+                return false;
+            }
+
+            hackRfDevice->setSampleRate(s->samplerate);
+            hackRfDevice->setFrequency(s->frequency);
+            hackRfDevice->setLatencyStages(m_txRing, nullptr);
+
+            if (hackRfDevice->startSoftwareTx() != RF_OK || !createLoopbackDevice(s->samplerate)) {
+                delete hackRfDevice;
+                hackRfDevice = nullptr;
+                return false;
+            }
+
+            HackRfDevice* modulator = hackRfDevice;
+            loopbackDevice->start([modulator](int8_t* buffer, uint32_t length) {
+                return modulator->fillTxBuffer(buffer, length);
+            });
+
+            fprintf(stderr, "[13]FM TX LOOPBACK SUCCESS\n");
+            fflush(stderr);
+            ThreadPlacement::lockMemory();
+            log("HackTvLib started in FM TX loopback mode. Audio via ring buffer.");
+            return true;
+        }
+
+        fprintf(stderr, "FM Transmitter only supports HackRF or loopback\n");
         fflush(stderr);
         log("FM Transmitter mode requires HackRF device");
         return false;
@@ -2116,6 +2620,7 @@ bool HackTvLib::start()
 
         fprintf(stderr, "[27]VIDEO TX SUCCESS \n");
         fflush(stderr);
+        ThreadPlacement::lockMemory();
         log("HackTvLib started in TX mode.");
         return true;
     } catch (const std::exception& e) {
@@ -2174,6 +2679,27 @@ void HackTvLib::writeExternalAudio(const float* data, size_t count)
     }
 }
 
+std::vector<std::string> HackTvLib::listDevices()
+{
+    std::vector<std::string> devices;
+
+    HackRfDevice probe;
+    for (const std::string& serial : probe.listDevices()) {
+        devices.push_back("hackrf:" + serial);
+    }
+    for (const std::string& serial : RTLSDRDevice::listSerials()) {
+        devices.push_back("rtlsdr:" + serial);
+    }
+    return devices;
+}
+
+size_t HackTvLib::externalAudioQueued() const
+{
+    if (!hackRfDevice || !hackRfDevice->m_useAudioFileRing.load()) return 0;
+    // The ring holds stereo pairs
+    return hackRfDevice->ringAvailable() / 2;
+}
+
 void HackTvLib::setTxModulationType(int type)
 {
     if (hackRfDevice) {
@@ -0,0 +1,192 @@
+#ifndef LATENCYHISTOGRAM_H
+#define LATENCYHISTOGRAM_H
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+// Latency of one pipeline stage, in quarter-octave buckets from 1 us to
+// about a minute (a bucket is 19% wide, so percentiles are good to ~10%).
+// record() is lock-free and can be called from any thread, including the
+// USB and audio callbacks; reading is for statistics and may miss a
+// sample that lands at the same moment.
+//
+// A stage records how long a block waited or worked there: dequeue minus
+// enqueue on one clock (steadyUs), or for hops between machines capture
+// time against arrival, both UTC (utcUs; only as good as the clock sync,
+// so those can come out negative and are counted apart).
+class LatencyHistogram
+{
+public:
+    static constexpr int BUCKETS_PER_OCTAVE = 4;
+    static constexpr int OCTAVES = 26;
+    static constexpr int BUCKETS = 1 + BUCKETS_PER_OCTAVE * OCTAVES;   // bucket 0: under 1 us
+
+    struct Summary {
+        uint64_t count = 0;
+        uint64_t negative = 0;          // clock skew between machines
+        double meanMs = 0.0;
+        double p50Ms = 0.0;
+        double p90Ms = 0.0;
+        double p99Ms = 0.0;
+        double maxMs = 0.0;
+    };
+
+    static int64_t steadyUs()
+    {
+        return std::chrono::duration_cast<std::chrono::microseconds>(
+                   std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    static int64_t utcUs()
+    {
+        return std::chrono::duration_cast<std::chrono::microseconds>(
+                   std::chrono::system_clock::now().time_since_epoch()).count();
+    }
+
+    void record(int64_t us)
+    {
+        if (us < 0) {
+            m_negative.fetch_add(1, std::memory_order_relaxed);
+            us = 0;
+        }
+        m_buckets[bucket(us)].fetch_add(1, std::memory_order_relaxed);
+        m_count.fetch_add(1, std::memory_order_relaxed);
+        m_sumUs.fetch_add(static_cast<uint64_t>(us), std::memory_order_relaxed);
+        uint64_t max = m_maxUs.load(std::memory_order_relaxed);
+        while (static_cast<uint64_t>(us) > max &&
+               !m_maxUs.compare_exchange_weak(max, static_cast<uint64_t>(us), std::memory_order_relaxed)) {
+        }
+    }
+
+    void recordMs(double ms) { record(static_cast<int64_t>(ms * 1000.0)); }
+
+    Summary summary() const
+    {
+        Summary s;
+        std::array<uint64_t, BUCKETS> counts;
+        for (int b = 0; b < BUCKETS; b++) {
+            counts[b] = m_buckets[b].load(std::memory_order_relaxed);
+            s.count += counts[b];
+        }
+        if (s.count == 0) return s;
+        s.negative = m_negative.load(std::memory_order_relaxed);
+        s.meanMs = m_sumUs.load(std::memory_order_relaxed) / 1000.0 / s.count;
+        s.maxMs = m_maxUs.load(std::memory_order_relaxed) / 1000.0;
+        s.p50Ms = std::min(percentileUs(counts, s.count, 0.50) / 1000.0, s.maxMs);
+        s.p90Ms = std::min(percentileUs(counts, s.count, 0.90) / 1000.0, s.maxMs);
+        s.p99Ms = std::min(percentileUs(counts, s.count, 0.99) / 1000.0, s.maxMs);
+        return s;
+    }
+
+    void reset()
+    {
+        for (auto& b : m_buckets) b.store(0, std::memory_order_relaxed);
+        m_count.store(0, std::memory_order_relaxed);
+        m_negative.store(0, std::memory_order_relaxed);
+        m_sumUs.store(0, std::memory_order_relaxed);
+        m_maxUs.store(0, std::memory_order_relaxed);
+    }
+
+private:
+    static int bucket(int64_t us)
+    {
+        if (us < 1) return 0;
+        const int b = 1 + static_cast<int>(std::log2(static_cast<double>(us)) * BUCKETS_PER_OCTAVE);
+        return b < BUCKETS ? b : BUCKETS - 1;
+    }
+
+    // Geometric middle of the bucket holding the q-th sample
+    static double percentileUs(const std::array<uint64_t, BUCKETS>& counts, uint64_t total, double q)
+    {
+        const uint64_t rank = static_cast<uint64_t>(std::ceil(q * total));
+        uint64_t seen = 0;
+        for (int b = 0; b < BUCKETS; b++) {
+            seen += counts[b];
+            if (seen >= rank && counts[b] > 0) {
+                return b == 0 ? 0.5 : std::exp2((b - 0.5) / BUCKETS_PER_OCTAVE);
+            }
+        }
+        return 0.0;
+    }
+
+    std::array<std::atomic<uint64_t>, BUCKETS> m_buckets{};
+    std::atomic<uint64_t> m_count{0};
+    std::atomic<uint64_t> m_negative{0};
+    std::atomic<uint64_t> m_sumUs{0};
+    std::atomic<uint64_t> m_maxUs{0};
+};
+
+// Named stages of one pipeline. stage() hands out a histogram that lives
+// as long as the recorder, so the hot paths keep the reference and never
+// look names up; asking for a name twice gives the same one.
+class LatencyRecorder
+{
+public:
+    LatencyHistogram& stage(const std::string& name)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (auto& entry : m_stages) {
+            if (entry.first == name) return entry.second;
+        }
+        m_stages.emplace_back(std::piecewise_construct, std::forward_as_tuple(name), std::forward_as_tuple());
+        return m_stages.back().second;
+    }
+
+    // Stages with samples, in the order they were made
+    std::vector<std::pair<std::string, LatencyHistogram::Summary>> summaries() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        std::vector<std::pair<std::string, LatencyHistogram::Summary>> list;
+        for (const auto& entry : m_stages) {
+            LatencyHistogram::Summary s = entry.second.summary();
+            if (s.count > 0) list.emplace_back(entry.first, s);
+        }
+        return list;
+    }
+
+    // One line per stage with samples, milliseconds:
+    // "<prefix><stage> n=<count> mean=<> p50=<> p90=<> p99=<> max=<>[ neg=<count>]"
+    std::string report(const std::string& prefix = std::string()) const
+    {
+        std::string text;
+        for (const auto& entry : summaries()) {
+            text += formatLine(prefix + entry.first, entry.second);
+        }
+        return text;
+    }
+
+    void reset()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (auto& entry : m_stages) entry.second.reset();
+    }
+
+    static std::string formatLine(const std::string& name, const LatencyHistogram::Summary& s)
+    {
+        char line[256];
+        int n = std::snprintf(line, sizeof(line), "%s n=%llu mean=%.2f p50=%.2f p90=%.2f p99=%.2f max=%.2f",
+                              name.c_str(), static_cast<unsigned long long>(s.count),
+                              s.meanMs, s.p50Ms, s.p90Ms, s.p99Ms, s.maxMs);
+        if (s.negative > 0 && n > 0 && n < static_cast<int>(sizeof(line))) {
+            std::snprintf(line + n, sizeof(line) - n, " neg=%llu", static_cast<unsigned long long>(s.negative));
+        }
+        return std::string(line) + "\n";
+    }
+
+private:
+    mutable std::mutex m_mutex;
+    std::deque<std::pair<std::string, LatencyHistogram>> m_stages;     // deque: stable addresses
+};
+
+#endif // LATENCYHISTOGRAM_H
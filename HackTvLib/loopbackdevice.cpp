@@ -0,0 +1,354 @@
+#include "loopbackdevice.h"
+#include <cmath>
+#include <cstdio>
+#include <algorithm>
+
+LoopbackDevice::LoopbackDevice(QObject *parent)
+    : QObject(parent)
+    , m_isRunning(false)
+    , m_sampleRate(DEFAULT_SAMPLE_RATE)
+    , m_noiseDbfs(NOISE_OFF)
+    , m_freqOffsetHz(0.0)
+    , m_sampleRatePpm(0.0)
+    , m_realtime(true)
+    , m_ncoPhase(0.0)
+    , m_resamplePos(0.0)
+    , m_lastSample(0.0f, 0.0f)
+    , m_rng(0x5eed1234u)
+    , m_gauss(0.0f, 1.0f)
+    , m_blockFill(0)
+    , m_pacedSamples(0)
+    , m_samplesDelivered(0)
+    , m_blocksDelivered(0)
+{
+    m_block.resize(BLOCK_SAMPLES * 2, 0);
+    m_work.reserve(BLOCK_SAMPLES);
+}
+
+LoopbackDevice::~LoopbackDevice()
+{
+    stop();
+}
+
+// ============================================================
+// Control
+// ============================================================
+
+int LoopbackDevice::start(TxSource source)
+{
+    if (m_isRunning.load()) {
+        fprintf(stderr, "LoopbackDevice: already running\n");
+        fflush(stderr);
+        return RF_ERROR;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_processMutex);
+        m_ncoPhase = 0.0;
+        m_resamplePos = 0.0;
+        m_lastSample = std::complex<float>(0.0f, 0.0f);
+        m_blockFill = 0;
+        for (auto& block : m_ready) {
+            m_spare.push_back(std::move(block));
+        }
+        m_ready.clear();
+        m_samplesDelivered.store(0);
+        m_blocksDelivered.store(0);
+        m_pacedSamples = 0;
+        m_startTime = std::chrono::steady_clock::now();
+        m_runStart = m_startTime;
+    }
+
+    m_source = std::move(source);
+    m_isRunning.store(true);
+
+    if (m_source) {
+        m_pullThread = std::make_unique<std::thread>(&LoopbackDevice::pullLoop, this);
+    }
+
+    fprintf(stderr, "LoopbackDevice started: %.3f MS/s, %s, awgn=%.1f dBFS, offset=%.1f Hz, rate error=%.1f ppm\n",
+            m_sampleRate.load() / 1e6,
+            m_realtime.load() ? "real-time" : "unthrottled",
+            m_noiseDbfs.load(), m_freqOffsetHz.load(), m_sampleRatePpm.load());
+    fflush(stderr);
+    return RF_OK;
+}
+
+int LoopbackDevice::stop()
+{
+    bool wasRunning = m_isRunning.exchange(false);
+
+    if (m_pullThread && m_pullThread->joinable()) {
+        m_pullThread->join();
+    }
+    m_pullThread.reset();
+
+    if (wasRunning) {
+        printStats();
+    }
+    return RF_OK;
+}
+
+void LoopbackDevice::printStats()
+{
+    double elapsed = std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - m_runStart).count();
+    uint64_t samples = m_samplesDelivered.load();
+
+    fprintf(stderr, "LoopbackDevice stopped: %llu blocks, %.1f MS in %.2f s (%.2f MS/s)\n",
+            (unsigned long long)m_blocksDelivered.load(), samples / 1e6, elapsed,
+            elapsed > 0 ? samples / elapsed / 1e6 : 0.0);
+    fflush(stderr);
+}
+
+// ============================================================
+// Push path (hacktv rf_t sink)
+// ============================================================
+
+int LoopbackDevice::rfOpen(rf_t *rf)
+{
+    rf->ctx = this;
+    rf->write = _rf_write;
+    rf->read = nullptr;
+    rf->close = _rf_close;
+    return start();
+}
+
+int LoopbackDevice::_rf_write(void *ctx, int16_t *iq_data, size_t samples)
+{
+    LoopbackDevice *device = static_cast<LoopbackDevice*>(ctx);
+    if (!device) return RF_ERROR;
+    return device->write(iq_data, samples);
+}
+
+int LoopbackDevice::_rf_close(void *ctx)
+{
+    LoopbackDevice *device = static_cast<LoopbackDevice*>(ctx);
+    if (device) device->stop();
+    return RF_OK;
+}
+
+int LoopbackDevice::write(const int16_t *iq_data, size_t samples)
+{
+    if (!m_isRunning.load() || !iq_data) {
+        return RF_ERROR;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_processMutex);
+
+        m_work.resize(samples);
+        for (size_t i = 0; i < samples; i++) {
+            m_work[i] = std::complex<float>(iq_data[i * 2] / 32768.0f,
+                                            iq_data[i * 2 + 1] / 32768.0f);
+        }
+        process(m_work.data(), samples);
+    }
+    deliverReady();
+    return RF_OK;
+}
+
+// ============================================================
+// Pull path (FM/AM TX modulators)
+// ============================================================
+
+void LoopbackDevice::pullLoop()
+{
+    std::vector<int8_t> tx(BLOCK_SAMPLES * 2);
+
+    while (m_isRunning.load()) {
+        if (m_source(tx.data(), static_cast<uint32_t>(tx.size())) < 0) {
+            fprintf(stderr, "LoopbackDevice: TX source stopped\n");
+            fflush(stderr);
+            break;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(m_processMutex);
+            m_work.resize(BLOCK_SAMPLES);
+            for (size_t i = 0; i < BLOCK_SAMPLES; i++) {
+                m_work[i] = std::complex<float>(tx[i * 2] / 128.0f, tx[i * 2 + 1] / 128.0f);
+            }
+            process(m_work.data(), BLOCK_SAMPLES);
+        }
+        deliverReady();
+    }
+}
+
+// ============================================================
+// Channel model + block assembly
+// ============================================================
+
+void LoopbackDevice::process(const std::complex<float> *in, size_t count)
+{
+    const double ppm = m_sampleRatePpm.load();
+    const double step = 1.0 + ppm * 1e-6;
+    const bool resample = (ppm != 0.0);
+
+    const double offset = m_freqOffsetHz.load();
+    const double phaseInc = 2.0 * M_PI * offset / std::max(1u, m_sampleRate.load());
+    const bool shift = (offset != 0.0);
+
+    const float noiseDbfs = m_noiseDbfs.load();
+    const bool noise = noiseDbfs > NOISE_OFF;
+    // Full scale complex sine = 0 dBFS, noise power split over I and Q
+    const float sigma = noise ? std::sqrt(std::pow(10.0f, noiseDbfs / 10.0f) / 2.0f) : 0.0f;
+
+    auto put = [&](std::complex<float> v) {
+        if (shift) {
+            v *= std::complex<float>(static_cast<float>(std::cos(m_ncoPhase)),
+                                     static_cast<float>(std::sin(m_ncoPhase)));
+            m_ncoPhase += phaseInc;
+            if (m_ncoPhase > M_PI) m_ncoPhase -= 2.0 * M_PI;
+            else if (m_ncoPhase < -M_PI) m_ncoPhase += 2.0 * M_PI;
+        }
+        if (noise) {
+            v += std::complex<float>(m_gauss(m_rng) * sigma, m_gauss(m_rng) * sigma);
+        }
+
+        m_block[m_blockFill * 2] = static_cast<int8_t>(
+            std::lround(std::clamp(v.real() * 127.0f, -127.0f, 127.0f)));
+        m_block[m_blockFill * 2 + 1] = static_cast<int8_t>(
+            std::lround(std::clamp(v.imag() * 127.0f, -127.0f, 127.0f)));
+
+        if (++m_blockFill == BLOCK_SAMPLES) {
+            queueBlock();
+        }
+    };
+
+    for (size_t i = 0; i < count; i++) {
+        if (!resample) {
+            put(in[i]);
+            continue;
+        }
+
+        // Sample rate error: read the TX stream with a clock that is
+        // off by 'ppm', linear interpolation between neighbouring samples.
+        while (m_resamplePos < 1.0) {
+            float t = static_cast<float>(m_resamplePos);
+            put(m_lastSample + (in[i] - m_lastSample) * t);
+            m_resamplePos += step;
+        }
+        m_resamplePos -= 1.0;
+        m_lastSample = in[i];
+    }
+}
+
+// Under m_processMutex: the full block waits for deliverReady()
+void LoopbackDevice::queueBlock()
+{
+    m_blockFill = 0;
+    m_ready.push_back(std::move(m_block));
+    if (m_spare.empty()) {
+        m_block.assign(BLOCK_SAMPLES * 2, 0);
+    } else {
+        m_block = std::move(m_spare.back());
+        m_spare.pop_back();
+    }
+}
+
+// Processing thread, without m_processMutex
+void LoopbackDevice::deliverReady()
+{
+    std::vector<std::vector<int8_t>> ready;
+    DataCallback callback;
+    {
+        std::lock_guard<std::mutex> lock(m_processMutex);
+        if (m_ready.empty()) return;
+        ready.swap(m_ready);
+        callback = m_dataCallback;
+    }
+
+    for (const auto& block : ready) {
+        if (callback) {
+            try {
+                callback(block.data(), block.size());
+            } catch (...) {
+                fprintf(stderr, "LoopbackDevice: exception in data callback\n");
+                fflush(stderr);
+            }
+        }
+
+        m_samplesDelivered.fetch_add(BLOCK_SAMPLES);
+        m_blocksDelivered.fetch_add(1);
+        pace();
+    }
+
+    std::lock_guard<std::mutex> lock(m_processMutex);
+    for (auto& block : ready) {
+        m_spare.push_back(std::move(block));
+    }
+}
+
+void LoopbackDevice::pace()
+{
+    if (!m_realtime.load()) return;
+
+    // Deadline of the next block on the nominal sample clock. If the
+    // consumer falls more than 100 ms behind, the clock is re-based
+    // instead of bursting to catch up. Only the sleep is unlocked.
+    std::chrono::steady_clock::time_point due;
+    {
+        std::lock_guard<std::mutex> lock(m_processMutex);
+        uint32_t rate = m_sampleRate.load();
+        if (rate == 0) return;
+
+        m_pacedSamples += BLOCK_SAMPLES;
+        due = m_startTime + std::chrono::nanoseconds(
+            static_cast<int64_t>(m_pacedSamples * 1e9 / rate));
+        auto now = std::chrono::steady_clock::now();
+        if (due <= now) {
+            if (now - due > std::chrono::milliseconds(100)) {
+                m_startTime += (now - due);
+            }
+            return;
+        }
+    }
+    std::this_thread::sleep_until(due);
+}
+
+// ============================================================
+// Parameters
+// ============================================================
+
+void LoopbackDevice::setDataCallback(DataCallback callback)
+{
+    std::lock_guard<std::mutex> lock(m_processMutex);
+    m_dataCallback = std::move(callback);
+}
+
+void LoopbackDevice::setSampleRate(uint32_t sample_rate)
+{
+    std::lock_guard<std::mutex> lock(m_processMutex);
+    m_sampleRate.store(sample_rate);
+    // Restart the pacing clock at the new rate
+    m_startTime = std::chrono::steady_clock::now();
+    m_pacedSamples = 0;
+}
+
+void LoopbackDevice::setNoiseLevel(float dbfs)
+{
+    m_noiseDbfs.store(dbfs);
+}
+
+void LoopbackDevice::setFrequencyOffset(double hz)
+{
+    m_freqOffsetHz.store(hz);
+}
+
+void LoopbackDevice::setSampleRateError(double ppm)
+{
+    if (!std::isfinite(ppm) || std::fabs(ppm) > MAX_RATE_ERROR_PPM) {
+        const double clamped = std::isfinite(ppm) ? std::clamp(ppm, -MAX_RATE_ERROR_PPM, MAX_RATE_ERROR_PPM) : 0.0;
+        fprintf(stderr, "LoopbackDevice: rate error %.1f ppm out of range (+/-%.0f), using %.1f ppm\n",
+                ppm, MAX_RATE_ERROR_PPM, clamped);
+        fflush(stderr);
+        ppm = clamped;
+    }
+    m_sampleRatePpm.store(ppm);
+}
+
+void LoopbackDevice::setRealtime(bool realtime)
+{
+    m_realtime.store(realtime);
+}
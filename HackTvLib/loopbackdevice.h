@@ -0,0 +1,122 @@
+#ifndef LOOPBACKDEVICE_H
+#define LOOPBACKDEVICE_H
+
+#include <QObject>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <memory>
+#include <functional>
+#include <vector>
+#include <complex>
+#include <random>
+#include <chrono>
+#include "hacktv/rf.h"
+#include "constants.h"
+
+// Software RF device: TX samples are looped back to the RX DataCallback.
+//
+// Two ways to feed it:
+//   - push: hacktv video TX writes through rf_write() (see rfOpen())
+//   - pull: start(source) runs a thread that asks the source for int8 IQ
+//           blocks, e.g. HackRfDevice::fillTxBuffer() for FM/AM TX
+//
+// Optional channel impairments are applied before delivery:
+// AWGN (dBFS), carrier frequency offset (Hz) and sample rate error (ppm).
+// Blocks are 131072 IQ samples (262144 bytes) like a HackRF USB transfer,
+// paced at the nominal sample rate or delivered as fast as consumers accept.
+class LoopbackDevice : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit LoopbackDevice(QObject *parent = nullptr);
+    ~LoopbackDevice();
+
+    using DataCallback = std::function<void(const int8_t*, size_t)>;
+    using TxSource = std::function<int(int8_t*, uint32_t)>;
+
+    static constexpr size_t BLOCK_SAMPLES = 131072;
+    static constexpr float NOISE_OFF = -200.0f;
+    // Resampling steps 1 + ppm*1e-6, which must stay well above zero
+    static constexpr double MAX_RATE_ERROR_PPM = 1e5;
+
+    // Control
+    int start(TxSource source = nullptr);
+    int stop();
+    bool isRunning() const { return m_isRunning.load(); }
+
+    // Push path: hook this device into a hacktv rf_t sink
+    int rfOpen(rf_t *rf);
+    int write(const int16_t *iq_data, size_t samples);
+
+    // Callback
+    void setDataCallback(DataCallback callback);
+
+    // Parameters
+    void setSampleRate(uint32_t sample_rate);
+    void setNoiseLevel(float dbfs);
+    void setFrequencyOffset(double hz);
+    void setSampleRateError(double ppm);
+    void setRealtime(bool realtime);
+
+    uint32_t getSampleRate() const { return m_sampleRate.load(); }
+    uint64_t getSamplesDelivered() const { return m_samplesDelivered.load(); }
+    uint64_t getBlocksDelivered() const { return m_blocksDelivered.load(); }
+
+private:
+    static int _rf_write(void *ctx, int16_t *iq_data, size_t samples);
+    static int _rf_close(void *ctx);
+
+    void pullLoop();
+    void process(const std::complex<float> *in, size_t count);
+    void queueBlock();
+    void deliverReady();
+    void pace();
+    void printStats();
+
+    // Thread management
+    std::unique_ptr<std::thread> m_pullThread;
+    std::atomic<bool> m_isRunning;
+    TxSource m_source;
+
+    // Push and pull paths never run at the same time, this guards
+    // parameter changes against the processing thread. It is not held
+    // while the data callback runs or pacing sleeps, so setters return
+    // at once and the callback may call them.
+    std::mutex m_processMutex;
+
+    // Callback
+    DataCallback m_dataCallback;
+
+    // Parameters
+    std::atomic<uint32_t> m_sampleRate;
+    std::atomic<float> m_noiseDbfs;
+    std::atomic<double> m_freqOffsetHz;
+    std::atomic<double> m_sampleRatePpm;
+    std::atomic<bool> m_realtime;
+
+    // Impairment state
+    double m_ncoPhase;
+    double m_resamplePos;              // fractional read position (sample rate error)
+    std::complex<float> m_lastSample;  // previous input for linear interpolation
+    std::mt19937 m_rng;
+    std::normal_distribution<float> m_gauss;
+
+    // Output block; full ones wait in m_ready for delivery outside the
+    // lock, then go back to m_spare
+    std::vector<std::complex<float>> m_work;
+    std::vector<int8_t> m_block;
+    size_t m_blockFill;
+    std::vector<std::vector<int8_t>> m_ready;
+    std::vector<std::vector<int8_t>> m_spare;
+
+    // Pacing / statistics
+    std::chrono::steady_clock::time_point m_startTime;   // pacing clock origin
+    std::chrono::steady_clock::time_point m_runStart;
+    uint64_t m_pacedSamples;
+    std::atomic<uint64_t> m_samplesDelivered;
+    std::atomic<uint64_t> m_blocksDelivered;
+};
+
+#endif // LOOPBACKDEVICE_H
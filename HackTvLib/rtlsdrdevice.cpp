@@ -2,6 +2,7 @@
 #include <iostream>
 #include <sstream>
 #include <chrono>
+#include <algorithm>
 
 RTLSDRDevice::RTLSDRDevice(QObject *parent)
     : QObject(parent)
@@ -75,6 +76,46 @@ int RTLSDRDevice::getDeviceCount()
     return rtlsdr_get_device_count();
 }
 
+std::vector<std::string> RTLSDRDevice::listSerials()
+{
+    const int count = rtlsdr_get_device_count();
+    std::vector<std::string> serials(count);
+    for (int i = 0; i < count; ++i) {
+        char manufacturer[256] = {0};
+        char product[256] = {0};
+        char serial[256] = {0};
+        if (rtlsdr_get_device_usb_strings(i, manufacturer, product, serial) == 0) {
+            serials[i] = serial;
+        }
+    }
+
+    std::vector<std::string> names(count);
+    for (int i = 0; i < count; ++i) {
+        const bool unique = !serials[i].empty() &&
+                            std::count(serials.begin(), serials.end(), serials[i]) == 1;
+        names[i] = unique ? serials[i] : std::to_string(i);
+    }
+    return names;
+}
+
+int RTLSDRDevice::findDevice(const std::string& serialOrIndex)
+{
+    if (serialOrIndex.empty()) {
+        return 0;
+    }
+
+    const std::vector<std::string> names = listSerials();
+    for (size_t i = 0; i < names.size(); ++i) {
+        if (names[i] == serialOrIndex) {
+            return static_cast<int>(i);
+        }
+    }
+
+    // Serial shared by several dongles: the first one
+    int index = rtlsdr_get_index_by_serial(serialOrIndex.c_str());
+    return (index >= 0) ? index : -1;
+}
+
 bool RTLSDRDevice::initialize(uint32_t deviceIndex, uint32_t sampleRate, uint32_t frequency, int gain)
 {
     std::lock_guard<std::mutex> lock(m_deviceMutex);
@@ -232,7 +273,7 @@ bool RTLSDRDevice::start()
 
     // Start reading thread
     m_readThread = std::make_unique<std::thread>([this]() {
-        int result = rtlsdr_read_async(m_device, rtlsdrCallback, this, 0, 0);
+        int result = rtlsdr_read_async(m_device, rtlsdrCallback, this, ASYNC_BUFFERS, 0);
         if (result < 0 && !m_isDestroying.load()) {
             std::cerr << "rtlsdr_read_async failed with error: " << result << std::endl;
             m_isRunning.store(false);
@@ -23,10 +23,19 @@ public:
 
     using DataCallback = std::function<void(const int8_t*, size_t)>;
 
+    // Buffers rtlsdr_read_async keeps queued (librtlsdr's default count)
+    static constexpr uint32_t ASYNC_BUFFERS = 15;
+
     // Device enumeration
     static std::vector<std::string> listDevices();
     static int getDeviceCount();
 
+    // Serial of each device, or its index when it has none or shares it
+    // with another dongle (many ship with 00000001)
+    static std::vector<std::string> listSerials();
+    // Index for a serial or an index from listSerials(); empty: 0, -1: not found
+    static int findDevice(const std::string& serialOrIndex);
+
     // Initialization
     bool initialize(uint32_t deviceIndex = 0,
                     uint32_t sampleRate = DEFAULT_SAMPLE_RATE,
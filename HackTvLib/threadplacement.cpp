@@ -0,0 +1,448 @@
+#include "threadplacement.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <unistd.h>
+#endif
+#ifdef __linux__
+#include <sys/syscall.h>
+#endif
+
+namespace {
+
+const char* const ROLE_NAMES[ThreadPlacement::RoleCount] = { "usb", "tx", "media", "dsp", "audio" };
+
+struct State {
+    std::mutex mutex;
+    ThreadPlacement::Policy policies[ThreadPlacement::RoleCount];
+    std::string outcomes[ThreadPlacement::RoleCount];   // what the last apply() got
+    unsigned threads[ThreadPlacement::RoleCount] = {};
+    bool lockMemory = false;
+    std::string memory;
+};
+
+State& state()
+{
+    static State s;
+    return s;
+}
+
+// Bumped on every policy change, so threads apply again on their next call
+std::atomic<unsigned> g_generation{1};
+thread_local unsigned t_generation = 0;
+thread_local int t_role = -1;
+thread_local bool t_placed = false;    // scheduling or affinity changed on this thread
+
+std::string cpuList(uint64_t mask)
+{
+    std::string out;
+    for (int cpu = 0; cpu < 64; cpu++) {
+        if (!(mask >> cpu & 1)) continue;
+        int last = cpu;
+        while (last + 1 < 64 && (mask >> (last + 1) & 1)) last++;
+        if (!out.empty()) out += ",";
+        out += std::to_string(cpu);
+        if (last > cpu) out += "-" + std::to_string(last);
+        cpu = last;
+    }
+    return out;
+}
+
+bool parseInt(const std::string& text, int lo, int hi, int* value)
+{
+    if (text.empty()) return false;
+    char* end = nullptr;
+    errno = 0;
+    long v = std::strtol(text.c_str(), &end, 10);
+    if (errno || *end || v < lo || v > hi) return false;
+    *value = static_cast<int>(v);
+    return true;
+}
+
+// "0,2-3,6"
+bool parseCpuList(const std::string& text, uint64_t* mask)
+{
+    uint64_t out = 0;
+    size_t pos = 0;
+    while (pos <= text.size()) {
+        size_t comma = text.find(',', pos);
+        if (comma == std::string::npos) comma = text.size();
+        const std::string item = text.substr(pos, comma - pos);
+        const size_t dash = item.find('-');
+        int first = 0, last = 0;
+        if (dash == std::string::npos) {
+            if (!parseInt(item, 0, 63, &first)) return false;
+            last = first;
+        } else if (!parseInt(item.substr(0, dash), 0, 63, &first) ||
+                   !parseInt(item.substr(dash + 1), 0, 63, &last) || last < first) {
+            return false;
+        }
+        for (int cpu = first; cpu <= last; cpu++) out |= uint64_t(1) << cpu;
+        pos = comma + 1;
+    }
+    *mask = out;
+    return out != 0;
+}
+
+std::string describe(const ThreadPlacement::Policy& policy)
+{
+    std::string out;
+    if (policy.fifoPriority > 0) out += "fifo:" + std::to_string(policy.fifoPriority);
+    if (policy.setNice) out += std::string(out.empty() ? "" : "/") + "nice:" + std::to_string(policy.nice);
+    if (policy.cpuMask) out += std::string(out.empty() ? "" : "/") + "cpus:" + cpuList(policy.cpuMask);
+    return out.empty() ? "default" : out;
+}
+
+void append(std::string& out, const std::string& part)
+{
+    if (!out.empty()) out += ", ";
+    out += part;
+}
+
+// The stack a real-time thread will use, faulted in while that is still cheap
+#if defined(__GNUC__)
+__attribute__((noinline))
+#endif
+void prefaultStack()
+{
+    volatile unsigned char stack[64 * 1024];
+    for (size_t i = 0; i < sizeof(stack); i += 4096) stack[i] = 0;
+}
+
+// Back to what a new thread gets: normal scheduling, nice 0, any CPU
+std::string restoreDefaults()
+{
+    std::string out;
+#ifdef _WIN32
+    HANDLE self = GetCurrentThread();
+    if (!SetThreadPriority(self, THREAD_PRIORITY_NORMAL)) append(out, "thread priority reset refused");
+    DWORD_PTR processMask = 0, systemMask = 0;
+    if (!GetProcessAffinityMask(GetCurrentProcess(), &processMask, &systemMask) ||
+        !SetThreadAffinityMask(self, processMask)) {
+        append(out, "CPU reset refused");
+    }
+#else
+    sched_param param{};
+    param.sched_priority = 0;
+    int r = pthread_setschedparam(pthread_self(), SCHED_OTHER, &param);
+    if (r != 0) append(out, std::string("SCHED_OTHER refused (") + std::strerror(r) + ")");
+#ifdef __linux__
+    const int tid = static_cast<int>(syscall(SYS_gettid));
+    if (setpriority(PRIO_PROCESS, tid, 0) != 0) {
+        append(out, std::string("nice 0 refused (") + std::strerror(errno) + ")");
+    }
+    // The kernel drops CPUs outside the cpuset, so all bits means any allowed CPU
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) CPU_SET(cpu, &set);
+    if (sched_setaffinity(0, sizeof(set), &set) != 0) {
+        append(out, std::string("CPU reset refused (") + std::strerror(errno) + ")");
+    }
+#endif
+#endif
+    return out.empty() ? "default (restored)" : "default, " + out;
+}
+
+std::string applyPolicy(const ThreadPlacement::Policy& policy)
+{
+    std::string out;
+#ifdef _WIN32
+    HANDLE self = GetCurrentThread();
+    if (policy.fifoPriority > 0 || policy.setNice) {
+        // No SCHED_FIFO: the nearest thread priority
+        int priority = THREAD_PRIORITY_NORMAL;
+        if (policy.fifoPriority > 0) priority = policy.fifoPriority >= 50 ? THREAD_PRIORITY_TIME_CRITICAL : THREAD_PRIORITY_HIGHEST;
+        else if (policy.nice <= -10) priority = THREAD_PRIORITY_HIGHEST;
+        else if (policy.nice < 0) priority = THREAD_PRIORITY_ABOVE_NORMAL;
+        else if (policy.nice >= 10) priority = THREAD_PRIORITY_LOWEST;
+        else if (policy.nice > 0) priority = THREAD_PRIORITY_BELOW_NORMAL;
+        append(out, SetThreadPriority(self, priority) ? "thread priority " + std::to_string(priority)
+                                                      : std::string("thread priority refused"));
+        if (policy.fifoPriority > 0) prefaultStack();
+    }
+    if (policy.cpuMask) {
+        append(out, SetThreadAffinityMask(self, static_cast<DWORD_PTR>(policy.cpuMask))
+                        ? "CPUs " + cpuList(policy.cpuMask) : "CPUs " + cpuList(policy.cpuMask) + " refused");
+    }
+#else
+    bool realtime = false;
+    if (policy.fifoPriority > 0) {
+        const int priority = std::min(std::max(policy.fifoPriority, sched_get_priority_min(SCHED_FIFO)),
+                                      sched_get_priority_max(SCHED_FIFO));
+        sched_param param{};
+        param.sched_priority = priority;
+        int r = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+#ifdef RLIMIT_RTPRIO
+        // Unprivileged, but allowed up to RLIMIT_RTPRIO (limits.conf rtprio)
+        rlimit limit{};
+        if (r == EPERM && getrlimit(RLIMIT_RTPRIO, &limit) == 0 && limit.rlim_cur != RLIM_INFINITY &&
+            limit.rlim_cur > 0 && static_cast<int>(limit.rlim_cur) < priority) {
+            param.sched_priority = static_cast<int>(limit.rlim_cur);
+            r = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+        }
+#endif
+        if (r == 0) {
+            realtime = true;
+            append(out, "SCHED_FIFO " + std::to_string(param.sched_priority) +
+                            (param.sched_priority < priority ? " (RLIMIT_RTPRIO)" : ""));
+        } else {
+            append(out, "SCHED_FIFO " + std::to_string(priority) + " refused (" + std::strerror(r) + ")");
+        }
+    }
+    if (!realtime && (policy.setNice || policy.fifoPriority > 0)) {
+        // Also the fallback for a refused SCHED_FIFO
+        const int nice = policy.setNice ? policy.nice : -10;
+#ifdef __linux__
+        // Linux nice values are per thread
+        const int tid = static_cast<int>(syscall(SYS_gettid));
+        if (setpriority(PRIO_PROCESS, tid, nice) == 0) {
+            append(out, "nice " + std::to_string(nice));
+        } else {
+            append(out, "nice " + std::to_string(nice) + " refused (" + std::strerror(errno) + "), default priority");
+        }
+#else
+        append(out, "nice " + std::to_string(nice) + " not per thread here, default priority");
+#endif
+    }
+    if (policy.cpuMask) {
+#ifdef __linux__
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        for (int cpu = 0; cpu < 64 && cpu < CPU_SETSIZE; cpu++) {
+            if (policy.cpuMask >> cpu & 1) CPU_SET(cpu, &set);
+        }
+        // 0: the calling thread (bionic has no pthread_setaffinity_np)
+        if (sched_setaffinity(0, sizeof(set), &set) == 0) {
+            append(out, "CPUs " + cpuList(policy.cpuMask));
+        } else {
+            append(out, "CPUs " + cpuList(policy.cpuMask) + " refused (" + std::strerror(errno) + ")");
+        }
+#else
+        append(out, "CPU affinity not supported here");
+#endif
+    }
+    if (realtime) prefaultStack();
+#endif
+    return out.empty() ? "default" : out;
+}
+
+} // namespace
+
+bool ThreadPlacement::parse(const std::string& spec, std::string* error)
+{
+    auto fail = [&](const std::string& why) {
+        if (error) *error = why + " in '" + spec + "'";
+        return false;
+    };
+
+    const size_t eq = spec.find('=');
+    if (eq == std::string::npos) return fail("expected role=settings");
+    const std::string roleName = spec.substr(0, eq);
+    int first = -1;
+    for (int r = 0; r < RoleCount; r++) {
+        if (roleName == ROLE_NAMES[r]) first = r;
+    }
+    const bool all = roleName == "all";
+    if (first < 0 && !all) return fail("unknown role '" + roleName + "'");
+
+    // On top of what the role has; "default" clears it
+    Policy policy = all ? Policy() : ThreadPlacement::policy(static_cast<Role>(first));
+    const std::string settings = spec.substr(eq + 1);
+    size_t pos = 0;
+    while (pos <= settings.size()) {
+        size_t slash = settings.find('/', pos);
+        if (slash == std::string::npos) slash = settings.size();
+        const std::string item = settings.substr(pos, slash - pos);
+        const size_t colon = item.find(':');
+        const std::string key = item.substr(0, colon);
+        const std::string value = colon == std::string::npos ? std::string() : item.substr(colon + 1);
+        if (key == "default" && value.empty()) {
+            policy = Policy();
+        } else if (key == "fifo") {
+            if (!parseInt(value, 1, 99, &policy.fifoPriority)) return fail("fifo wants 1-99");
+        } else if (key == "nice") {
+            if (!parseInt(value, -20, 19, &policy.nice)) return fail("nice wants -20..19");
+            policy.setNice = true;
+        } else if (key == "cpus") {
+            if (!parseCpuList(value, &policy.cpuMask)) return fail("cpus wants a list like 0,2-3");
+        } else {
+            return fail("unknown setting '" + item + "'");
+        }
+        pos = slash + 1;
+    }
+
+    for (int r = 0; r < RoleCount; r++) {
+        if (all || r == first) setPolicy(static_cast<Role>(r), policy);
+    }
+    return true;
+}
+
+const char* ThreadPlacement::usage()
+{
+    return "role=setting[/setting...]; roles usb, tx, media, dsp, audio, all; "
+           "settings fifo:<1-99>, nice:<-20..19>, cpus:<0,2-3>, default";
+}
+
+void ThreadPlacement::setPolicy(Role role, const Policy& policy)
+{
+    if (role < 0 || role >= RoleCount) return;
+    State& s = state();
+    {
+        std::lock_guard<std::mutex> lock(s.mutex);
+        s.policies[role] = policy;
+    }
+    g_generation.fetch_add(1, std::memory_order_release);
+}
+
+ThreadPlacement::Policy ThreadPlacement::policy(Role role)
+{
+    if (role < 0 || role >= RoleCount) return Policy();
+    State& s = state();
+    std::lock_guard<std::mutex> lock(s.mutex);
+    return s.policies[role];
+}
+
+const char* ThreadPlacement::roleName(Role role)
+{
+    return (role >= 0 && role < RoleCount) ? ROLE_NAMES[role] : "?";
+}
+
+void ThreadPlacement::apply(Role role)
+{
+    if (role < 0 || role >= RoleCount) return;
+    const unsigned generation = g_generation.load(std::memory_order_acquire);
+    if (t_generation == generation && t_role == role) return;
+    t_generation = generation;
+    t_role = role;
+
+    // A changed policy replaces the old one instead of adding to it, and
+    // one switched back to default undoes what this thread was given
+    const Policy wanted = policy(role);
+    if (wanted.isDefault() && !t_placed) return;
+
+    std::string outcome;
+    if (t_placed) {
+        outcome = restoreDefaults();
+        t_placed = false;
+    }
+    if (!wanted.isDefault()) {
+        outcome = applyPolicy(wanted);
+        t_placed = true;
+    }
+    bool changed = false;
+    {
+        State& s = state();
+        std::lock_guard<std::mutex> lock(s.mutex);
+        changed = s.outcomes[role] != outcome;
+        s.outcomes[role] = outcome;
+        s.threads[role]++;
+    }
+    // Once per distinct result, not per pool thread
+    if (changed) {
+        fprintf(stderr, "Thread placement: %s thread: %s\n", ROLE_NAMES[role], outcome.c_str());
+        fflush(stderr);
+    }
+}
+
+void ThreadPlacement::setLockMemory(bool enable)
+{
+    State& s = state();
+    std::lock_guard<std::mutex> lock(s.mutex);
+    s.lockMemory = enable;
+}
+
+bool ThreadPlacement::lockMemoryEnabled()
+{
+    State& s = state();
+    std::lock_guard<std::mutex> lock(s.mutex);
+    return s.lockMemory;
+}
+
+bool ThreadPlacement::lockMemory()
+{
+    State& s = state();
+    std::lock_guard<std::mutex> lock(s.mutex);
+    if (!s.lockMemory) return false;
+
+    bool ok = false;
+    std::string memory;
+#ifdef __linux__
+    // MCL_FUTURE under a finite RLIMIT_MEMLOCK would make later mmap()s
+    // fail once the limit is reached; lock what exists only
+    rlimit limit{};
+    const bool haveLimit = getrlimit(RLIMIT_MEMLOCK, &limit) == 0;
+    const bool unlimited = geteuid() == 0 || (haveLimit && limit.rlim_cur == RLIM_INFINITY);
+    const std::string limitText = haveLimit && limit.rlim_cur != RLIM_INFINITY
+                                      ? "RLIMIT_MEMLOCK " + std::to_string(limit.rlim_cur / 1024) + " KB"
+                                      : "RLIMIT_MEMLOCK unlimited";
+    if (mlockall(MCL_CURRENT | (unlimited ? MCL_FUTURE : 0)) == 0) {
+        ok = true;
+        memory = unlimited ? "mlockall current + future"
+                           : "mlockall current only (" + limitText + "), later allocations are not locked";
+    } else {
+        memory = std::string("mlockall refused (") + std::strerror(errno) + ", " + limitText +
+                 "), buffers are only pre-faulted";
+    }
+#else
+    memory = "memory locking not supported here, buffers are only pre-faulted";
+#endif
+    if (memory != s.memory) {
+        fprintf(stderr, "Thread placement: memory: %s\n", memory.c_str());
+        fflush(stderr);
+    }
+    s.memory = memory;
+    return ok;
+}
+
+void ThreadPlacement::prefault(void* buf, size_t len)
+{
+    if (!buf || !len) return;
+    // Read and write back, so buffers that already hold data keep it
+    volatile unsigned char* p = static_cast<volatile unsigned char*>(buf);
+    for (size_t i = 0; i < len; i += 4096) p[i] = p[i];
+    p[len - 1] = p[len - 1];
+}
+
+std::vector<std::string> ThreadPlacement::report()
+{
+    std::vector<std::string> lines;
+    State& s = state();
+    std::lock_guard<std::mutex> lock(s.mutex);
+    for (int r = 0; r < RoleCount; r++) {
+        if (s.policies[r].isDefault()) continue;
+        std::string line = std::string(ROLE_NAMES[r]) + ": " + describe(s.policies[r]) + " -> ";
+        if (s.threads[r] == 0) {
+            line += "no thread yet";
+        } else {
+            line += s.outcomes[r] + " (" + std::to_string(s.threads[r]) + (s.threads[r] == 1 ? " thread)" : " threads)");
+        }
+        lines.push_back(line);
+    }
+    if (s.lockMemory) {
+        lines.push_back("memory: " + (s.memory.empty() ? std::string("mlockall pending") : s.memory));
+    }
+    return lines;
+}
+
+extern "C" void thread_placement_apply(int role)
+{
+    ThreadPlacement::apply(static_cast<ThreadPlacement::Role>(role));
+}
+
+extern "C" void thread_placement_prefault(void *buf, size_t len)
+{
+    ThreadPlacement::prefault(buf, len);
+}
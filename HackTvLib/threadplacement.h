@@ -0,0 +1,104 @@
+#ifndef THREADPLACEMENT_H
+#define THREADPLACEMENT_H
+
+#include <stddef.h>
+
+/* HackTvLib exports it; HackRfRadio compiles its own copy (THREADPLACEMENT_STATIC) */
+#ifdef _WIN32
+#if defined(HACKTVLIB_LIBRARY)
+#define THREADPLACEMENT_EXPORT __declspec(dllexport)
+#elif defined(THREADPLACEMENT_STATIC)
+#define THREADPLACEMENT_EXPORT
+#else
+#define THREADPLACEMENT_EXPORT __declspec(dllimport)
+#endif
+#else
+#define THREADPLACEMENT_EXPORT
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Hot threads, by what they do */
+enum {
+    THREAD_ROLE_USB = 0,    /* libhackrf / librtlsdr transfer callbacks, loopback and file source */
+    THREAD_ROLE_TX,         /* hacktv rfTxLoop */
+    THREAD_ROLE_MEDIA,      /* ffmpeg decode and scaler threads */
+    THREAD_ROLE_DSP,        /* DDC thread, demodulator and FFT workers */
+    THREAD_ROLE_AUDIO,      /* audio sink pulls, when the backend has a thread for them */
+    THREAD_ROLE_COUNT
+};
+
+/* For the hacktv C threads: see ThreadPlacement::apply() and prefault() */
+THREADPLACEMENT_EXPORT void thread_placement_apply(int role);
+THREADPLACEMENT_EXPORT void thread_placement_prefault(void *buf, size_t len);
+
+#ifdef __cplusplus
+}
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Process-wide scheduling, CPU affinity and memory locking for the hot
+// threads. The application sets a policy per role once (command line:
+// --thread usb=fifo:70/cpus:2 ...); every hot thread calls apply() with its
+// role when it starts or on its first callback. The first call on a thread
+// applies the policy, later ones cost a thread_local compare, and a policy
+// change is picked up on the next call. A changed policy replaces the old
+// one; back to default restores normal scheduling, nice 0 and any CPU.
+//
+// Nothing here is fatal. Without the privilege for SCHED_FIFO the priority
+// is lowered to RLIMIT_RTPRIO, then the thread falls back to the policy's
+// nice level, then to the default. mlockall() locks future mappings only
+// when RLIMIT_MEMLOCK allows it, so a later allocation cannot fail for it.
+// report() says what each role actually got.
+class THREADPLACEMENT_EXPORT ThreadPlacement
+{
+public:
+    enum Role {
+        Usb = THREAD_ROLE_USB,
+        Tx = THREAD_ROLE_TX,
+        Media = THREAD_ROLE_MEDIA,
+        Dsp = THREAD_ROLE_DSP,
+        Audio = THREAD_ROLE_AUDIO,
+        RoleCount = THREAD_ROLE_COUNT
+    };
+
+    struct Policy {
+        int fifoPriority = 0;       // SCHED_FIFO 1-99, 0: normal scheduling
+        bool setNice = false;
+        int nice = 0;               // -20..19; also the fallback when FIFO is refused
+        uint64_t cpuMask = 0;       // bit n: CPU n, 0: any CPU
+
+        bool isDefault() const { return fifoPriority == 0 && !setNice && cpuMask == 0; }
+    };
+
+    // "role=setting/setting", role usb, tx, media, dsp, audio or all;
+    // settings fifo:<1-99>, nice:<-20..19>, cpus:<list like 0,2-3> or default
+    static bool parse(const std::string& spec, std::string* error = nullptr);
+    static const char* usage();
+
+    static void setPolicy(Role role, const Policy& policy);
+    static Policy policy(Role role);
+    static const char* roleName(Role role);
+
+    // Calling thread; cheap after the first call
+    static void apply(Role role);
+
+    // mlockall() when enabled; call again once the big buffers exist
+    static void setLockMemory(bool enable);
+    static bool lockMemoryEnabled();
+    static bool lockMemory();
+
+    // Writes every page of buf, so a real-time thread does not fault on it
+    static void prefault(void* buf, size_t len);
+
+    // One line per configured role and for memory locking
+    static std::vector<std::string> report();
+};
+
+#endif // __cplusplus
+
+#endif // THREADPLACEMENT_H
@@ -0,0 +1,39 @@
+QT = core network
+CONFIG += c++17 cmdline
+
+# Loopback throughput / CPU benchmark for the HackRfTcp data port.
+# Builds the streamer sources directly; no HackRF or HackTvLib needed.
+TCP_DIR = $$absolute_path($$PWD/../HackRfTcp)
+INCLUDEPATH += $$TCP_DIR
+
+# Latency histograms and thread placement, shared with HackTvLib
+LIB_DIR = $$absolute_path($$PWD/../HackTvLib)
+INCLUDEPATH += $$LIB_DIR
+DEFINES += THREADPLACEMENT_STATIC
+
+SOURCES += \
+        main.cpp \
+        $$TCP_DIR/iqstreamer.cpp \
+        $$TCP_DIR/ddcchannel.cpp \
+        $$TCP_DIR/iqcodec.cpp \
+        $$TCP_DIR/spectrumanalyzer.cpp \
+        $$LIB_DIR/ddcchain.cpp \
+        $$LIB_DIR/threadplacement.cpp
+
+HEADERS += \
+    $$TCP_DIR/iqstreamer.h \
+    $$TCP_DIR/ddcchannel.h \
+    $$TCP_DIR/iqcodec.h \
+    $$TCP_DIR/spectrumanalyzer.h \
+    $$LIB_DIR/ddcchain.h \
+    $$LIB_DIR/threadplacement.h
+
+unix:!macx: LIBS += -lpthread
+
+TARGET = IqStreamBench
+TEMPLATE = app
+
+# Default rules for deployment.
+qnx: target.path = /tmp/$${TARGET}/bin
+else: unix:!android: target.path = /opt/$${TARGET}/bin
+!isEmpty(target.path): INSTALLS += target
@@ -0,0 +1,420 @@
+// IqStreamBench - loopback benchmark for the HackRfTcp data port
+//
+// Runs IqStreamer exactly as HackRfTcp does (network thread, per-client
+// backlogs) and feeds it synthetic int8 IQ in HackRF-sized blocks at a
+// given sample rate. N clients on 127.0.0.1 read as fast as they can.
+// Reports what every client received, drops, and the CPU spent on the
+// network thread, so the QTcpSocket, sendmsg() and MSG_ZEROCOPY paths
+// can be compared on the same machine:
+//   IqStreamBench --clients 4 --rate 20000000 --qt-sockets
+//   IqStreamBench --clients 4 --rate 20000000
+//   IqStreamBench --clients 4 --rate 20000000 --zerocopy
+//   IqStreamBench --clients 4 --rate 20000000 --encoding bfp4
+//
+// --codecs benchmarks the transport encodings alone (ratio, encode and
+// decode MB/s on one core and across the pool) and exits.
+
+#include "iqstreamer.h"
+#include "iqcodec.h"
+
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QTcpSocket>
+#include <QThread>
+#include <QThreadPool>
+#include <QDebug>
+#include <cstdio>
+#include <vector>
+#include <atomic>
+#include <memory>
+#include <chrono>
+#include <thread>
+#include <random>
+#include <cmath>
+
+#ifdef Q_OS_LINUX
+#include <pthread.h>
+#include <time.h>
+#endif
+
+// ============================================================
+// CPU time (Linux: per thread, so the clients do not count)
+// ============================================================
+
+#ifdef Q_OS_LINUX
+static double threadCpuSeconds(pthread_t thread)
+{
+    clockid_t clock;
+    timespec ts;
+    if (pthread_getcpuclockid(thread, &clock) != 0 || clock_gettime(clock, &ts) != 0)
+        return 0.0;
+    return ts.tv_sec + ts.tv_nsec / 1.0e9;
+}
+
+static double processCpuSeconds()
+{
+    timespec ts;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1.0e9;
+}
+#endif
+
+// ============================================================
+// Loopback client
+// ============================================================
+
+struct BenchClient {
+    std::atomic<quint64> bytes{0};
+    std::atomic<bool> connected{false};
+    std::atomic<bool> failed{false};
+};
+
+static void runClient(BenchClient* state, quint16 port, const std::atomic<bool>* stop)
+{
+    QTcpSocket socket;
+    socket.connectToHost(QHostAddress::LocalHost, port);
+    if (!socket.waitForConnected(3000)) {
+        state->failed = true;
+        return;
+    }
+    state->connected = true;
+
+    std::vector<char> buf(1024 * 1024);
+    while (!stop->load()) {
+        if (!socket.waitForReadyRead(200)) {
+            if (socket.state() != QAbstractSocket::ConnectedState) break;
+            continue;
+        }
+        qint64 n;
+        while ((n = socket.read(buf.data(), static_cast<qint64>(buf.size()))) > 0) {
+            state->bytes.fetch_add(static_cast<quint64>(n), std::memory_order_relaxed);
+        }
+    }
+    socket.abort();
+}
+
+// ============================================================
+// Codec benchmark
+// ============================================================
+
+// Noise at 'rms' LSB plus a few carriers, clipped like the HackRF ADC
+static std::vector<QByteArray> makeSignal(int blocks, int blockBytes, double rms)
+{
+    std::mt19937 rng(1234);
+    std::normal_distribution<double> noise(0.0, rms);
+    const double tones[] = { 0.013, -0.071, 0.22 };
+    std::vector<QByteArray> signal;
+    quint64 n = 0;
+    for (int b = 0; b < blocks; b++) {
+        QByteArray block(blockBytes, Qt::Uninitialized);
+        for (int i = 0; i < blockBytes; i += 2, n++) {
+            double re = noise(rng), im = noise(rng);
+            for (double f : tones) {
+                re += rms * std::cos(2.0 * M_PI * f * n);
+                im += rms * std::sin(2.0 * M_PI * f * n);
+            }
+            block[i] = static_cast<char>(std::clamp(std::lround(re), -128L, 127L));
+            block[i + 1] = static_cast<char>(std::clamp(std::lround(im), -128L, 127L));
+        }
+        signal.push_back(block);
+    }
+    return signal;
+}
+
+static int runCodecBench(int blocks, int blockBytes, double rms)
+{
+    const std::vector<QByteArray> signal = makeSignal(blocks, blockBytes, rms);
+    const double totalMB = static_cast<double>(blocks) * blockBytes / 1.0e6;
+    const int threads = QThreadPool::globalInstance()->maxThreadCount();
+
+    printf("========================================\n");
+    printf("IqStreamBench codecs: %d blocks of %d bytes, noise %.1f LSB rms, %d pool threads\n",
+           blocks, blockBytes, rms, threads);
+    printf("  %-8s %7s %12s %12s %12s %8s\n", "encoding", "ratio", "enc MB/s", "enc pool", "dec MB/s", "SNR dB");
+
+    int failures = 0;
+    for (int e = IqCodec::Raw; e <= IqCodec::Deflate; e++) {
+        const IqCodec::Encoding encoding = static_cast<IqCodec::Encoding>(e);
+        IqCodec::BlockInfo info;
+        info.sampleRate = 20000000;
+
+        // One core
+        std::vector<QByteArray> frames(signal.size());
+        QElapsedTimer timer;
+        timer.start();
+        for (size_t i = 0; i < signal.size(); i++) frames[i] = IqCodec::encodeFrame(encoding, signal[i], info);
+        const double encSec = timer.nsecsElapsed() / 1.0e9;
+
+        // All cores, one block per task as in IqStreamer
+        timer.start();
+        for (size_t i = 0; i < signal.size(); i++) {
+            QThreadPool::globalInstance()->start([&signal, encoding, info, i]() {
+                QByteArray frame = IqCodec::encodeFrame(encoding, signal[i], info);
+                Q_UNUSED(frame);
+            });
+        }
+        QThreadPool::globalInstance()->waitForDone();
+        const double poolSec = timer.nsecsElapsed() / 1.0e9;
+
+        // Decode as TcpClient does, and compare
+        quint64 encodedBytes = 0;
+        double signalPower = 0.0, errorPower = 0.0;
+        double decSec = 0.0;
+        for (size_t i = 0; i < frames.size(); i++) {
+            encodedBytes += frames[i].size();
+            IqCodec::FrameHeader header;
+            QByteArray out;
+            timer.start();
+            bool ok = IqCodec::parseHeader(frames[i].constData(), &header) &&
+                      IqCodec::decodeFrame(header, frames[i].constData() + header.headerBytes, out);
+            decSec += timer.nsecsElapsed() / 1.0e9;
+            if (!ok || out.size() != signal[i].size()) {
+                failures++;
+                continue;
+            }
+            for (int k = 0; k < out.size(); k++) {
+                double s = signal[i][k];
+                double d = out[k] - s;
+                signalPower += s * s;
+                errorPower += d * d;
+            }
+        }
+        if (encoding != IqCodec::Bfp4 && errorPower > 0.0) failures++;
+
+        QString snr = errorPower > 0.0 ? QString::number(10.0 * std::log10(signalPower / errorPower), 'f', 1)
+                                       : QString("exact");
+        printf("  %-8s %7.2f %12.0f %12.0f %12.0f %8s\n",
+               qPrintable(IqCodec::encodingName(encoding)),
+               static_cast<double>(blocks) * blockBytes / encodedBytes,
+               totalMB / encSec, totalMB / poolSec, totalMB / decSec, qPrintable(snr));
+    }
+    printf("========================================\n");
+    fflush(stdout);
+
+    if (failures) {
+        fprintf(stderr, "FAIL: %d blocks did not decode correctly\n", failures);
+        return 2;
+    }
+    return 0;
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("IqStreamBench");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Loopback throughput and CPU benchmark for the HackRfTcp data port");
+    parser.addHelpOption();
+
+    QCommandLineOption clientsOpt({"n", "clients"}, "Number of loopback clients", "count", "4");
+    QCommandLineOption rateOpt({"s", "rate"}, "Sample rate in S/s (2 bytes per sample)", "rate", "20000000");
+    QCommandLineOption secondsOpt({"t", "seconds"}, "Measurement time", "seconds", "10");
+    QCommandLineOption blockOpt("block", "Block size in bytes (HackRF transfer: 262144)", "bytes", "262144");
+    QCommandLineOption portOpt("port", "Data port on 127.0.0.1", "port", "15000");
+    QCommandLineOption unthrottledOpt("unthrottled", "Push blocks as fast as possible");
+    QCommandLineOption backlogOpt("backlog", "Per-client backlog in blocks", "blocks", "16");
+    QCommandLineOption policyOpt("drop-policy", "drop-oldest, drop-newest or disconnect", "policy", "drop-oldest");
+    QCommandLineOption sendBufferOpt("send-buffer", "SO_SNDBUF in KB", "KB", "1024");
+    QCommandLineOption zeroCopyOpt("zerocopy", "Linux: MSG_ZEROCOPY");
+    QCommandLineOption corkOpt("tcp-cork", "Linux: TCP_CORK each batch instead of TCP_NODELAY");
+    QCommandLineOption qtSocketsOpt("qt-sockets", "Send through QTcpSocket instead of sendmsg()");
+    QCommandLineOption encodingOpt("encoding", "Clients ask for raw, bfp4 or deflate frames", "encoding");
+    QCommandLineOption codecsOpt("codecs", "Benchmark the encodings only (ratio, MB/s) and exit");
+    QCommandLineOption codecBlocksOpt("codec-blocks", "Blocks for --codecs", "blocks", "128");
+    QCommandLineOption noiseOpt("noise", "Test signal noise in LSB rms for --codecs", "lsb", "12");
+    QCommandLineOption minRateOpt("min-rate", "Fail (exit 2) if a client gets less than this share of the input rate", "fraction");
+    for (const auto* opt : {&clientsOpt, &rateOpt, &secondsOpt, &blockOpt, &portOpt, &unthrottledOpt,
+                            &backlogOpt, &policyOpt, &sendBufferOpt, &zeroCopyOpt, &corkOpt,
+                            &qtSocketsOpt, &encodingOpt, &codecsOpt, &codecBlocksOpt, &noiseOpt, &minRateOpt})
+        parser.addOption(*opt);
+    parser.process(app);
+
+    const int numClients = std::max(1, parser.value(clientsOpt).toInt());
+    const double sampleRate = parser.value(rateOpt).toDouble();
+    const double seconds = parser.value(secondsOpt).toDouble();
+    const int blockBytes = std::max(2, parser.value(blockOpt).toInt()) & ~1;
+    const quint16 port = parser.value(portOpt).toUShort();
+    const bool unthrottled = parser.isSet(unthrottledOpt);
+
+    if (parser.isSet(codecsOpt)) {
+        return runCodecBench(std::max(1, parser.value(codecBlocksOpt).toInt()), blockBytes,
+                             parser.value(noiseOpt).toDouble());
+    }
+
+    IqCodec::Encoding encoding = IqCodec::Raw;
+    if (parser.isSet(encodingOpt) && !IqCodec::parseEncoding(parser.value(encodingOpt), &encoding)) {
+        fprintf(stderr, "Invalid encoding: %s\n", qPrintable(parser.value(encodingOpt)));
+        return 1;
+    }
+
+    IqStreamer::DropPolicy policy;
+    if (!IqStreamer::parsePolicy(parser.value(policyOpt), &policy)) {
+        fprintf(stderr, "Invalid drop policy: %s\n", qPrintable(parser.value(policyOpt)));
+        return 1;
+    }
+
+    IqStreamer::SendOptions options;
+    options.direct = !parser.isSet(qtSocketsOpt);
+    options.zeroCopy = parser.isSet(zeroCopyOpt);
+    options.cork = parser.isSet(corkOpt);
+    options.noDelay = !options.cork;
+    options.sendBuffer = parser.value(sendBufferOpt).toInt() * 1024;
+
+    // Same threading as SdrDevice
+    QThread netThread;
+    IqStreamer* streamer = new IqStreamer;
+    streamer->moveToThread(&netThread);
+    QObject::connect(&netThread, &QThread::finished, streamer, &QObject::deleteLater);
+    netThread.start();
+
+    streamer->setDefaultPolicy(policy, parser.value(backlogOpt).toInt());
+    streamer->setSendOptions(options);
+
+    QString error;
+    if (!streamer->listen(port, &error)) {
+        fprintf(stderr, "Cannot listen on port %u: %s\n", port, qPrintable(error));
+        netThread.quit();
+        netThread.wait();
+        return 1;
+    }
+
+#ifdef Q_OS_LINUX
+    pthread_t netThreadId;
+    QMetaObject::invokeMethod(streamer, [&netThreadId]() { netThreadId = pthread_self(); },
+                              Qt::BlockingQueuedConnection);
+#endif
+
+    // ============================================================
+    // Clients
+    // ============================================================
+    std::atomic<bool> stop{false};
+    std::vector<std::unique_ptr<BenchClient>> clients;
+    std::vector<QThread*> clientThreads;
+    for (int i = 0; i < numClients; i++) {
+        clients.push_back(std::make_unique<BenchClient>());
+        BenchClient* state = clients.back().get();
+        QThread* thread = QThread::create(runClient, state, port, &stop);
+        thread->start();
+        clientThreads.push_back(thread);
+    }
+
+    QElapsedTimer connectTimer;
+    connectTimer.start();
+    while (streamer->clientCount() < numClients && connectTimer.elapsed() < 5000)
+        QThread::msleep(10);
+    if (streamer->clientCount() < numClients) {
+        fprintf(stderr, "Only %d of %d clients connected\n", streamer->clientCount(), numClients);
+        stop = true;
+        for (QThread* thread : clientThreads) { thread->wait(); delete thread; }
+        netThread.quit();
+        netThread.wait();
+        return 1;
+    }
+
+    if (parser.isSet(encodingOpt)) {
+        QList<quint64> ids;
+        for (const IqStreamer::ClientRef& ref : streamer->findClients(QHostAddress::LocalHost, 0))
+            ids.append(ref.id);
+        streamer->setEncoding(ids, encoding);
+    }
+
+    // ============================================================
+    // Producer (stands in for the RX callback thread)
+    // ============================================================
+    std::vector<int8_t> block(blockBytes);
+    for (int i = 0; i < blockBytes; i++)
+        block[i] = static_cast<int8_t>((i * 37) & 0xff);
+
+    const double blockSeconds = (blockBytes / 2) / sampleRate;
+    std::vector<quint64> startBytes;
+    for (const auto& c : clients) startBytes.push_back(c->bytes.load());
+
+#ifdef Q_OS_LINUX
+    const double netCpuStart = threadCpuSeconds(netThreadId);
+    const double procCpuStart = processCpuSeconds();
+#endif
+
+    QElapsedTimer wall;
+    wall.start();
+    auto next = std::chrono::steady_clock::now();
+    quint64 blocksPushed = 0;
+    while (wall.nsecsElapsed() < static_cast<qint64>(seconds * 1.0e9)) {
+        IqCodec::BlockInfo info;
+        info.sequence = static_cast<uint32_t>(blocksPushed);
+        info.sampleIndex = blocksPushed * (blockBytes / 2);
+        info.sampleRate = static_cast<uint32_t>(sampleRate);
+        streamer->pushBlock(block.data(), block.size(), info);
+        blocksPushed++;
+        if (!unthrottled) {
+            next += std::chrono::nanoseconds(static_cast<qint64>(blockSeconds * 1.0e9));
+            std::this_thread::sleep_until(next);
+        }
+    }
+    const double wallSec = wall.nsecsElapsed() / 1.0e9;
+
+#ifdef Q_OS_LINUX
+    const double netCpu = threadCpuSeconds(netThreadId) - netCpuStart;
+    const double procCpu = processCpuSeconds() - procCpuStart;
+#endif
+
+    // Let in-flight data land before reading the counters
+    QThread::msleep(200);
+    std::vector<quint64> received;
+    for (size_t i = 0; i < clients.size(); i++)
+        received.push_back(clients[i]->bytes.load() - startBytes[i]);
+    const QString status = streamer->statusText();
+    const quint64 dropped = streamer->droppedBlocks();
+    const quint64 overruns = streamer->inputOverruns();
+
+    stop = true;
+    for (QThread* thread : clientThreads) { thread->wait(); delete thread; }
+    streamer->close();
+    netThread.quit();
+    netThread.wait();
+
+    // ============================================================
+    // Report
+    // ============================================================
+    const double inputMBps = blocksPushed * static_cast<double>(blockBytes) / wallSec / 1.0e6;
+    double minShare = 1.0;
+    quint64 totalBytes = 0;
+
+    printf("========================================\n");
+    printf("IqStreamBench report\n");
+    printf("  Path:         %s%s%s, SO_SNDBUF %d KB%s\n",
+           options.direct ? "sendmsg" : "QTcpSocket",
+           options.zeroCopy ? " + MSG_ZEROCOPY" : "", options.cork ? " + TCP_CORK" : "",
+           options.sendBuffer / 1024,
+           parser.isSet(encodingOpt) ? qPrintable(", " + IqCodec::encodingName(encoding) + " frames (client rates are wire bytes)")
+                                     : "");
+    printf("  Input:        %llu blocks of %d bytes, %.1f MB/s (%.2f MS/s) for %.2f s\n",
+           (unsigned long long)blocksPushed, blockBytes, inputMBps, inputMBps / 2.0, wallSec);
+    for (size_t i = 0; i < received.size(); i++) {
+        const double mbps = received[i] / wallSec / 1.0e6;
+        const double share = inputMBps > 0 ? mbps / inputMBps : 0.0;
+        minShare = std::min(minShare, share);
+        totalBytes += received[i];
+        printf("  Client %-2zu     %8.1f MB/s (%5.1f %%)%s\n", i, mbps, share * 100.0,
+               clients[i]->failed ? " - failed" : "");
+    }
+    printf("  Total out:    %.1f MB/s\n", totalBytes / wallSec / 1.0e6);
+    printf("  Dropped:      %llu blocks, %llu input overruns\n",
+           (unsigned long long)dropped, (unsigned long long)overruns);
+#ifdef Q_OS_LINUX
+    printf("  CPU:          network thread %.1f %%, process %.1f %% (clients included)\n",
+           100.0 * netCpu / wallSec, 100.0 * procCpu / wallSec);
+    printf("  Net thread:   %.2f ns/byte sent\n", totalBytes ? netCpu * 1.0e9 / totalBytes : 0.0);
+#endif
+    printf("  Streamer:     %s\n", qPrintable(status));
+    printf("========================================\n");
+    fflush(stdout);
+
+    if (parser.isSet(minRateOpt) && minShare < parser.value(minRateOpt).toDouble()) {
+        fprintf(stderr, "FAIL: slowest client got %.1f %% of the input < %s\n",
+                minShare * 100.0, qPrintable(parser.value(minRateOpt)));
+        return 2;
+    }
+    return 0;
+}
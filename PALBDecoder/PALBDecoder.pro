@@ -41,6 +41,8 @@ linux {
 SOURCES += \
     audiodemodulator.cpp \
     audiooutput.cpp \
+    audioring.cpp \
+    polyphaseresampler.cpp \
     main.cpp \
     MainWindow.cpp \
     PALDecoder.cpp
@@ -50,7 +52,9 @@ HEADERS += \
     MainWindow.h \
     PALDecoder.h \
     audiodemodulator.h \
-    audiooutput.h
+    audiooutput.h \
+    audioring.h \
+    polyphaseresampler.h
 
 # Default rules for deployment.
 qnx: target.path = /tmp/$${TARGET}/bin
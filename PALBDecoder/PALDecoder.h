@@ -38,6 +38,14 @@ public:
     bool getColorMode() const { return m_colorMode; }
     float getChromaGain() const { return m_chromaGain; }
 
+    // Statistics (read between processSamples() calls, e.g. by PALBench)
+    uint64_t getTotalSamples() const { return m_totalSamples; }
+    uint64_t getFrameCount() const { return m_frameCount; }
+    uint64_t getLinesProcessed() const { return m_linesProcessed; }
+    uint64_t getSyncDetected() const { return m_syncDetected; }
+    bool isSyncLocked() const { return m_syncLocked; }
+    float getSyncQuality() const { return m_lastSyncQuality; }
+
 signals:
     void frameReady(const QImage& frame);
     void syncStatsUpdated(float syncRate, float peakLevel, float minLevel);
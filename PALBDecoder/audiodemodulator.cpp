@@ -60,7 +60,7 @@ void AudioDemodulator::initFinalFilter()
 //
 // Strategy: greedily pick the largest safe integer factor at each stage.
 // "Safe" means the anti-alias filter cutoff is well within Nyquist.
-// After all integer stages, do a final linear-interpolation resample to 48 kHz.
+// After all integer stages, a polyphase resampler takes it to exactly 48 kHz.
 //
 // Known good chains:
 //   16 MHz: /5 -> 3.2M, /10 -> 320k, /2 -> 160k, /3 -> 53.3k, resample -> 48k
@@ -146,7 +146,11 @@ void AudioDemodulator::rebuildDecimationChain()
                  << "(" << s.filterTaps.size() << "taps)";
         rate = s.outputRate;
     }
-    qDebug() << "  Final resample:" << rate / 1e3 << "kHz -> 48 kHz";
+    // Always restart the resampler: a new chain means a discontinuous input
+    m_resampler.setRates(rate, AUDIO_SAMP_RATE);
+    m_resampler.reset();
+    qDebug() << "  Final resample:" << rate / 1e3 << "kHz -> 48 kHz"
+             << "(" << m_resampler.taps() << "taps x" << PolyphaseResampler::PHASES << "phases)";
 
     emit audioCapabilityChanged(true, m_inputSampleRate, m_currentCarrierFreq);
 }
@@ -351,37 +355,6 @@ std::vector<float> AudioDemodulator::decimate(
     return decimated;
 }
 
-// Simple linear interpolation resampler
-std::vector<float> AudioDemodulator::resample(
-    const std::vector<float>& signal,
-    double inputRate,
-    double outputRate)
-{
-    if (signal.empty() || inputRate <= 0 || outputRate <= 0) {
-        return signal;
-    }
-
-    double ratio = inputRate / outputRate;
-    size_t outputSize = static_cast<size_t>(signal.size() / ratio);
-    std::vector<float> resampled;
-    resampled.reserve(outputSize);
-
-    for (size_t i = 0; i < outputSize; i++) {
-        double srcPos = i * ratio;
-        size_t idx = static_cast<size_t>(srcPos);
-
-        if (idx + 1 < signal.size()) {
-            double frac = srcPos - idx;
-            float interpolated = signal[idx] * (1.0 - frac) + signal[idx + 1] * frac;
-            resampled.push_back(interpolated);
-        } else if (idx < signal.size()) {
-            resampled.push_back(signal[idx]);
-        }
-    }
-
-    return resampled;
-}
-
 void AudioDemodulator::emitAudioBuffer(const std::vector<float>& audio)
 {
     if (audio.empty()) {
@@ -498,7 +471,7 @@ void AudioDemodulator::processSamples(const std::vector<std::complex<float>>& sa
 
         // 5. Final resample to exactly 48 kHz
         if (std::abs(currentRate - 48000.0) > 1.0) {
-            audio = resample(audio, currentRate, 48000.0);
+            audio = m_resampler.process(audio);
         }
 
         // 6. Final audio bandwidth filter at 15 kHz
@@ -558,7 +531,7 @@ std::vector<float> AudioDemodulator::demodulateAudio(
     }
 
     if (std::abs(currentRate - 48000.0) > 1.0) {
-        audio = resample(audio, currentRate, 48000.0);
+        audio = m_resampler.process(audio);
     }
 
     audio = applyFIRFilter(audio, m_audioFilterTaps);
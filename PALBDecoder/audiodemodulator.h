@@ -8,6 +8,7 @@
 #include <deque>
 #include <cstdint>
 #include <cmath>
+#include "polyphaseresampler.h"
 
 class AudioDemodulator : public QObject
 {
@@ -118,10 +119,8 @@ private:
     // Decimation
     std::vector<float> decimate(const std::vector<float>& signal, int factor);
 
-    // Resampling (for non-integer decimation)
-    std::vector<float> resample(const std::vector<float>& signal,
-                                double inputRate,
-                                double outputRate);
+    // Final stage to 48 kHz (set up by rebuildDecimationChain)
+    PolyphaseResampler m_resampler;
 
     // Output processing
     void emitAudioBuffer(const std::vector<float>& audio);
@@ -5,34 +5,16 @@
 
 AudioOutput::AudioOutput(QObject *parent)
     : QObject(parent)
+    , m_ring(CHANNEL_COUNT, RING_FRAMES)
+    , m_device(&m_ring, SAMPLE_RATE)
 {
-    // Pre-allocate circular buffer
-    audioBuffer.resize(RESERVE_SIZE);
-    outputBuffer.resize(CHUNK_SIZE * 2 * sizeof(qint16));
-
+    m_device.setTargetLatency(TARGET_MS);
     initializeAudio();
-
-    moveToThread(&audioWriterThread);
-    connect(&audioWriterThread, &QThread::started, this, &AudioOutput::audioWriterLoop);
-    audioWriterThread.start();
 }
 
 AudioOutput::~AudioOutput()
 {
-    m_running = false;
-    queueNotEmpty.wakeAll();
-    audioWriterThread.quit();
-    audioWriterThread.wait();
-
-    if (audioDevice) {
-        audioDevice->close();
-        audioDevice = nullptr;
-    }
-
-    if (m_audioOutput) {
-        m_audioOutput->stop();
-        m_audioOutput.reset();
-    }
+    stop();
 }
 
 bool AudioOutput::initializeAudio()
@@ -46,11 +28,9 @@ bool AudioOutput::initializeAudio()
 
         m_format = defaultDevice.preferredFormat();
         m_format.setSampleRate(SAMPLE_RATE);
-        m_format.setChannelCount(CHANNEL_COUNT);
+        m_format.setChannelCount(2);
         m_format.setSampleFormat(QAudioFormat::Int16);
 
-        m_inputFormat = m_format;
-
         if (!defaultDevice.isFormatSupported(m_format)) {
             qCritical() << "Audio format not supported!";
             return false;
@@ -59,27 +39,27 @@ bool AudioOutput::initializeAudio()
         m_audioOutput.reset(new QAudioSink(defaultDevice, m_format));
         if (!m_audioOutput) return false;
 
-        // Larger buffer for stability
-        m_audioOutput->setBufferSize(4 * 1024 * 1024);  // 4 MB
+        // Small device buffer: the jitter margin lives in the ring
+        m_audioOutput->setBufferSize(SAMPLE_RATE * AudioRingDevice::SINK_BUFFER_MS / 1000 * 2 * sizeof(qint16));
 
         connect(m_audioOutput.get(), &QAudioSink::stateChanged,
                 this, &AudioOutput::handleAudioOutputStateChanged);
 
-        audioDevice = m_audioOutput->start();
+        m_ring.reset();
+        m_device.open(QIODevice::ReadOnly);
+        m_audioOutput->start(&m_device);
 
-        if (!audioDevice || !audioDevice->isOpen()) {
+        if (m_audioOutput->error() != QAudio::NoError) {
             qCritical() << "Failed to start audio device";
+            m_device.close();
             return false;
         }
+        m_running = true;
 
         qDebug() << "Audio initialized:";
-        qDebug() << "  Format: 48kHz, 2ch, Int16";
+        qDebug() << "  Format: 48kHz, 2ch, Int16 (mono input on both sides), pull mode";
         qDebug() << "  Buffer:" << m_audioOutput->bufferSize() / 1024 << "KB";
-        qDebug() << "  Chunk size:" << CHUNK_SIZE << "samples ("
-                 << (CHUNK_SIZE * 1000 / SAMPLE_RATE) << "ms)";
-        qDebug() << "  Priming:" << MIN_BUFFER_SAMPLES << "samples ("
-                 << (MIN_BUFFER_SAMPLES * 1000 / SAMPLE_RATE) << "ms)";
-
+        qDebug() << "  Target latency:" << m_device.targetLatencyMs() << "ms";
         return true;
 
     } catch (const std::exception& e) {
@@ -119,186 +99,43 @@ void AudioOutput::setVolume(int value)
     }
 }
 
-void AudioOutput::enqueueAudio(const std::vector<float>& samples)
+void AudioOutput::enqueueAudio(const float* samples, size_t count)
 {
-    if (samples.empty()) return;
-
-    QMutexLocker locker(&mutex);
-
-    size_t samplesToAdd = samples.size();
-
-    // Check overflow - drop oldest samples if buffer full
-    if (bufferSize + samplesToAdd > MAX_QUEUE_SIZE) {
-        size_t overflow = (bufferSize + samplesToAdd) - MAX_QUEUE_SIZE;
-        readPos = (readPos + overflow) % RESERVE_SIZE;
-        bufferSize -= overflow;
-
-        static int dropCount = 0;
-        if (++dropCount % 100 == 0) {
-            qWarning() << "Audio buffer overflow! Dropped" << overflow << "samples";
-        }
-    }
-
-    // Fast batch copy - handle wraparound
-    size_t firstChunk = std::min(samplesToAdd, RESERVE_SIZE - writePos);
-    std::copy(samples.begin(), samples.begin() + firstChunk,
-              audioBuffer.begin() + writePos);
-
-    if (samplesToAdd > firstChunk) {
-        // Wrap around
-        size_t secondChunk = samplesToAdd - firstChunk;
-        std::copy(samples.begin() + firstChunk, samples.end(),
-                  audioBuffer.begin());
-        writePos = secondChunk;
-    } else {
-        writePos = (writePos + firstChunk) % RESERVE_SIZE;
-    }
-
-    bufferSize += samplesToAdd;
+    if (!m_running || count < static_cast<size_t>(CHANNEL_COUNT)) return;
 
-    // Wake up writer thread
-    if (bufferSize >= MIN_BUFFER_SAMPLES) {
-        queueNotEmpty.wakeOne();
-    }
+    // Full ring: the newest audio goes, counted with the trims
+    const size_t lost = m_ring.write(samples, count / CHANNEL_COUNT);
+    if (lost > 0) m_device.countOverrun(lost);
 }
 
-void AudioOutput::audioWriterLoop()
-{
-    bool bufferPrimed = false;
-    std::vector<float> chunk;
-    chunk.reserve(CHUNK_SIZE);
-
-    int consecutiveUnderruns = 0;
-
-    while (m_running) {
-        chunk.clear();
-
-        {
-            QMutexLocker locker(&mutex);
-
-            // Initial buffer priming - wait for sufficient data
-            if (!bufferPrimed) {
-                if (bufferSize < MIN_BUFFER_SAMPLES) {
-                    queueNotEmpty.wait(&mutex, 2000);  // 2000ms wait - daha uzun bekle
-                    continue;
-                }
-                bufferPrimed = true;
-                consecutiveUnderruns = 0;
-                qDebug() << "Audio buffer primed with" << bufferSize << "samples ("
-                         << (bufferSize * 1000.0 / SAMPLE_RATE) << "ms)";
-            }
-
-            // Check for underrun
-            if (bufferSize < CHUNK_SIZE) {
-                consecutiveUnderruns++;
-
-                // If too many consecutive underruns, re-prime the buffer
-                if (consecutiveUnderruns > 5) {  // 10→5
-                    bufferPrimed = false;
-                    qWarning() << "Too many underruns, re-priming buffer...";
-                    queueNotEmpty.wait(&mutex, 1000);  // 500ms→1000ms
-                    continue;
-                }
-
-                queueNotEmpty.wait(&mutex, 100);
-                continue;
-            }
-
-            // Reset underrun counter on successful read
-            if (consecutiveUnderruns > 0) {
-                consecutiveUnderruns = 0;
-            }
-
-            // Fast batch read from circular buffer
-            size_t firstChunk = std::min<size_t>(CHUNK_SIZE, RESERVE_SIZE - readPos);
-            chunk.insert(chunk.end(),
-                         audioBuffer.begin() + readPos,
-                         audioBuffer.begin() + readPos + firstChunk);
-
-            if (CHUNK_SIZE > firstChunk) {
-                // Wrap around
-                size_t secondChunk = CHUNK_SIZE - firstChunk;
-                chunk.insert(chunk.end(),
-                             audioBuffer.begin(),
-                             audioBuffer.begin() + secondChunk);
-                readPos = secondChunk;
-            } else {
-                readPos = (readPos + firstChunk) % RESERVE_SIZE;
-            }
-
-            bufferSize -= CHUNK_SIZE;
-
-        }
-
-        if (!chunk.empty()) {
-            processAudio(chunk);
-        }
-    }
-
-    qDebug() << "Audio writer thread stopped";
-}
-
-void AudioOutput::processAudio(const std::vector<float>& audioData)
+int AudioOutput::queueSize() const
 {
-    if (!audioDevice || audioData.empty()) return;
-
-    // Use pre-allocated buffer
-    size_t requiredSize = audioData.size() * 2 * sizeof(qint16);
-    if (outputBuffer.size() < requiredSize) {
-        outputBuffer.resize(requiredSize);
-    }
-
-    qint16* output = reinterpret_cast<qint16*>(outputBuffer.data());
-
-    // Fast conversion: mono to stereo with clipping
-    for (size_t i = 0; i < audioData.size(); ++i) {
-        // Clamp and convert to 16-bit
-        float sample = std::clamp(audioData[i], -1.0f, 1.0f);
-        qint16 intSample = static_cast<qint16>(sample * 32767.0f);
-
-        output[i * 2] = intSample;      // Left
-        output[i * 2 + 1] = intSample;  // Right
-    }
-
-    qint64 bytesToWrite = audioData.size() * 2 * sizeof(qint16);
-    qint64 bytesWritten = 0;
-
-    // Write to audio device
-    while (bytesWritten < bytesToWrite && m_running) {
-        // Wait for space in output buffer
-        qint64 freeBytes = m_audioOutput->bytesFree();
-        if (freeBytes < (bytesToWrite - bytesWritten)) {
-            continue;
-        }
-
-        qint64 written = audioDevice->write(
-            outputBuffer.constData() + bytesWritten,
-            bytesToWrite - bytesWritten
-            );
-
-        if (written > 0) {
-            bytesWritten += written;
-        } else if (written < 0) {
-            qCritical() << "Audio write error!";
-            break;
-        }
-    }
+    return static_cast<int>(m_ring.available() * CHANNEL_COUNT);
 }
 
-int AudioOutput::queueSize() const
+double AudioOutput::queueDuration() const
 {
-    QMutexLocker locker(&mutex);
-    return static_cast<int>(bufferSize);
+    return m_ring.available() / static_cast<double>(SAMPLE_RATE);
 }
 
-double AudioOutput::queueDuration() const
+double AudioOutput::latencyMs() const
 {
-    QMutexLocker locker(&mutex);
-    return bufferSize / static_cast<double>(SAMPLE_RATE);
+    double ms = m_device.bufferedMs();
+    if (m_audioOutput) {
+        const qint64 queued = m_audioOutput->bufferSize() - m_audioOutput->bytesFree();
+        ms += std::max<qint64>(0, queued) * 1000.0 / (SAMPLE_RATE * 2 * sizeof(qint16));
+    }
+    return ms;
 }
 
 void AudioOutput::stop()
 {
+    if (!m_running) return;
     m_running = false;
-    queueNotEmpty.wakeAll();
+
+    if (m_audioOutput) {
+        m_audioOutput->stop();
+        m_audioOutput.reset();
+    }
+    m_device.close();
 }
@@ -2,32 +2,39 @@
 #define AUDIOOUTPUT_H
 
 #include <QObject>
-#include <QThread>
-#include <QMutex>
+#include <QScopedPointer>
 #include <QAudioSink>
 #include <QAudioFormat>
-#include <QIODevice>
-#include <QWaitCondition>
-#include <QElapsedTimer>
 #include <vector>
 #include <atomic>
+#include "audioring.h"
 
+// Mono float audio at 48 kHz, played through a QAudioSink in pull
+// mode from a lock-free ring (see AudioRing). enqueueAudio() from one
+// thread at a time.
 class AudioOutput : public QObject
 {
     Q_OBJECT
+
 public:
     explicit AudioOutput(QObject *parent = nullptr);
     ~AudioOutput();
 
     bool initializeAudio();
     void stop();
-    void enqueueAudio(const std::vector<float>& samples);
+    void enqueueAudio(const std::vector<float>& samples) { enqueueAudio(samples.data(), samples.size()); }
+    void enqueueAudio(const float* samples, size_t count);
 
     int queueSize() const;
     double queueDuration() const;
     int sampleRate() const { return m_format.sampleRate(); }
     bool isRunning() const { return m_running.load(); }
 
+    // Ring plus what the sink has queued
+    double latencyMs() const;
+    quint64 underruns() const { return m_device.underruns(); }
+    quint64 droppedFrames() const { return m_device.droppedFrames(); }
+
 public slots:
     void setVolume(int value);
 
@@ -35,42 +42,22 @@ private slots:
     void handleAudioOutputStateChanged(QAudio::State newState);
 
 private:
-    void audioWriterLoop();
-    void processAudio(const std::vector<float>& audioData);
-
-    // Audio configuration
     static constexpr int SAMPLE_RATE = 48000;
-    static constexpr int CHANNEL_COUNT = 2;
+    static constexpr int CHANNEL_COUNT = 1;            // of the input; the sink is stereo
+    static constexpr size_t RING_FRAMES = 16384;    // 340 ms, well over the target
 
-    // Buffer configuration (optimized for stability)
-    static constexpr int MIN_BUFFER_SAMPLES = 4800;    // 200ms @ 48kHz (priming)
-    static constexpr int RESTART_THRESHOLD = 2400;     // 100ms (re-prime threshold)
-    static constexpr int CHUNK_SIZE = 480;              // 10ms @ 48kHz (write chunks)
-    static constexpr int MAX_QUEUE_SIZE = 480000;       // 10s maximum
-    static constexpr int RESERVE_SIZE = 500000;         // Pre-allocated size
+    // Audio is demodulated once per PAL frame, so it lands in 40 ms bursts.
+    // The ring target must hold a whole burst plus a margin, or the drift
+    // control reads the sawtooth as excess and keeps dropping frames.
+    static constexpr int PRODUCER_BURST_MS = 40;
+    static constexpr int TARGET_MS = PRODUCER_BURST_MS + 20;
 
-    // Audio format and device
     QAudioFormat m_format;
-    QAudioFormat m_inputFormat;
     QScopedPointer<QAudioSink> m_audioOutput;
-    QIODevice* audioDevice = nullptr;
-
-    // High-performance circular buffer
-    std::vector<float> audioBuffer;
-    size_t writePos = 0;
-    size_t readPos = 0;
-    size_t bufferSize = 0;
-
-    // Thread synchronization
-    mutable QMutex mutex;
-    QWaitCondition queueNotEmpty;
-
-    // Worker thread
-    QThread audioWriterThread;
-    std::atomic_bool m_running{true};
+    AudioRing m_ring;
+    AudioRingDevice m_device;
 
-    // Pre-allocated output buffer
-    QByteArray outputBuffer;
+    std::atomic_bool m_running{false};
 };
 
 #endif // AUDIOOUTPUT_H
@@ -0,0 +1,247 @@
+#include "audioring.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define AUDIORING_SSE2 1
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define AUDIORING_NEON 1
+#endif
+
+namespace {
+
+constexpr float FULL_SCALE = 32767.0f;
+
+// Round to nearest even and saturate, as the SIMD paths do, so a sample
+// converts the same wherever a block ends
+inline qint16 toInt16(float s)
+{
+    return static_cast<qint16>(std::lrintf(std::clamp(s * FULL_SCALE, -32768.0f, 32767.0f)));
+}
+
+#if defined(AUDIORING_NEON)
+// Nearest-even like _mm_cvtps_epi32; ARMv7 has only the truncating
+// convert, so clamp and round with the 1.5 * 2^23 trick first
+inline int32x4_t roundToInt32(float32x4_t v)
+{
+#if defined(__aarch64__)
+    return vcvtnq_s32_f32(v);
+#else
+    const float32x4_t magic = vdupq_n_f32(12582912.0f);
+    v = vminq_f32(vmaxq_f32(v, vdupq_n_f32(-32768.0f)), vdupq_n_f32(32767.0f));
+    return vcvtq_s32_f32(vsubq_f32(vaddq_f32(v, magic), magic));
+#endif
+}
+#endif
+
+// Interleaved float -> int16, n samples. Scaling, nearest-even rounding and
+// the saturating pack give the same result as toInt16.
+void convertStereo(const float* in, qint16* out, size_t n)
+{
+    size_t i = 0;
+#if defined(AUDIORING_SSE2)
+    const __m128 scale = _mm_set1_ps(FULL_SCALE);
+    for (; i + 8 <= n; i += 8) {
+        const __m128i a = _mm_cvtps_epi32(_mm_mul_ps(_mm_loadu_ps(in + i), scale));
+        const __m128i b = _mm_cvtps_epi32(_mm_mul_ps(_mm_loadu_ps(in + i + 4), scale));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm_packs_epi32(a, b));
+    }
+#elif defined(AUDIORING_NEON)
+    const float32x4_t scale = vdupq_n_f32(FULL_SCALE);
+    for (; i + 8 <= n; i += 8) {
+        const int32x4_t a = roundToInt32(vmulq_f32(vld1q_f32(in + i), scale));
+        const int32x4_t b = roundToInt32(vmulq_f32(vld1q_f32(in + i + 4), scale));
+        vst1q_s16(out + i, vcombine_s16(vqmovn_s32(a), vqmovn_s32(b)));
+    }
+#endif
+    for (; i < n; i++) out[i] = toInt16(in[i]);
+}
+
+// Mono float -> stereo int16, n frames
+void convertMono(const float* in, qint16* out, size_t n)
+{
+    size_t i = 0;
+#if defined(AUDIORING_SSE2)
+    const __m128 scale = _mm_set1_ps(FULL_SCALE);
+    for (; i + 4 <= n; i += 4) {
+        const __m128i v = _mm_cvtps_epi32(_mm_mul_ps(_mm_loadu_ps(in + i), scale));
+        const __m128i p = _mm_packs_epi32(v, v);                // s0 s1 s2 s3 s0 s1 s2 s3
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i * 2), _mm_unpacklo_epi16(p, p));
+    }
+#elif defined(AUDIORING_NEON)
+    const float32x4_t scale = vdupq_n_f32(FULL_SCALE);
+    for (; i + 4 <= n; i += 4) {
+        const int16x4_t v = vqmovn_s32(roundToInt32(vmulq_f32(vld1q_f32(in + i), scale)));
+        const int16x4x2_t lr = vzip_s16(v, v);
+        vst1q_s16(out + i * 2, vcombine_s16(lr.val[0], lr.val[1]));
+    }
+#endif
+    for (; i < n; i++) out[i * 2] = out[i * 2 + 1] = toInt16(in[i]);
+}
+
+} // namespace
+
+// ============================================================
+// AudioRing
+// ============================================================
+
+AudioRing::AudioRing(int channels, size_t capacityFrames)
+    : m_channels(channels == 1 ? 1 : 2)
+{
+    size_t capacity = 1;
+    while (capacity < capacityFrames) capacity <<= 1;
+    m_mask = capacity - 1;
+    m_buffer.assign(capacity * m_channels, 0.0f);
+}
+
+size_t AudioRing::available() const
+{
+    return static_cast<size_t>(m_write.load(std::memory_order_acquire) -
+                               m_read.load(std::memory_order_acquire));
+}
+
+size_t AudioRing::write(const float* samples, size_t frames)
+{
+    const uint64_t w = m_write.load(std::memory_order_relaxed);
+    const uint64_t r = m_read.load(std::memory_order_acquire);
+    const size_t space = capacity() - static_cast<size_t>(w - r);
+    const size_t n = std::min(frames, space);
+
+    // At most two pieces around the wrap
+    const size_t pos = static_cast<size_t>(w) & m_mask;
+    const size_t first = std::min(n, capacity() - pos);
+    std::memcpy(m_buffer.data() + pos * m_channels, samples, first * m_channels * sizeof(float));
+    std::memcpy(m_buffer.data(), samples + first * m_channels, (n - first) * m_channels * sizeof(float));
+
+    m_write.store(w + n, std::memory_order_release);
+    return frames - n;
+}
+
+size_t AudioRing::readStereoInt16(qint16* out, size_t frames)
+{
+    const uint64_t r = m_read.load(std::memory_order_relaxed);
+    const uint64_t w = m_write.load(std::memory_order_acquire);
+    const size_t n = std::min(frames, static_cast<size_t>(w - r));
+
+    const size_t pos = static_cast<size_t>(r) & m_mask;
+    const size_t first = std::min(n, capacity() - pos);
+    if (m_channels == 2) {
+        convertStereo(m_buffer.data() + pos * 2, out, first * 2);
+        convertStereo(m_buffer.data(), out + first * 2, (n - first) * 2);
+    } else {
+        convertMono(m_buffer.data() + pos, out, first);
+        convertMono(m_buffer.data(), out + first * 2, n - first);
+    }
+
+    m_read.store(r + n, std::memory_order_release);
+    return n;
+}
+
+void AudioRing::discard(size_t frames)
+{
+    const uint64_t r = m_read.load(std::memory_order_relaxed);
+    const uint64_t w = m_write.load(std::memory_order_acquire);
+    m_read.store(r + std::min(frames, static_cast<size_t>(w - r)), std::memory_order_release);
+}
+
+void AudioRing::reset()
+{
+    m_write.store(0, std::memory_order_relaxed);
+    m_read.store(0, std::memory_order_relaxed);
+}
+
+// ============================================================
+// AudioRingDevice
+// ============================================================
+
+AudioRingDevice::AudioRingDevice(AudioRing* ring, int sampleRate, QObject *parent)
+    : QIODevice(parent)
+    , m_ring(ring)
+    , m_sampleRate(sampleRate)
+    , m_targetMs(DEFAULT_TARGET_MS)
+    , m_target(static_cast<size_t>(sampleRate) * DEFAULT_TARGET_MS / 1000)
+{
+}
+
+void AudioRingDevice::setTargetLatency(int ms)
+{
+    m_targetMs = std::clamp(ms, 5, 1000);
+    m_target.store(static_cast<size_t>(m_sampleRate) * m_targetMs / 1000, std::memory_order_relaxed);
+}
+
+double AudioRingDevice::bufferedMs() const
+{
+    return m_ring->available() * 1000.0 / m_sampleRate;
+}
+
+qint64 AudioRingDevice::bytesAvailable() const
+{
+    // Silence stands in for missing audio, so there is always a pull's worth
+    const qint64 frameBytes = 2 * sizeof(qint16);
+    const qint64 ring = static_cast<qint64>(m_ring->available()) * frameBytes;
+    return std::max<qint64>(ring, static_cast<qint64>(m_target.load(std::memory_order_relaxed)) * frameBytes) +
+           QIODevice::bytesAvailable();
+}
+
+qint64 AudioRingDevice::readData(char *data, qint64 maxlen)
+{
+    const qint64 frameBytes = 2 * sizeof(qint16);
+    const size_t frames = static_cast<size_t>(maxlen / frameBytes);
+    if (frames == 0) return 0;
+    qint16* out = reinterpret_cast<qint16*>(data);
+    const size_t target = m_target.load(std::memory_order_relaxed);
+    size_t fill = m_ring->available();
+
+    if (!m_primed) {
+        if (fill < target) {
+            std::memset(data, 0, static_cast<size_t>(frames * frameBytes));
+            return static_cast<qint64>(frames * frameBytes);
+        }
+        m_primed = true;
+        m_averageFill = static_cast<double>(fill);
+    }
+
+    // Far behind (a burst after a network stall): back to the target at once
+    if (fill > target * 4 + frames) {
+        m_ring->discard(fill - target);
+        m_dropped.fetch_add(fill - target, std::memory_order_relaxed);
+        fill = target;
+        m_averageFill = static_cast<double>(fill);
+    }
+
+    // Slow drift: drop or repeat up to 0.5% of the frames, spread one per pull
+    m_averageFill += (static_cast<double>(fill) - m_averageFill) * 0.05;
+    const size_t slip = std::max<size_t>(1, frames / 200);
+    size_t want = frames;
+    size_t repeat = 0;
+    if (m_averageFill > target * 1.5 && fill > frames + slip) {
+        m_ring->discard(slip);
+        m_dropped.fetch_add(slip, std::memory_order_relaxed);
+    } else if (m_averageFill < target * 0.5 && frames > slip) {
+        repeat = slip;
+        want = frames - slip;
+    }
+
+    const size_t got = m_ring->readStereoInt16(out, want);
+    if (got < want) {
+        std::memset(out + got * 2, 0, (frames - got) * frameBytes);
+        m_underruns.fetch_add(1, std::memory_order_relaxed);
+        m_primed = false;
+    } else {
+        for (size_t k = want; k < want + repeat; k++) {
+            out[k * 2] = out[want * 2 - 2];
+            out[k * 2 + 1] = out[want * 2 - 1];
+        }
+    }
+    return static_cast<qint64>(frames * frameBytes);
+}
+
+qint64 AudioRingDevice::writeData(const char *data, qint64 len)
+{
+    Q_UNUSED(data);
+    Q_UNUSED(len);
+    return -1;
+}
@@ -0,0 +1,96 @@
+#ifndef AUDIORING_H
+#define AUDIORING_H
+
+#include <QIODevice>
+#include <atomic>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+// Low-latency audio path (same file in HackRfRadio, HackTvGui, PALBDecoder).
+//
+// The demodulator writes float audio into AudioRing, a single-producer
+// single-consumer ring: no lock, no allocation per block. The QAudioSink
+// pulls through AudioRingDevice, which converts straight out of the ring
+// to stereo int16 (SSE2 / NEON) and keeps the fill near a target:
+//  - it primes to the target before playing, and again after an underrun
+//    (which plays silence);
+//  - while the smoothed fill drifts off the target it drops or repeats a
+//    frame or two per pull (at most 0.5%), which absorbs the radio vs
+//    sound card clock offset without an audible step;
+//  - a burst that leaves it far behind is thrown away down to the target.
+// A full ring drops the newest audio (overrun).
+//
+// One thread writes, one thread reads (the sink's); nothing else touches
+// the ring while the sink runs.
+class AudioRing
+{
+public:
+    // channels: 1 (played on both sides) or 2 (interleaved L, R)
+    AudioRing(int channels, size_t capacityFrames);
+
+    int channels() const { return m_channels; }
+    size_t capacity() const { return m_mask + 1; }
+
+    // Producer. Returns the frames that did not fit.
+    size_t write(const float* samples, size_t frames);
+
+    // Consumer
+    size_t available() const;
+    // Up to 'frames' frames as interleaved stereo int16; returns the count
+    size_t readStereoInt16(qint16* out, size_t frames);
+    void discard(size_t frames);
+
+    // Only with both sides stopped
+    void reset();
+
+private:
+    int m_channels;
+    size_t m_mask;                          // capacity - 1, in frames
+    std::vector<float> m_buffer;
+    alignas(64) std::atomic<uint64_t> m_write{0};   // frames ever written
+    alignas(64) std::atomic<uint64_t> m_read{0};    // frames ever read
+};
+
+class AudioRingDevice : public QIODevice
+{
+    Q_OBJECT
+
+public:
+    static constexpr int DEFAULT_TARGET_MS = 20;
+    static constexpr int SINK_BUFFER_MS = 20;     // what to ask of the QAudioSink
+
+    AudioRingDevice(AudioRing* ring, int sampleRate, QObject *parent = nullptr);
+
+    void setTargetLatency(int ms);
+    int targetLatencyMs() const { return m_targetMs; }
+
+    // Audio waiting in the ring
+    double bufferedMs() const;
+    quint64 underruns() const { return m_underruns.load(std::memory_order_relaxed); }
+    // Frames lost to a full ring plus frames trimmed to catch up
+    quint64 droppedFrames() const { return m_dropped.load(std::memory_order_relaxed); }
+    void countOverrun(size_t frames) { m_dropped.fetch_add(frames, std::memory_order_relaxed); }
+
+    bool isSequential() const override { return true; }
+    qint64 bytesAvailable() const override;
+
+protected:
+    qint64 readData(char *data, qint64 maxlen) override;
+    qint64 writeData(const char *data, qint64 len) override;
+
+private:
+    AudioRing* m_ring;
+    int m_sampleRate;
+    int m_targetMs;
+    std::atomic<size_t> m_target;           // frames
+
+    // Sink thread only
+    bool m_primed = false;
+    double m_averageFill = 0.0;
+
+    std::atomic<quint64> m_underruns{0};
+    std::atomic<quint64> m_dropped{0};
+};
+
+#endif // AUDIORING_H
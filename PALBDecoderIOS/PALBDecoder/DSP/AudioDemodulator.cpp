@@ -108,6 +108,9 @@ void AudioDemodulator::rebuildDecimationChain()
         m_decimChain.push_back(std::move(stage));
         currentRate = newRate;
     }
+
+    m_resampler.setRates(currentRate, AUDIO_SAMP_RATE);
+    m_resampler.reset();
 }
 
 std::vector<float> AudioDemodulator::designLowPassFIR(int numTaps, float cutoffFreq, float sampleRate)
@@ -274,25 +277,11 @@ void AudioDemodulator::decimateInPlace(std::vector<float>& signal, int factor)
     signal.resize(outSize);
 }
 
-void AudioDemodulator::resampleInPlace(std::vector<float>& signal, double inputRate, double outputRate)
+void AudioDemodulator::resampleInPlace(std::vector<float>& signal)
 {
-    if (signal.empty() || inputRate <= 0 || outputRate <= 0) return;
-    double ratio = inputRate / outputRate;
-    size_t outputSize = static_cast<size_t>(signal.size() / ratio);
-
-    m_firTemp.resize(outputSize);
-    for (size_t i = 0; i < outputSize; i++) {
-        double srcPos = i * ratio;
-        size_t idx = static_cast<size_t>(srcPos);
-        if (idx + 1 < signal.size()) {
-            double frac = srcPos - idx;
-            m_firTemp[i] = signal[idx] * (1.0f - (float)frac) + signal[idx + 1] * (float)frac;
-        } else if (idx < signal.size()) {
-            m_firTemp[i] = signal[idx];
-        } else {
-            m_firTemp[i] = 0;
-        }
-    }
+    if (signal.empty()) return;
+    m_firTemp.clear();
+    m_resampler.process(signal.data(), signal.size(), m_firTemp);
     signal.swap(m_firTemp);
 }
 
@@ -440,7 +429,7 @@ void AudioDemodulator::processSamples(const int8_t* data, size_t len)
         stageIdx++;
     }
 
-    if (std::abs(currentRate - 48000.0) > 1.0) resampleInPlace(m_workAudio, currentRate, 48000.0);
+    if (std::abs(currentRate - 48000.0) > 1.0) resampleInPlace(m_workAudio);
     applyFIRFilterInPlace(m_workAudio, m_audioFilterTaps);
     emitAudioBuffer(m_workAudio);
 }
@@ -9,6 +9,7 @@
 #include <functional>
 #include <algorithm>
 #include <numeric>
+#include "PolyphaseResampler.h"
 
 class AudioDemodulator
 {
@@ -91,12 +92,13 @@ private:
     void fmDemodulateInPlace(const std::vector<std::complex<float>>& signal, std::vector<float>& out, double signalRate);
     float unwrapPhase(float phase, float lastPhase);
     void decimateInPlace(std::vector<float>& signal, int factor);
-    void resampleInPlace(std::vector<float>& signal, double inputRate, double outputRate);
+    void resampleInPlace(std::vector<float>& signal);   // final stage to 48 kHz
     void emitAudioBuffer(const std::vector<float>& audio);
 
     // Pre-allocated work buffers (avoid per-call malloc)
     std::vector<float> m_workReal, m_workImag, m_workAudio;
     std::vector<float> m_firTemp;
+    PolyphaseResampler m_resampler;
 };
 
 #endif
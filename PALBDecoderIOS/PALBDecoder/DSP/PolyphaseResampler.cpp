@@ -0,0 +1,173 @@
+#include "PolyphaseResampler.h"
+#include <algorithm>
+#include <cmath>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#include <xmmintrin.h>
+#define RESAMPLER_SSE 1
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define RESAMPLER_NEON 1
+#endif
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+namespace {
+
+// x against two coefficient rows at once, n a multiple of 4
+inline void dot2(const float* x, const float* a, const float* b, int n, float& ya, float& yb)
+{
+#if defined(RESAMPLER_SSE)
+    __m128 accA = _mm_setzero_ps();
+    __m128 accB = _mm_setzero_ps();
+    for (int k = 0; k < n; k += 4) {
+        const __m128 v = _mm_loadu_ps(x + k);
+        accA = _mm_add_ps(accA, _mm_mul_ps(v, _mm_loadu_ps(a + k)));
+        accB = _mm_add_ps(accB, _mm_mul_ps(v, _mm_loadu_ps(b + k)));
+    }
+    alignas(16) float sa[4], sb[4];
+    _mm_store_ps(sa, accA);
+    _mm_store_ps(sb, accB);
+    ya = (sa[0] + sa[1]) + (sa[2] + sa[3]);
+    yb = (sb[0] + sb[1]) + (sb[2] + sb[3]);
+#elif defined(RESAMPLER_NEON)
+    float32x4_t accA = vdupq_n_f32(0.0f);
+    float32x4_t accB = vdupq_n_f32(0.0f);
+    for (int k = 0; k < n; k += 4) {
+        const float32x4_t v = vld1q_f32(x + k);
+        accA = vmlaq_f32(accA, v, vld1q_f32(a + k));
+        accB = vmlaq_f32(accB, v, vld1q_f32(b + k));
+    }
+    float sa[4], sb[4];
+    vst1q_f32(sa, accA);
+    vst1q_f32(sb, accB);
+    ya = (sa[0] + sa[1]) + (sa[2] + sa[3]);
+    yb = (sb[0] + sb[1]) + (sb[2] + sb[3]);
+#else
+    float sa[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+    float sb[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+    for (int k = 0; k < n; k += 4) {
+        for (int j = 0; j < 4; j++) {
+            sa[j] += x[k + j] * a[k + j];
+            sb[j] += x[k + j] * b[k + j];
+        }
+    }
+    ya = (sa[0] + sa[1]) + (sa[2] + sa[3]);
+    yb = (sb[0] + sb[1]) + (sb[2] + sb[3]);
+#endif
+}
+
+} // namespace
+
+PolyphaseResampler::PolyphaseResampler()
+    : m_inRate(0.0)
+    , m_outRate(0.0)
+    , m_passband(DEFAULT_PASSBAND)
+    , m_baseTaps(DEFAULT_TAPS)
+    , m_taps(0)
+    , m_step(1.0)
+    , m_position(0.0)
+{
+}
+
+void PolyphaseResampler::setRates(double inRate, double outRate, double passband, int taps)
+{
+    if (inRate <= 0.0 || outRate <= 0.0) return;
+    passband = std::clamp(passband, 0.1, 0.99);
+    taps = std::clamp(taps, 4, MAX_TAPS);
+    if (m_taps > 0 && inRate == m_inRate && outRate == m_outRate &&
+        passband == m_passband && taps == m_baseTaps) {
+        return;
+    }
+
+    m_inRate = inRate;
+    m_outRate = outRate;
+    m_passband = passband;
+    m_baseTaps = taps;
+    m_step = inRate / outRate;
+    buildBank();
+    reset();
+}
+
+void PolyphaseResampler::buildBank()
+{
+    const double stretch = std::max(1.0, m_step);
+    int taps = static_cast<int>(std::ceil(m_baseTaps * stretch));
+    taps = std::min((taps + 3) & ~3, MAX_TAPS);
+    m_taps = taps;
+
+    // Cutoff in cycles per input sample
+    const double fc = 0.5 * m_passband / stretch;
+    const double half = taps / 2.0;
+    m_bank.assign(static_cast<size_t>(PHASES + 1) * taps, 0.0f);
+
+    for (int p = 0; p <= PHASES; p++) {
+        const double mu = static_cast<double>(p) / PHASES;
+        float* row = &m_bank[static_cast<size_t>(p) * taps];
+        double sum = 0.0;
+        for (int k = 0; k < taps; k++) {
+            // Distance of history sample k from the output position
+            const double d = k - (half - 1.0) - mu;
+            const double x = 2.0 * fc * d;
+            const double sinc = (std::abs(x) < 1e-9) ? 1.0 : std::sin(M_PI * x) / (M_PI * x);
+            const double w = (d + half) / (2.0 * half);
+            double win = 0.0;
+            if (w > 0.0 && w < 1.0) {
+                win = 0.35875 - 0.48829 * std::cos(2.0 * M_PI * w)
+                    + 0.14128 * std::cos(4.0 * M_PI * w)
+                    - 0.01168 * std::cos(6.0 * M_PI * w);
+            }
+            const double h = sinc * win;
+            row[k] = static_cast<float>(h);
+            sum += h;
+        }
+        if (sum != 0.0) {
+            for (int k = 0; k < taps; k++) row[k] = static_cast<float>(row[k] / sum);
+        }
+    }
+}
+
+void PolyphaseResampler::reset()
+{
+    // Zeros ahead of the first input sample, so output 0 lines up with input 0
+    m_history.assign(m_taps > 0 ? m_taps / 2 - 1 : 0, 0.0f);
+    m_position = 0.0;
+}
+
+void PolyphaseResampler::process(const float* in, size_t count, std::vector<float>& out)
+{
+    if (count == 0 || m_taps == 0) return;
+
+    m_history.insert(m_history.end(), in, in + count);
+    const size_t avail = m_history.size();
+    const size_t taps = static_cast<size_t>(m_taps);
+    const size_t need = out.size() + static_cast<size_t>(count / m_step) + 2;
+    if (out.capacity() < need) out.reserve(std::max(need, out.capacity() * 2));
+
+    const float* x = m_history.data();
+    double pos = m_position;
+    while (static_cast<size_t>(pos) + taps <= avail) {
+        const size_t base = static_cast<size_t>(pos);
+        const double phase = (pos - base) * PHASES;
+        const int p = static_cast<int>(phase);
+        const float frac = static_cast<float>(phase - p);
+        const float* a = &m_bank[static_cast<size_t>(p) * taps];
+        float ya, yb;
+        dot2(x + base, a, a + taps, m_taps, ya, yb);
+        out.push_back(ya + (yb - ya) * frac);
+        pos += m_step;
+    }
+
+    const size_t consumed = std::min(static_cast<size_t>(pos), avail);
+    m_history.erase(m_history.begin(), m_history.begin() + consumed);
+    m_position = pos - static_cast<double>(consumed);
+}
+
+std::vector<float> PolyphaseResampler::process(const std::vector<float>& in)
+{
+    std::vector<float> out;
+    process(in.data(), in.size(), out);
+    return out;
+}
@@ -0,0 +1,27 @@
+QT = core gui
+CONFIG += c++17 cmdline
+
+# Headless benchmark / regression runner for the PALBDecoder DSP.
+# Builds the decoder sources directly; no HackRF or HackTvLib needed.
+PAL_DIR = $$absolute_path($$PWD/../PALBDecoder)
+INCLUDEPATH += $$PAL_DIR
+
+SOURCES += \
+        main.cpp \
+        $$PAL_DIR/PALDecoder.cpp \
+        $$PAL_DIR/audiodemodulator.cpp \
+        $$PAL_DIR/polyphaseresampler.cpp
+
+HEADERS += \
+    $$PAL_DIR/PALDecoder.h \
+    $$PAL_DIR/audiodemodulator.h \
+    $$PAL_DIR/FrameBuffer.h \
+    $$PAL_DIR/polyphaseresampler.h
+
+TARGET = PALBench
+TEMPLATE = app
+
+# Default rules for deployment.
+qnx: target.path = /tmp/$${TARGET}/bin
+else: unix:!android: target.path = /opt/$${TARGET}/bin
+!isEmpty(target.path): INSTALLS += target
@@ -0,0 +1,634 @@
+// PALBench - headless PAL-B/G decoder benchmark and regression runner
+//
+// Reads a recorded IQ file (PALBDecoder "Record IQ" output, hacktv -o file:
+// output, rtl_sdr captures, ...) and drives PALDecoder + AudioDemodulator as
+// fast as the CPU allows. Same pipeline as PALBDecoder's MainWindow:
+//   int8 IQ -> complex<float> -> FrameBuffer (40 ms) -> video + audio demod
+// but single threaded and without frame skipping, so results are
+// reproducible run to run.
+//
+// --resampler benchmarks the -> 48 kHz audio resampler alone (speed,
+// passband, alias and image rejection against the kernels it replaced)
+// and exits; no input file needed.
+
+#include "PALDecoder.h"
+#include "audiodemodulator.h"
+#include "FrameBuffer.h"
+#include "polyphaseresampler.h"
+
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QDir>
+#include <QImage>
+#include <QDebug>
+#include <cstdio>
+#include <vector>
+#include <complex>
+#include <algorithm>
+#include <cmath>
+
+// ============================================================
+// Input sample formats (names follow hacktv's rf_file types)
+// ============================================================
+
+enum class SampleType { Uint8, Int8, Int16, Float };
+
+static bool parseSampleType(const QString& name, SampleType& type, int& bytesPerIQ)
+{
+    QString n = name.toLower();
+    if (n == "int8")                 { type = SampleType::Int8;  bytesPerIQ = 2; }
+    else if (n == "uint8")           { type = SampleType::Uint8; bytesPerIQ = 2; }
+    else if (n == "int16")           { type = SampleType::Int16; bytesPerIQ = 4; }
+    else if (n == "float" || n == "cf32") { type = SampleType::Float; bytesPerIQ = 8; }
+    else return false;
+    return true;
+}
+
+// Same scaling as MainWindow::handleReceivedData for int8 (/128)
+static void convertBlock(const uchar* src, size_t count, SampleType type,
+                         std::vector<std::complex<float>>& out)
+{
+    out.resize(count);
+    switch (type) {
+    case SampleType::Int8: {
+        const int8_t* p = reinterpret_cast<const int8_t*>(src);
+        for (size_t i = 0; i < count; i++)
+            out[i] = std::complex<float>(p[i * 2] / 128.0f, p[i * 2 + 1] / 128.0f);
+        break;
+    }
+    case SampleType::Uint8:
+        for (size_t i = 0; i < count; i++)
+            out[i] = std::complex<float>((src[i * 2] - 127.5f) / 128.0f,
+                                         (src[i * 2 + 1] - 127.5f) / 128.0f);
+        break;
+    case SampleType::Int16: {
+        const int16_t* p = reinterpret_cast<const int16_t*>(src);
+        for (size_t i = 0; i < count; i++)
+            out[i] = std::complex<float>(p[i * 2] / 32768.0f, p[i * 2 + 1] / 32768.0f);
+        break;
+    }
+    case SampleType::Float: {
+        const float* p = reinterpret_cast<const float*>(src);
+        for (size_t i = 0; i < count; i++)
+            out[i] = std::complex<float>(p[i * 2], p[i * 2 + 1]);
+        break;
+    }
+    }
+}
+
+// ============================================================
+// Output writers
+// ============================================================
+
+// 16-bit PCM mono WAV, header patched on close()
+class WavWriter
+{
+public:
+    bool open(const QString& path, int sampleRate)
+    {
+        m_file.setFileName(path);
+        if (!m_file.open(QIODevice::WriteOnly))
+            return false;
+        m_sampleRate = sampleRate;
+        m_dataBytes = 0;
+        writeHeader();
+        return true;
+    }
+
+    void write(const std::vector<float>& samples)
+    {
+        if (!m_file.isOpen()) return;
+        m_pcm.resize(samples.size());
+        for (size_t i = 0; i < samples.size(); i++) {
+            float s = std::clamp(samples[i], -1.0f, 1.0f);
+            m_pcm[i] = static_cast<int16_t>(s * 32767.0f);
+        }
+        m_file.write(reinterpret_cast<const char*>(m_pcm.data()), m_pcm.size() * sizeof(int16_t));
+        m_dataBytes += static_cast<quint32>(m_pcm.size() * sizeof(int16_t));
+    }
+
+    void close()
+    {
+        if (!m_file.isOpen()) return;
+        m_file.seek(0);
+        writeHeader();
+        m_file.close();
+    }
+
+private:
+    void put32(quint32 v) { char b[4] = { char(v), char(v >> 8), char(v >> 16), char(v >> 24) }; m_file.write(b, 4); }
+    void put16(quint16 v) { char b[2] = { char(v), char(v >> 8) }; m_file.write(b, 2); }
+
+    void writeHeader()
+    {
+        m_file.write("RIFF", 4);
+        put32(36 + m_dataBytes);
+        m_file.write("WAVEfmt ", 8);
+        put32(16);
+        put16(1);                       // PCM
+        put16(1);                       // mono
+        put32(m_sampleRate);
+        put32(m_sampleRate * 2);        // byte rate
+        put16(2);                       // block align
+        put16(16);                      // bits per sample
+        m_file.write("data", 4);
+        put32(m_dataBytes);
+    }
+
+    QFile m_file;
+    int m_sampleRate = 48000;
+    quint32 m_dataBytes = 0;
+    std::vector<int16_t> m_pcm;
+};
+
+// YUV4MPEG2 4:4:4 stream (playable with ffplay / mpv, diffable byte for byte)
+class Y4mWriter
+{
+public:
+    bool open(const QString& path)
+    {
+        m_file.setFileName(path);
+        return m_file.open(QIODevice::WriteOnly);
+    }
+
+    void write(const QImage& frame)
+    {
+        if (!m_file.isOpen()) return;
+        const int w = frame.width();
+        const int h = frame.height();
+        if (!m_headerWritten) {
+            m_file.write(QString("YUV4MPEG2 W%1 H%2 F25:1 Ip A1:1 C444\n").arg(w).arg(h).toLatin1());
+            m_headerWritten = true;
+        }
+        m_planes.resize(static_cast<size_t>(w) * h * 3);
+        uint8_t* yP = m_planes.data();
+        uint8_t* uP = yP + w * h;
+        uint8_t* vP = uP + w * h;
+
+        // BT.601 studio range
+        for (int y = 0; y < h; y++) {
+            const QRgb* line = reinterpret_cast<const QRgb*>(frame.constScanLine(y));
+            for (int x = 0; x < w; x++) {
+                int r = qRed(line[x]), g = qGreen(line[x]), b = qBlue(line[x]);
+                int i = y * w + x;
+                yP[i] = static_cast<uint8_t>(( 66 * r + 129 * g +  25 * b + 128) / 256 + 16);
+                uP[i] = static_cast<uint8_t>((-38 * r -  74 * g + 112 * b + 128) / 256 + 128);
+                vP[i] = static_cast<uint8_t>((112 * r -  94 * g -  18 * b + 128) / 256 + 128);
+            }
+        }
+        m_file.write("FRAME\n", 6);
+        m_file.write(reinterpret_cast<const char*>(m_planes.data()), m_planes.size());
+    }
+
+    void close() { m_file.close(); }
+
+private:
+    QFile m_file;
+    bool m_headerWritten = false;
+    std::vector<uint8_t> m_planes;
+};
+
+// Audio carrier in baseband = (videoCarrier + 5.5 MHz) - tuneFreq
+// (same calculation as MainWindow::applyFrequencyChange)
+static double audioCarrierBasebandHz(uint64_t tuneHz)
+{
+    double tuneMHz = tuneHz / 1.0e6;
+    double videoCarrierMHz;
+    if (tuneMHz >= 470.0 && tuneMHz <= 862.0) {
+        int ch = static_cast<int>(std::floor((tuneMHz - 470.0 - 0.001) / 8.0));
+        if (ch < 0) ch = 0;
+        videoCarrierMHz = 470.0 + ch * 8.0 + 1.25;
+    } else {
+        videoCarrierMHz = tuneMHz;
+    }
+    return (videoCarrierMHz + 5.5 - tuneMHz) * 1.0e6;
+}
+
+static double ms(qint64 ns) { return ns / 1.0e6; }
+
+// ============================================================
+// --resampler: audio resampler report
+// ============================================================
+
+// The kernels the polyphase bank replaced, for comparison:
+// FMDemodulator's 6-tap windowed sinc evaluated per tap...
+static std::vector<float> sincResample(const std::vector<float>& in, double inRate, double outRate)
+{
+    const double ratio = inRate / outRate;
+    const int halfKernel = 3;
+    std::vector<float> out;
+    out.reserve(static_cast<size_t>(in.size() / ratio) + 1);
+    for (double pos = 0.0; pos < static_cast<double>(in.size()); pos += ratio) {
+        int center = static_cast<int>(pos);
+        double frac = pos - center;
+        float sample = 0.0f, weightSum = 0.0f;
+        for (int j = -halfKernel + 1; j <= halfKernel; j++) {
+            int idx = center + j;
+            if (idx < 0 || idx >= static_cast<int>(in.size())) continue;
+            double x = j - frac;
+            float sinc = (std::abs(x) < 1e-6) ? 1.0f : static_cast<float>(std::sin(x * M_PI) / (x * M_PI));
+            double wpos = (j - frac + halfKernel) / (2.0 * halfKernel);
+            float w = 0.35875f - 0.48829f * std::cos(2.0f * static_cast<float>(M_PI) * wpos)
+                     + 0.14128f * std::cos(4.0f * static_cast<float>(M_PI) * wpos)
+                     - 0.01168f * std::cos(6.0f * static_cast<float>(M_PI) * wpos);
+            sample += in[idx] * sinc * w;
+            weightSum += sinc * w;
+        }
+        out.push_back(weightSum > 0.0f ? sample / weightSum : sample);
+    }
+    return out;
+}
+
+// ...and the linear interpolation of AMDemodulator / AudioDemodulator
+static std::vector<float> linearResample(const std::vector<float>& in, double inRate, double outRate)
+{
+    const double ratio = inRate / outRate;
+    const size_t outN = static_cast<size_t>(in.size() / ratio);
+    std::vector<float> out;
+    out.reserve(outN);
+    for (size_t i = 0; i < outN; i++) {
+        double pos = i * ratio;
+        size_t idx = static_cast<size_t>(pos);
+        double frac = pos - idx;
+        if (idx + 1 < in.size()) out.push_back(static_cast<float>(in[idx] * (1.0 - frac) + in[idx + 1] * frac));
+        else out.push_back(in[idx]);
+    }
+    return out;
+}
+
+enum class ResamplerKind { Polyphase, Sinc, Linear };
+
+static std::vector<float> runResampler(ResamplerKind kind, const std::vector<float>& in, double inRate)
+{
+    if (kind == ResamplerKind::Sinc) return sincResample(in, inRate, 48000.0);
+    if (kind == ResamplerKind::Linear) return linearResample(in, inRate, 48000.0);
+
+    // Streamed in 10 ms blocks, as the demodulators call it
+    PolyphaseResampler resampler;
+    resampler.setRates(inRate, 48000.0);
+    std::vector<float> out;
+    const size_t block = std::max<size_t>(1, static_cast<size_t>(inRate / 100.0));
+    for (size_t i = 0; i < in.size(); i += block)
+        resampler.process(in.data() + i, std::min(block, in.size() - i), out);
+    return out;
+}
+
+// Least squares fit of a tone at 'freq' to y[from, to): returns its power,
+// residual = mean square of everything else
+static double fitTone(const std::vector<float>& y, size_t from, size_t to, double freq, double& residual)
+{
+    double cc = 0.0, cs = 0.0, ss = 0.0, yc = 0.0, ys = 0.0;
+    const double w = 2.0 * M_PI * freq / 48000.0;
+    for (size_t i = from; i < to; i++) {
+        const double c = std::cos(w * i), s = std::sin(w * i);
+        cc += c * c; cs += c * s; ss += s * s;
+        yc += y[i] * c; ys += y[i] * s;
+    }
+    const double det = cc * ss - cs * cs;
+    const double a = (yc * ss - ys * cs) / det;
+    const double b = (cc * ys - cs * yc) / det;
+    double err = 0.0;
+    for (size_t i = from; i < to; i++) {
+        const double e = y[i] - (a * std::cos(w * i) + b * std::sin(w * i));
+        err += e * e;
+    }
+    residual = err / (to - from);
+    return (a * a + b * b) / 2.0;
+}
+
+static double db(double powerRatio) { return 10.0 * std::log10(std::max(powerRatio, 1e-20)); }
+
+static int runResamplerBench()
+{
+    // Rates ahead of the final stage in the demodulators' chains
+    const double rates[] = { 44100.0, 50000.0, 160000.0 / 3.0, 62500.0, 200000.0, 400000.0 };
+    const double passbandTones[] = { 100.0, 1000.0, 3000.0, 6000.0, 10000.0, 12000.0, 15000.0 };
+    const char* names[] = { "polyphase", "sinc-6", "linear" };
+    const double amplitude = 0.5;
+    const double tonePower = amplitude * amplitude / 2.0;
+
+    printf("PALBench resampler: -> 48 kHz, %d phases, passband %.2f, 1 s tones of %.1f FS\n",
+           PolyphaseResampler::PHASES, PolyphaseResampler::DEFAULT_PASSBAND, amplitude);
+    printf("  gain: min/max over %.0f Hz..%.0f kHz; SINAD: worst in-band residual; alias: worst output\n"
+           "  of a tone that folds below 20 kHz, all relative to the tone\n",
+           passbandTones[0], passbandTones[6] / 1000.0);
+    printf("  %-9s %-9s %5s %10s %16s %10s %10s\n", "in rate", "kernel", "taps", "MS/s out", "gain dB", "SINAD dB", "alias dB");
+
+    for (double inRate : rates) {
+        const size_t n = static_cast<size_t>(inRate);
+        std::vector<float> tone(n);
+
+        for (int k = 0; k < 3; k++) {
+            const ResamplerKind kind = static_cast<ResamplerKind>(k);
+
+            // Speed: 10 s of noise
+            std::vector<float> noise(n * 10);
+            uint32_t seed = 12345;
+            for (auto& v : noise) { seed = seed * 1664525u + 1013904223u; v = (seed >> 8) / 16777216.0f - 0.5f; }
+            QElapsedTimer timer;
+            timer.start();
+            const size_t produced = runResampler(kind, noise, inRate).size();
+            const double sec = std::max(timer.nsecsElapsed() / 1.0e9, 1e-9);
+
+            double gainMin = 1e9, gainMax = -1e9, sinad = 1e9;
+            for (double f : passbandTones) {
+                for (size_t i = 0; i < n; i++) tone[i] = static_cast<float>(amplitude * std::sin(2.0 * M_PI * f * i / inRate));
+                const std::vector<float> y = runResampler(kind, tone, inRate);
+                double residual = 0.0;
+                const double power = fitTone(y, 4800, y.size() - 4800, f, residual);
+                gainMin = std::min(gainMin, db(power / tonePower));
+                gainMax = std::max(gainMax, db(power / tonePower));
+                sinad = std::min(sinad, db(power / std::max(residual, 1e-30)));
+            }
+
+            // Everything left of a tone above the output Nyquist is alias;
+            // count the tones that fold into the audio band (below 20 kHz)
+            double alias = -200.0;
+            for (double f = 28000.0; f < inRate * 0.49 && f < 100000.0; f += 1700.0) {
+                if (std::abs(f - std::round(f / 48000.0) * 48000.0) > 20000.0) continue;
+                for (size_t i = 0; i < n; i++) tone[i] = static_cast<float>(amplitude * std::sin(2.0 * M_PI * f * i / inRate));
+                const std::vector<float> y = runResampler(kind, tone, inRate);
+                double power = 0.0;
+                for (size_t i = 4800; i + 4800 < y.size(); i++) power += static_cast<double>(y[i]) * y[i];
+                power /= (y.size() - 9600);
+                alias = std::max(alias, db(power / tonePower));
+            }
+
+            PolyphaseResampler probe;
+            probe.setRates(inRate, 48000.0);
+            const QString taps = (kind == ResamplerKind::Polyphase) ? QString::number(probe.taps())
+                               : (kind == ResamplerKind::Sinc) ? QString("6") : QString("2");
+            const QString gain = QString("%1..%2").arg(gainMin, 0, 'f', 2).arg(gainMax, 0, 'f', 2);
+            const QString aliasText = (inRate > 56000.0) ? QString::number(alias, 'f', 1) : QString("-");
+            printf("  %-9.0f %-9s %5s %10.2f %16s %10.1f %10s\n", inRate, names[k], qPrintable(taps),
+                   produced / sec / 1.0e6, qPrintable(gain), sinad, qPrintable(aliasText));
+        }
+    }
+    fflush(stdout);
+    return 0;
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("PALBench");
+    QCoreApplication::setApplicationVersion("1.0");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Headless PAL-B/G decoder benchmark (IQ file in, frames/WAV out)");
+    parser.addHelpOption();
+    parser.addVersionOption();
+    parser.addPositionalArgument("input", "IQ file (interleaved I/Q)");
+
+    QCommandLineOption sampleRateOpt(QStringList() << "s" << "sample-rate", "Sample rate in Hz (default: 16000000)", "rate", "16000000");
+    QCommandLineOption freqOpt(QStringList() << "f" << "frequency", "Tune frequency of the capture in Hz (default: 479300000)", "freq", "479300000");
+    QCommandLineOption typeOpt(QStringList() << "t" << "type", "Sample type: int8, uint8, int16, float (default: int8)", "type", "int8");
+    QCommandLineOption blockOpt(QStringList() << "b" << "block", "Samples per input block (default: 131072)", "samples", "131072");
+    QCommandLineOption loopsOpt(QStringList() << "l" << "loops", "Play the file N times (default: 1)", "n", "1");
+    QCommandLineOption pngDirOpt("png-dir", "Write decoded frames as PNG into this directory", "dir");
+    QCommandLineOption pngEveryOpt("png-every", "Write every Nth frame as PNG (default: 1)", "n", "1");
+    QCommandLineOption y4mOpt("y4m", "Write all decoded frames to a YUV4MPEG2 file", "file");
+    QCommandLineOption wavOpt("wav", "Write demodulated audio to a 48 kHz WAV file", "file");
+    QCommandLineOption colorOpt("color", "Enable colour decoding");
+    QCommandLineOption noAudioOpt("no-audio", "Skip audio demodulation");
+    QCommandLineOption noVideoOpt("no-video", "Skip video decoding");
+    QCommandLineOption minSyncOpt("min-sync", "Exit with code 2 if sync detection rate (%) is below this", "percent");
+    QCommandLineOption minFramesOpt("min-frames", "Exit with code 2 if fewer frames were decoded", "n");
+    QCommandLineOption resamplerOpt("resampler", "Report speed, passband and alias rejection of the audio resampler and exit");
+    parser.addOptions({ sampleRateOpt, freqOpt, typeOpt, blockOpt, loopsOpt,
+                        pngDirOpt, pngEveryOpt, y4mOpt, wavOpt,
+                        colorOpt, noAudioOpt, noVideoOpt, minSyncOpt, minFramesOpt, resamplerOpt });
+    parser.process(app);
+
+    if (parser.isSet(resamplerOpt)) {
+        return runResamplerBench();
+    }
+
+    const QStringList positional = parser.positionalArguments();
+    if (positional.size() != 1) {
+        parser.showHelp(1);
+    }
+
+    SampleType sampleType;
+    int bytesPerIQ = 2;
+    if (!parseSampleType(parser.value(typeOpt), sampleType, bytesPerIQ)) {
+        fprintf(stderr, "Unknown sample type: %s\n", qPrintable(parser.value(typeOpt)));
+        return 1;
+    }
+
+    const int sampleRate = parser.value(sampleRateOpt).toInt();
+    const uint64_t frequency = parser.value(freqOpt).toULongLong();
+    const size_t blockSamples = std::max(1024, parser.value(blockOpt).toInt());
+    const int loops = std::max(1, parser.value(loopsOpt).toInt());
+    const int pngEvery = std::max(1, parser.value(pngEveryOpt).toInt());
+    const bool doVideo = !parser.isSet(noVideoOpt);
+    const bool doAudio = !parser.isSet(noAudioOpt);
+
+    if (sampleRate <= 0) {
+        fprintf(stderr, "Invalid sample rate\n");
+        return 1;
+    }
+
+    // ============================================================
+    // Input (memory mapped, no copies besides the float conversion)
+    // ============================================================
+    QFile input(positional.first());
+    if (!input.open(QIODevice::ReadOnly)) {
+        fprintf(stderr, "Cannot open %s\n", qPrintable(input.fileName()));
+        return 1;
+    }
+    const qint64 fileSize = input.size();
+    const size_t totalIQ = static_cast<size_t>(fileSize / bytesPerIQ);
+    const uchar* mapped = input.map(0, fileSize);
+    if (!mapped || totalIQ == 0) {
+        fprintf(stderr, "Cannot map %s (or file is empty)\n", qPrintable(input.fileName()));
+        return 1;
+    }
+
+    // ============================================================
+    // Decoders
+    // ============================================================
+    PALDecoder palDecoder;
+    palDecoder.setSampleRate(sampleRate);
+    palDecoder.setTuneFrequency(frequency);
+    palDecoder.setColorMode(parser.isSet(colorOpt));
+
+    AudioDemodulator audioDemod;
+    audioDemod.setSampleRate(sampleRate);
+    audioDemod.setAudioCarrierFreq(audioCarrierBasebandHz(frequency));
+    audioDemod.setAudioEnabled(doAudio);
+
+    FrameBuffer frameBuffer(sampleRate, 0.04);
+
+    // ============================================================
+    // Outputs
+    // ============================================================
+    QString pngDir;
+    if (parser.isSet(pngDirOpt)) {
+        pngDir = parser.value(pngDirOpt);
+        if (!QDir().mkpath(pngDir)) {
+            fprintf(stderr, "Cannot create %s\n", qPrintable(pngDir));
+            return 1;
+        }
+    }
+
+    Y4mWriter y4m;
+    bool y4mEnabled = false;
+    if (parser.isSet(y4mOpt)) {
+        if (!y4m.open(parser.value(y4mOpt))) {
+            fprintf(stderr, "Cannot create %s\n", qPrintable(parser.value(y4mOpt)));
+            return 1;
+        }
+        y4mEnabled = true;
+    }
+
+    WavWriter wav;
+    bool wavEnabled = false;
+    if (parser.isSet(wavOpt)) {
+        if (!wav.open(parser.value(wavOpt), 48000)) {
+            fprintf(stderr, "Cannot create %s\n", qPrintable(parser.value(wavOpt)));
+            return 1;
+        }
+        wavEnabled = true;
+    }
+
+    // Per-stage timers (nanoseconds)
+    qint64 tConvert = 0, tFrameBuffer = 0, tVideo = 0, tAudio = 0, tFrameOut = 0, tAudioOut = 0;
+    uint64_t framesOut = 0;
+    uint64_t audioSamplesOut = 0;
+
+    // frameReady / audioReady are emitted synchronously from processSamples()
+    // on this thread, so output time is measured here and subtracted later.
+    QObject::connect(&palDecoder, &PALDecoder::frameReady, [&](const QImage& frame) {
+        QElapsedTimer t;
+        t.start();
+        if (!pngDir.isEmpty() && framesOut % pngEvery == 0) {
+            frame.save(QDir(pngDir).filePath(QString("frame_%1.png").arg(framesOut, 5, 10, QChar('0'))), "PNG");
+        }
+        if (y4mEnabled) {
+            y4m.write(frame);
+        }
+        framesOut++;
+        tFrameOut += t.nsecsElapsed();
+    });
+
+    QObject::connect(&audioDemod, &AudioDemodulator::audioReady, [&](const std::vector<float>& samples) {
+        QElapsedTimer t;
+        t.start();
+        if (wavEnabled) {
+            wav.write(samples);
+        }
+        audioSamplesOut += samples.size();
+        tAudioOut += t.nsecsElapsed();
+    });
+
+    fprintf(stderr, "PALBench: %s, %lld bytes, %s, %.3f MS/s, tune %.3f MHz, %d loop(s)\n",
+            qPrintable(QFileInfo(input.fileName()).fileName()), fileSize,
+            qPrintable(parser.value(typeOpt)), sampleRate / 1.0e6, frequency / 1.0e6, loops);
+
+    // ============================================================
+    // Main loop
+    // ============================================================
+    std::vector<std::complex<float>> block;
+    block.reserve(blockSamples);
+    uint64_t samplesIn = 0;
+    uint64_t blocksIn = 0;
+    uint64_t blocksLocked = 0;
+
+    QElapsedTimer wall;
+    wall.start();
+
+    for (int loop = 0; loop < loops; loop++) {
+        for (size_t pos = 0; pos < totalIQ; pos += blockSamples) {
+            const size_t count = std::min(blockSamples, totalIQ - pos);
+            QElapsedTimer t;
+
+            t.start();
+            convertBlock(mapped + pos * bytesPerIQ, count, sampleType, block);
+            tConvert += t.nsecsElapsed();
+
+            t.start();
+            frameBuffer.addBuffer(block);
+            tFrameBuffer += t.nsecsElapsed();
+
+            // A block longer than a frame completes several
+            while (frameBuffer.isFrameReady()) {
+                t.start();
+                const std::vector<std::complex<float>> frame = frameBuffer.getFrame();
+                tFrameBuffer += t.nsecsElapsed();
+
+                if (doVideo) {
+                    t.start();
+                    palDecoder.processSamples(frame);
+                    tVideo += t.nsecsElapsed();
+                }
+                if (doAudio) {
+                    t.start();
+                    audioDemod.processSamples(frame);
+                    tAudio += t.nsecsElapsed();
+                }
+            }
+
+            samplesIn += count;
+            blocksIn++;
+            if (palDecoder.isSyncLocked())
+                blocksLocked++;
+        }
+    }
+
+    const qint64 tWall = wall.nsecsElapsed();
+
+    input.unmap(const_cast<uchar*>(mapped));
+    y4m.close();
+    wav.close();
+
+    // Output callbacks ran inside processSamples(): report decode time only
+    tVideo = std::max<qint64>(0, tVideo - tFrameOut);
+    tAudio = std::max<qint64>(0, tAudio - tAudioOut);
+
+    // ============================================================
+    // Report
+    // ============================================================
+    const double wallSec = tWall / 1.0e9;
+    const double signalSec = static_cast<double>(samplesIn) / sampleRate;
+    const uint64_t lines = palDecoder.getLinesProcessed();
+    const double syncRate = lines ? 100.0 * palDecoder.getSyncDetected() / lines : 0.0;
+    const double lockRate = blocksIn ? 100.0 * blocksLocked / blocksIn : 0.0;
+
+    printf("========================================\n");
+    printf("PALBench report\n");
+    printf("  Input:        %llu samples (%.3f s of signal)\n", (unsigned long long)samplesIn, signalSec);
+    printf("  Wall time:    %.3f s (%.2fx real time)\n", wallSec, wallSec > 0 ? signalSec / wallSec : 0.0);
+    printf("  Throughput:   %.2f MS/s\n", wallSec > 0 ? samplesIn / wallSec / 1.0e6 : 0.0);
+    printf("  Frames:       %llu (%.2f frames/s)\n", (unsigned long long)framesOut, wallSec > 0 ? framesOut / wallSec : 0.0);
+    printf("  Lines:        %llu\n", (unsigned long long)lines);
+    printf("  Sync detect:  %.1f %% of lines\n", syncRate);
+    printf("  Sync locked:  %.1f %% of blocks\n", lockRate);
+    printf("  Sync quality: %.1f %% (last window)\n", palDecoder.getSyncQuality());
+    printf("  Audio:        %llu samples (%.3f s)%s\n", (unsigned long long)audioSamplesOut,
+           audioSamplesOut / 48000.0, audioDemod.isAudioCapable() ? "" : " - carrier above Nyquist");
+    printf("  Stage times:\n");
+    printf("    convert     %10.1f ms\n", ms(tConvert));
+    printf("    framebuffer %10.1f ms\n", ms(tFrameBuffer));
+    printf("    video       %10.1f ms\n", ms(tVideo));
+    printf("    audio       %10.1f ms\n", ms(tAudio));
+    printf("    frame out   %10.1f ms\n", ms(tFrameOut));
+    printf("    audio out   %10.1f ms\n", ms(tAudioOut));
+    printf("========================================\n");
+    fflush(stdout);
+
+    // Regression thresholds
+    int rc = 0;
+    if (parser.isSet(minSyncOpt) && syncRate < parser.value(minSyncOpt).toDouble()) {
+        fprintf(stderr, "FAIL: sync detection %.1f %% < %s %%\n", syncRate, qPrintable(parser.value(minSyncOpt)));
+        rc = 2;
+    }
+    if (parser.isSet(minFramesOpt) && framesOut < parser.value(minFramesOpt).toULongLong()) {
+        fprintf(stderr, "FAIL: %llu frames < %s\n", (unsigned long long)framesOut, qPrintable(parser.value(minFramesOpt)));
+        rc = 2;
+    }
+    return rc;
+}
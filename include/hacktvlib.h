@@ -21,11 +21,15 @@
 #include <vector>
 #include <mutex>
 #include <cstring>
+#include "latencyhistogram.h"
+#include "ddcprocessor.h"
 
 // Forward declarations for types defined in DLL
 struct hacktv_t;
 class HackRfDevice;
 class RTLSDRDevice;
+class LoopbackDevice;
+class FileSourceDevice;
 enum rxtx_mode : int;
 
 class HACKTVLIB_EXPORT HackTvLib : public QObject
@@ -39,9 +43,22 @@ public:
     using LogCallback = std::function<void(const std::string&)>;
     using DataCallback = std::function<void(const int8_t*, size_t)>;
 
+    // Attached receivers as -o values (hackrf:<serial>, rtlsdr:<serial or index>)
+    static std::vector<std::string> listDevices();
+
     bool start();
     bool stop();
     int hardReset();
+
+    // Warm RX/TX switch of a started HackRF (RX or the FM transmitter):
+    // the device stays open and the data callback, DDC, modulator and
+    // audio ring are kept, so only streaming restarts; tuning, gains and
+    // TX settings carry over. false when that is not possible (other
+    // output, video TX, not started): stop(), setArguments() and start()
+    // then. Each switch is timed as rf.switch in latency().
+    bool switchToRx();
+    bool switchToTx();
+    bool isTxMode() const;
     void setLogCallback(LogCallback callback);
     void setReceivedDataCallback(DataCallback callback);
     void clearCallbacks();
@@ -65,14 +82,54 @@ public:
     void setFreqCorrection(int ppm);
     void setDirectSampling(int mode);
     void setOffsetTuning(bool enable);
+    void setTunerGain(int gain_tenth_db);
+    void setTunerAutoGain(bool enable);
+    void setAgcMode(bool enable);
+
+    // IQ file playback: jump to a position in seconds
+    void seekFile(double seconds);
 
     // External audio ring buffer for FM TX
     void enableExternalAudioRing();
     void writeExternalAudio(const float* data, size_t count);
+    // Mono frames written but not yet taken by the TX callback
+    size_t externalAudioQueued() const;
 
     // Set TX modulation type: 0=NFM, 1=WFM, 2=AM
     void setTxModulationType(int type);
 
+    // Per-stage latency of this radio (latencyhistogram.h): rx.transfer
+    // (first sample to data callback), rx.interval (between callbacks) and
+    // rx.callback (time the callback holds the USB thread); tx.ring (audio
+    // waiting for the TX callback), tx.usb (libhackrf transfers queued
+    // ahead of the block being filled) and rf.switch (warm RX/TX switches)
+    LatencyRecorder& latency() { return m_latency; }
+
+    // Capture time, UTC microseconds, of the first sample of the block the
+    // data callback is being given; only meaningful inside the callback
+    uint64_t blockTimeUs() const { return m_blockTimeUs; }
+
+    // Tuning epoch: setFrequency() advances tuneEpoch() once the device has
+    // retuned. blockEpoch(), the epoch of the block the data callback is
+    // being given, follows when the blocks that were already in flight have
+    // been delivered, so a caller hopping the radio drops blocks of an older
+    // epoch. blockEpoch() is only meaningful inside the callback
+    uint32_t tuneEpoch() const { return m_tuneEpoch.load(std::memory_order_acquire); }
+    uint32_t blockEpoch() const { return m_blockEpoch; }
+
+    // Optional DDC (ddcprocessor.h) on a DSP thread of its own: every RX
+    // block is also shifted by config.offsetHz, decimated to about
+    // config.outputRate and handed to callback, next to the raw data
+    // callback. Can be set before start() or while running and follows
+    // setSampleRate(); the rate in each DdcBlock is the one to use.
+    // setDdcConfig() changes offset, rate or filter without a new thread.
+    using DdcCallback = DdcProcessor::Callback;
+    void setDdc(const DdcConfig& config, DdcCallback callback);
+    void setDdcConfig(const DdcConfig& config);
+    void clearDdc();
+    // 0 while there is no DDC or no sample rate yet
+    double ddcOutputRate();
+
     bool isInitialized() const {
         return (s != nullptr);
     }
@@ -110,9 +167,36 @@ private:
     // Devices
     HackRfDevice* hackRfDevice = nullptr;
     RTLSDRDevice* rtlSdrDevice = nullptr;
+    LoopbackDevice* loopbackDevice = nullptr;
+    FileSourceDevice* fileSourceDevice = nullptr;
+
+    // Latency stages; rx.* are written on the data callback thread only
+    LatencyRecorder m_latency;
+    LatencyHistogram* m_rxTransfer = nullptr;
+    LatencyHistogram* m_rxInterval = nullptr;
+    LatencyHistogram* m_rxCallback = nullptr;
+    LatencyHistogram* m_txRing = nullptr;
+    LatencyHistogram* m_txUsb = nullptr;
+    LatencyHistogram* m_rfSwitch = nullptr;
+    std::atomic<uint32_t> m_rxSampleRate{0};
+    int64_t m_lastBlockUs = 0;
+    uint64_t m_blockTimeUs = 0;
+    std::atomic<uint32_t> m_tuneEpoch{0};
+    std::atomic<int> m_staleBlocks{0};      // still to come from before the last retune
+    uint32_t m_blockEpoch = 0;
+
+    // DDC; the data callback pushes to it under m_ddcMutex. rx.ddc.queue
+    // and rx.ddc.work are its hand-off wait and processing time
+    std::mutex m_ddcMutex;
+    DdcProcessor* m_ddc = nullptr;
+    uint32_t m_ddcInputRate = 0;
+    LatencyHistogram* m_rxDdcQueue = nullptr;
+    LatencyHistogram* m_rxDdcWork = nullptr;
 
     // Private methods
     bool openDevice();
+    bool createLoopbackDevice(uint32_t sampleRate);
+    bool createFileSourceDevice();
     bool setVideo();
     bool initAv();
     bool parseArguments();
@@ -120,6 +204,7 @@ private:
     void cleanupArgv();
     void rfTxLoop();
     void rfRxLoop();
+    bool switchHackRf(rxtx_mode mode);
 };
 
 #endif // HACKTVLIB_H